@@ -24,16 +24,42 @@
     #define EFBOARD_NUM_BATTERIES 1            //!< Number of battery cells used for V_BAT NOTE: LiIon LIPo should only use Singel Cell Akku do not use anything else
     #define EFBOARD_VBAT_MAX (4.2 * EFBOARD_NUM_BATTERIES) //!< Voltage at which battery cells are considered full
     #define EFBOARD_VBAT_MIN (3.4 * EFBOARD_NUM_BATTERIES) //!< Voltage at which battery cells are considered empty
+    #define EFBOARD_BAT_RESISTANCE_MOHM 150    //!< Internal resistance of the cell, protection circuit and wiring
+    #define EFBOARD_BAT_CAPACITY_MAH 2000      //!< Nominal capacity of the cell, used until a discharge was learned
 #else //assume Akaline
     #define EFBOARD_BAT_TYPE_NAME "Alkaline"
     #define EFBOARD_NUM_BATTERIES 3            //!< Number of battery cells used for V_BAT
     #define EFBOARD_VBAT_MAX (1.60 * EFBOARD_NUM_BATTERIES) //!< Voltage at which battery cells are considered full
     #define EFBOARD_VBAT_MIN (1.13 * EFBOARD_NUM_BATTERIES) //!< Voltage at which battery cells are considered empty
+    #define EFBOARD_BAT_RESISTANCE_MOHM (200 * EFBOARD_NUM_BATTERIES)  //!< Internal resistance of the cells, holder and wiring
+    #define EFBOARD_BAT_CAPACITY_MAH 2000      //!< Nominal capacity of the cells down to EFBOARD_VBAT_MIN, used until a discharge was learned
 #endif
 
 #define EFBOARD_BROWN_OUT_SOFT EFBOARD_VBAT_MIN //!< V_BAT threshold after which a soft brown out is triggered
 #define EFBOARD_BROWN_OUT_HARD (EFBOARD_BROWN_OUT_SOFT - 0.08) //!< V_BAT threshold after which a hard brown out is triggered
+#define EFBOARD_BROWN_OUT_RECOVER (EFBOARD_BROWN_OUT_SOFT + 0.05 * EFBOARD_NUM_BATTERIES) //!< V_BAT above which the badge boots normally again after a hard brown out
 
+//battery sampling
+//interval at which V_BAT is sampled in the background, getters only return the cached value
+#define EFBOARD_VBAT_SAMPLE_INTERVAL_MS 1000
+//ADC readings per sample, their median rejects single outliers
+#define EFBOARD_VBAT_BURST 5
+//efficiency of the 5V boost converter, used to estimate the battery current drawn by the LEDs
+#define EFBOARD_BOOST_EFFICIENCY_PERCENT 85
+//voltage range the discharge curve is learned in, a discharge has to start above full and end below empty
+#define EFBOARD_VBAT_LEARN_FULL (EFBOARD_VBAT_MAX - 0.05 * EFBOARD_NUM_BATTERIES)
+#define EFBOARD_VBAT_LEARN_EMPTY (EFBOARD_BROWN_OUT_SOFT + 0.02 * EFBOARD_NUM_BATTERIES)
+
+
+
+//Execution model
+//split the work across both cores (comment out to keep everything in the single Arduino loop()):
+//FSM logic, radio and persistence run in a task on EF_DUALCORE_LOGIC_CORE, next to the BT / WiFi controller tasks.
+//loop() keeps ARDUINO_RUNNING_CORE for itself and only renders the OLED, LED frames are transmitted on the same core.
+//#define EF_DUALCORE
+#define EF_DUALCORE_LOGIC_CORE 0
+#define EF_DUALCORE_LOGIC_PRIORITY 1
+#define EF_DUALCORE_LOGIC_STACK 8192
 
 
 //EFLed Config
@@ -54,9 +80,27 @@
 #define EFLED_DRAGON_CHEEK_IDX 3
 #define EFLED_DRAGON_EAR_BOTTOM_IDX 4
 #define EFLED_DRAGON_EAR_TOP_IDX 5
+//maximum current in mA all LEDs together may draw from the 5V boost converter. Frames exceeding it are dimmed.
+//140 mA equals all LEDs white at a raw brightness of 44, the highest level known to run stable.
+#define EFLED_CURRENT_BUDGET_MA 140
+//highest raw brightness sparse frames are scaled up to as long as they stay within EFLED_CURRENT_BUDGET_MA
+#define EFLED_BRIGHTNESS_CEILING 128
+//transmit LED frames from a separate task instead of blocking the main loop (comment out to disable)
+//#define EFLED_ASYNC_OUTPUT
+#ifdef EF_DUALCORE
+    //LED frames are transmitted on the render core (see EF_DUALCORE below)
+    #define EFLED_ASYNC_OUTPUT
+    #define EFLED_ASYNC_OUTPUT_CORE ARDUINO_RUNNING_CORE
+#else
+    #define EFLED_ASYNC_OUTPUT_CORE 0
+#endif
+#define EFLED_ASYNC_OUTPUT_PRIORITY 2
+#define EFLED_ASYNC_OUTPUT_STACK 2048
 
 
 //EFDisplay Config
+//time between two OLED frames. The CPU may sleep in between.
+#define EFDISPLAY_FRAME_INTERVAL_MS 20
 #define OLED_CS    5   // Chip Select
 #define OLED_DC    6   // Data/Command
 #define OLED_RESET 7   // Reset
@@ -75,4 +119,23 @@
 #define EFTOUCH_CALIBRATE_NUM_SAMPLES 10
 #define EFTOUCH_SHORTPRESS_DURATION_MS 450
 #define EFTOUCH_LONGPRESS_DURATION_MS  1800
-#define EFTOUCH_MULTITOUCH_COOLDOWN_MS 1000
\ No newline at end of file
+#define EFTOUCH_MULTITOUCH_COOLDOWN_MS 1000
+//interval of hold events while a zone is held after a longpress
+#define EFTOUCH_HOLD_INTERVAL_MS 150
+
+//pads are sampled this often while awake to track the untouched baseline
+#define EFTOUCH_BASELINE_INTERVAL_MS 100
+//baseline moves 1/2^N of the way towards each untouched sample
+#define EFTOUCH_BASELINE_IIR_SHIFT 4
+//press threshold as multiple of the measured noise, never below the detection step
+#define EFTOUCH_BASELINE_NOISE_FACTOR 4
+//release threshold in percent of the press threshold
+#define EFTOUCH_RELEASE_THRESHOLD_PERCENT 75
+//touches held longer than this are considered baseline drift and relearned
+#define EFTOUCH_BASELINE_MAX_TOUCH_MS 60000
+//enable the ESP32-S3 hardware IIR filter and denoise channel for touch readings (comment out to disable)
+//#define EFTOUCH_HW_FILTER
+//raw touch readings are recorded this often when built with -D EFTOUCH_RECORDER (GET TOUCHTRACE)
+#define EFTOUCH_RECORDER_INTERVAL_MS 20
+//number of samples the touch recorder keeps, the last minute at 20 ms
+#define EFTOUCH_RECORDER_CAPACITY 3000
@@ -27,13 +27,50 @@
  * @author Honigeintopf
  */
 
-#include <memory>
-#include <queue>
+#include <algorithm>
+#include <cstddef>
+
+#include <EFRingBuffer.h>
+#include <EFScheduler.h>
 
 #include "FSMEvent.h"
 #include "FSMGlobals.h"
 #include "FSMState.h"
 
+#define FSM_EVENT_QUEUE_CAPACITY 32         //!< Number of events the touch handler to FSM ring can hold. Must be a power of two.
+#define FSM_EVENT_BURST_TIMEOUT_US 50000    //!< Time after which an incomplete release burst is processed anyway
+#define FSM_PERSIST_DELAY_MS 3000           //!< Quiet time after the last globals change before they are written to NVS
+#define FSM_PERSIST_MAX_DELAY_MS 15000      //!< Upper bound for deferring a globals write while changes keep coming in
+#define FSM_SLEEP_INACTIVITY_MS 7200000     //!< Time without touch events after which a battery powered badge enters deep sleep. 0 disables.
+
+/**
+ * @brief Size and alignment of a storage slot able to hold any of the given
+ * state types
+ */
+template<typename... States>
+struct FSMStateSlot {
+    static constexpr size_t size = std::max({sizeof(States)...});
+    static constexpr size_t align = std::max({alignof(States)...});
+};
+
+/**
+ * @brief Storage slot for all states the FSM can construct. Must list every
+ * type FSM::create() builds.
+ */
+typedef FSMStateSlot<
+    DisplayPrideFlag,
+    AnimateRainbow,
+    AnimateMatrix,
+    AnimateSnake,
+    AnimateHeartbeat,
+    AnimatePerlin,
+    OTAUpdate,
+    GameHuemesh,
+    GameFoxHuntBle,
+    VUMeter,
+    MenuMain,
+    DeepSleep
+> FSMStateArenaSlot;
 
 /**
  * @brief Main finite state machine (FSM)
@@ -43,20 +80,102 @@ class FSM {
     protected:
 
         unsigned int tickrate_ms;         //!< Amount of milliseconds this FSM whishes to be handle()'ed
-        unsigned int state_last_run;      //!< Timestamp of the last execution of the current states run() method
+        EFSchedulerTask state_run;        //!< Deadline of the current states run() method
+
+        alignas(FSMStateArenaSlot::align) uint8_t arena[2][FSMStateArenaSlot::size];  //!< In-place storage for the current and the next state
+        uint8_t state_slot;                  //!< Arena slot holding the current state
+        FSMState* state;                     //!< Current FSM state, lives in arena[state_slot]
+        FSMStateId state_id;                 //!< Id of the current state
+        FSMStateId resume_id;                //!< Last remembered state that was left, resumed after deep sleep
+        uint32_t resume_tick;                //!< Tick of resume_id when it was left
+        uint32_t last_event_ms;              //!< millis() of the last touch event, used to detect inactivity
+        EFRingBuffer<FSMEventData, FSM_EVENT_QUEUE_CAPACITY> eventqueue;  //!< Events written by EFTouch.poll(), drained by handle()
+        FSMEventData burst[2];               //!< Events resolved from a release burst that still need to be delivered
+        uint8_t burst_len;                   //!< Number of valid entries in burst
+        uint8_t burst_pos;                   //!< Next entry of burst to deliver
+        uint8_t longpressed_zones;           //!< Bitmask (1 << EFTouchZone) of zones whose current touch already delivered a longpress
+        uint32_t reported_overflows;         //!< Event queue overflows that were already logged
+        FSMGlobals globals;                  //!< Global FSM state data
 
-        std::unique_ptr<FSMState> state;     //!< Current FSM state
-        std::queue<FSMEvent> eventqueue;     //!< Queue to store FSMEvents. ATTENTION: THIS IS NOT THREAD SAFE ON ITS OWN!
-        std::shared_ptr<FSMGlobals> globals; //!< Global FSM state data
+        uint8_t persisted[FSMGLOBALS_BLOB_SIZE];  //!< Blob image last read from or written to NVS
+        bool persisted_legacy;               //!< NVS still holds the pre-blob per-key layout that must be cleared on the next write
+        bool persist_pending;                //!< Globals changed and a write to NVS is scheduled
+        uint32_t persist_deadline;           //!< millis() at which a pending write is performed
+        uint32_t persist_latest;             //!< millis() a pending write is performed at the latest
+        uint32_t persist_requests;           //!< Number of times globals were marked for persisting
+        uint32_t persist_writes;             //!< Number of times globals were actually written to NVS
 
         const char* NVS_NAMESPACE = "effsm";  //!< Namespace under which the FSM stores persisted data in non-volatile storage (NVS)
+        const char* NVS_KEY_GLOBALS = "globals";  //!< NVS key of the globals blob
 
         /**
          * @brief Retrieves the next FSMEvent from the queue in a non-blocking fashion.
+         *
+         * Releasing or longpressing a touch zone makes EFTouch emit a burst of
+         * events. Only the most specific gesture of such a burst is returned,
+         * e.g., a longpress suppresses the shortpress and release of the same
+         * touch. The release of a touch that already delivered a longpress is
+         * dropped.
          * 
          * @return Next FSMEvent or FSMEvent::NoOp if no events exist
          */
-        FSMEvent dequeueEvent();
+        FSMEventData dequeueEvent();
+
+        /**
+         * @brief Consumes the release or longpress burst at the head of the event queue
+         *
+         * @return True if the burst was complete and got resolved into burst[]
+         */
+        bool resolveBurst();
+
+        /**
+         * @brief Passes the given event to the matching touch handler of the current state
+         *
+         * @param event Event to propagate
+         * @return State to transition to or FSMStateId::None
+         */
+        FSMStateId propagateEvent(FSMEvent event);
+
+        /**
+         * @brief Constructs the given state inside an arena slot
+         *
+         * @param id State to construct
+         * @param slot Arena slot to construct the state in. Must be unoccupied.
+         * @return Constructed state or nullptr if id does not name a state
+         */
+        FSMState* create(FSMStateId id, uint8_t slot);
+
+        /**
+         * @brief Marks the globals as changed. The write to NVS is deferred
+         * until no further change occurred for FSM_PERSIST_DELAY_MS, so bursts
+         * of changes (e.g., tapping through colors) result in a single write.
+         *
+         * @param now Current millis()
+         */
+        void schedulePersistGlobals(uint32_t now);
+
+        /**
+         * @brief Serializes the persisted fields of globals into a versioned,
+         * CRC protected blob
+         *
+         * @param blob Buffer of FSMGLOBALS_BLOB_SIZE bytes
+         */
+        void serializeGlobals(uint8_t* blob);
+
+        /**
+         * @brief Restores the persisted fields of globals from the given blob
+         *
+         * @param blob Buffer of FSMGLOBALS_BLOB_SIZE bytes
+         * @return True if version, length and CRC of the blob were valid
+         */
+        bool deserializeGlobals(const uint8_t* blob);
+
+        /**
+         * @brief Restores globals from the per-key layout used before the blob
+         *
+         * @return True if any legacy key was found
+         */
+        bool restoreLegacyGlobals();
 
     public:
 
@@ -73,16 +192,18 @@ class FSM {
         ~FSM();
 
         /**
-         * @brief Resumes the FSM to the last state according to NVS data
+         * @brief Resumes the FSM to the state and tick saved before deep sleep
+         * or, after a regular boot, to the last state according to NVS data
          */
         void resume();
 
         /**
-         * @brief Performs a transition to the given next state
+         * @brief Performs a transition to the given next state. The next state
+         * is constructed in place, no heap allocations are performed.
          * 
          * @param next The state to transition to.
          */
-        void transition(std::unique_ptr<FSMState> next);
+        void transition(FSMStateId next);
 
         /**
          * @brief Retrieves the tick rate of this FSM
@@ -92,10 +213,34 @@ class FSM {
         unsigned int getTickRateMs();
 
         /**
-         * @brief Enqueues the given event to be handled during the next cycle
+         * @brief Retrieves the name of the currently active state
+         *
+         * @return Name of the current state or "None" if no state is active
+         */
+        const char* getStateName();
+
+        /**
+         * @brief Enqueues the given event to be handled during the next cycle.
+         * Wait-free. Must only be called from a single context, the touch
+         * handlers executed by EFTouch.poll() in task context.
          */
         void queueEvent(FSMEvent event);
 
+        /**
+         * @brief Enqueues the given event to be handled during the next cycle.
+         * Wait-free. Must only be called from a single context, the touch
+         * handlers executed by EFTouch.poll() in task context.
+         *
+         * @param event Event to enqueue
+         * @param timestamp_us micros() at the time the event was captured
+         */
+        void queueEvent(FSMEvent event, uint32_t timestamp_us);
+
+        /**
+         * @brief Retrieves the number of events dropped because the queue was full
+         */
+        uint32_t getDroppedEventCount();
+
         /**
          * @brief Retrieves the number of FSMEvents currently waiting to be processed
          * 
@@ -103,6 +248,16 @@ class FSM {
          */
         unsigned int getQueueSize();
 
+        /**
+         * @brief Retrieves the milliseconds until handle() has actual work:
+         * queued events, a due run() of the current state, a running LED
+         * effect or a pending write of the globals
+         *
+         * @param now Current time in milliseconds
+         * @return Milliseconds until the next deadline, 0 if work is pending
+         */
+        uint32_t getTimeUntilNextDeadline(uint32_t now);
+
         /**
          * @brief Execute a processing cycle. Processes all events that are currently queued.
          */
@@ -118,9 +273,26 @@ class FSM {
 
         /**
          * @brief Presists the current globals state of this FSM to the NVS partition
+         * immediately. Does not touch the flash if the persisted data is unchanged.
          */
         void persistGlobals();
 
+        /**
+         * @brief Retrieves the number of times globals were marked for persisting
+         */
+        uint32_t getPersistRequestCount();
+
+        /**
+         * @brief Retrieves the number of NVS writes performed for globals
+         */
+        uint32_t getPersistWriteCount();
+
+        /**
+         * @brief Retrieves the number of requested globals writes that were
+         * coalesced or skipped because the data was unchanged
+         */
+        uint32_t getPersistAvoidedCount();
+
         /**
          * @brief Loads the globals state from the NVS partition and recovers it into current
          * globals FSM state
@@ -28,6 +28,7 @@
  */
 
 #include <Arduino.h>
+#include <EFTouchZone.h>
 
 /**
  * @brief Events the FSM is sensitive to
@@ -44,6 +45,64 @@ enum class FSMEvent {
     NoseRelease,
     NoseShortpress,
     NoseLongpress,
+    FingerprintHold,
+    NoseHold,
+};
+
+/**
+ * @brief Retrieves the name of the given event
+ */
+constexpr const char* toString(FSMEvent event) {
+    switch (event) {
+        case FSMEvent::NoOp: return "NoOp";
+        case FSMEvent::AllShortpress: return "AllShortpress";
+        case FSMEvent::AllLongpress: return "AllLongpress";
+        case FSMEvent::FingerprintTouch: return "FingerprintTouch";
+        case FSMEvent::FingerprintRelease: return "FingerprintRelease";
+        case FSMEvent::FingerprintShortpress: return "FingerprintShortpress";
+        case FSMEvent::FingerprintLongpress: return "FingerprintLongpress";
+        case FSMEvent::NoseTouch: return "NoseTouch";
+        case FSMEvent::NoseRelease: return "NoseRelease";
+        case FSMEvent::NoseShortpress: return "NoseShortpress";
+        case FSMEvent::NoseLongpress: return "NoseLongpress";
+        case FSMEvent::FingerprintHold: return "FingerprintHold";
+        case FSMEvent::NoseHold: return "NoseHold";
+        default: return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Determines the touch zone an event originates from
+ *
+ * @param event Event to determine the zone of
+ * @return Source zone. EFTouchZone::All for multi-touch events and NoOp.
+ */
+constexpr EFTouchZone toZone(FSMEvent event) {
+    switch (event) {
+        case FSMEvent::FingerprintTouch:
+        case FSMEvent::FingerprintRelease:
+        case FSMEvent::FingerprintShortpress:
+        case FSMEvent::FingerprintLongpress:
+        case FSMEvent::FingerprintHold:
+            return EFTouchZone::Fingerprint;
+        case FSMEvent::NoseTouch:
+        case FSMEvent::NoseRelease:
+        case FSMEvent::NoseShortpress:
+        case FSMEvent::NoseLongpress:
+        case FSMEvent::NoseHold:
+            return EFTouchZone::Nose;
+        default:
+            return EFTouchZone::All;
+    }
+}
+
+/**
+ * @brief An FSMEvent together with the moment and place it was captured
+ */
+struct FSMEventData {
+    FSMEvent type;          //!< Type of the event
+    EFTouchZone zone;       //!< Touch zone the event originates from
+    uint32_t timestamp_us;  //!< micros() at the time the touch edge was captured or the gesture completed
 };
 
 #endif /* FSMEVENT_H_ */
\ No newline at end of file
@@ -29,30 +29,47 @@
 
 #include <Arduino.h>
 
+#define FSMGLOBALS_BLOB_VERSION 1  //!< Layout version of the persisted globals blob. Bump on any change to FSMGLOBALS_PERSISTED_FIELDS.
+
+/**
+ * @brief Single declaration of all FSMGlobals members that are persisted to NVS
+ *
+ * Each entry is X(type, name, default, legacy_key). legacy_key is the NVS key
+ * the value was stored under before the globals were persisted as a single
+ * blob, or nullptr for fields added afterwards. Changing this list changes
+ * the blob layout and requires bumping FSMGLOBALS_BLOB_VERSION.
+ */
+#define FSMGLOBALS_PERSISTED_FIELDS(X) \
+    X(uint8_t, resumeStateIdx,        0,  "resumeStateIdx")  /* Index of the state that should be resumed upon reboot */ \
+    X(uint8_t, menuMainPointerIdx,    0,  "menuIdx")         /* MenuMain: Index of the menu cursor */ \
+    X(uint8_t, ledBrightnessPercent,  40, "ledBrightPcent")  /* The current brightness percentage of the LEDs */ \
+    X(uint8_t, prideFlagModeIdx,      1,  "prideFlagMode")   /* DisplayPrideFlag: Mode selector */ \
+    X(uint8_t, animRainbowIdx,        0,  "animRainbow")     /* AnimateRainbow: Mode selector */ \
+    X(uint8_t, animSnakeAnimationIdx, 0,  "animSnakeIdx")    /* AnimateSnake: Mode selector */ \
+    X(uint8_t, animSnakeHueIdx,       0,  "animSnakeHueIdx") /* AnimateSnake: Hue selector */ \
+    X(uint8_t, animHeartbeatHue,      0,  "animHbHue")       /* AnimateHeartbeat: Hue selector */ \
+    X(uint8_t, animHeartbeatSpeed,    1,  "animHbSpeed")     /* AnimateHeartbeat: Speed selector */ \
+    X(uint8_t, animMatrixIdx,         0,  "animMatrixIdx")   /* AnimateMatrix: Color selector */ \
+    X(uint8_t, huemeshOwnHue,         0,  "huemeshOwnHue")   /* GameHuemesh: Own hue selector */
+
 /**
  * @brief Internal data structure used by the FSM to allows carrying data over
  * between states and allows it to be persisted to the non-volatile storage (NVS).
  *
- * @warning If you want your data to be persisted to NVS, you need to add it to
- * FSM::persistGlobals() and FSM::restoreGlobals() respectively.
+ * @note If you want your data to be persisted to NVS, declare it inside
+ * FSMGLOBALS_PERSISTED_FIELDS instead of directly within this struct.
  */
 typedef struct {
-    uint8_t resumeStateIdx = 0;        //!< Index of the state that should be resumed upon reboot
-    uint8_t menuMainPointerIdx = 0;    //!< MenuMain: Index of the menu cursor
-    uint8_t ledBrightnessPercent = 40; //!< The current brightness percentage of the LEDs
-
-    uint8_t prideFlagModeIdx = 1;   //!< DisplayPrideFlag: Mode selector
-    uint8_t animRainbowIdx = 0;     //!< AnimateRainbow: Mode selector
-    uint8_t animSnakeAnimationIdx = 0; //!< AnimateSnake: Mode selector
-    uint8_t animSnakeHueIdx = 0;       //!< AnimateSnake: Mode selector
-    uint8_t animHeartbeatHue = 0;   //!< AnimateHeartbeat: Hue selector
-    uint8_t animHeartbeatSpeed = 1; //!< AnimateHeartbeat: Speed selector
-    uint8_t animMatrixIdx = 0;      //!< AnimateMatrix: Color selector
-	uint8_t animPerlinSpeed    = 1;     //!< AnimatePerlin: Speed selector
-    uint8_t customIdx = 0;              //!< Custom: Mode selector
-
-	uint8_t huemeshOwnHue = 0;	//!< GameHuemesh: Own hue smelector
+#define FSMGLOBALS_DECLARE_FIELD(type, name, value, legacy_key) type name = value;
+    FSMGLOBALS_PERSISTED_FIELDS(FSMGLOBALS_DECLARE_FIELD)
+#undef FSMGLOBALS_DECLARE_FIELD
 
+    uint8_t animPerlinSpeed = 1;    //!< AnimatePerlin: Speed selector
+    uint8_t customIdx = 0;          //!< Custom: Mode selector
 } FSMGlobals;
 
+#define FSMGLOBALS_FIELD_SIZE(type, name, value, legacy_key) + sizeof(type)
+#define FSMGLOBALS_PAYLOAD_SIZE (0 FSMGLOBALS_PERSISTED_FIELDS(FSMGLOBALS_FIELD_SIZE))  //!< Bytes of persisted field data
+#define FSMGLOBALS_BLOB_SIZE (2 + FSMGLOBALS_PAYLOAD_SIZE + 4)  //!< Blob size: version, payload length, payload, CRC32
+
 #endif /* FSMGLOBALS_H_ */
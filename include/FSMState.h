@@ -27,10 +27,29 @@
  * @author Honigeintopf
  */
 
-#include <memory>
+#include <EFGovernor.h>
 
 #include "FSMGlobals.h"
 
+/**
+ * @brief Identifies an FSM state. Touch handlers return the state to transition
+ * to, the FSM constructs it in place.
+ */
+enum class FSMStateId : uint8_t {
+    None,              //!< No transition / no state
+    DisplayPrideFlag,
+    AnimateRainbow,
+    AnimateMatrix,
+    AnimateSnake,
+    AnimateHeartbeat,
+    AnimatePerlin,
+    OTAUpdate,
+    GameHuemesh,
+    GameFoxHuntBle,
+    VUMeter,
+    MenuMain,
+    DeepSleep,
+};
 
 /**
  * @brief Base class for FSM states
@@ -39,15 +58,19 @@ class FSMState {
 
     protected:
     
-        std::shared_ptr<FSMGlobals> globals;  //!< Pointer to global FSM state variables
+        FSMGlobals* globals;                  //!< Pointer to global FSM state variables, owned by the FSM
         bool is_globals_dirty;                //!< Marks globals as dirty, causing it to be persisted to NVS
         bool is_locked;                       //!< True, if the state should be considered as locked
+        uint32_t tick = 0;                    //!< Animation step of the state, advanced by run()
 
     public:
+
+        virtual ~FSMState() {}
+
         /**
          * @brief Sets the reference on the global FSM data struct
          */
-        void attachGlobals(std::shared_ptr<FSMGlobals> globals);
+        void attachGlobals(FSMGlobals* globals);
 
         /**
          * @brief Determines, if the globals struct was modified and requires
@@ -84,6 +107,17 @@ class FSMState {
          */
         bool isLocked();
 
+        /**
+         * @brief Retrieves the animation step of this state
+         */
+        uint32_t getTick();
+
+        /**
+         * @brief Continues the animation at the given step, e.g., when resuming
+         * after deep sleep. Called after entry().
+         */
+        void setTick(uint32_t tick);
+
         /**
          * @brief Provides access to the name of this state
          * 
@@ -107,6 +141,22 @@ class FSMState {
          */
         virtual const unsigned int getTickRateMs();
 
+        /**
+         * @brief Provides access to the performance class of this state
+         *
+         * @return CPU frequency range EFGovernor selects from while this
+         * state is active
+         */
+        virtual EFGovernorPerf getPerfClass();
+
+        /**
+         * @brief Determines if the FSM may put the badge to deep sleep after
+         * FSM_SLEEP_INACTIVITY_MS without touch input while this state is active
+         *
+         * @return False, if this state is busy without user interaction
+         */
+        virtual bool allowsInactivitySleep();
+
         /**
          * @brief Executed on state entry 
          */
@@ -125,80 +175,89 @@ class FSMState {
         /**
          * @brief Executed on FSMEvent::FingerprintTouch
          */
-        virtual std::unique_ptr<FSMState> touchEventFingerprintTouch();
+        virtual FSMStateId touchEventFingerprintTouch();
 
         /**
          * @brief Executed on FSMEvent::FingerprintRelease
          */
-        virtual std::unique_ptr<FSMState> touchEventFingerprintRelease();
+        virtual FSMStateId touchEventFingerprintRelease();
 
         /**
          * @brief Executed on FSMEvent::FingerprintShortpress
          */
-        virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress();
+        virtual FSMStateId touchEventFingerprintShortpress();
 
         /**
          * @brief Executed on FSMEvent::FingerprintLongpress
          */
-        virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress();
+        virtual FSMStateId touchEventFingerprintLongpress();
+
+        /**
+         * @brief Executed on FSMEvent::FingerprintHold
+         */
+        virtual FSMStateId touchEventFingerprintHold();
 
         /**
          * @brief Executed on FSMEvent::NoseTouch
          */
-        virtual std::unique_ptr<FSMState> touchEventNoseTouch();
+        virtual FSMStateId touchEventNoseTouch();
 
         /**
          * @brief Executed on FSMEvent::NoseRelease
          */
-        virtual std::unique_ptr<FSMState> touchEventNoseRelease();
+        virtual FSMStateId touchEventNoseRelease();
 
         /**
          * @brief Executed on FSMEvent::NoseShortpress
          */
-        virtual std::unique_ptr<FSMState> touchEventNoseShortpress();
+        virtual FSMStateId touchEventNoseShortpress();
 
         /**
          * @brief Executed on FSMEvent::NoseLongpress
          */
-        virtual std::unique_ptr<FSMState> touchEventNoseLongpress();
+        virtual FSMStateId touchEventNoseLongpress();
+
+        /**
+         * @brief Executed on FSMEvent::NoseHold
+         */
+        virtual FSMStateId touchEventNoseHold();
 
         /**
          * @brief Executed on FSMEvent::AllShortpress
          */
-        virtual std::unique_ptr<FSMState> touchEventAllShortpress();
+        virtual FSMStateId touchEventAllShortpress();
 
         /**
          * @brief Executed on FSMEvent::AllLongpress
          */
-        virtual std::unique_ptr<FSMState> touchEventAllLongpress();
+        virtual FSMStateId touchEventAllLongpress();
 };
 
 /**
  * @brief Displays pride flags
  */
 struct DisplayPrideFlag : public FSMState {
-    uint32_t tick = 0;
     uint8_t flagidx = 0;
     unsigned int switchdelay_ms = 5000;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
     virtual const unsigned int getTickRateMs() override;
+    virtual EFGovernorPerf getPerfClass() override;
 
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 };
 
 /**
  * @brief Displays rainbow animations
  */
 struct AnimateRainbow : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
@@ -207,10 +266,10 @@ struct AnimateRainbow : public FSMState {
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 
     void _animateRainbow();
     void _animateRainbowCircle();
@@ -220,7 +279,6 @@ struct AnimateRainbow : public FSMState {
  * @brief Displays matrix animation
  */
 struct AnimateMatrix : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
@@ -229,17 +287,16 @@ struct AnimateMatrix : public FSMState {
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 };
 
 /**
  * @brief Displays snake animations
  */
 struct AnimateSnake : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
@@ -248,10 +305,10 @@ struct AnimateSnake : public FSMState {
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 
     void _animateSnake();
     void _animateKnightRider();
@@ -265,7 +322,6 @@ struct AnimateSnake : public FSMState {
  * @brief Displays pulsing color
  */
 struct AnimateHeartbeat : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
@@ -274,18 +330,17 @@ struct AnimateHeartbeat : public FSMState {
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventNoseRelease() override;
+    virtual FSMStateId touchEventNoseShortpress() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 };
 
 /**
  * @brief Displays perlin-noise pattern
  */
 struct AnimatePerlin : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
@@ -294,8 +349,8 @@ struct AnimatePerlin : public FSMState {
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseShortpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventNoseShortpress() override;
 };
 
 /**
@@ -303,65 +358,66 @@ struct AnimatePerlin : public FSMState {
  */
 struct OTAUpdate : public FSMState {
     virtual const char* getName() override;
+    virtual EFGovernorPerf getPerfClass() override;
+    virtual bool allowsInactivitySleep() override;
 
     virtual void entry() override;
     virtual void run() override;
     virtual void exit() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
 };
 
 /**
  * @brief HuemeshGame
  */
 struct GameHuemesh : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
+    virtual EFGovernorPerf getPerfClass() override;
 
     virtual void entry() override;
     virtual void run() override;
 	virtual void exit() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-	virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-	virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-	virtual std::unique_ptr<FSMState> touchEventNoseShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseLongpress() override;
-	virtual std::unique_ptr<FSMState> touchEventNoseRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+	virtual FSMStateId touchEventFingerprintLongpress() override;
+	virtual FSMStateId touchEventFingerprintRelease() override;
+	virtual FSMStateId touchEventNoseShortpress() override;
+    virtual FSMStateId touchEventNoseLongpress() override;
+	virtual FSMStateId touchEventNoseRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 };
 
 /**
  * @brief Fox-hunt (BLE RSSI) game
  */
 struct GameFoxHuntBle : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
+    virtual EFGovernorPerf getPerfClass() override;
 
     virtual void entry() override;
     virtual void run() override;
     virtual void exit() override;
 
     // Touch routing (same signature style as your other states)
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-	virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-	virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-	virtual std::unique_ptr<FSMState> touchEventNoseShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseLongpress() override;
-	virtual std::unique_ptr<FSMState> touchEventNoseRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+	virtual FSMStateId touchEventFingerprintLongpress() override;
+	virtual FSMStateId touchEventFingerprintRelease() override;
+	virtual FSMStateId touchEventNoseShortpress() override;
+    virtual FSMStateId touchEventNoseLongpress() override;
+	virtual FSMStateId touchEventNoseRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 };
 
 /**
  * @brief Displays matrix animation
  */
 struct VUMeter : public FSMState {
-    uint32_t tick = 0;
 
     virtual const char* getName() override;
     virtual bool shouldBeRemembered() override;
@@ -369,10 +425,10 @@ struct VUMeter : public FSMState {
     virtual void entry() override;
     virtual void run() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventAllLongpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintRelease() override;
+    virtual FSMStateId touchEventAllLongpress() override;
 };
 
 /**
@@ -380,7 +436,14 @@ struct VUMeter : public FSMState {
  */
 struct MenuMain : public FSMState {
     uint8_t menucursor_idx = 0;
-    uint32_t tick = 0;
+    int8_t brightness_direction = 0;  //!< Direction of the current brightness scrub
+    uint8_t scrub_ticks = 0;          //!< Remaining ticks the brightness bar is shown instead of the cursor
+
+    /**
+     * @brief Moves the LED brightness one step into brightness_direction and
+     * shows it on the EF bar
+     */
+    void scrubBrightness();
 
     virtual const char* getName() override;
     virtual const unsigned int getTickRateMs() override;
@@ -389,12 +452,26 @@ struct MenuMain : public FSMState {
     virtual void run() override;
     virtual void exit() override;
 
-    virtual std::unique_ptr<FSMState> touchEventFingerprintRelease() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventFingerprintLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseLongpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseShortpress() override;
-    virtual std::unique_ptr<FSMState> touchEventNoseRelease() override;
+    virtual FSMStateId touchEventFingerprintRelease() override;
+    virtual FSMStateId touchEventFingerprintShortpress() override;
+    virtual FSMStateId touchEventFingerprintLongpress() override;
+    virtual FSMStateId touchEventNoseLongpress() override;
+    virtual FSMStateId touchEventNoseHold() override;
+    virtual FSMStateId touchEventNoseShortpress() override;
+    virtual FSMStateId touchEventNoseRelease() override;
+};
+
+/**
+ * @brief Turns off the LEDs and puts the badge into deep sleep until the
+ * fingerprint is touched
+ */
+struct DeepSleep : public FSMState {
+    virtual const char* getName() override;
+    virtual const unsigned int getTickRateMs() override;
+    virtual EFGovernorPerf getPerfClass() override;
+
+    virtual void entry() override;
+    virtual void run() override;
 };
 
 #endif /* FSM_STATE_H_ */
@@ -26,41 +26,149 @@
 #include <EFConfig.h>
 #include <Arduino.h>
 #include <ArduinoOTA.h>
+#include <Preferences.h>
 #include <WiFi.h>
 
+#include <EFEnergy.h>
+#include <EFGovernor.h>
 #include <EFLed.h>
+#include <EFIdle.h>
 #include <EFLogging.h>
+#include <EFProfiler.h>
+#include <EFRadio.h>
+#include <EFTouch.h>
+#include <EFTouchRecorder.h>
+#include <EFTrace.h>
 
 #include "EFBoard.h"
 #include "EFSettings.h"
 
 static String s_rxLine;  // << add
 
+#define EFBOARD_RESUME_MAGIC 0x45465253  //!< Marks a valid resume point in RTC memory ("EFRS")
+#define EFBOARD_NVS_NAMESPACE "efbat"      //!< NVS namespace of the learned discharge curve
+#define EFBOARD_NVS_KEY_CURVE "curve"      //!< NVS key of the learned discharge curve
+
+/**
+ * @brief State to resume to after deep sleep. Kept in RTC memory, which
+ * survives deep sleep but not a reset or power loss.
+ */
+struct EFBoardResumePoint {
+    uint32_t magic;  //!< EFBOARD_RESUME_MAGIC if state and tick are valid
+    uint32_t tick;   //!< Animation step of the state
+    uint8_t state;   //!< FSMStateId of the state
+};
+
 RTC_DATA_ATTR uint32_t bootCount = 0;
+RTC_DATA_ATTR EFBoardResumePoint resumePoint = {0, 0, 0};
+RTC_DATA_ATTR EFBoardBrownOutRecord brownOutRecord = {0, 0, 0, 0, 0};
+
+/**
+ * @brief Takes a burst of calibrated ADC readings of V_BAT
+ *
+ * @return Median of the burst in mV, without sag compensation
+ */
+static uint32_t readBatteryMilliVolts() {
+    // Voltage divider resistors in 100 Ohm: R11 = 51.1k, R12 = 100k
+    constexpr uint32_t R1 = 511;
+    constexpr uint32_t R2 = 1000;
+
+    // analogReadMilliVolts() converts using the ADC calibration burnt into eFuse
+    uint32_t readings[EFBOARD_VBAT_BURST];
+    for (uint8_t i = 0; i < EFBOARD_VBAT_BURST; i++) {
+        readings[i] = analogReadMilliVolts(EFBOARD_PIN_VBAT);
+    }
+    return EFBoardBattery::median(readings, EFBOARD_VBAT_BURST) * (R1 + R2) / R2;
+}
+
+/**
+ * @brief Hardware access of the hard brown out cycle
+ */
+class EFBoardBrownOutHardware : public EFBoardBrownOutPlatform {
+
+    public:
+
+        bool leds_ready = false;  //!< EFLed was initialized by main, false right after boot
+
+        uint32_t readBatteryMilliVolts() override {
+            analogReadResolution(12);
+            pinMode(EFBOARD_PIN_VBAT, INPUT);
+            return ::readBatteryMilliVolts();
+        }
+
+        void blink(uint32_t duration_ms) override {
+            if (!this->leds_ready) {
+                EFLed.init();
+                this->leds_ready = true;
+            }
+            EFLed.setBrightnessPercent(30);
+            EFLed.clear();
+            EFLed.enablePower();
+            EFLed.setDragonNose(CRGB::Red);
+            delay(duration_ms);
+            EFLed.disablePower();
+        }
+
+        void deepSleep(uint32_t duration_ms) override {
+            // Touch wakeup might still be armed by EFIdle
+            esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+            esp_sleep_enable_timer_wakeup(duration_ms * 1000ULL);
+            EFBOARD_SERIAL_DEVICE.flush();
+            esp_deep_sleep_start();
+        }
+};
+
+static EFBoardBrownOutHardware brownOutHardware;
+static EFBoardBrownOut brownOut(
+    brownOutHardware, brownOutRecord,
+    EFBOARD_BROWN_OUT_RECOVER * 1000, EFBOARD_BROWN_OUT_INTERVAL_MS, EFBOARD_BROWN_OUT_BLINK_MS
+);
 
 volatile int8_t ota_last_progress = -1;
 
 EFBoardClass::EFBoardClass()
-    : power_state(EFBoardPowerState::UNKNOWN) {
-    bootCount++;
+    : power_state(EFBoardPowerState::UNKNOWN)
+    , battery({EFBOARD_BAT_RESISTANCE_MOHM, 5000, EFBOARD_BOOST_EFFICIENCY_PERCENT})
+    , battery_voltage(0.0f)
+    , battery_percent(0)
+    , battery_powered(false)
+    , discharge_curve(EFBOARD_VBAT_LEARN_FULL * 1000, EFBOARD_VBAT_LEARN_EMPTY * 1000) {
 }
 
 void EFBoardClass::setup() {
+    bootCount++;
+
     // Setup serial
     // If flashing often fails, you can add a safety-backoff delay before running serial which helps with flashing
     //delay(2000);
     EFBOARD_SERIAL_DEVICE.begin(EFBOARD_SERIAL_BAUD);
-    delay(50);
+
+    // A pending hard brown out only blinks, checks V_BAT and deep sleeps again
+    const EFBoardBrownOutStep brownout_step = brownOut.wakeup();
+
     EFSettings::begin();
-    LOG("\r\n");
-    this->printCredits();
-    LOG("\r\n");
+    if (!this->isResuming()) {
+        // Waking up from deep sleep must be quick, nobody watches the console then
+        delay(50);
+        LOG("\r\n");
+        this->printCredits();
+        LOG("\r\n");
+    }
 
     // Board initialization process
     LOG_INFO("(EFBoard) Initializing badge ...");
     LOGF_INFO("(EFBoard) Boot #%d - %s\r\n", this->getWakeupCount(), this->getWakeupReason());
     LOGF_INFO("(EFBoard) Firmware version: %s (compiled: %s @ %s)\r\n", EFBOARD_FIRMWARE_VERSION, __DATE__, __TIME__);
     LOGF_INFO("(EFBoard) Battery type: %s\r\n", EFBOARD_BAT_TYPE_NAME);
+    if (brownout_step == EFBoardBrownOutStep::Recovered) {
+        LOGF_WARNING(
+            "(EFBoard) Recovered from hard brown out (%s, V_BAT = %.2f V -> %.2f V after %lu wakeups)\r\n",
+            toString(static_cast<EFBoardBrownOutReason>(brownOutRecord.reason)),
+            brownOutRecord.detected_mv / 1000.0f,
+            brownOutRecord.last_mv / 1000.0f,
+            (unsigned long) brownOutRecord.wakeups
+        );
+    }
 
     // CPU frequency
     LOGF_DEBUG("(EFBoard) Initial CPU frequency: %d\r\n", getCpuFrequencyMhz());
@@ -72,6 +180,17 @@ void EFBoardClass::setup() {
     LOG_DEBUG("(EFBoard) Set ADC read resolution to: 12 bit");
     pinMode(EFBOARD_PIN_VBAT, INPUT);
     LOG_INFO("(EFBoard) Initialized battery sense ADC")
+    this->battery.reset();
+    {
+        Preferences pref;
+        EFBoardDischargeCurveData data;
+        pref.begin(EFBOARD_NVS_NAMESPACE, true);
+        if (pref.getBytes(EFBOARD_NVS_KEY_CURVE, &data, sizeof(data)) == sizeof(data) && this->discharge_curve.restore(data)) {
+            LOGF_INFO("(EFBoard) Restored discharge curve: %u mAh\r\n", this->discharge_curve.getCapacityMah());
+        }
+        pref.end();
+    }
+    this->sampleBattery();
 
     // Seed rnd
     randomSeed(analogRead(0));
@@ -81,12 +200,7 @@ void EFBoardClass::setup() {
     const EFBoardPowerState pwrstate = this->getPowerState();
     if (pwrstate == EFBoardPowerState::BAT_BROWN_OUT_HARD) {
         LOGF_ERROR("(EFBoard) HARD BROWN OUT DETECTED (V_BAT = %.2f V). Panic!\r\n", this->getBatteryVoltage());
-        while (1) {
-            // TODO: use actual hard brownout code here
-            // sleep most of the time.
-            esp_sleep_enable_timer_wakeup(5 * 1000000);
-            esp_light_sleep_start();
-        }
+        this->hardBrownOut(EFBoardBrownOutReason::Boot);
     } else if (pwrstate == EFBoardPowerState::BAT_BROWN_OUT_SOFT) {
         LOGF_WARNING("(EFBoard) Soft brown out detected (V_BAT = %.2f V)\r\n", this->getBatteryVoltage());
     }
@@ -99,7 +213,7 @@ void EFBoardClass::setup() {
     }
 
     // Wifi modem stuff
-    this->disableWifi();
+    EFRadio.shutdown();
     this->disableOTA();
     //this->enableOTA();
 
@@ -122,6 +236,42 @@ unsigned int EFBoardClass::getWakeupCount() {
     return bootCount;
 }
 
+bool EFBoardClass::isResuming() {
+    // Only the fingerprint wakes the badge from DeepSleep, timer wakeups belong to a hard brown out
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TOUCHPAD && resumePoint.magic == EFBOARD_RESUME_MAGIC;
+}
+
+void EFBoardClass::setResumePoint(uint8_t state, uint32_t tick) {
+    resumePoint.state = state;
+    resumePoint.tick = tick;
+    resumePoint.magic = EFBOARD_RESUME_MAGIC;
+}
+
+bool EFBoardClass::getResumePoint(uint8_t& state, uint32_t& tick) {
+    if (!this->isResuming()) {
+        return false;
+    }
+    state = resumePoint.state;
+    tick = resumePoint.tick;
+    resumePoint.magic = 0;
+    return true;
+}
+
+void EFBoardClass::deepSleep() {
+    LOGF_INFO("(EFBoard) Entering deep sleep after %lu ms\r\n", (unsigned long) millis());
+    // The timer wakeup armed by EFIdle would end deep sleep right away
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    EFTouch.enableWakeup(EFTouchZone::Fingerprint);
+    EFBOARD_SERIAL_DEVICE.flush();
+    esp_deep_sleep_start();
+}
+
+void EFBoardClass::hardBrownOut(EFBoardBrownOutReason reason) {
+    // LEDs are only initialized once setup() is done
+    brownOutHardware.leds_ready = reason == EFBoardBrownOutReason::Runtime;
+    brownOut.enter(reason, this->battery.getMilliVolts());
+}
+
 const char *EFBoardClass::getWakeupReason() {
     esp_sleep_wakeup_cause_t wakeup_reason;
     wakeup_reason = esp_sleep_get_wakeup_cause();
@@ -154,50 +304,68 @@ const char *EFBoardClass::getWakeupReason() {
     }
 }
 
-const float EFBoardClass::getBatteryVoltage() {
-    // Voltage divider resistors: R11 = 51.1k, R12 = 100k
-    constexpr float R1 = 51.1f;
-    constexpr float R2 = 100.0f;
-    constexpr float ADC_MAX_VALUE = 4095.0f;
-    constexpr float ADC_REF_VOLTAGE = 3.5f; // Reference voltage for ADC. Should be 3.3V, but the results are wonky. 3.5 works better
-    constexpr float voltage_divider_factor = (R1 + R2) / R2;
-    constexpr int NUM_SAMPLES = 10;
-
-    // Static variables retain their values between function calls
-    static float samples[NUM_SAMPLES] = {0.0f};
-    static int index = 0;
-    static int count = 0;
-
-    float battery_voltage = (analogRead(EFBOARD_PIN_VBAT) * (ADC_REF_VOLTAGE / ADC_MAX_VALUE)) * voltage_divider_factor;
-
-    // Insert into circular buffer
-    samples[index] = battery_voltage;
-    index = (index + 1) % NUM_SAMPLES;
-    if (count < NUM_SAMPLES) count++;
-
-    // Compute average
-    float sum = 0.0f;
-    for (int i = 0; i < count; i++) {
-        sum += samples[i];
+void EFBoardClass::sampleBattery() {
+    this->battery.update(readBatteryMilliVolts(), EFLed.getEstimatedMilliamps());
+
+    this->battery_voltage = this->battery.getMilliVolts() / 1000.0f;
+    this->battery_powered = this->battery_voltage > EFBOARD_VBAT_MIN - 0.5;
+    if (this->discharge_curve.isLearned()) {
+        this->battery_percent = this->discharge_curve.getPercent(this->battery.getMilliVolts());
+        return;
     }
+#ifdef EFBOARD_BAT_TYPE_LIION
+    this->battery_percent = this->getBatteryCapacityLiIonPercent();
+#elif defined(EFBOARD_BAT_TYPE_ALKALINE)
+    this->battery_percent = this->getBatteryCapacityAlkalinePercent();
+#else
+    #error "No battery type defined! Define EFBOARD_BAT_TYPE_LIION or EFBOARD_BAT_TYPE_ALKALINE"
+#endif
+}
 
-    float average_voltage = sum / count;
-    return average_voltage;
+const float EFBoardClass::getBatteryVoltage() {
+    return this->battery_voltage;
 }
 
 const bool EFBoardClass::isBatteryPowered() {
-    return this->getBatteryVoltage() > EFBOARD_VBAT_MIN - 0.5;
+    return this->battery_powered;
 }
 
 const uint8_t EFBoardClass::getBatteryCapacityPercent() {
+    return this->battery_percent;
+}
 
-#ifdef EFBOARD_BAT_TYPE_LIION
-    return this->getBatteryCapacityLiIonPercent();
-#elif defined(EFBOARD_BAT_TYPE_ALKALINE)
-    return this->getBatteryCapacityAlkalinePercent();
-#else
-    #error "No battery type defined! Define EFBOARD_BAT_TYPE_LIION or EFBOARD_BAT_TYPE_ALKALINE"
-#endif
+void EFBoardClass::learnDischarge(uint32_t drained_mah) {
+    if (!this->isBatteryPowered()) {
+        return;
+    }
+    if (this->discharge_curve.update(this->battery.getMilliVolts(), drained_mah)) {
+        Preferences pref;
+        const EFBoardDischargeCurveData& data = this->discharge_curve.getData();
+        pref.begin(EFBOARD_NVS_NAMESPACE, false);
+        pref.putBytes(EFBOARD_NVS_KEY_CURVE, &data, sizeof(data));
+        pref.end();
+        if (data.session_next == 0) {
+            LOGF_INFO("(EFBoard) Learned discharge, capacity: %u mAh\r\n", this->discharge_curve.getCapacityMah());
+        } else {
+            LOGF_DEBUG("(EFBoard) Discharge point %u crossed\r\n", data.session_next - 1);
+        }
+    }
+}
+
+const EFBoardDischargeCurve& EFBoardClass::getDischargeCurve() const {
+    return this->discharge_curve;
+}
+
+void EFBoardClass::resetDischargeCurve() {
+    Preferences pref;
+    this->discharge_curve.reset();
+    pref.begin(EFBOARD_NVS_NAMESPACE, false);
+    pref.remove(EFBOARD_NVS_KEY_CURVE);
+    pref.end();
+}
+
+const uint16_t EFBoardClass::getBatteryCapacityMah() {
+    return this->discharge_curve.isLearned() ? this->discharge_curve.getCapacityMah() : EFBOARD_BAT_CAPACITY_MAH;
 }
 
 const uint8_t EFBoardClass::getBatteryCapacityLiIonPercent() {
@@ -243,20 +411,8 @@ const EFBoardPowerState EFBoardClass::updatePowerState() {
     if (!this->isBatteryPowered()) {
         this->power_state = EFBoardPowerState::USB;
     } else {
-        float vbat = this->getBatteryVoltage();
-
-        if (vbat <= EFBOARD_BROWN_OUT_SOFT) {
-            // A low-battery state could be a momentary spike
-            // We take multiple samples to make sure we are really low on battery
-            float sum = 0.0f;
-            constexpr uint8_t samples = 5;
-            for (uint8_t i = 0; i < samples; i++) {
-                sum += this->getBatteryVoltage();
-                delay(1);
-            }
-            vbat = sum / samples;
-            LOGF("BATTERY: Measurement average: %f\r\n", vbat);
-        }
+        // Momentary spikes are already filtered out by sampleBattery()
+        const float vbat = this->getBatteryVoltage();
 
         if (vbat <= EFBOARD_BROWN_OUT_HARD || this->power_state == EFBoardPowerState::BAT_BROWN_OUT_HARD) {
             this->power_state = EFBoardPowerState::BAT_BROWN_OUT_HARD;
@@ -314,16 +470,17 @@ bool EFBoardClass::connectToWifi(const char *ssid, const char *password) {
     return true;
 }
 
-bool EFBoardClass::disableWifi() {
-    WiFi.disconnect(true, true);
-    if (!WiFi.enableSTA(false)) {
-        LOG_ERROR("(EFBoard) Failed to disable WiFi");
-        return false;
-    }
-
-    LOG_INFO("(EFBoard) Disabled WiFi");
-    return true;
-}
+/**
+ * @brief Blinks the dragons eye green three times after a successful OTA update
+ */
+static const EFLedKeyframe effect_ota_done[] = {
+    {EFLedMask::EYE, CRGB::Green, 500, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 500, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Green, 500, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 500, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Green, 500, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 500, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+};
 
 void EFBoardClass::enableOTA(const char *password) {
     LOG_INFO("(EFBoard) Initializing OTA ... ");
@@ -353,12 +510,9 @@ void EFBoardClass::enableOTA(const char *password) {
             })
             .onEnd([]() {
                 LOG_INFO("(OTA) Finished! Rebooting ...");
-                for (uint8_t i = 0; i < 3; i++) {
-                    EFLed.setDragonEye(CRGB::Green);
-                    delay(500);
-                    EFLed.setDragonEye(CRGB::Black);
-                    delay(500);
-                }
+                // The badge reboots right after this callback, so play the effect to the end here
+                EFLed.playEffect(effect_ota_done);
+                EFLed.finishEffect();
                 EFLed.clear();
             })
             .onProgress([](unsigned int progress, unsigned int total) {
@@ -484,6 +638,210 @@ void EFBoardClass::handleConsoleLine(const String& ln) {
     } else if (ln == "RESET NAME") {
         EFSettings::resetName();
         EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET LED") {
+        EFBOARD_SERIAL_DEVICE.printf(
+            "shows/s=%u shows=%lu skipped=%lu coalesced=%lu dropped=%lu limited=%lu mA=%u\r\n",
+            EFLed.getShowsPerSecond(),
+            (unsigned long) EFLed.getShowCount(),
+            (unsigned long) EFLed.getSkippedFrameCount(),
+            (unsigned long) EFLed.getCoalescedFrameCount(),
+            (unsigned long) EFLed.getDroppedFrameCount(),
+            (unsigned long) EFLed.getLimitedFrameCount(),
+            EFLed.getEstimatedMilliamps()
+        );
+    } else if (ln == "GET SCHED") {
+        for (uint8_t i = 0; i < EFScheduler.getTaskCount(); i++) {
+            const EFSchedulerTask* task = EFScheduler.getTask(i);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%s period=%lu policy=%s runs=%lu missed=%lu\r\n",
+                task->getName(),
+                (unsigned long) task->getPeriodMs(),
+                toString(task->getPolicy()),
+                (unsigned long) task->getRunCount(),
+                (unsigned long) task->getMissedCount()
+            );
+            this->printHistogram("  late", task->getLateness());
+            this->printHistogram("  jitter", task->getJitter());
+        }
+    } else if (ln == "RESET SCHED") {
+        EFScheduler.resetStats();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "SET TRACE:ON" || ln == "SET TRACE:OFF") {
+        EFTrace.setEnabled(ln == "SET TRACE:ON");
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET LATENCY") {
+        EFBOARD_SERIAL_DEVICE.printf("trace=%s events=%u\r\n", EFTrace.isEnabled() ? "on" : "off", EFTrace.getCount());
+        for (EFTraceStage stage : {EFTraceStage::Queue, EFTraceStage::Handler, EFTraceStage::Photon, EFTraceStage::Total}) {
+            const EFTracePercentiles p = EFTrace.getPercentiles(stage);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%s n=%u p50=%luus p90=%luus p99=%luus max=%luus\r\n",
+                toString(stage),
+                p.count,
+                (unsigned long) p.p50,
+                (unsigned long) p.p90,
+                (unsigned long) p.p99,
+                (unsigned long) p.max
+            );
+        }
+    } else if (ln == "RESET LATENCY") {
+        EFTrace.reset();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET PROFILE") {
+#ifdef EFPROFILER
+        for (uint8_t i = 0; i < EFProfiler.getRowCount(); i++) {
+            const EFProfilerRow* row = EFProfiler.getRow(i);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%s %s n=%lu min=%.1fus avg=%.1fus p99=%.1fus max=%.1fus\r\n",
+                row->name,
+                toString(row->section),
+                (unsigned long) row->count,
+                row->min / 1000.0f,
+                row->sum / row->count / 1000.0f,
+                row->getPercentile(99) / 1000.0f,
+                row->max / 1000.0f
+            );
+        }
+        EFBOARD_SERIAL_DEVICE.printf("dropped=%lu\r\n", (unsigned long) EFProfiler.getDroppedCount());
+#else
+        EFBOARD_SERIAL_DEVICE.println("ERR profiler not built, use -D EFPROFILER");
+#endif
+    } else if (ln == "RESET PROFILE") {
+#ifdef EFPROFILER
+        EFProfiler.reset();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+#else
+        EFBOARD_SERIAL_DEVICE.println("ERR profiler not built, use -D EFPROFILER");
+#endif
+    } else if (ln == "SET IDLE:ON" || ln == "SET IDLE:OFF") {
+        EFIdle.setEnabled(ln == "SET IDLE:ON");
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET IDLE") {
+        EFBOARD_SERIAL_DEVICE.printf("idle=%s\r\n", EFIdle.isEnabled() ? "on" : "off");
+        for (uint8_t i = 0; i < EFIdle.getStateCount(); i++) {
+            const EFIdleStats* stats = EFIdle.getStats(i);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%s asleep=%.1f%% time=%.1fs sleeps=%lu touch=%lu\r\n",
+                stats->name,
+                stats->getAsleepPercent(),
+                stats->total_us / 1000000.0f,
+                (unsigned long) stats->sleeps,
+                (unsigned long) stats->touch_wakeups
+            );
+        }
+        EFBOARD_SERIAL_DEVICE.print("blocked");
+        for (uint8_t i = 1; i < EFIDLE_NUM_BLOCKERS; i++) {
+            const EFIdleBlocker blocker = static_cast<EFIdleBlocker>(i);
+            EFBOARD_SERIAL_DEVICE.printf(" %s=%lu", toString(blocker), (unsigned long) EFIdle.getBlockedCount(blocker));
+        }
+        EFBOARD_SERIAL_DEVICE.println();
+    } else if (ln == "RESET IDLE") {
+        EFIdle.reset();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET ENERGY") {
+        for (uint8_t i = 0; i < EFEnergy.getStateCount(); i++) {
+            const EFEnergyStats* stats = EFEnergy.getStats(i);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%s avg=%.1fmA charge=%.2fmAh time=%.1fs",
+                stats->name,
+                stats->getAverageMilliamps(),
+                stats->getChargeMah(),
+                stats->total_ms / 1000.0f
+            );
+            for (uint8_t c = 0; c < EFENERGY_NUM_CONSUMERS; c++) {
+                EFBOARD_SERIAL_DEVICE.printf(" %s=%.2f", toString(static_cast<EFEnergyConsumer>(c)), stats->charge_mams[c] / 3600000.0f);
+            }
+            EFBOARD_SERIAL_DEVICE.println();
+        }
+        EFBOARD_SERIAL_DEVICE.printf(
+            "now=%.1fmA avg=%.1fmA drained=%.1fmAh trend=%.1f%%/h capacity=%umAh%s remaining=%.1fh\r\n",
+            EFEnergy.getCurrentMilliamps(),
+            EFEnergy.getAverageMilliamps(),
+            EFEnergy.getDrainedMah(),
+            EFEnergy.getTrendPercentPerHour(),
+            this->getBatteryCapacityMah(),
+            this->discharge_curve.isLearned() ? "" : " (nominal)",
+            EFEnergy.getHoursRemaining()
+        );
+    } else if (ln == "RESET ENERGY") {
+        EFEnergy.reset();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET BATCURVE") {
+        const EFBoardDischargeCurveData& data = this->discharge_curve.getData();
+        EFBOARD_SERIAL_DEVICE.printf("discharges=%u running=%u\r\n", data.discharges, data.session_next > 0);
+        for (uint8_t i = 0; i < EFBOARDDISCHARGECURVE_POINTS; i++) {
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%umV learned=%umAh session=%umAh\r\n",
+                this->discharge_curve.getPointMilliVolts(i),
+                data.learned_mah[i],
+                i < data.session_next ? data.session_mah[i] : 0
+            );
+        }
+    } else if (ln == "RESET BATCURVE") {
+        this->resetDischargeCurve();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET CPU") {
+        EFBOARD_SERIAL_DEVICE.printf(
+            "perf=%s mhz=%lu load=%u%% switches=%lu\r\n",
+            toString(EFGovernor.getPerf()),
+            (unsigned long) getCpuFrequencyMhz(),
+            EFGovernor.getLoadPercent(),
+            (unsigned long) EFGovernor.getSwitchCount()
+        );
+        uint64_t total_ms = 0;
+        for (uint8_t i = 0; i < EFGOVERNOR_NUM_FREQUENCIES; i++) {
+            total_ms += EFGovernor.getTimeMs(i);
+        }
+        for (uint8_t i = 0; i < EFGOVERNOR_NUM_FREQUENCIES; i++) {
+            const uint64_t time_ms = EFGovernor.getTimeMs(i);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%luMHz time=%.1fs share=%.1f%%\r\n",
+                (unsigned long) EFGovernorClass::getFrequencyMhz(i),
+                time_ms / 1000.0f,
+                total_ms > 0 ? 100.0f * time_ms / total_ms : 0.0f
+            );
+        }
+    } else if (ln == "RESET CPU") {
+        EFGovernor.reset();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+    } else if (ln == "GET TOUCH") {
+        for (EFTouchZone zone : {EFTouchZone::Fingerprint, EFTouchZone::Nose}) {
+            const EFTouchBaseline& baseline = EFTouch.getBaseline(zone);
+            EFBOARD_SERIAL_DEVICE.printf(
+                "%s baseline=%lu noise=%lu press=%lu release=%lu touched=%u\r\n",
+                zone == EFTouchZone::Fingerprint ? "fingerprint" : "nose",
+                (unsigned long) baseline.getBaseline(),
+                (unsigned long) baseline.getNoise(),
+                (unsigned long) baseline.getPressThreshold(),
+                (unsigned long) baseline.getReleaseThreshold(),
+                baseline.isTouched()
+            );
+        }
+        EFBOARD_SERIAL_DEVICE.printf("dropped=%lu\r\n", (unsigned long) EFTouch.getDroppedEdgeCount());
+    } else if (ln == "GET TOUCHTRACE") {
+#ifdef EFTOUCH_RECORDER
+        // Size first, so a capture knows how many raw bytes follow
+        EFBOARD_SERIAL_DEVICE.printf("TOUCHTRACE %lu\r\n", (unsigned long) EFTouchRecorder.getEncodedSize());
+        EFTouchRecorder.dump(EFBOARD_SERIAL_DEVICE);
+        EFBOARD_SERIAL_DEVICE.println();
+#else
+        EFBOARD_SERIAL_DEVICE.println("ERR touch recorder not built, use -D EFTOUCH_RECORDER");
+#endif
+    } else if (ln == "RESET TOUCHTRACE") {
+#ifdef EFTOUCH_RECORDER
+        EFTouchRecorder.reset();
+        EFBOARD_SERIAL_DEVICE.println("OK");
+#else
+        EFBOARD_SERIAL_DEVICE.println("ERR touch recorder not built, use -D EFTOUCH_RECORDER");
+#endif
+    } else if (ln == "GET RADIO") {
+        EFBOARD_SERIAL_DEVICE.printf(
+            "ble=%u sta=%u ap=%u heap=%lu min=%lu\r\n",
+            EFRadio.getUserCount(EFRadioResource::BLE),
+            EFRadio.getUserCount(EFRadioResource::WiFiSTA),
+            EFRadio.getUserCount(EFRadioResource::WiFiAP),
+            (unsigned long) ESP.getFreeHeap(),
+            (unsigned long) ESP.getMinFreeHeap()
+        );
     } else {
         EFBOARD_SERIAL_DEVICE.println("ERR");
     }
@@ -493,3 +851,16 @@ void EFBoardClass::handleConsoleLine(const String& ln) {
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFBOARD)
 EFBoardClass EFBoard;
 #endif
+
+void EFBoardClass::printHistogram(const char* label, const EFSchedulerHistogram& histogram) {
+    EFBOARD_SERIAL_DEVICE.printf("%s max=%lums", label, (unsigned long) histogram.max);
+    for (uint8_t i = 0; i < EFSCHEDULER_HISTOGRAM_BUCKETS; i++) {
+        EFBOARD_SERIAL_DEVICE.printf(
+            " %lu%s:%lu",
+            (unsigned long) EFSchedulerHistogram::getBucketLowerBound(i),
+            (i == EFSCHEDULER_HISTOGRAM_BUCKETS - 1) ? "+" : "",
+            (unsigned long) histogram.buckets[i]
+        );
+    }
+    EFBOARD_SERIAL_DEVICE.println();
+}
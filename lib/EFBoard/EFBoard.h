@@ -28,11 +28,23 @@
  */
 
 #include <EFConfig.h>
+#include <EFScheduler.h>
+#include "EFBoardBattery.h"
+#include "EFBoardBrownOut.h"
+#include "EFBoardDischargeCurve.h"
 #include "EFBoardPowerState.h"
 
 #define EFBOARD_SERIAL_DEVICE USBSerial    //!< Serial device to use for logging
 #define EFBOARD_SERIAL_BAUD 115200         //!< Baudrate for the serial device
 
+#ifndef EFBOARD_BROWN_OUT_INTERVAL_MS
+#define EFBOARD_BROWN_OUT_INTERVAL_MS 5000  //!< Deep sleep time between two V_BAT checks during a hard brown out
+#endif
+
+#ifndef EFBOARD_BROWN_OUT_BLINK_MS
+#define EFBOARD_BROWN_OUT_BLINK_MS 100      //!< Duration of the red nose blink after each V_BAT check
+#endif
+
 /**
  * @brief Basic related to the EF badge board
  */
@@ -41,6 +53,16 @@ class EFBoardClass {
     protected:
 
         EFBoardPowerState power_state;  //!< Power state of the board during the last check
+        EFBoardBattery battery;         //!< Filters the V_BAT samples taken by sampleBattery()
+        float battery_voltage;          //!< Filtered battery voltage as of the last sample
+        uint8_t battery_percent;        //!< Battery capacity level as of the last sample
+        bool battery_powered;           //!< Battery detection as of the last sample
+        EFBoardDischargeCurve discharge_curve;  //!< Discharge curve learned by learnDischarge(), persisted in NVS
+
+        /**
+         * @brief Prints a single scheduler histogram as one console line
+         */
+        void printHistogram(const char* label, const EFSchedulerHistogram& histogram);
 
     public:
 
@@ -65,6 +87,48 @@ class EFBoardClass {
          */
         unsigned int getWakeupCount();
 
+        /**
+         * @brief Determines if the badge woke up from deep sleep with a valid
+         * resume point, i.e., setup() should skip the bootup animations
+         *
+         * @return True if a resume point is waiting to be consumed
+         */
+        bool isResuming();
+
+        /**
+         * @brief Stores the state to resume to after deep sleep in RTC memory
+         *
+         * @param state FSMStateId of the state to resume to
+         * @param tick Animation step of the state
+         */
+        void setResumePoint(uint8_t state, uint32_t tick);
+
+        /**
+         * @brief Retrieves and consumes the resume point stored before deep sleep
+         *
+         * @param state FSMStateId of the state to resume to
+         * @param tick Animation step of the state
+         * @return True if the badge woke up from deep sleep with a valid resume point
+         */
+        bool getResumePoint(uint8_t& state, uint32_t& tick);
+
+        /**
+         * @brief Enters deep sleep with the fingerprint as the only wakeup
+         * source. Does not return, the badge reboots on wakeup.
+         */
+        void deepSleep();
+
+        /**
+         * @brief Handles a hard brown out: Stores the reason in RTC memory,
+         * blinks the nose and deep sleeps. Every EFBOARD_BROWN_OUT_INTERVAL_MS
+         * the badge wakes up, blinks and checks V_BAT again. Once V_BAT
+         * recovered above EFBOARD_BROWN_OUT_RECOVER, it boots normally.
+         * Does not return.
+         *
+         * @param reason Where the brown out was detected
+         */
+        void hardBrownOut(EFBoardBrownOutReason reason);
+
         /**
          * @brief Retrieves the cause for the last wakeup in a human-readable form.
          *
@@ -73,26 +137,64 @@ class EFBoardClass {
         const char* getWakeupReason();
 
         /**
-         * @brief Reads the current battery voltage
+         * @brief Samples V_BAT and updates the cached battery readings. Takes a
+         * burst of EFBOARD_VBAT_BURST calibrated ADC readings, compensates the
+         * voltage sag caused by the current LED frame and adds the result to a
+         * moving average. Should be called every EFBOARD_VBAT_SAMPLE_INTERVAL_MS.
+         */
+        void sampleBattery();
+
+        /**
+         * @brief Retrieves the battery voltage as of the last sampleBattery()
          *
-         * @return Current battery voltage
+         * @return Filtered battery voltage
          */
         const float getBatteryVoltage();
 
         /**
-         * @brief Determiens if the badge currently has batteries connected to it
+         * @brief Determiens if the badge currently has batteries connected to it,
+         * as of the last sampleBattery()
          *
          * @return True if batterys were detected
          */
         const bool isBatteryPowered();
 
         /**
-         * @brief Approximates current battery capacity level in percent
+         * @brief Retrieves the battery capacity level as of the last sampleBattery()
          *
          * @return Current approx. battery capacity level in percent (0 - 100)
          */
         const uint8_t getBatteryCapacityPercent();
 
+        /**
+         * @brief Feeds the charge drained from the battery into the learned
+         * discharge curve. Once a complete discharge was learned,
+         * getBatteryCapacityPercent() is derived from it instead of the fixed
+         * voltage table. Progress is persisted in NVS whenever a point of the
+         * curve is crossed, so learning survives reboots.
+         *
+         * @param drained_mah Monotonic counter of the charge drained since boot
+         */
+        void learnDischarge(uint32_t drained_mah);
+
+        /**
+         * @brief Retrieves the learned discharge curve
+         */
+        const EFBoardDischargeCurve& getDischargeCurve() const;
+
+        /**
+         * @brief Forgets the learned discharge curve, also in NVS
+         */
+        void resetDischargeCurve();
+
+        /**
+         * @brief Retrieves the usable battery capacity, learned if available,
+         * EFBOARD_BAT_CAPACITY_MAH otherwise
+         *
+         * @return Capacity in mAh
+         */
+        const uint16_t getBatteryCapacityMah();
+
         /**
          * @brief Approximates current battery capacity level in percent
          * this funktion should be used if thebord is run on AA Batteries not on Litium Akku
@@ -108,16 +210,6 @@ class EFBoardClass {
          * @return Current approx. battery capacity level in percent (0 - 100)
          */
         const uint8_t getBatteryCapacityAlkalinePercent();
-        /**
-         * @brief Updates the power state of the board. If a brown out state was
-         * reached once, the board power state does not automatically recover
-         * from this.
-         *
-         * If you wish to reset the brown out condition use resetPowerState().
-         *
-         * @return The detected power state
-         */
-
         /**
          * @brief Updates the power state of the board. If a brown out state was
          * reached once, the board power state does not automatically recover
@@ -153,13 +245,6 @@ class EFBoardClass {
          */
         bool connectToWifi(const char* ssid, const char* password);
 
-        /**
-         * @brief Disconnects from any WiFi network and disables the radio modem
-         *
-         * @return True if the radio modem was sucessfully disabled
-         */
-        bool disableWifi();
-
         /**
          * @brief Enables OTA update receiver
          *
@@ -184,6 +269,18 @@ class EFBoardClass {
          *  - `SET NAME:<text>`  → store the badge name in NVS
          *  - `GET NAME`         → print the current name to serial
          *  - `RESET NAME`       → clear stored name (defaults on next boot)
+         *  - `GET LED`          → print LED push statistics
+         *  - `GET SCHED`        → print lateness / jitter histograms of scheduled tasks
+         *  - `RESET SCHED`      → clear scheduler statistics
+         *  - `SET TRACE:ON|OFF` → enable / disable input-to-LED latency tracing
+         *  - `GET LATENCY`      → print latency percentiles of traced input events
+         *  - `RESET LATENCY`    → discard traced input events
+         *  - `GET ENERGY`       → print estimated charge per state and remaining runtime
+         *  - `RESET ENERGY`     → clear energy statistics
+         *  - `GET BATCURVE`     → print the learned battery discharge curve
+         *  - `GET CPU`          → print the CPU governor state and time spent per frequency
+         *  - `RESET CPU`        → clear the time spent per frequency
+         *  - `RESET BATCURVE`   → forget the learned battery discharge curve
          * @param ln The command line string (without newline characters)
          */
         void handleConsoleLine(const String& ln);
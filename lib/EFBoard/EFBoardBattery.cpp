@@ -0,0 +1,88 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EFBoardBattery.h"
+
+EFBoardBattery::EFBoardBattery(const EFBoardBatteryConfig& config)
+: config(config)
+{
+    this->reset();
+}
+
+void EFBoardBattery::reset() {
+    this->window_len = 0;
+    this->window_pos = 0;
+    this->window_sum = 0;
+    this->last_sag_mv = 0;
+}
+
+uint32_t EFBoardBattery::median(uint32_t* readings, uint8_t count) {
+    // Bursts are tiny, insertion sort is fastest
+    for (uint8_t i = 1; i < count; i++) {
+        const uint32_t value = readings[i];
+        uint8_t j = i;
+        for (; j > 0 && readings[j - 1] > value; j--) {
+            readings[j] = readings[j - 1];
+        }
+        readings[j] = value;
+    }
+    return readings[count / 2];
+}
+
+uint32_t EFBoardBattery::update(uint32_t vbat_mv, uint32_t load_ma) {
+    // Battery current of the load behind the converter: P = U * I / efficiency
+    uint32_t sag_mv = 0;
+    if (vbat_mv > 0 && this->config.efficiency_percent > 0) {
+        const uint32_t bat_ma = (uint64_t) load_ma * this->config.load_mv * 100 / ((uint64_t) vbat_mv * this->config.efficiency_percent);
+        sag_mv = bat_ma * this->config.resistance_mohm / 1000;
+    }
+    this->last_sag_mv = sag_mv;
+    const uint32_t sample = vbat_mv + sag_mv;
+
+    if (this->window_len == 0) {
+        for (uint8_t i = 0; i < EFBOARDBATTERY_WINDOW; i++) {
+            this->window[i] = sample;
+        }
+        this->window_len = EFBOARDBATTERY_WINDOW;
+        this->window_sum = sample * EFBOARDBATTERY_WINDOW;
+        return sample;
+    }
+
+    this->window_sum -= this->window[this->window_pos];
+    this->window[this->window_pos] = sample;
+    this->window_sum += sample;
+    this->window_pos = (this->window_pos + 1) % EFBOARDBATTERY_WINDOW;
+
+    return this->getMilliVolts();
+}
+
+bool EFBoardBattery::hasSamples() const {
+    return this->window_len > 0;
+}
+
+uint32_t EFBoardBattery::getMilliVolts() const {
+    return this->window_len > 0 ? this->window_sum / this->window_len : 0;
+}
+
+uint32_t EFBoardBattery::getSagMilliVolts() const {
+    return this->last_sag_mv;
+}
@@ -0,0 +1,111 @@
+#ifndef EFBOARDBATTERY_H_
+#define EFBOARDBATTERY_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+#define EFBOARDBATTERY_WINDOW 8  //!< Number of samples averaged into the cached battery voltage
+
+/**
+ * @brief Electrical properties used to compensate the voltage sag caused by the LEDs
+ */
+struct EFBoardBatteryConfig {
+    uint16_t resistance_mohm;     //!< Internal resistance of the battery pack including wiring
+    uint16_t load_mv;             //!< Voltage the LED load is supplied with
+    uint8_t efficiency_percent;   //!< Efficiency of the converter supplying the LED load
+};
+
+/**
+ * @brief Filters battery voltage samples
+ *
+ * Each sample is the median of a burst of ADC readings, which rejects single
+ * outliers. The voltage sag caused by the current the LEDs draw through the
+ * internal resistance of the battery is added back, so bright frames do not
+ * read as an emptier battery. The last EFBOARDBATTERY_WINDOW samples are
+ * averaged.
+ *
+ * Does not depend on Arduino, so the filter can be exercised on the host.
+ */
+class EFBoardBattery {
+
+    protected:
+
+        EFBoardBatteryConfig config;              //!< Electrical properties of the battery and load
+        uint32_t window[EFBOARDBATTERY_WINDOW];   //!< Compensated samples in mV
+        uint8_t window_len;                       //!< Number of valid samples in window
+        uint8_t window_pos;                       //!< Next slot to write in window
+        uint32_t window_sum;                      //!< Sum of all valid samples in window
+        uint32_t last_sag_mv;                     //!< Compensation applied to the last sample
+
+    public:
+
+        /**
+         * @brief Creates a filter without samples
+         */
+        explicit EFBoardBattery(const EFBoardBatteryConfig& config);
+
+        /**
+         * @brief Forgets all samples
+         */
+        void reset();
+
+        /**
+         * @brief Sorts the given readings in place and returns their median
+         *
+         * @param readings Burst of ADC readings
+         * @param count Number of readings, at least 1
+         */
+        static uint32_t median(uint32_t* readings, uint8_t count);
+
+        /**
+         * @brief Adds a sample. The first sample fills the whole window, so
+         * the voltage is valid right away.
+         *
+         * @param vbat_mv Measured battery voltage in mV
+         * @param load_ma Current drawn by the LEDs while measuring in mA
+         * @return Filtered battery voltage in mV
+         */
+        uint32_t update(uint32_t vbat_mv, uint32_t load_ma);
+
+        /**
+         * @brief Determines if at least one sample was added since the last reset()
+         */
+        bool hasSamples() const;
+
+        /**
+         * @brief Retrieves the filtered battery voltage
+         *
+         * @return Battery voltage in mV, 0 without samples
+         */
+        uint32_t getMilliVolts() const;
+
+        /**
+         * @brief Retrieves the sag that was added to the last sample
+         *
+         * @return Compensated voltage sag in mV
+         */
+        uint32_t getSagMilliVolts() const;
+};
+
+#endif /* EFBOARDBATTERY_H_ */
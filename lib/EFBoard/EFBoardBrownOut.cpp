@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EFBoardBrownOut.h"
+
+const char* toString(EFBoardBrownOutReason reason) {
+    switch (reason) {
+        case EFBoardBrownOutReason::None: return "none";
+        case EFBoardBrownOutReason::Boot: return "boot";
+        case EFBoardBrownOutReason::Runtime: return "runtime";
+        default: return "UNKNOWN";
+    }
+}
+
+EFBoardBrownOut::EFBoardBrownOut(
+    EFBoardBrownOutPlatform& platform,
+    EFBoardBrownOutRecord& record,
+    uint32_t recover_mv,
+    uint32_t interval_ms,
+    uint32_t blink_ms
+)
+: platform(platform)
+, record(record)
+, recover_mv(recover_mv)
+, interval_ms(interval_ms)
+, blink_ms(blink_ms)
+{}
+
+bool EFBoardBrownOut::isPending() const {
+    return this->record.magic == EFBOARDBROWNOUT_MAGIC;
+}
+
+void EFBoardBrownOut::enter(EFBoardBrownOutReason reason, uint32_t vbat_mv) {
+    this->record.magic = EFBOARDBROWNOUT_MAGIC;
+    this->record.wakeups = 0;
+    this->record.detected_mv = vbat_mv;
+    this->record.last_mv = vbat_mv;
+    this->record.reason = static_cast<uint8_t>(reason);
+
+    this->platform.blink(this->blink_ms);
+    this->platform.deepSleep(this->interval_ms);
+}
+
+EFBoardBrownOutStep EFBoardBrownOut::wakeup() {
+    if (!this->isPending()) {
+        return EFBoardBrownOutStep::None;
+    }
+
+    this->record.last_mv = this->platform.readBatteryMilliVolts();
+    if (this->record.last_mv >= this->recover_mv) {
+        this->record.magic = 0;
+        return EFBoardBrownOutStep::Recovered;
+    }
+
+    // Saturate instead of wrapping after a very long time
+    if (this->record.wakeups < UINT32_MAX) {
+        this->record.wakeups++;
+    }
+    this->platform.blink(this->blink_ms);
+    this->platform.deepSleep(this->interval_ms);
+    return EFBoardBrownOutStep::Sleep;
+}
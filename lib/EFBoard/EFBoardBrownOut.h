@@ -0,0 +1,151 @@
+#ifndef EFBOARDBROWNOUT_H_
+#define EFBOARDBROWNOUT_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+#define EFBOARDBROWNOUT_MAGIC 0x45464230  //!< Marks a valid brown out record in RTC memory ("EFB0")
+
+/**
+ * @brief Where a hard brown out was detected
+ */
+enum class EFBoardBrownOutReason : uint8_t {
+    None,     //!< No brown out
+    Boot,     //!< During board setup, before anything else was started
+    Runtime,  //!< By the periodic battery check while running
+};
+
+const char* toString(EFBoardBrownOutReason reason);
+
+/**
+ * @brief Hard brown out state kept across deep sleep cycles
+ */
+struct EFBoardBrownOutRecord {
+    uint32_t magic;         //!< EFBOARDBROWNOUT_MAGIC if the record is valid
+    uint32_t wakeups;       //!< Number of wakeups that found V_BAT still too low
+    uint16_t detected_mv;   //!< V_BAT when the brown out was detected
+    uint16_t last_mv;       //!< V_BAT during the last wakeup
+    uint8_t reason;         //!< EFBoardBrownOutReason
+};
+
+/**
+ * @brief Hardware used by EFBoardBrownOut. Kept abstract, so the deep sleep
+ * cycle can be exercised on the host.
+ */
+class EFBoardBrownOutPlatform {
+
+    public:
+
+        virtual ~EFBoardBrownOutPlatform() = default;
+
+        /**
+         * @brief Takes a single, filtered V_BAT reading with the LEDs off
+         *
+         * @return V_BAT in mV
+         */
+        virtual uint32_t readBatteryMilliVolts() = 0;
+
+        /**
+         * @brief Lights the dragon nose red for the given time
+         */
+        virtual void blink(uint32_t duration_ms) = 0;
+
+        /**
+         * @brief Enters deep sleep with only the timer as wakeup source. Does
+         * not return on the badge, which reboots on wakeup.
+         */
+        virtual void deepSleep(uint32_t duration_ms) = 0;
+};
+
+/**
+ * @brief Result of EFBoardBrownOut::wakeup()
+ */
+enum class EFBoardBrownOutStep : uint8_t {
+    None,       //!< No brown out was pending, boot normally
+    Sleep,      //!< V_BAT is still too low, went back to deep sleep
+    Recovered,  //!< V_BAT recovered, the record was cleared, boot normally
+};
+
+/**
+ * @brief Hard brown out cycle: Instead of keeping RAM and peripherals powered
+ * in light sleep, the badge deep sleeps with the reason stored in RTC memory.
+ * Every wakeup only blinks the nose and checks V_BAT before sleeping again.
+ * Once V_BAT recovered above the given threshold, the record is cleared and
+ * the badge boots normally.
+ *
+ * Does not depend on Arduino, so the cycle can be exercised on the host.
+ */
+class EFBoardBrownOut {
+
+    protected:
+
+        EFBoardBrownOutPlatform& platform;  //!< Hardware access
+        EFBoardBrownOutRecord& record;      //!< Record in RTC memory
+        uint32_t recover_mv;                //!< V_BAT at which the badge boots normally again
+        uint32_t interval_ms;               //!< Deep sleep time between two checks
+        uint32_t blink_ms;                  //!< Duration of the blink signaling the brown out
+
+    public:
+
+        /**
+         * @brief Creates the cycle on top of the given record
+         *
+         * @param platform Hardware access
+         * @param record Record in RTC memory, surviving deep sleep
+         * @param recover_mv V_BAT at which the badge boots normally again
+         * @param interval_ms Deep sleep time between two checks
+         * @param blink_ms Duration of the blink signaling the brown out
+         */
+        EFBoardBrownOut(
+            EFBoardBrownOutPlatform& platform,
+            EFBoardBrownOutRecord& record,
+            uint32_t recover_mv,
+            uint32_t interval_ms,
+            uint32_t blink_ms
+        );
+
+        /**
+         * @brief Determines if a brown out is pending in the record
+         */
+        bool isPending() const;
+
+        /**
+         * @brief Records the brown out, blinks and enters deep sleep
+         *
+         * @param reason Where the brown out was detected
+         * @param vbat_mv V_BAT that triggered it
+         */
+        void enter(EFBoardBrownOutReason reason, uint32_t vbat_mv);
+
+        /**
+         * @brief Continues a pending brown out after waking up. Must be called
+         * early during boot, before anything draws significant current.
+         *
+         * @return What was done. Never returns EFBoardBrownOutStep::Sleep on
+         * the badge, as deep sleep reboots.
+         */
+        EFBoardBrownOutStep wakeup();
+};
+
+#endif /* EFBOARDBROWNOUT_H_ */
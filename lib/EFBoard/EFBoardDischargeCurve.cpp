@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <string.h>
+
+#include "EFBoardDischargeCurve.h"
+
+EFBoardDischargeCurve::EFBoardDischargeCurve(uint16_t full_mv, uint16_t empty_mv)
+: full_mv(full_mv)
+, empty_mv(empty_mv)
+{
+    this->reset();
+}
+
+void EFBoardDischargeCurve::reset() {
+    memset(&this->data, 0, sizeof(this->data));
+    this->data.version = EFBOARDDISCHARGECURVE_VERSION;
+    this->session_offset_mah = 0;
+    this->session_resync = false;
+}
+
+bool EFBoardDischargeCurve::restore(const EFBoardDischargeCurveData& data) {
+    if (data.version != EFBOARDDISCHARGECURVE_VERSION || data.session_next > EFBOARDDISCHARGECURVE_POINTS) {
+        return false;
+    }
+    for (uint8_t i = 1; i < EFBOARDDISCHARGECURVE_POINTS; i++) {
+        if (data.learned_mah[i] < data.learned_mah[i - 1]) {
+            return false;
+        }
+    }
+
+    this->data = data;
+    this->session_resync = data.session_next > 0;
+    return true;
+}
+
+const EFBoardDischargeCurveData& EFBoardDischargeCurve::getData() const {
+    return this->data;
+}
+
+uint16_t EFBoardDischargeCurve::getPointMilliVolts(uint8_t idx) const {
+    return this->full_mv - (uint32_t) (this->full_mv - this->empty_mv) * idx / (EFBOARDDISCHARGECURVE_POINTS - 1);
+}
+
+bool EFBoardDischargeCurve::update(uint32_t vbat_mv, uint32_t drained_mah) {
+    // Full again, i.e., charged or fresh cells: Start over
+    if (vbat_mv >= this->getPointMilliVolts(0)) {
+        const bool started = this->data.session_next != 1;
+        this->data.session_next = 1;
+        this->data.session_mah[0] = 0;
+        this->session_offset_mah = -(int32_t) drained_mah;
+        this->session_resync = false;
+        return started;
+    }
+    if (this->data.session_next == 0) {
+        return false;
+    }
+
+    // A restored discharge continues at the last point it crossed
+    if (this->session_resync) {
+        this->session_offset_mah = this->data.session_mah[this->data.session_next - 1] - (int32_t) drained_mah;
+        this->session_resync = false;
+    }
+    const int32_t since_full = (int32_t) drained_mah + this->session_offset_mah;
+    const uint16_t since_full_mah = since_full < 0 ? 0 : (since_full > UINT16_MAX ? UINT16_MAX : since_full);
+
+    bool crossed = false;
+    while (this->data.session_next < EFBOARDDISCHARGECURVE_POINTS && vbat_mv < this->getPointMilliVolts(this->data.session_next)) {
+        this->data.session_mah[this->data.session_next++] = since_full_mah;
+        crossed = true;
+    }
+
+    if (this->data.session_next == EFBOARDDISCHARGECURVE_POINTS) {
+        // Discharge complete. Averaging with the previous ones follows aging cells.
+        if (this->data.session_mah[EFBOARDDISCHARGECURVE_POINTS - 1] >= EFBOARDDISCHARGECURVE_MIN_MAH) {
+            for (uint8_t i = 0; i < EFBOARDDISCHARGECURVE_POINTS; i++) {
+                this->data.learned_mah[i] = this->data.discharges == 0
+                    ? this->data.session_mah[i]
+                    : (this->data.learned_mah[i] + this->data.session_mah[i]) / 2;
+            }
+            if (this->data.discharges < UINT8_MAX) {
+                this->data.discharges++;
+            }
+        }
+        this->data.session_next = 0;
+    }
+
+    return crossed;
+}
+
+bool EFBoardDischargeCurve::isLearned() const {
+    return this->data.discharges > 0;
+}
+
+uint16_t EFBoardDischargeCurve::getCapacityMah() const {
+    return this->isLearned() ? this->data.learned_mah[EFBOARDDISCHARGECURVE_POINTS - 1] : 0;
+}
+
+uint8_t EFBoardDischargeCurve::getPercent(uint32_t vbat_mv) const {
+    const uint16_t capacity = this->getCapacityMah();
+    if (capacity == 0 || vbat_mv >= this->getPointMilliVolts(0)) {
+        return capacity == 0 ? 0 : 100;
+    }
+
+    // Charge drained at the given voltage, interpolated between the surrounding points
+    uint32_t drained = capacity;
+    for (uint8_t i = 0; i + 1 < EFBOARDDISCHARGECURVE_POINTS; i++) {
+        const uint16_t upper = this->getPointMilliVolts(i);
+        const uint16_t lower = this->getPointMilliVolts(i + 1);
+        if (vbat_mv > lower) {
+            const uint16_t from = this->data.learned_mah[i];
+            const uint16_t to = this->data.learned_mah[i + 1];
+            drained = from + (uint32_t) (to - from) * (upper - vbat_mv) / (upper - lower);
+            break;
+        }
+    }
+
+    return (uint8_t) (((capacity - drained) * 100 + capacity / 2) / capacity);
+}
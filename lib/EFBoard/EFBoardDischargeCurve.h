@@ -0,0 +1,129 @@
+#ifndef EFBOARDDISCHARGECURVE_H_
+#define EFBOARDDISCHARGECURVE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+#define EFBOARDDISCHARGECURVE_POINTS 16   //!< Number of voltages the drained charge is learned at
+#define EFBOARDDISCHARGECURVE_VERSION 1   //!< Layout version of EFBoardDischargeCurveData
+#define EFBOARDDISCHARGECURVE_MIN_MAH 50  //!< Discharges draining less are considered implausible and dropped
+
+/**
+ * @brief Persisted state of an EFBoardDischargeCurve
+ */
+struct EFBoardDischargeCurveData {
+    uint8_t version;                                    //!< EFBOARDDISCHARGECURVE_VERSION
+    uint8_t discharges;                                 //!< Number of complete discharges learned, saturating
+    uint8_t session_next;                               //!< Next point the running discharge has to cross, 0 if none is running
+    uint8_t reserved;
+    uint16_t learned_mah[EFBOARDDISCHARGECURVE_POINTS]; //!< Charge drained from full until each point was crossed
+    uint16_t session_mah[EFBOARDDISCHARGECURVE_POINTS]; //!< Same for the running discharge
+};
+
+/**
+ * @brief Learns the discharge curve of the battery from coulomb counting
+ *
+ * The voltage range between full and empty is split into
+ * EFBOARDDISCHARGECURVE_POINTS evenly spaced points. A discharge starts
+ * once the battery reads full. Each time the voltage crosses the next point,
+ * the charge drained since then is recorded. Once the last point is crossed,
+ * the discharge is averaged into the learned curve. The capacity level is
+ * then derived from the drained charge instead of a fixed voltage table.
+ *
+ * Does not depend on Arduino, so the learning can be exercised on the host.
+ */
+class EFBoardDischargeCurve {
+
+    protected:
+
+        uint16_t full_mv;                  //!< Voltage of the first point
+        uint16_t empty_mv;                 //!< Voltage of the last point
+        EFBoardDischargeCurveData data;    //!< Learned curve and running discharge
+        int32_t session_offset_mah;        //!< Added to the drained counter to get the charge drained since full
+        bool session_resync;               //!< The running discharge was restored and needs a new offset
+
+    public:
+
+        /**
+         * @brief Creates a curve that has not learned anything yet
+         *
+         * @param full_mv Voltage at which the battery is considered full
+         * @param empty_mv Voltage at which the battery is considered empty
+         */
+        EFBoardDischargeCurve(uint16_t full_mv, uint16_t empty_mv);
+
+        /**
+         * @brief Forgets the learned curve and the running discharge
+         */
+        void reset();
+
+        /**
+         * @brief Restores previously persisted data. A running discharge
+         * continues from the last point it crossed.
+         *
+         * @return True if the data was valid
+         */
+        bool restore(const EFBoardDischargeCurveData& data);
+
+        /**
+         * @brief Retrieves the data to persist
+         */
+        const EFBoardDischargeCurveData& getData() const;
+
+        /**
+         * @brief Retrieves the voltage of the given point
+         */
+        uint16_t getPointMilliVolts(uint8_t idx) const;
+
+        /**
+         * @brief Processes the next battery reading
+         *
+         * @param vbat_mv Filtered battery voltage
+         * @param drained_mah Monotonic counter of the charge drained from the battery
+         * @return True if a point was crossed, i.e., the data should be persisted
+         */
+        bool update(uint32_t vbat_mv, uint32_t drained_mah);
+
+        /**
+         * @brief Determines if at least one complete discharge was learned
+         */
+        bool isLearned() const;
+
+        /**
+         * @brief Retrieves the learned capacity between full and empty
+         *
+         * @return Capacity in mAh, 0 if not learned yet
+         */
+        uint16_t getCapacityMah() const;
+
+        /**
+         * @brief Calculates the capacity level from the learned curve
+         *
+         * @param vbat_mv Filtered battery voltage
+         * @return Capacity level in percent (0 - 100)
+         */
+        uint8_t getPercent(uint32_t vbat_mv) const;
+};
+
+#endif /* EFBOARDDISCHARGECURVE_H_ */
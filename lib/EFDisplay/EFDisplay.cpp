@@ -28,6 +28,7 @@
 #include <GlitchLine.h>
 #include <EFLogging.h>
 #include <EFBoard.h>
+#include <EFEnergy.h>
 #include <EFLed.h>
 
 #include <U8g2lib.h>
@@ -36,7 +37,7 @@
 #include <vector>
 #include <array>
 #include <string>
-#include <sstream>
+#include <cstring>
 
 #include "EFDisplay.h"
 
@@ -54,10 +55,6 @@ static uint16_t counter = 0;
 //static bool glitch_anim = false;
 //static int thick_line = -1;
 //static int thin_line = -1;
-int battery_update_counter = 0;
-int battery_percentage = 0;
-int staticMultiplier =1;
-float battery_voltage = 0;
 
 // define these near the top of EFDisplay.cpp to avoid magic numbers
 // Your coordinate system with U8G2_R3 ends up X: 0..63, Y: 0..127
@@ -70,14 +67,18 @@ static constexpr uint8_t HUD_Y0     = 30;  // first baseline y
 //static constexpr uint8_t HUD_MARGIN = 4;   // space below last HUD line
 static constexpr uint8_t HUD_LINE5_Y = 85;  // pick what clears the eye outline
 
-bool inMenu = false;
-
 
 std::vector<GlitchLine*> lines = {};
 
 U8G2_SSD1306_128X64_NONAME_F_4W_HW_SPI u8g2(U8G2_R0, OLED_CS, OLED_DC, OLED_RESET);
 
-void EFDisplayClass::init() {
+void EFDisplayClass::init(bool animate) {
+    // May be called from the FSM while the render loop runs on the other core
+    render_hold.store(true);
+    while (rendering.load()) {
+        delay(1);
+    }
+
     SPI.begin(OLED_SCLK, -1, OLED_MOSI, OLED_CS);
     u8g2.begin();
     u8g2.setDisplayRotation(U8G2_R3);
@@ -85,18 +86,55 @@ void EFDisplayClass::init() {
     u8g2.clearBuffer();
     LOG_INFO("Display setup!");
 
+    EFEnergy.setDisplayOn(true);
     audioInit();         // <— optional now; enable when you want
-    bootupAnimation();
+    if (animate) {
+        bootupAnimation();
+    }
+
+    render_hold.store(false);
+}
+
+void EFDisplayClass::setPowerSave(bool enable) {
+    render_hold.store(true);
+    while (rendering.load()) {
+        delay(1);
+    }
+
+    u8g2.setPowerSave(enable);
+    EFEnergy.setDisplayOn(!enable);
+
+    render_hold.store(enable);
 }
 
 void EFDisplayClass::loop() {
-    if(inMenu)return;//show the display Loop only when not in the main menu
+    rendering.store(true);
+    if (!render_hold.load()) {
+        render();
+    }
+    rendering.store(false);
+}
+
+void EFDisplayClass::render() {
+    const bool changed = state.update();
+    const EFDisplayState& s = state.read();
+    if (s.menu_visible) {
+        // The menu is static, only redraw it when it changed
+        if (changed) {
+            u8g2.clearBuffer(); //clear screen
+            updatePowerInfo();  //print power status
+            drawMultiline(0, 30, s.menu);
+            u8g2.sendBuffer();
+        }
+        return;
+    }
+
     u8g2.clearBuffer();
     updatePowerInfo();
     //EFLed.setDragonEye(CRGB(60, 60, 100));
     //EFLed.setDragonMuzzle(CRGB(40, 40, 80));
 
-    if (!hudEnabled) {
+    if (!s.hud_enabled) {
         //audioTick();         // <— optional now; enable when you want
         animationTick();
         /*
@@ -127,18 +165,19 @@ void EFDisplayClass::loop() {
 
 
 void EFDisplayClass::updatePowerInfo() const {
-    if(battery_update_counter < 1) {
-        battery_percentage = EFBoard.getBatteryCapacityPercent();
-        battery_voltage = EFBoard.getBatteryVoltage();
-        battery_update_counter = 100;
-    }
-    battery_update_counter--;
-    String batt = "BAT:" + String(battery_percentage) + "%";
+    // EFBoard caches the readings of its background sampler, no ADC access here
+    String batt = "BAT:" + String(EFBoard.getBatteryCapacityPercent()) + "%";
 
     if(!EFBoard.isBatteryPowered()) {
         batt = "USB POWER";
     }else{
-        u8g2.drawStr(10, 20, ("PWR:" + String(battery_voltage) + "V").c_str());
+        // Only 10 characters fit, the remaining runtime replaces the label once known
+        const float hours = EFEnergy.getHoursRemaining();
+        String pwr = "PWR:" + String(EFBoard.getBatteryVoltage()) + "V";
+        if (hours >= 0.0f) {
+            pwr = String(EFBoard.getBatteryVoltage()) + "V " + (hours < 10.0f ? String(hours, 1) : String((int) min(hours, 999.0f))) + "h";
+        }
+        u8g2.drawStr(10, 20, pwr.c_str());
     }
     u8g2.drawStr(10, 10, batt.c_str());
 }
@@ -271,26 +310,26 @@ void EFDisplayClass::eyeOutline() const {
     }
 }
 
-void EFDisplayClass::DisplayMenu(const String& text,bool showMenu){
+void EFDisplayClass::DisplayMenu(const char* text,bool showMenu){
+    pending.menu_visible = showMenu;
     if(showMenu){
-        inMenu = true;
-        u8g2.clearBuffer(); //clear screen
-        updatePowerInfo();  //print power status
-        drawMultiline(0, 30, text.c_str());
-        u8g2.sendBuffer();
-    }else{
-        inMenu = false;
+        snprintf(pending.menu, sizeof(pending.menu), "%s", text);
     }
+    publishState();
  }
 
  void EFDisplayClass::drawMultiline(int x, int y, const char *text) {
   int lineHeight = u8g2.getMaxCharHeight() + 1;
-  std::string s(text);
-  std::stringstream ss(s);
-  std::string line;
+  char line[32]; // Copied line by line on the stack, called on every menu entry
   int i = 0;
-  while (std::getline(ss, line, '\n')) {
-    u8g2.drawStr(x, y + i * lineHeight, line.c_str());
+  while (*text) {
+    size_t len = strcspn(text, "\n");
+    size_t copy = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+    memcpy(line, text, copy);
+    line[copy] = '\0';
+    u8g2.drawStr(x, y + i * lineHeight, line);
+    text += len;
+    if (*text == '\n') text++;
     i++;
   }
 }
@@ -407,16 +446,25 @@ void EFDisplayClass::audioTick() {
     g_audio_level = lvl;
 }
 
+void EFDisplayClass::publishState() {
+    state.publish(pending);
+}
+
 void EFDisplayClass::setHUDEnabled(bool on) {
-    hudEnabled = on;
+    pending.hud_enabled = on;
+    publishState();
 }
 
 void EFDisplayClass::setHUDLine(uint8_t idx, const String& text) {
-    if (idx < 6) hudLines[idx] = text;
+    if (idx < EFDISPLAY_HUD_NUM_LINES) {
+        snprintf(pending.hud[idx], EFDISPLAY_HUD_LINE_LEN, "%s", text.c_str());
+        publishState();
+    }
 }
 
 void EFDisplayClass::clearHUD() {
-    for (auto &l : hudLines) l = "";
+    for (auto &l : pending.hud) l[0] = '\0';
+    publishState();
 }
 
 String EFDisplayClass::truncateToWidth(const String& s, uint8_t maxW) {
@@ -434,31 +482,33 @@ String EFDisplayClass::truncateToWidth(const String& s, uint8_t maxW) {
 }
 
 void EFDisplayClass::drawHUD() const {
-    if (!hudEnabled) return;
+    const EFDisplayState& s = state.read();
+    if (!s.hud_enabled) return;
 
     u8g2.setFont(u8g2_font_5x8_tr);
     uint8_t y = HUD_Y0;
 
     // draw lines 0..3 with uniform spacing
     for (int i = 0; i < 4; ++i) {
-        String line = truncateToWidth(hudLines[i], SCR_W);
-        if (hudLines[i].length() > 0) {
+        if (s.hud[i][0] != '\0') {
+            String line = truncateToWidth(s.hud[i], SCR_W);
             u8g2.drawStr(0, y, line.c_str());
         }
         y += HUD_LINE_H;
     }
 
     // draw line 4 (the 5th line) at a custom Y to avoid the eye
-    if (hudLines[4].length() > 0) {
+    if (s.hud[4][0] != '\0') {
         // clamp just in case
         uint8_t y5 = (HUD_LINE5_Y < SCR_H) ? HUD_LINE5_Y : (SCR_H - 1);
-        String line = truncateToWidth(hudLines[4], SCR_W);
+        String line = truncateToWidth(s.hud[4], SCR_W);
         u8g2.drawStr(0, y5, line.c_str());
     }
 }
 
-void EFDisplayClass::setStaticMultiplier(uint8_t multiplier) const {
-    staticMultiplier = multiplier;
+void EFDisplayClass::setStaticMultiplier(uint8_t multiplier) {
+    pending.static_multiplier = multiplier;
+    publishState();
 }
 
 void EFDisplayClass::drawHUDStatic(uint8_t yStart) const {
@@ -468,7 +518,7 @@ void EFDisplayClass::drawHUDStatic(uint8_t yStart) const {
 
     // Seed varies per frame, but we just use Arduino random()
     // DOTS: ~150 sparse pixels
-    const int DOTS = 150*staticMultiplier/100;
+    const int DOTS = 150*state.read().static_multiplier/100;
     for (int i = 0; i < DOTS; ++i) {
         int x = random(0, SCR_W);
         int y = random(yStart, SCR_H);
@@ -476,7 +526,7 @@ void EFDisplayClass::drawHUDStatic(uint8_t yStart) const {
     }
 
     // Dashes: a few short horizontal jitter lines
-    const int DASHES = 10*staticMultiplier/100;
+    const int DASHES = 10*state.read().static_multiplier/100;
     for (int i = 0; i < DASHES; ++i) {
         int y  = random(yStart, SCR_H);
         int x  = random(0, SCR_W - 2);
@@ -27,11 +27,52 @@
  * @author Irah / DarkRat
  */
 
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <EFSnapshot.h>
+
+#define EFDISPLAY_HUD_NUM_LINES 5
+#define EFDISPLAY_HUD_LINE_LEN 24
+#define EFDISPLAY_MENU_TEXT_LEN 128
+
+/**
+ * @brief Everything the FSM can change about the display. Handed over to the
+ * render loop as a whole, see EFSnapshot.
+ */
+struct EFDisplayState {
+    bool menu_visible = false;                                       //!< Show the menu instead of the animation
+    bool hud_enabled = false;                                        //!< Show the HUD instead of the glitch lines
+    uint8_t static_multiplier = 1;                                   //!< Amount of HUD static in percent
+    char menu[EFDISPLAY_MENU_TEXT_LEN] = {0};                        //!< Menu text, lines separated by '\n'
+    char hud[EFDISPLAY_HUD_NUM_LINES][EFDISPLAY_HUD_LINE_LEN] = {};  //!< HUD lines
+};
+
 class EFDisplayClass {
 
     public:
 
-    void init();
+    /**
+     * @brief Initializes the display
+     *
+     * @param animate Play the bootup animation. Skipped when waking up from deep sleep.
+     */
+    void init(bool animate = true);
+
+    /**
+     * @brief Turns the display off (e.g., before deep sleep) or back on. The
+     * render loop stays paused while the display is off.
+     *
+     * @param enable True to turn the display off
+     */
+    void setPowerSave(bool enable);
+
+    /**
+     * @brief Renders the next frame from the latest published state. Must
+     * only be called from the render loop, all other methods may be called
+     * from the FSM on the other core.
+     */
     void loop();
 
     void animationTick() const;
@@ -58,7 +99,7 @@ class EFDisplayClass {
      * @param text Menu Text to Display
      * @param showMenu Boolan show ot not show menu
      */
-    void DisplayMenu(const String& text,bool showMenu);
+    void DisplayMenu(const char* text,bool showMenu);
 
     void drawMultiline(int x, int y, const char *text);//helper automatic line wrap
 
@@ -76,12 +117,24 @@ class EFDisplayClass {
      *
      * @param multiplier Sets the Static Multiplier
      */
-    void   setStaticMultiplier(uint8_t multiplier) const;
+    void   setStaticMultiplier(uint8_t multiplier);
 
     private:
     // HUD state
-    bool   hudEnabled = false;
-    String hudLines[5]; // 5 short lines max
+    EFDisplayState pending;                  //!< State as set by the FSM
+    EFSnapshot<EFDisplayState> state;        //!< Latest published state, read by the render loop
+    std::atomic<bool> render_hold{false};    //!< Set while init() needs exclusive access to the display
+    std::atomic<bool> rendering{false};      //!< Set while loop() draws a frame
+
+        /**
+         * @brief Hands the pending state over to the render loop
+         */
+    void   publishState();
+
+        /**
+         * @brief Draws a frame. Called by loop() unless init() holds the display.
+         */
+    void   render();
 
 
         /**
@@ -0,0 +1,229 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cstring>
+
+#include <Arduino.h>
+
+#include <EFBoard.h>
+#include <EFIdle.h>
+#include <EFLed.h>
+#include <EFRadio.h>
+
+#include "EFEnergy.h"
+
+const char* toString(EFEnergyConsumer consumer) {
+    switch (consumer) {
+        case EFEnergyConsumer::LED: return "led";
+        case EFEnergyConsumer::CPU: return "cpu";
+        case EFEnergyConsumer::Radio: return "radio";
+        case EFEnergyConsumer::Display: return "display";
+        default: return "UNKNOWN";
+    }
+}
+
+float EFEnergyStats::getChargeMah() const {
+    uint64_t sum = 0;
+    for (uint8_t i = 0; i < EFENERGY_NUM_CONSUMERS; i++) {
+        sum += this->charge_mams[i];
+    }
+    return sum / 3600000.0f;
+}
+
+float EFEnergyStats::getAverageMilliamps() const {
+    return this->total_ms > 0 ? this->getChargeMah() * 3600000.0f / this->total_ms : 0.0f;
+}
+
+EFEnergyClass::EFEnergyClass()
+: drained_mams(0)
+, last_led_mams(0)
+, last_asleep_us(0)
+, last_ms(0)
+, has_last(false)
+, display_on(false)
+, current_ma(0.0f)
+, average_ma(0.0f)
+, trend_start_ms(0)
+, trend_start_percent(0)
+, trend_percent_per_hour(0.0f)
+{
+    this->reset();
+}
+
+void EFEnergyClass::sample(const char* state, uint32_t now_ms) {
+    // Light sleep time is only accounted per state, sum it up
+    uint64_t asleep_us = 0;
+    for (uint8_t i = 0; i < EFIdle.getStateCount(); i++) {
+        asleep_us += EFIdle.getStats(i)->asleep_us;
+    }
+    const uint64_t led_mams = EFLed.getEstimatedCharge();
+
+    if (!this->has_last || now_ms == this->last_ms) {
+        this->last_ms = now_ms;
+        this->last_led_mams = led_mams;
+        this->last_asleep_us = asleep_us;
+        this->has_last = true;
+        return;
+    }
+    const uint32_t dt_ms = now_ms - this->last_ms;
+    // EFIdle statistics might have been reset in between
+    const uint64_t asleep_delta_us = asleep_us >= this->last_asleep_us ? asleep_us - this->last_asleep_us : asleep_us;
+    const float asleep = min(asleep_delta_us / (dt_ms * 1000.0f), 1.0f);
+
+    // LEDs run from the 5V boost converter, its input current rises as the battery drains
+    const float vbat = EFBoard.isBatteryPowered() ? EFBoard.getBatteryVoltage() : (EFBOARD_VBAT_MIN + EFBOARD_VBAT_MAX) / 2;
+    const float led_ma = (led_mams - this->last_led_mams) / (float) dt_ms * 5.0f / vbat * 100.0f / EFBOARD_BOOST_EFFICIENCY_PERCENT;
+    const float cpu_ma = (1.0f - asleep) * (EFENERGY_CPU_BASE_MA + EFENERGY_CPU_MA_PER_MHZ * getCpuFrequencyMhz())
+        + asleep * EFENERGY_LIGHT_SLEEP_MA
+        + EFENERGY_BOARD_MA;
+    float radio_ma = 0.0f;
+    if (EFRadio.isActive(EFRadioResource::BLE)) {
+        radio_ma += EFENERGY_BLE_MA;
+    }
+    if (EFRadio.isActive(EFRadioResource::WiFiSTA) || EFRadio.isActive(EFRadioResource::WiFiAP)) {
+        radio_ma += EFENERGY_WIFI_MA;
+    }
+    const float display_ma = this->display_on ? EFENERGY_DISPLAY_MA : 0.0f;
+
+    const float consumer_ma[EFENERGY_NUM_CONSUMERS] = {led_ma, cpu_ma, radio_ma, display_ma};
+    EFEnergyStats* stats = this->getStats(state);
+    const bool drains_battery = EFBoard.isBatteryPowered();
+    this->current_ma = 0.0f;
+    for (uint8_t i = 0; i < EFENERGY_NUM_CONSUMERS; i++) {
+        const uint64_t charge_mams = (uint64_t) (consumer_ma[i] * dt_ms);
+        if (stats) {
+            stats->charge_mams[i] += charge_mams;
+        }
+        if (drains_battery) {
+            this->drained_mams += charge_mams;
+        }
+        this->current_ma += consumer_ma[i];
+    }
+    if (stats) {
+        stats->total_ms += dt_ms;
+    }
+
+    // Exponential moving average, weighted by the sample period
+    if (this->average_ma == 0.0f) {
+        this->average_ma = this->current_ma;
+    } else {
+        const float alpha = dt_ms / (EFENERGY_AVERAGE_TAU_S * 1000.0f + dt_ms);
+        this->average_ma += alpha * (this->current_ma - this->average_ma);
+    }
+
+    this->last_ms = now_ms;
+    this->last_led_mams = led_mams;
+    this->last_asleep_us = asleep_us;
+
+    EFBoard.learnDischarge(this->getDrainedMah());
+    this->updateTrend(now_ms);
+}
+
+void EFEnergyClass::updateTrend(uint32_t now_ms) {
+    if (!EFBoard.isBatteryPowered()) {
+        this->trend_start_ms = 0;
+        this->trend_percent_per_hour = 0.0f;
+        return;
+    }
+
+    const uint8_t percent = EFBoard.getBatteryCapacityPercent();
+    if (this->trend_start_ms == 0 || percent > this->trend_start_percent) {
+        // First sample on battery or charged in between: Start over
+        this->trend_start_ms = now_ms | 1;
+        this->trend_start_percent = percent;
+        return;
+    }
+
+    const uint32_t elapsed_ms = now_ms - this->trend_start_ms;
+    if (elapsed_ms >= EFENERGY_TREND_WINDOW_MS) {
+        this->trend_percent_per_hour = (this->trend_start_percent - percent) * 3600000.0f / elapsed_ms;
+        this->trend_start_ms = now_ms | 1;
+        this->trend_start_percent = percent;
+    }
+}
+
+void EFEnergyClass::setDisplayOn(bool on) {
+    this->display_on = on;
+}
+
+float EFEnergyClass::getCurrentMilliamps() const {
+    return this->current_ma;
+}
+
+float EFEnergyClass::getAverageMilliamps() const {
+    return this->average_ma;
+}
+
+float EFEnergyClass::getDrainedMah() const {
+    return this->drained_mams / 3600000.0f;
+}
+
+float EFEnergyClass::getTrendPercentPerHour() const {
+    return this->trend_percent_per_hour;
+}
+
+float EFEnergyClass::getHoursRemaining() const {
+    if (!EFBoard.isBatteryPowered() || this->average_ma <= 0.0f) {
+        return -1.0f;
+    }
+
+    const uint8_t percent = EFBoard.getBatteryCapacityPercent();
+    const float model_h = percent / 100.0f * EFBoard.getBatteryCapacityMah() / this->average_ma;
+    if (this->trend_percent_per_hour <= 0.0f) {
+        return model_h;
+    }
+    return (model_h + percent / this->trend_percent_per_hour) / 2;
+}
+
+EFEnergyStats* EFEnergyClass::getStats(const char* state) {
+    for (uint8_t i = 0; i < EFENERGY_MAX_STATES; i++) {
+        if (this->states[i].name == nullptr) {
+            this->states[i].name = state;
+            return &this->states[i];
+        }
+        // State names are string literals, compare the pointer first
+        if (this->states[i].name == state || strcmp(this->states[i].name, state) == 0) {
+            return &this->states[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t EFEnergyClass::getStateCount() const {
+    uint8_t n = 0;
+    while (n < EFENERGY_MAX_STATES && this->states[n].name != nullptr) {
+        n++;
+    }
+    return n;
+}
+
+const EFEnergyStats* EFEnergyClass::getStats(uint8_t idx) const {
+    return idx < this->getStateCount() ? &this->states[idx] : nullptr;
+}
+
+void EFEnergyClass::reset() {
+    memset(this->states, 0, sizeof(this->states));
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFENERGY)
+EFEnergyClass EFEnergy;
+#endif
@@ -0,0 +1,219 @@
+#ifndef EFENERGY_H_
+#define EFENERGY_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+#ifndef EFENERGY_CPU_BASE_MA
+#define EFENERGY_CPU_BASE_MA 12.0f      //!< Current drawn by the awake CPU, extrapolated to 0 MHz
+#endif
+
+#ifndef EFENERGY_CPU_MA_PER_MHZ
+#define EFENERGY_CPU_MA_PER_MHZ 0.1f    //!< Additional current drawn by the awake CPU per MHz
+#endif
+
+#ifndef EFENERGY_LIGHT_SLEEP_MA
+#define EFENERGY_LIGHT_SLEEP_MA 1.0f    //!< Current drawn by the CPU in light sleep
+#endif
+
+#ifndef EFENERGY_BOARD_MA
+#define EFENERGY_BOARD_MA 2.0f          //!< Quiescent current of the regulators and the V_BAT divider
+#endif
+
+#ifndef EFENERGY_BLE_MA
+#define EFENERGY_BLE_MA 90.0f           //!< Current drawn while BLE is in use. Scanning keeps the receiver on all the time.
+#endif
+
+#ifndef EFENERGY_WIFI_MA
+#define EFENERGY_WIFI_MA 100.0f         //!< Current drawn while WiFi is in use, station or access point
+#endif
+
+#ifndef EFENERGY_DISPLAY_MA
+#define EFENERGY_DISPLAY_MA 10.0f       //!< Current drawn by the OLED while it is on
+#endif
+
+#ifndef EFENERGY_AVERAGE_TAU_S
+#define EFENERGY_AVERAGE_TAU_S 300      //!< Time constant of the moving average of the current
+#endif
+
+#ifndef EFENERGY_TREND_WINDOW_MS
+#define EFENERGY_TREND_WINDOW_MS 900000 //!< Period the capacity level trend is measured over
+#endif
+
+/**
+ * @brief Maximum number of states energy is accounted for
+ */
+#define EFENERGY_MAX_STATES 16
+
+/**
+ * @brief Part of the badge drawing current
+ */
+enum class EFEnergyConsumer : uint8_t {
+    LED,      //!< LEDs, see EFLedClass::getEstimatedCharge()
+    CPU,      //!< CPU, awake or in light sleep, and board quiescent current
+    Radio,    //!< BLE and WiFi, see EFRadio
+    Display,  //!< OLED
+};
+
+#define EFENERGY_NUM_CONSUMERS 4
+
+const char* toString(EFEnergyConsumer consumer);
+
+/**
+ * @brief Energy accounting for a single FSM state
+ */
+struct EFEnergyStats {
+    const char* name;                               //!< State name, nullptr if the slot is unused
+    uint64_t total_ms;                              //!< Time spent while the state was active
+    uint64_t charge_mams[EFENERGY_NUM_CONSUMERS];   //!< Charge drawn from the battery in mA*ms, per consumer
+
+    /**
+     * @brief Retrieves the total charge drawn while the state was active
+     *
+     * @return Charge in mAh
+     */
+    float getChargeMah() const;
+
+    /**
+     * @brief Retrieves the average current while the state was active
+     *
+     * @return Current in mA
+     */
+    float getAverageMilliamps() const;
+};
+
+/**
+ * @brief Estimates the battery current from what the badge is doing and
+ * accounts the drawn charge to the active state. Nothing on the board
+ * measures current, so the current of each consumer is modelled:
+ *
+ *  - LEDs: Integrated from the estimate of every transmitted frame, converted
+ *    to the battery side of the 5V boost converter
+ *  - CPU: Clock frequency and the time spent in light sleep, see EFIdle
+ *  - Radio and display: Fixed current while in use
+ *
+ * The integrated charge feeds the learned discharge curve of EFBoard. The
+ * remaining runtime combines the modelled current with the trend of the
+ * measured capacity level.
+ */
+class EFEnergyClass {
+
+    protected:
+
+        EFEnergyStats states[EFENERGY_MAX_STATES];  //!< Energy accounting per state
+        uint64_t drained_mams;                      //!< Charge drawn from the battery since boot, not cleared by reset()
+        uint64_t last_led_mams;                     //!< EFLedClass::getEstimatedCharge() during the previous sample()
+        uint64_t last_asleep_us;                    //!< Light sleep time of all states during the previous sample()
+        uint32_t last_ms;                           //!< Timestamp of the previous sample()
+        bool has_last;                              //!< False until the first sample()
+        bool display_on;                            //!< OLED is powered
+        float current_ma;                           //!< Current during the previous sample period
+        float average_ma;                           //!< Moving average of current_ma
+        uint32_t trend_start_ms;                    //!< Start of the running trend window, 0 if none is running
+        uint8_t trend_start_percent;                //!< Capacity level at trend_start_ms
+        float trend_percent_per_hour;               //!< Capacity level drop of the last complete window, 0 if unknown
+
+        /**
+         * @brief Retrieves the accounting slot of the given state, creating it if required
+         *
+         * @return Slot or nullptr if EFENERGY_MAX_STATES is exceeded
+         */
+        EFEnergyStats* getStats(const char* state);
+
+        /**
+         * @brief Follows the capacity level over EFENERGY_TREND_WINDOW_MS
+         */
+        void updateTrend(uint32_t now_ms);
+
+    public:
+
+        EFEnergyClass();
+
+        /**
+         * @brief Accounts the charge drawn since the previous call to the given
+         * state. Should be called regularly, right after EFBoardClass::sampleBattery().
+         *
+         * @param state Name of the active state
+         * @param now_ms Current time
+         */
+        void sample(const char* state, uint32_t now_ms);
+
+        /**
+         * @brief Informs about the OLED being powered on or off
+         */
+        void setDisplayOn(bool on);
+
+        /**
+         * @brief Retrieves the modelled current during the last sample period
+         *
+         * @return Current in mA
+         */
+        float getCurrentMilliamps() const;
+
+        /**
+         * @brief Retrieves the moving average of the modelled current
+         *
+         * @return Current in mA
+         */
+        float getAverageMilliamps() const;
+
+        /**
+         * @brief Retrieves the charge drawn from the battery since boot. Time
+         * on USB power is not counted.
+         *
+         * @return Charge in mAh
+         */
+        float getDrainedMah() const;
+
+        /**
+         * @brief Retrieves the capacity level drop measured over the last
+         * complete trend window
+         *
+         * @return Percent per hour, 0 if unknown
+         */
+        float getTrendPercentPerHour() const;
+
+        /**
+         * @brief Estimates the remaining runtime on battery. Averages the
+         * estimate from the modelled current and the remaining capacity with
+         * the one from the capacity level trend, if known.
+         *
+         * @return Remaining runtime in hours, negative if unknown or not on battery
+         */
+        float getHoursRemaining() const;
+
+        uint8_t getStateCount() const;
+        const EFEnergyStats* getStats(uint8_t idx) const;
+
+        /**
+         * @brief Clears the per state statistics
+         */
+        void reset();
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFENERGY)
+extern EFEnergyClass EFEnergy;
+#endif
+
+#endif /* EFENERGY_H_ */
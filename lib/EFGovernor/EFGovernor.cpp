@@ -0,0 +1,179 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cstring>
+
+#include <Arduino.h>
+
+#include <EFLogging.h>
+#include <EFRadio.h>
+
+#include "EFGovernor.h"
+
+/**
+ * @brief Frequencies the governor switches between. 80, 160 and 240 MHz share
+ * the 80 MHz APB clock, so peripherals keep running across switches.
+ */
+static const uint32_t frequencies_mhz[EFGOVERNOR_NUM_FREQUENCIES] = {40, 80, 160, 240};
+
+/**
+ * @brief Retrieves the lowest frequency that is at least the given one
+ */
+static uint8_t indexOf(uint32_t mhz) {
+    for (uint8_t i = 0; i < EFGOVERNOR_NUM_FREQUENCIES; i++) {
+        if (frequencies_mhz[i] >= mhz) {
+            return i;
+        }
+    }
+    return EFGOVERNOR_NUM_FREQUENCIES - 1;
+}
+
+const char* toString(EFGovernorPerf perf) {
+    switch (perf) {
+        case EFGovernorPerf::Low: return "low";
+        case EFGovernorPerf::Normal: return "normal";
+        case EFGovernorPerf::High: return "high";
+        default: return "UNKNOWN";
+    }
+}
+
+EFGovernorClass::EFGovernorClass()
+: perf(EFGovernorPerf::Normal)
+, freq_idx(indexOf(80))  // EFBoardClass::setup() starts at 80 MHz
+, busy_us(0)
+, window_start_ms(0)
+, load_percent(0)
+, since_ms(0)
+, switches(0)
+{
+    memset(this->time_ms, 0, sizeof(this->time_ms));
+}
+
+void EFGovernorClass::getRange(uint8_t& min_idx, uint8_t& max_idx) const {
+    switch (this->perf) {
+        case EFGovernorPerf::Low: min_idx = 0; max_idx = indexOf(80); break;
+        case EFGovernorPerf::High: min_idx = indexOf(160); max_idx = indexOf(240); break;
+        default: min_idx = 0; max_idx = indexOf(160); break;
+    }
+
+    uint32_t floor_mhz = EFGOVERNOR_MIN_MHZ;
+    for (uint8_t i = 0; i < EFRADIO_NUM_RESOURCES; i++) {
+        if (EFRadio.isActive(static_cast<EFRadioResource>(i))) {
+            floor_mhz = max(floor_mhz, (uint32_t) EFGOVERNOR_RADIO_MIN_MHZ);
+        }
+    }
+    min_idx = max(min_idx, indexOf(floor_mhz));
+    max_idx = max(max_idx, min_idx);
+}
+
+void EFGovernorClass::select(uint8_t idx, uint32_t now_ms) {
+    if (idx == this->freq_idx) {
+        return;
+    }
+
+    this->time_ms[this->freq_idx] += now_ms - this->since_ms;
+    this->since_ms = now_ms;
+    this->freq_idx = idx;
+    this->switches++;
+    setCpuFrequencyMhz(frequencies_mhz[idx]);
+    LOGF_DEBUG("(EFGovernor) Set CPU frequency to %lu MHz\r\n", (unsigned long) frequencies_mhz[idx]);
+}
+
+void EFGovernorClass::setPerf(EFGovernorPerf perf) {
+    uint8_t min_idx;
+    uint8_t max_idx;
+    const uint32_t now_ms = millis();
+
+    this->perf = perf;
+    this->getRange(min_idx, max_idx);
+    this->select(min_idx, now_ms);
+
+    // The load of the previous state says nothing about the new one
+    this->busy_us = 0;
+    this->window_start_ms = now_ms;
+}
+
+EFGovernorPerf EFGovernorClass::getPerf() const {
+    return this->perf;
+}
+
+void EFGovernorClass::ensureMhz(uint32_t mhz) {
+    const uint8_t idx = indexOf(mhz);
+    if (this->freq_idx < idx) {
+        this->select(idx, millis());
+    }
+}
+
+void EFGovernorClass::addBusy(uint32_t us) {
+    this->busy_us += us;
+}
+
+void EFGovernorClass::update(uint32_t now_ms) {
+    const uint32_t elapsed_ms = now_ms - this->window_start_ms;
+    if (elapsed_ms < EFGOVERNOR_WINDOW_MS) {
+        return;
+    }
+    this->load_percent = min(this->busy_us / (elapsed_ms * 10), (uint32_t) 100);
+    this->busy_us = 0;
+    this->window_start_ms = now_ms;
+
+    // One step at a time, the load is measured again at the new frequency
+    uint8_t min_idx;
+    uint8_t max_idx;
+    this->getRange(min_idx, max_idx);
+    uint8_t idx = this->freq_idx;
+    if (this->load_percent > EFGOVERNOR_UP_PERCENT && idx < max_idx) {
+        idx++;
+    } else if (this->load_percent < EFGOVERNOR_DOWN_PERCENT && idx > min_idx) {
+        idx--;
+    }
+    this->select(constrain(idx, min_idx, max_idx), now_ms);
+}
+
+uint8_t EFGovernorClass::getLoadPercent() const {
+    return this->load_percent;
+}
+
+uint32_t EFGovernorClass::getFrequencyMhz(uint8_t idx) {
+    return idx < EFGOVERNOR_NUM_FREQUENCIES ? frequencies_mhz[idx] : 0;
+}
+
+uint64_t EFGovernorClass::getTimeMs(uint8_t idx) const {
+    if (idx >= EFGOVERNOR_NUM_FREQUENCIES) {
+        return 0;
+    }
+    return this->time_ms[idx] + (idx == this->freq_idx ? millis() - this->since_ms : 0);
+}
+
+uint32_t EFGovernorClass::getSwitchCount() const {
+    return this->switches;
+}
+
+void EFGovernorClass::reset() {
+    memset(this->time_ms, 0, sizeof(this->time_ms));
+    this->since_ms = millis();
+    this->switches = 0;
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFGOVERNOR)
+EFGovernorClass EFGovernor;
+#endif
@@ -0,0 +1,164 @@
+#ifndef EFGOVERNOR_H_
+#define EFGOVERNOR_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+#ifndef EFGOVERNOR_MIN_MHZ
+/**
+ * @brief Lowest CPU frequency the governor selects. Below 80 MHz the APB
+ * clock drops with the CPU clock, which breaks the LED timing of the RMT
+ * peripheral set up by FastLED.
+ */
+#define EFGOVERNOR_MIN_MHZ 80
+#endif
+
+/**
+ * @brief CPU frequency WiFi and BLE require, regardless of EFGOVERNOR_MIN_MHZ
+ */
+#define EFGOVERNOR_RADIO_MIN_MHZ 80
+
+#ifndef EFGOVERNOR_WINDOW_MS
+#define EFGOVERNOR_WINDOW_MS 500        //!< Period the load is measured over before the frequency is adjusted
+#endif
+
+#ifndef EFGOVERNOR_UP_PERCENT
+#define EFGOVERNOR_UP_PERCENT 70        //!< Load above which the next higher frequency is selected
+#endif
+
+#ifndef EFGOVERNOR_DOWN_PERCENT
+#define EFGOVERNOR_DOWN_PERCENT 25      //!< Load below which the next lower frequency is selected
+#endif
+
+/**
+ * @brief Number of CPU frequencies the governor switches between, see
+ * EFGovernorClass::getFrequencyMhz()
+ */
+#define EFGOVERNOR_NUM_FREQUENCIES 4
+
+/**
+ * @brief Performance class declared by a FSM state
+ */
+enum class EFGovernorPerf : uint8_t {
+    Low,     //!< Static output, always runs at the lowest frequency
+    Normal,  //!< Animations, boosts up to 160 MHz under load
+    High,    //!< Radio or signal processing, starts at 160 MHz and boosts up to 240 MHz
+};
+
+const char* toString(EFGovernorPerf perf);
+
+/**
+ * @brief CPU frequency governor: Selects the CPU frequency from the
+ * performance class of the active state and the measured load.
+ *
+ * On a transition, the frequency is reset to the lowest one of the new
+ * class. Every EFGOVERNOR_WINDOW_MS, the share of time spent executing
+ * scheduled work moves it one step up or down within the class. The time
+ * spent at each frequency is accounted to quantify the battery impact.
+ */
+class EFGovernorClass {
+
+    protected:
+
+        EFGovernorPerf perf;                                 //!< Performance class of the active state
+        uint8_t freq_idx;                                    //!< Selected frequency
+        uint32_t busy_us;                                    //!< Time spent executing work during the running window
+        uint32_t window_start_ms;                            //!< Start of the running window
+        uint8_t load_percent;                                //!< Load of the last complete window
+        uint32_t since_ms;                                   //!< Start of the time not yet accounted to freq_idx
+        uint64_t time_ms[EFGOVERNOR_NUM_FREQUENCIES];        //!< Time spent at each frequency
+        uint32_t switches;                                   //!< Number of frequency changes
+
+        /**
+         * @brief Retrieves the frequency range of the active class, respecting
+         * EFGOVERNOR_MIN_MHZ and active radios
+         */
+        void getRange(uint8_t& min_idx, uint8_t& max_idx) const;
+
+        /**
+         * @brief Switches to the given frequency and accounts the time spent
+         * at the previous one
+         */
+        void select(uint8_t idx, uint32_t now_ms);
+
+    public:
+
+        EFGovernorClass();
+
+        /**
+         * @brief Sets the performance class of the active state. Called by the
+         * FSM on every transition.
+         */
+        void setPerf(EFGovernorPerf perf);
+        EFGovernorPerf getPerf() const;
+
+        /**
+         * @brief Raises the frequency to at least the given one until the next
+         * adjustment, e.g., before bringing up a radio stack
+         */
+        void ensureMhz(uint32_t mhz);
+
+        /**
+         * @brief Accounts time spent executing work to the running window
+         */
+        void addBusy(uint32_t us);
+
+        /**
+         * @brief Closes the running window if EFGOVERNOR_WINDOW_MS passed and
+         * adjusts the frequency to the measured load. Should be called at
+         * least every EFGOVERNOR_WINDOW_MS.
+         */
+        void update(uint32_t now_ms);
+
+        /**
+         * @brief Retrieves the load of the last complete window
+         *
+         * @return Share of time spent executing work in percent
+         */
+        uint8_t getLoadPercent() const;
+
+        /**
+         * @brief Retrieves the given frequency of the ones the governor switches between
+         */
+        static uint32_t getFrequencyMhz(uint8_t idx);
+
+        /**
+         * @brief Retrieves the time spent at the given frequency, including the
+         * running period if it is the selected one
+         */
+        uint64_t getTimeMs(uint8_t idx) const;
+
+        uint32_t getSwitchCount() const;
+
+        /**
+         * @brief Clears the time accounting
+         */
+        void reset();
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFGOVERNOR)
+extern EFGovernorClass EFGovernor;
+#endif
+
+#endif /* EFGOVERNOR_H_ */
@@ -0,0 +1,161 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cstring>
+
+#include <Arduino.h>
+
+#include <EFBoard.h>
+#include <EFLed.h>
+#include <EFRadio.h>
+#include <EFTouch.h>
+
+#include "EFIdle.h"
+
+const char* toString(EFIdleBlocker blocker) {
+    switch (blocker) {
+        case EFIdleBlocker::None: return "none";
+        case EFIdleBlocker::Disabled: return "disabled";
+        case EFIdleBlocker::Deadline: return "deadline";
+        case EFIdleBlocker::Touch: return "touch";
+        case EFIdleBlocker::Radio: return "radio";
+        case EFIdleBlocker::UsbPower: return "usb";
+        case EFIdleBlocker::LedOutput: return "led";
+        default: return "UNKNOWN";
+    }
+}
+
+float EFIdleStats::getAsleepPercent() const {
+    return this->total_us > 0 ? 100.0f * this->asleep_us / this->total_us : 0.0f;
+}
+
+EFIdleClass::EFIdleClass()
+: last_us(0)
+, has_last(false)
+, enabled(true)
+{
+    this->reset();
+}
+
+void EFIdleClass::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool EFIdleClass::isEnabled() const {
+    return this->enabled;
+}
+
+EFIdleBlocker EFIdleClass::getBlocker(uint32_t budget_ms) const {
+    if (!this->enabled) {
+        return EFIdleBlocker::Disabled;
+    }
+    if (budget_ms < EFIDLE_MIN_SLEEP_MS) {
+        return EFIdleBlocker::Deadline;
+    }
+    if (EFTouch.isTouchActive()) {
+        return EFIdleBlocker::Touch;
+    }
+    for (uint8_t i = 0; i < EFRADIO_NUM_RESOURCES; i++) {
+        if (EFRadio.isActive(static_cast<EFRadioResource>(i))) {
+            return EFIdleBlocker::Radio;
+        }
+    }
+    if (EFBoard.getPowerState() == EFBoardPowerState::USB) {
+        return EFIdleBlocker::UsbPower;
+    }
+    if (!EFLed.isOutputIdle()) {
+        return EFIdleBlocker::LedOutput;
+    }
+    return EFIdleBlocker::None;
+}
+
+EFIdleBlocker EFIdleClass::idle(const char* state, uint32_t budget_ms) {
+    EFIdleStats* stats = this->getStats(state);
+    const EFIdleBlocker blocker = this->getBlocker(budget_ms);
+
+    if (blocker == EFIdleBlocker::None) {
+        const uint32_t sleep_ms = min(budget_ms, (uint32_t) EFIDLE_MAX_SLEEP_MS);
+        esp_sleep_enable_timer_wakeup(sleep_ms * 1000ULL);
+        esp_sleep_enable_touchpad_wakeup();
+        const uint32_t start_us = micros();
+        esp_light_sleep_start();
+        if (stats) {
+            stats->asleep_us += micros() - start_us;
+            stats->sleeps++;
+            if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TOUCHPAD) {
+                stats->touch_wakeups++;
+            }
+        }
+    } else {
+        this->blocked[static_cast<uint8_t>(blocker)]++;
+    }
+
+    // Account everything since the previous call, awake and asleep, to the active state
+    const uint32_t now_us = micros();
+    if (stats && this->has_last) {
+        stats->total_us += now_us - this->last_us;
+    }
+    this->last_us = now_us;
+    this->has_last = true;
+
+    return blocker;
+}
+
+EFIdleStats* EFIdleClass::getStats(const char* state) {
+    for (uint8_t i = 0; i < EFIDLE_MAX_STATES; i++) {
+        if (this->states[i].name == nullptr) {
+            this->states[i].name = state;
+            return &this->states[i];
+        }
+        // State names are string literals, compare the pointer first
+        if (this->states[i].name == state || strcmp(this->states[i].name, state) == 0) {
+            return &this->states[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t EFIdleClass::getStateCount() const {
+    uint8_t n = 0;
+    while (n < EFIDLE_MAX_STATES && this->states[n].name != nullptr) {
+        n++;
+    }
+    return n;
+}
+
+const EFIdleStats* EFIdleClass::getStats(uint8_t idx) const {
+    return idx < this->getStateCount() ? &this->states[idx] : nullptr;
+}
+
+uint32_t EFIdleClass::getBlockedCount(EFIdleBlocker blocker) const {
+    return this->blocked[static_cast<uint8_t>(blocker)];
+}
+
+void EFIdleClass::reset() {
+    memset(this->states, 0, sizeof(this->states));
+    memset(this->blocked, 0, sizeof(this->blocked));
+    this->has_last = false;
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFIDLE)
+EFIdleClass EFIdle;
+#endif
@@ -0,0 +1,139 @@
+#ifndef EFIDLE_H_
+#define EFIDLE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+/**
+ * @brief Shortest idle period worth entering light sleep for. Entering and
+ * leaving light sleep takes roughly a millisecond.
+ */
+#define EFIDLE_MIN_SLEEP_MS 3
+
+/**
+ * @brief Longest single light sleep period. Caps sleeping if no deadline is known.
+ */
+#define EFIDLE_MAX_SLEEP_MS 1000
+
+/**
+ * @brief Maximum number of states time is accounted for
+ */
+#define EFIDLE_MAX_STATES 16
+
+
+/**
+ * @brief Reason why the idle governor did or did not enter light sleep
+ */
+enum class EFIdleBlocker : uint8_t {
+    None,       //!< Nothing prevented light sleep
+    Disabled,   //!< Governor is disabled
+    Deadline,   //!< Next deadline is closer than EFIDLE_MIN_SLEEP_MS
+    Touch,      //!< A zone is touched. Only touching wakes from light sleep, releasing does not.
+    Radio,      //!< BLE or WiFi is in use, see EFRadio
+    UsbPower,   //!< Running on USB power, light sleep would drop the USB console
+    LedOutput,  //!< A LED frame is still being transmitted
+};
+
+#define EFIDLE_NUM_BLOCKERS 7
+
+const char* toString(EFIdleBlocker blocker);
+
+/**
+ * @brief Time accounting for a single FSM state
+ */
+struct EFIdleStats {
+    const char* name;        //!< State name, nullptr if the slot is unused
+    uint64_t total_us;       //!< Time spent while the state was active
+    uint64_t asleep_us;      //!< Part of total_us spent in light sleep
+    uint32_t sleeps;         //!< Number of light sleep periods
+    uint32_t touch_wakeups;  //!< Number of light sleep periods ended early by a touch
+
+    /**
+     * @brief Retrieves the fraction of time spent asleep in percent
+     */
+    float getAsleepPercent() const;
+};
+
+/**
+ * @brief Idle governor: Puts the CPU into light sleep until the next deadline
+ * instead of busy-polling in loop(). Touch interrupts and the timer wake it up.
+ */
+class EFIdleClass {
+
+    protected:
+
+        EFIdleStats states[EFIDLE_MAX_STATES];        //!< Time accounting per state
+        uint32_t blocked[EFIDLE_NUM_BLOCKERS];        //!< Number of idle() calls that did not sleep, per reason
+        uint32_t last_us;                             //!< micros() at the end of the previous idle() call
+        bool has_last;                                //!< False until the first idle() call after a reset
+        bool enabled;                                 //!< Light sleep is allowed
+
+        /**
+         * @brief Retrieves the accounting slot of the given state, creating it if required
+         *
+         * @return Slot or nullptr if EFIDLE_MAX_STATES is exceeded
+         */
+        EFIdleStats* getStats(const char* state);
+
+    public:
+
+        EFIdleClass();
+
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+
+        /**
+         * @brief Determines what keeps the CPU from sleeping for the given time
+         *
+         * @param budget_ms Milliseconds until the next deadline
+         * @return EFIdleBlocker::None if light sleep is possible
+         */
+        EFIdleBlocker getBlocker(uint32_t budget_ms) const;
+
+        /**
+         * @brief Enters light sleep for up to budget_ms unless something blocks
+         * it. Accounts the time since the previous call to the given state.
+         *
+         * @param state Name of the active state
+         * @param budget_ms Milliseconds until the next deadline, see
+         * EFSchedulerClass::getTimeUntilNextWork()
+         * @return Reason why no light sleep was entered or EFIdleBlocker::None
+         */
+        EFIdleBlocker idle(const char* state, uint32_t budget_ms);
+
+        uint8_t getStateCount() const;
+        const EFIdleStats* getStats(uint8_t idx) const;
+        uint32_t getBlockedCount(EFIdleBlocker blocker) const;
+
+        /**
+         * @brief Clears all statistics
+         */
+        void reset();
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFIDLE)
+extern EFIdleClass EFIdle;
+#endif
+
+#endif /* EFIDLE_H_ */
@@ -24,36 +24,75 @@
  * @author Honigeintopf
  */
 
+#include <algorithm>
+
 #include <Arduino.h>
 #include <FastLED.h>
 
 #include <EFLogging.h>
+#include <EFTrace.h>
 
 #include "EFLed.h"
+#include "EFLedEffect.h"
+#include "EFLedGeometry.h"
+#include "EFLedPower.h"
+
+#ifdef EFLED_ASYNC_OUTPUT
+#include "EFLedPipeline.h"
+
+/**
+ * @brief Backend that transmits frames via FastLED from its own buffer, so
+ * the render loop can keep modifying led_data during transmission.
+ */
+class EFLedFastLEDBackend : public EFLedBackend<EFLED_TOTAL_NUM> {
+
+    public:
+
+        CRGB tx_data[EFLED_TOTAL_NUM];  //!< LED data registered with FastLED
 
-static const EFLedClass::LEDPosition led_positions[] = {
-    {17, 126},  // 0
-    {21, 106},
-    {23, 91},
-    {41, 86},
-    {35, 48},
-    {37, 43},  // 5
-    {61, 15},
-    {61, 27},
-    {61, 41},
-    {61, 54},
-    {61, 67},  // 10
-    {61, 79},
-    {61, 93},
-    {61, 105},
-    {61, 118},
-    {61, 131},  // 15
-    {61, 144}
+        bool write(const EFLedFrame<EFLED_TOTAL_NUM>& frame) override {
+            memcpy(this->tx_data, frame.rgb, sizeof(this->tx_data));
+            FastLED.show(frame.brightness);
+            return true;
+        }
 };
 
+static EFLedPipeline<EFLED_TOTAL_NUM> output_pipeline;
+static EFLedFastLEDBackend output_backend;
+static TaskHandle_t output_task = nullptr;
+
+/**
+ * @brief LED output task. Sleeps until frames are published and transmits the
+ * newest one. Frames published during a transmission are coalesced.
+ */
+static void ledOutputTask(void*) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (output_pipeline.service(output_backend)) {
+            // Transmit frames published during the last transmission
+        }
+    }
+}
+#endif
+
 EFLedClass::EFLedClass()
 : max_brightness(0)
 , led_data({0})
+, out_data({0})
+, shown_data({0})
+, shown_brightness(0)
+, frame_depth(0)
+, show_count(0)
+, frames_skipped(0)
+, shows_in_window(0)
+, shows_per_second(0)
+, window_start_ms(0)
+, estimated_ma(0)
+, charge_mams(0)
+, charge_ms(0)
+, frames_limited(0)
+, overlay_data({0})
+, overlay_mask(0)
 {
 }
 
@@ -64,11 +103,37 @@ void EFLedClass::init() {
 void EFLedClass::init(const uint8_t absolute_max_brightness) {
     for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
         this->led_data[i] = CRGB::Black;
+        this->out_data[i] = CRGB::Black;
+        this->shown_data[i] = CRGB::Black;
     }
+    this->effect.stop();
+    this->overlay_mask = 0;
+    this->frame_depth = 0;
+    this->show_count = 0;
+    this->frames_skipped = 0;
+    this->shows_in_window = 0;
+    this->shows_per_second = 0;
+    this->window_start_ms = millis();
+    this->estimated_ma = 0;
+    this->charge_mams = 0;
+    this->charge_ms = millis();
+    this->frames_limited = 0;
     LOG_INFO("(EFLed) Initialized internal LED data struct");
 
     FastLED.clearData();
-    FastLED.addLeds<WS2812B, EFLED_PIN_LED_DATA, GRB>(this->led_data, EFLED_TOTAL_NUM);
+#ifdef EFLED_ASYNC_OUTPUT
+    FastLED.addLeds<WS2812B, EFLED_PIN_LED_DATA, GRB>(output_backend.tx_data, EFLED_TOTAL_NUM);
+    if (output_task == nullptr) {
+        xTaskCreatePinnedToCore(
+            ledOutputTask, "EFLedOutput",
+            EFLED_ASYNC_OUTPUT_STACK, nullptr, EFLED_ASYNC_OUTPUT_PRIORITY, &output_task,
+            EFLED_ASYNC_OUTPUT_CORE
+        );
+        LOGF_INFO("(EFLed) Started LED output task on core %d\r\n", EFLED_ASYNC_OUTPUT_CORE);
+    }
+#else
+    FastLED.addLeds<WS2812B, EFLED_PIN_LED_DATA, GRB>(this->out_data, EFLED_TOTAL_NUM);
+#endif
     LOGF_DEBUG("(EFLed) Added new WS2812B: %d LEDs @ PIN %d\r\n", EFLED_TOTAL_NUM, EFLED_PIN_LED_DATA);
 
     this->max_brightness = absolute_max_brightness;
@@ -86,6 +151,12 @@ void EFLedClass::enablePower() {
 }
 
 void EFLedClass::disablePower() {
+#ifdef EFLED_ASYNC_OUTPUT
+    // Let the output task finish pending frames before cutting the power
+    for (uint8_t timeout_ms = 50; timeout_ms > 0 && !output_pipeline.idle(); timeout_ms--) {
+        delay(1);
+    }
+#endif
     digitalWrite(EFLED_PIN_5VBOOST_ENABLE, LOW);
     LOG_INFO("(EFLed) Disabled +5V boost converter");
     delay(10);
@@ -95,12 +166,222 @@ void EFLedClass::clear() {
     for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
         this->led_data[i] = CRGB::Black;
     }
-    FastLED.show();
+    this->show();
+}
+
+void EFLedClass::show() {
+    if (this->frame_depth > 0) {
+        return;
+    }
+
+    this->compose();
+    this->transmit();
+}
+
+void EFLedClass::compose() {
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        this->out_data[i] = (this->overlay_mask & EFLedMask::led(i)) ? this->overlay_data[i] : this->led_data[i];
+    }
+}
+
+void EFLedClass::transmit() {
+    // Sparse frames are scaled up towards the ceiling, frames exceeding the
+    // current budget of the boost converter are scaled down
+    const uint8_t* rgb = reinterpret_cast<const uint8_t*>(this->out_data);
+    const uint8_t brightness = EFLedPower::scaleBrightness(
+        rgb, EFLED_TOTAL_NUM, FastLED.getBrightness(),
+        this->max_brightness, EFLED_BRIGHTNESS_CEILING, EFLED_CURRENT_BUDGET_MA
+    );
+    if (brightness < FastLED.getBrightness()) {
+        this->frames_limited++;
+    }
+    const unsigned long now = millis();
+    this->charge_mams += (uint64_t) this->estimated_ma * (now - this->charge_ms);
+    this->charge_ms = now;
+    this->estimated_ma = EFLedPower::estimateMilliamps(rgb, EFLED_TOTAL_NUM, brightness);
+
+#ifdef EFLED_ASYNC_OUTPUT
+    if (output_task != nullptr) {
+        output_pipeline.publish(rgb, brightness);
+        xTaskNotifyGive(output_task);
+    } else {
+        output_pipeline.drop();
+    }
+#else
+    FastLED.show(brightness);
+#endif
+    EFTrace.commit(micros());
+    std::copy(this->out_data, this->out_data + EFLED_TOTAL_NUM, this->shown_data);
+    this->shown_brightness = FastLED.getBrightness();
+    this->show_count++;
+    this->updateShowRate();
+    this->shows_in_window++;
+}
+
+void EFLedClass::updateShowRate() {
+    const unsigned long elapsed_ms = millis() - this->window_start_ms;
+    if (elapsed_ms >= 1000) {
+        // Windows that passed without any push or frame count as zero
+        this->shows_per_second = elapsed_ms < 2000 ? this->shows_in_window : 0;
+        this->shows_in_window = 0;
+        this->window_start_ms = millis();
+    }
+}
+
+void EFLedClass::beginFrame() {
+    this->frame_depth++;
+}
+
+void EFLedClass::commitFrame() {
+    if (this->frame_depth == 0) {
+        LOG_WARNING("(EFLed) commitFrame() called without open frame");
+        return;
+    }
+    if (--this->frame_depth > 0) {
+        return;
+    }
+
+    // Skip pushing frames that would not change anything
+    this->compose();
+    if (
+        this->shown_brightness == FastLED.getBrightness() &&
+        std::equal(this->out_data, this->out_data + EFLED_TOTAL_NUM, this->shown_data)
+    ) {
+        this->frames_skipped++;
+        this->updateShowRate();
+        return;
+    }
+
+    this->transmit();
+}
+
+bool EFLedClass::isFrameOpen() const {
+    return this->frame_depth > 0;
+}
+
+void EFLedClass::playEffect(const EFLedKeyframe* keyframes, uint8_t count, uint32_t clip) {
+    if (this->effect.isActive()) {
+        this->applyEffectBrightness(this->effect.getFinalBrightness());
+    }
+    this->effect.play(keyframes, count, clip, millis(), this->getBrightnessPercent());
+    this->updateEffect();
+}
+
+bool EFLedClass::updateEffect() {
+    if (!this->effect.isActive() && this->overlay_mask == 0) {
+        return false;
+    }
+
+    uint8_t brightness;
+    bool playing = this->effect.render(millis(), this->overlay_data, this->overlay_mask, brightness);
+    if (!playing) {
+        brightness = this->effect.getFinalBrightness();
+    }
+    this->applyEffectBrightness(brightness);
+    this->show();
+
+    return playing;
+}
+
+void EFLedClass::stopEffect() {
+    if (!this->effect.isActive()) {
+        return;
+    }
+
+    this->effect.stop();
+    this->overlay_mask = 0;
+    this->applyEffectBrightness(this->effect.getFinalBrightness());
+    this->show();
+}
+
+void EFLedClass::finishEffect() {
+    while (this->updateEffect()) {
+        delay(EFLED_EFFECT_POLL_INTERVAL_MS);
+    }
+}
+
+bool EFLedClass::isEffectPlaying() const {
+    return this->effect.isActive();
+}
+
+void EFLedClass::applyEffectBrightness(uint8_t brightness) {
+    if (brightness == EFLED_EFFECT_KEEP_BRIGHTNESS) {
+        return;
+    }
+    FastLED.setBrightness(round((min(brightness, (uint8_t) 100) / (float) 100) * this->max_brightness));
+}
+
+EFLedSegment EFLedClass::all() {
+    return {this->led_data, EFLED_TOTAL_NUM};
+}
+
+EFLedSegment EFLedClass::dragon() {
+    return {this->led_data + EFLED_DARGON_OFFSET, EFLED_DRAGON_NUM};
+}
+
+EFLedSegment EFLedClass::efbar() {
+    return {this->led_data + EFLED_EFBAR_OFFSET, EFLED_EFBAR_NUM};
+}
+
+uint16_t EFLedClass::getEstimatedMilliamps() const {
+    return this->estimated_ma;
+}
+
+uint64_t EFLedClass::getEstimatedCharge() const {
+    return this->charge_mams + (uint64_t) this->estimated_ma * (millis() - this->charge_ms);
+}
+
+uint32_t EFLedClass::getLimitedFrameCount() const {
+    return this->frames_limited;
+}
+
+uint32_t EFLedClass::getCoalescedFrameCount() const {
+#ifdef EFLED_ASYNC_OUTPUT
+    return output_pipeline.getCoalescedCount();
+#else
+    return 0;
+#endif
+}
+
+uint32_t EFLedClass::getDroppedFrameCount() const {
+#ifdef EFLED_ASYNC_OUTPUT
+    return output_pipeline.getDroppedCount();
+#else
+    return 0;
+#endif
+}
+
+bool EFLedClass::isOutputIdle() const {
+#ifdef EFLED_ASYNC_OUTPUT
+    return output_pipeline.idle();
+#else
+    return true;
+#endif
+}
+
+uint16_t EFLedClass::getShowsPerSecond() const {
+    // Windows are only closed by pushes and frames, roll over once output stopped
+    const unsigned long elapsed_ms = millis() - this->window_start_ms;
+    if (elapsed_ms >= 2000) {
+        return 0;
+    }
+    if (elapsed_ms >= 1000) {
+        return this->shows_in_window;
+    }
+    return this->shows_per_second;
+}
+
+uint32_t EFLedClass::getShowCount() const {
+    return this->show_count;
+}
+
+uint32_t EFLedClass::getSkippedFrameCount() const {
+    return this->frames_skipped;
 }
 
 void EFLedClass::setBrightnessPercent(uint8_t brightness) {
     FastLED.setBrightness(round((min(brightness, (uint8_t) 100) / (float) 100) * this->max_brightness));
-    FastLED.show();
+    this->show();
 }
 
 uint8_t EFLedClass::getBrightnessPercent() const {
@@ -111,58 +392,58 @@ void EFLedClass::setAll(const CRGB color[EFLED_TOTAL_NUM]) {
     for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
         this->led_data[i] = color[i];
     }
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setAllSolid(const CRGB color) {
     for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
         this->led_data[i] = color;
     }
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragonNose(const CRGB color) {
     this->led_data[EFLED_DRAGON_NOSE_IDX] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragonMuzzle(const CRGB color) {
     this->led_data[EFLED_DRAGON_MUZZLE_IDX] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragonEye(const CRGB color) {
     this->led_data[EFLED_DRAGON_EYE_IDX] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragonCheek(const CRGB color) {
     this->led_data[EFLED_DRAGON_CHEEK_IDX] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragonEarBottom(const CRGB color) {
     this->led_data[EFLED_DRAGON_EAR_BOTTOM_IDX] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragonEarTop(const CRGB color) {
     this->led_data[EFLED_DRAGON_EAR_TOP_IDX] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setDragon(const CRGB color[EFLED_DRAGON_NUM]) {
     for (uint8_t i = 0; i < EFLED_DRAGON_NUM; i++) {
         this->led_data[EFLED_DARGON_OFFSET + i] = color[i];
     }
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setEFBar(const CRGB color[EFLED_EFBAR_NUM]) {
     for (uint8_t i = 0; i < EFLED_EFBAR_NUM; i++) {
         this->led_data[EFLED_EFBAR_OFFSET + i] = color[i];
     }
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setEFBar(uint8_t idx, const CRGB color) {
@@ -171,7 +452,7 @@ void EFLedClass::setEFBar(uint8_t idx, const CRGB color) {
     }
 
     this->led_data[EFLED_EFBAR_OFFSET + idx] = color;
-    FastLED.show();
+    this->show();
 }
 
 void EFLedClass::setEFBarCursor(
@@ -184,12 +465,12 @@ void EFLedClass::setEFBarCursor(
         uint8_t fade = static_cast<uint8_t>(std::clamp(distance * 64.0f, 0.0f, 255.0f));
         this->led_data[EFLED_EFBAR_OFFSET + i] = (i == idx) ? color_on : color_off.scale8(fade);
     }
-    FastLED.show();
+    this->show();
 }
 
 EFLedClass::LEDPosition EFLedClass::getLEDPosition(const uint8_t idx) {
-    if (idx < std::size(led_positions)) {
-        return led_positions[idx];
+    if (idx < EFLedGeometry::POSITIONS.size()) {
+        return {EFLedGeometry::POSITIONS[idx].x, EFLedGeometry::POSITIONS[idx].y};
     }
     return {0, 0};  // Returning default position (0, 0) for out-of-bounds
 }
@@ -206,7 +487,7 @@ void EFLedClass::fillEFBarProportionally(
     for (uint8_t i = num_leds_on; i < EFLED_EFBAR_NUM; i++) {
         this->led_data[EFLED_EFBAR_OFFSET + i] = color_off;
     }
-    FastLED.show();
+    this->show();
 }
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFLED)
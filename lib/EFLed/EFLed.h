@@ -30,21 +30,64 @@
 #define FASTLED_ALL_PINS_HARDWARE_SPI
 #define FASTLED_ESP32_SPI_BUS HSPI
 
+#include <cassert>
+
 #include <EFConfig.h>
 #include <FastLED.h>
 
+#include "EFLedEffect.h"
+
 
 
 /**
  * @brief Initial value for global maximum for the LED brightness, 0–255
  * Has a huge impact on battery life.
  *
- * WARNING: The 5V boost converter is unable to power all LEDs on a high brightness level! Max brightness of 255 works
- * only, if only a few LEDs are used at the same time. When using all LEDs even in a single color, values over 60 can
- * overwhelm it and cause the colors to glitch. To be safe, choose a value below 50!
+ * The 5V boost converter is unable to power all LEDs on a high brightness level. Each pushed frame is therefore
+ * dimmed dynamically to stay within EFLED_CURRENT_BUDGET_MA, so sparse frames can be shown at higher brightness
+ * levels than frames that light up all LEDs.
  */
 #define EFLED_MAX_BRIGHTNESS_DEFAULT 50
 
+/**
+ * @brief Interval in milliseconds at which finishEffect() advances the current effect
+ */
+#define EFLED_EFFECT_POLL_INTERVAL_MS 10
+
+
+/**
+ * @brief Non-owning view onto a contiguous range of LEDs inside the driver
+ * buffer (std::span-style). Writing through a segment only modifies the LED
+ * data. Changes become visible with the next EFLedClass::show() or
+ * EFLedClass::commitFrame().
+ */
+struct EFLedSegment {
+    CRGB* const ptr;      //!< First LED of this segment inside the driver buffer
+    const uint8_t count;  //!< Number of LEDs inside this segment
+
+    CRGB* data() const { return this->ptr; }
+    uint8_t size() const { return this->count; }
+    CRGB* begin() const { return this->ptr; }
+    CRGB* end() const { return this->ptr + this->count; }
+
+    /**
+     * @brief Accesses a single LED of this segment. Out of range indices
+     * trip an assert in debug builds and are clamped to the last LED of the
+     * segment otherwise, so they never touch neighbouring LED data.
+     */
+    CRGB& operator[](uint8_t idx) const {
+        assert(idx < this->count);
+        return this->ptr[idx < this->count ? idx : this->count - 1];
+    }
+
+    /**
+     * @brief Sets all LEDs of this segment to the given color
+     *
+     * @param color Color to set
+     */
+    void fill(const CRGB color) const { fill_solid(this->ptr, this->count, color); }
+};
+
 
 /**
  * @brief Driver for badge LEDs
@@ -54,7 +97,49 @@ class EFLedClass {
     protected:
 
         CRGB led_data[EFLED_TOTAL_NUM];  //!< Internal LED data structure
-        uint8_t max_brightness;  //!< Maximum raw brightness (0-255)
+        uint8_t max_brightness;  //!< Raw brightness (0-255) a brightness of 100 % refers to
+
+        CRGB out_data[EFLED_TOTAL_NUM];    //!< LED data composed with the effect overlay, as it is pushed
+        CRGB shown_data[EFLED_TOTAL_NUM];  //!< Copy of the LED data that was last pushed to the LEDs
+        uint8_t shown_brightness;          //!< Raw brightness that was active during the last push
+        uint8_t frame_depth;               //!< Number of currently open frames. Pushes are deferred while > 0
+
+        uint32_t show_count;               //!< Total number of pushes to the LEDs
+        uint32_t frames_skipped;           //!< Number of committed frames that were skipped because nothing changed
+        uint16_t shows_in_window;          //!< Number of pushes during the current one second window
+        uint16_t shows_per_second;         //!< Number of pushes during the last complete one second window
+        unsigned long window_start_ms;     //!< Start of the current one second window
+
+        uint16_t estimated_ma;             //!< Estimated current draw of the last pushed frame in mA
+        uint64_t charge_mams;              //!< Estimated charge drawn by all frames before the last push in mA * ms
+        unsigned long charge_ms;           //!< millis() of the last push, estimated_ma is drawn since then
+        uint32_t frames_limited;           //!< Number of pushes that were dimmed to stay within the current budget
+
+        EFLedEffectPlayer effect;          //!< Player for one-shot keyframe effects
+        CRGB overlay_data[EFLED_TOTAL_NUM];//!< Effect overlay, drawn above the LED data
+        uint32_t overlay_mask;             //!< LEDs currently covered by the effect overlay (see EFLedMask)
+
+        /**
+         * @brief Closes the current one second window for getShowsPerSecond(), if it elapsed
+         */
+        void updateShowRate();
+
+        /**
+         * @brief Composes the LED data and the effect overlay into out_data
+         */
+        void compose();
+
+        /**
+         * @brief Pushes out_data to the LEDs, applying current limiting
+         */
+        void transmit();
+
+        /**
+         * @brief Sets the global brightness on behalf of an effect without pushing
+         *
+         * @param brightness Brightness percent or EFLED_EFFECT_KEEP_BRIGHTNESS
+         */
+        void applyEffectBrightness(uint8_t brightness);
 
 
     public:
@@ -83,8 +168,9 @@ class EFLedClass {
          * @brief Initializes this EFLed instance. Creates internal data structures,
          * resets FastLED library and initializes power circuit.
          *
-         * @param absolute_max_brightness Maximum raw brightness (0-255) the LEDs will
-         * be allowed to be set to.
+         * @param absolute_max_brightness Raw brightness (0-255) a brightness of
+         * 100 % refers to. Sparse frames are shown brighter, up to
+         * EFLED_BRIGHTNESS_CEILING.
          */
         void init(const uint8_t absolute_max_brightness);
 
@@ -103,6 +189,181 @@ class EFLedClass {
          */
         void clear();
 
+        /**
+         * @brief Pushes the current LED data to the LEDs. While a frame is open
+         * (see beginFrame()), the push is deferred until commitFrame().
+         *
+         * Sparse frames are pushed with a brightness scaled up towards
+         * EFLED_BRIGHTNESS_CEILING, as far as EFLED_CURRENT_BUDGET_MA allows.
+         * Frames lighting up all LEDs may be dimmed slightly. The brightness
+         * setting itself is not altered.
+         *
+         * If EFLED_ASYNC_OUTPUT is enabled, the data is handed to the LED output
+         * task and this call returns without waiting for the transmission.
+         */
+        void show();
+
+        /**
+         * @brief Opens a frame. All setters only modify the LED data until the
+         * frame is committed using commitFrame(). Frames can be nested, only the
+         * outermost commitFrame() pushes the data to the LEDs.
+         */
+        void beginFrame();
+
+        /**
+         * @brief Closes the current frame. If this was the outermost frame, the
+         * LED data is pushed to the LEDs once, unless neither LED data nor
+         * brightness changed since the last push.
+         */
+        void commitFrame();
+
+        /**
+         * @brief Determines if a frame is currently open
+         *
+         * @return True, if pushes to the LEDs are currently deferred
+         */
+        bool isFrameOpen() const;
+
+        /**
+         * @brief Starts playing a keyframe effect on top of the current LED data.
+         * Returns immediately. The effect is advanced by updateEffect(), which the
+         * FSM calls every cycle. Replaces any currently playing effect.
+         *
+         * @param keyframes Keyframes of the effect. They are copied, so
+         * runtime-generated effects can live on the stack.
+         * @param count Number of keyframes
+         * @param clip LEDs covered by the effect. LEDs inside the clip that are not
+         * painted by the current keyframe are black. 0 = all LEDs used by any keyframe
+         */
+        void playEffect(const EFLedKeyframe* keyframes, uint8_t count, uint32_t clip = 0);
+
+        /**
+         * @brief Plays a keyframe effect given as array
+         */
+        template<uint8_t N>
+        void playEffect(const EFLedKeyframe (&keyframes)[N], uint32_t clip = 0) {
+            this->playEffect(keyframes, N, clip);
+        }
+
+        /**
+         * @brief Advances the current effect and pushes the result. Inside of a
+         * frame, the push is deferred until commitFrame().
+         *
+         * @return True, if the effect is still playing
+         */
+        bool updateEffect();
+
+        /**
+         * @brief Stops the current effect immediately. Brightness changes of the
+         * effect are applied as if it had played to the end.
+         */
+        void stopEffect();
+
+        /**
+         * @brief Plays the current effect to the end, blocking the caller. Only
+         * meant for situations in which the main loop does not run anymore.
+         */
+        void finishEffect();
+
+        /**
+         * @brief Determines if a keyframe effect is currently playing
+         *
+         * @return True, if an effect is playing
+         */
+        bool isEffectPlaying() const;
+
+        /**
+         * @brief Provides a view onto all LEDs
+         *
+         * @return Segment containing all LEDs
+         */
+        EFLedSegment all();
+
+        /**
+         * @brief Provides a view onto the dragon LEDs
+         *
+         * @return Segment containing the dragon LEDs (nose to top ear)
+         */
+        EFLedSegment dragon();
+
+        /**
+         * @brief Provides a view onto the EF bar LEDs
+         *
+         * @return Segment containing the EF bar LEDs (from top to bottom)
+         */
+        EFLedSegment efbar();
+
+        /**
+         * @brief Retrieves the number of pushes to the LEDs during the last second
+         *
+         * @return Number of pushes per second
+         */
+        uint16_t getShowsPerSecond() const;
+
+        /**
+         * @brief Retrieves the total number of pushes to the LEDs since init()
+         *
+         * @return Total number of pushes
+         */
+        uint32_t getShowCount() const;
+
+        /**
+         * @brief Retrieves the number of committed frames that were not pushed to
+         * the LEDs because their content did not change
+         *
+         * @return Number of skipped frames
+         */
+        uint32_t getSkippedFrameCount() const;
+
+        /**
+         * @brief Retrieves the number of frames that were replaced by a newer
+         * frame before the LED output task could transmit them. Always 0 if
+         * EFLED_ASYNC_OUTPUT is disabled.
+         *
+         * @return Number of coalesced frames
+         */
+        uint32_t getCoalescedFrameCount() const;
+
+        /**
+         * @brief Retrieves the estimated current drawn by the LEDs for the last
+         * pushed frame, after current limiting was applied
+         *
+         * @return Estimated current in mA
+         */
+        uint16_t getEstimatedMilliamps() const;
+
+        /**
+         * @brief Retrieves the estimated charge drawn by the LEDs since init(),
+         * integrated over the pushed frames and the time each was shown
+         *
+         * @return Estimated charge in mA * ms
+         */
+        uint64_t getEstimatedCharge() const;
+
+        /**
+         * @brief Retrieves the number of pushed frames that were dimmed to stay
+         * within EFLED_CURRENT_BUDGET_MA
+         *
+         * @return Number of limited frames
+         */
+        uint32_t getLimitedFrameCount() const;
+
+        /**
+         * @brief Retrieves the number of frames that could not be transmitted
+         * by the LED output task. Always 0 if EFLED_ASYNC_OUTPUT is disabled.
+         *
+         * @return Number of dropped frames
+         */
+        uint32_t getDroppedFrameCount() const;
+
+        /**
+         * @brief Determines if all frames were transmitted, e.g., before the CPU
+         * may enter light sleep. Always true if EFLED_ASYNC_OUTPUT is disabled.
+         *
+         * @return True, if no frame is pending or being transmitted
+         */
+        bool isOutputIdle() const;
+
         /**
          * @brief Sets the global brightness for all LEDs in percent, relative to max brightness
          *
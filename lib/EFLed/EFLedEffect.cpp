@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <EFLogging.h>
+
+#include "EFLedEffect.h"
+
+EFLedEffectPlayer::EFLedEffectPlayer()
+: count(0)
+, clip(0)
+, start_ms(0)
+, start_brightness(0)
+, active(false)
+{
+}
+
+void EFLedEffectPlayer::play(
+    const EFLedKeyframe* keyframes,
+    uint8_t count,
+    uint32_t clip,
+    unsigned long now_ms,
+    uint8_t brightness
+) {
+    if (count > EFLED_EFFECT_MAX_KEYFRAMES) {
+        LOGF_WARNING("(EFLedEffect) Effect too long, truncating %d keyframes\r\n", count - EFLED_EFFECT_MAX_KEYFRAMES);
+        count = EFLED_EFFECT_MAX_KEYFRAMES;
+    }
+
+    this->clip = clip;
+    for (uint8_t i = 0; i < count; i++) {
+        this->keyframes[i] = keyframes[i];
+        if (clip == 0) {
+            this->clip |= keyframes[i].mask;
+        }
+    }
+    this->clip &= EFLedMask::ALL;
+    this->count = count;
+    this->start_ms = now_ms;
+    this->start_brightness = brightness;
+    this->active = count > 0;
+}
+
+void EFLedEffectPlayer::stop() {
+    this->active = false;
+}
+
+bool EFLedEffectPlayer::isActive() const {
+    return this->active;
+}
+
+uint8_t EFLedEffectPlayer::getFinalBrightness() const {
+    for (int8_t i = this->count - 1; i >= 0; i--) {
+        if (this->keyframes[i].brightness != EFLED_EFFECT_KEEP_BRIGHTNESS) {
+            return this->keyframes[i].brightness;
+        }
+    }
+    return EFLED_EFFECT_KEEP_BRIGHTNESS;
+}
+
+bool EFLedEffectPlayer::render(
+    unsigned long now_ms,
+    CRGB overlay[EFLED_TOTAL_NUM],
+    uint32_t& mask,
+    uint8_t& brightness
+) {
+    mask = 0;
+    brightness = EFLED_EFFECT_KEEP_BRIGHTNESS;
+    if (!this->active) {
+        return false;
+    }
+
+    // Find keyframe that is active at the given time
+    unsigned long elapsed = now_ms - this->start_ms;
+    unsigned long keyframe_start = 0;
+    uint8_t current = 0;
+    for (; current < this->count; current++) {
+        const uint16_t duration = this->keyframes[current].duration_ms;
+        if (duration > 0 && elapsed < keyframe_start + duration) {
+            break;
+        }
+        keyframe_start += duration;
+    }
+    if (current == this->count) {
+        this->active = false;
+        return false;
+    }
+
+    // Background
+    uint32_t painted = this->clip;
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        if (this->clip & EFLedMask::led(i)) {
+            overlay[i] = CRGB::Black;
+        }
+    }
+
+    // Layers, previous color and brightness to tween from
+    CRGB from_color = CRGB::Black;
+    uint8_t from_brightness = this->start_brightness;
+    for (uint8_t k = 0; k < current; k++) {
+        const EFLedKeyframe& kf = this->keyframes[k];
+        if (kf.duration_ms == 0) {
+            painted |= kf.mask;
+            for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+                if (kf.mask & EFLedMask::led(i)) {
+                    overlay[i] = kf.color;
+                }
+            }
+        } else {
+            from_color = kf.color;
+        }
+        if (kf.brightness != EFLED_EFFECT_KEEP_BRIGHTNESS) {
+            from_brightness = kf.brightness;
+            brightness = kf.brightness;
+        }
+    }
+
+    // Current keyframe
+    const EFLedKeyframe& kf = this->keyframes[current];
+    CRGB color = kf.color;
+    if (kf.tween == EFLedTween::Linear) {
+        const uint8_t progress = ((elapsed - keyframe_start) * 255) / kf.duration_ms;
+        color = blend(from_color, kf.color, progress);
+        if (kf.brightness != EFLED_EFFECT_KEEP_BRIGHTNESS) {
+            brightness = from_brightness + ((int16_t) kf.brightness - from_brightness) * progress / 255;
+        }
+    } else if (kf.brightness != EFLED_EFFECT_KEEP_BRIGHTNESS) {
+        brightness = kf.brightness;
+    }
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        if (kf.mask & EFLedMask::led(i)) {
+            overlay[i] = color;
+        }
+    }
+
+    mask = (painted | kf.mask) & EFLedMask::ALL;
+    return true;
+}
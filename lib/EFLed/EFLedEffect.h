@@ -0,0 +1,170 @@
+#ifndef EFLEDEFFECT_H_
+#define EFLEDEFFECT_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <EFConfig.h>
+#include <FastLED.h>
+
+/**
+ * @brief Maximum number of keyframes a single effect can consist of
+ */
+#define EFLED_EFFECT_MAX_KEYFRAMES 24
+
+/**
+ * @brief Brightness value of a keyframe that leaves the global brightness untouched
+ */
+#define EFLED_EFFECT_KEEP_BRIGHTNESS 0xFF
+
+
+/**
+ * @brief Bitmasks to select LEDs within a keyframe. Bit n selects LED n.
+ */
+namespace EFLedMask {
+
+    constexpr uint32_t led(uint8_t idx) {
+        return 1UL << idx;
+    }
+
+    constexpr uint32_t range(uint8_t first, uint8_t count) {
+        return ((count >= 32) ? 0xFFFFFFFFUL : ((1UL << count) - 1)) << first;
+    }
+
+    constexpr uint32_t ALL = range(0, EFLED_TOTAL_NUM);
+    constexpr uint32_t DRAGON = range(EFLED_DARGON_OFFSET, EFLED_DRAGON_NUM);
+    constexpr uint32_t EFBAR = range(EFLED_EFBAR_OFFSET, EFLED_EFBAR_NUM);
+    constexpr uint32_t NOSE = led(EFLED_DARGON_OFFSET + EFLED_DRAGON_NOSE_IDX);
+    constexpr uint32_t EYE = led(EFLED_DARGON_OFFSET + EFLED_DRAGON_EYE_IDX);
+
+    /**
+     * @brief Selects the first count LEDs of the EF bar (from top to bottom)
+     */
+    constexpr uint32_t efbarTop(uint8_t count) {
+        return range(EFLED_EFBAR_OFFSET, count > EFLED_EFBAR_NUM ? EFLED_EFBAR_NUM : count);
+    }
+
+    /**
+     * @brief Selects the last count LEDs of the EF bar (from top to bottom)
+     */
+    constexpr uint32_t efbarBottom(uint8_t count) {
+        return count > EFLED_EFBAR_NUM ? EFBAR : range(EFLED_EFBAR_OFFSET + EFLED_EFBAR_NUM - count, count);
+    }
+}
+
+
+/**
+ * @brief How a keyframe is reached from the previous one
+ */
+enum class EFLedTween : uint8_t {
+    Step,    //!< Jump to the keyframe color and hold it for the whole duration
+    Linear,  //!< Fade from the previous keyframe color (and brightness) over the duration
+};
+
+
+/**
+ * @brief Single step of an LED effect.
+ *
+ * A keyframe paints all LEDs in mask with color for duration_ms. Keyframes with
+ * a duration of 0 are layers: they stay painted until the effect ends, below
+ * all following keyframes. This allows multiple colors at the same time.
+ */
+struct EFLedKeyframe {
+    uint32_t mask;          //!< LEDs to paint (see EFLedMask)
+    CRGB color;             //!< Color to paint the LEDs with
+    uint16_t duration_ms;   //!< Time this keyframe is shown. 0 = layer
+    EFLedTween tween;       //!< How to reach this keyframe from the previous one
+    uint8_t brightness;     //!< Global brightness in percent or EFLED_EFFECT_KEEP_BRIGHTNESS
+};
+
+
+/**
+ * @brief Plays keyframe effects as an overlay on top of the regular LED data.
+ * The player itself never blocks nor touches the LEDs. It only renders the
+ * overlay for a given point in time (see EFLedClass::playEffect()).
+ */
+class EFLedEffectPlayer {
+
+    protected:
+
+        EFLedKeyframe keyframes[EFLED_EFFECT_MAX_KEYFRAMES];  //!< Copy of the currently played keyframes
+        uint8_t count;                                        //!< Number of valid keyframes
+        uint32_t clip;                                        //!< LEDs covered by the effect
+        unsigned long start_ms;                               //!< Timestamp the effect was started at
+        uint8_t start_brightness;                             //!< Brightness percent when the effect was started
+        bool active;                                          //!< True, while an effect is playing
+
+    public:
+
+        /**
+         * @brief Constructs a new idle effect player
+         */
+        EFLedEffectPlayer();
+
+        /**
+         * @brief Starts playing the given effect. The keyframes are copied, so
+         * they can be created on the stack. A previously playing effect is
+         * replaced.
+         *
+         * @param keyframes Keyframes of the effect
+         * @param count Number of keyframes (at most EFLED_EFFECT_MAX_KEYFRAMES)
+         * @param clip LEDs covered by the effect. LEDs inside the clip that are not
+         * painted by the current keyframe are black. 0 = all LEDs used by any keyframe
+         * @param now_ms Current timestamp in milliseconds
+         * @param brightness Current global brightness in percent
+         */
+        void play(const EFLedKeyframe* keyframes, uint8_t count, uint32_t clip, unsigned long now_ms, uint8_t brightness);
+
+        /**
+         * @brief Stops the current effect
+         */
+        void stop();
+
+        /**
+         * @brief Determines if an effect is currently playing
+         *
+         * @return True, if an effect is playing
+         */
+        bool isActive() const;
+
+        /**
+         * @brief Retrieves the brightness the current effect leaves behind
+         *
+         * @return Brightness of the last keyframe changing it or
+         * EFLED_EFFECT_KEEP_BRIGHTNESS, if no keyframe changes brightness
+         */
+        uint8_t getFinalBrightness() const;
+
+        /**
+         * @brief Renders the overlay for the given point in time. Stops the
+         * effect, if it is over.
+         *
+         * @param now_ms Current timestamp in milliseconds
+         * @param overlay LED data to render into. Only LEDs in mask are written
+         * @param mask Receives the LEDs covered by the overlay (0 if the effect is over)
+         * @param brightness Receives the brightness percent to apply or EFLED_EFFECT_KEEP_BRIGHTNESS
+         * @return True, if the effect is still playing
+         */
+        bool render(unsigned long now_ms, CRGB overlay[EFLED_TOTAL_NUM], uint32_t& mask, uint8_t& brightness);
+};
+
+#endif /* EFLEDEFFECT_H_ */
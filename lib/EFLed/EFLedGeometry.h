@@ -0,0 +1,234 @@
+#ifndef EFLEDGEOMETRY_H_
+#define EFLEDGEOMETRY_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <array>
+#include <cstdint>
+
+#include <EFConfig.h>
+
+/**
+ * @brief Position of a point on the badge in millimeters, relative to the
+ * upper left corner of the badge
+ */
+struct EFLedPoint {
+    int16_t x;  //!< X coordinate in millimeters
+    int16_t y;  //!< Y coordinate in millimeters
+};
+
+/**
+ * @brief Compile-time LED geometry. All tables are generated by the compiler
+ * from the LED positions, so spatial animations only need table lookups at
+ * runtime.
+ *
+ * Conventions:
+ *  - Distances are fixed-point millimeters with EFLEDGEOMETRY_DIST_FRAC_BITS
+ *    fractional bits (see toMillimeters())
+ *  - Angles are binary angles (0-255 for a full turn). 0 points to +x (right),
+ *    64 to +y (down).
+ *  - Normalized coordinates map the bounding box of all LEDs to 0-255
+ */
+namespace EFLedGeometry {
+
+    constexpr uint8_t DIST_FRAC_BITS = 4;  //!< Fractional bits of distance values
+
+    template<typename T>
+    using Table = std::array<T, EFLED_TOTAL_NUM>;
+
+    /**
+     * @brief Position of each LED in millimeters relative to the upper left corner of the badge
+     */
+    inline constexpr Table<EFLedPoint> POSITIONS = {{
+        {17, 126},  // 0
+        {21, 106},
+        {23, 91},
+        {41, 86},
+        {35, 48},
+        {37, 43},  // 5
+        {61, 15},
+        {61, 27},
+        {61, 41},
+        {61, 54},
+        {61, 67},  // 10
+        {61, 79},
+        {61, 93},
+        {61, 105},
+        {61, 118},
+        {61, 131},  // 15
+        {61, 144}
+    }};
+
+    inline constexpr EFLedPoint ANCHOR_EYE = POSITIONS[EFLED_DRAGON_EYE_IDX];    //!< Dragons eye LED
+    inline constexpr EFLedPoint ANCHOR_NOSE = POSITIONS[EFLED_DRAGON_NOSE_IDX];  //!< Dragons nose LED
+    inline constexpr EFLedPoint ANCHOR_POWER_BUTTON = {-30, 16};                 //!< Where the hand rests on the power button
+
+    /**
+     * @brief Integer square root
+     *
+     * @param value Radicand
+     * @return floor(sqrt(value))
+     */
+    constexpr uint32_t isqrt(uint32_t value) {
+        uint32_t result = 0;
+        uint32_t bit = 1UL << 30;
+        while (bit > value) {
+            bit >>= 2;
+        }
+        while (bit != 0) {
+            if (value >= result + bit) {
+                value -= result + bit;
+                result = (result >> 1) + bit;
+            } else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Distance between two points
+     *
+     * @return Rounded distance in fixed-point millimeters (DIST_FRAC_BITS)
+     */
+    constexpr uint16_t distance(EFLedPoint a, EFLedPoint b) {
+        const int32_t dx = (a.x - b.x) << DIST_FRAC_BITS;
+        const int32_t dy = (a.y - b.y) << DIST_FRAC_BITS;
+        const uint32_t sq = dx * dx + dy * dy;
+        const uint32_t root = isqrt(sq);
+        // Round to nearest: (root + 0.5)² = root² + root + 0.25
+        return root + (sq > root * root + root ? 1 : 0);
+    }
+
+    /**
+     * @brief Converts a fixed-point distance to millimeters
+     */
+    constexpr float toMillimeters(uint16_t dist) {
+        return dist / static_cast<float>(1 << DIST_FRAC_BITS);
+    }
+
+    /**
+     * @brief Approximates the angle of the vector (dx, dy). Maximum error is
+     * below one binary angle unit (1.4 degrees).
+     *
+     * @return Binary angle (0-255), 0 = +x, 64 = +y
+     */
+    constexpr uint8_t angle(int32_t dx, int32_t dy) {
+        if (dx == 0 && dy == 0) {
+            return 0;
+        }
+        const int32_t ax = dx < 0 ? -dx : dx;
+        const int32_t ay = dy < 0 ? -dy : dy;
+        const bool swap = ay > ax;
+        const int64_t num = swap ? ax : ay;
+        const int64_t den = swap ? ay : ax;
+
+        // atan(z) ~ pi/4 * z + 0.273 * z * (1 - z) for 0 <= z <= 1, scaled to 32 units per pi/4
+        const int64_t octant = (32 * 1000 * num * den + 11124 * num * (den - num) + 500 * den * den) / (1000 * den * den);
+
+        int32_t a = swap ? 64 - octant : octant;
+        if (dx < 0) {
+            a = 128 - a;
+        }
+        if (dy < 0) {
+            a = 256 - a;
+        }
+        return static_cast<uint8_t>(a & 0xFF);
+    }
+
+    /**
+     * @brief Generates the distance of every LED to the given anchor
+     */
+    constexpr Table<uint16_t> makeDistanceTable(EFLedPoint anchor) {
+        Table<uint16_t> table = {};
+        for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+            table[i] = distance(POSITIONS[i], anchor);
+        }
+        return table;
+    }
+
+    /**
+     * @brief Generates the angle of every LED as seen from the given anchor
+     */
+    constexpr Table<uint8_t> makeAngleTable(EFLedPoint anchor) {
+        Table<uint8_t> table = {};
+        for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+            table[i] = angle(POSITIONS[i].x - anchor.x, POSITIONS[i].y - anchor.y);
+        }
+        return table;
+    }
+
+    /**
+     * @brief Smallest / largest coordinate of all LEDs along one axis
+     */
+    constexpr int16_t extent(bool y_axis, bool maximum) {
+        int16_t result = y_axis ? POSITIONS[0].y : POSITIONS[0].x;
+        for (const EFLedPoint& p : POSITIONS) {
+            const int16_t v = y_axis ? p.y : p.x;
+            if (maximum ? v > result : v < result) {
+                result = v;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Generates the coordinate of every LED along one axis, mapped from
+     * the bounding box of all LEDs to 0-255
+     */
+    constexpr Table<uint8_t> makeNormalizedTable(bool y_axis) {
+        const int16_t lo = extent(y_axis, false);
+        const int16_t span = extent(y_axis, true) - lo;
+        Table<uint8_t> table = {};
+        for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+            const int16_t v = (y_axis ? POSITIONS[i].y : POSITIONS[i].x) - lo;
+            table[i] = span == 0 ? 0 : (v * 255 + span / 2) / span;
+        }
+        return table;
+    }
+
+    inline constexpr EFLedPoint CENTER = {
+        static_cast<int16_t>((extent(false, false) + extent(false, true)) / 2),
+        static_cast<int16_t>((extent(true, false) + extent(true, true)) / 2)
+    };  //!< Center of the bounding box of all LEDs
+
+    inline constexpr Table<uint16_t> DISTANCE_FROM_EYE = makeDistanceTable(ANCHOR_EYE);
+    inline constexpr Table<uint16_t> DISTANCE_FROM_NOSE = makeDistanceTable(ANCHOR_NOSE);
+    inline constexpr Table<uint16_t> DISTANCE_FROM_POWER_BUTTON = makeDistanceTable(ANCHOR_POWER_BUTTON);
+    inline constexpr Table<uint16_t> DISTANCE_FROM_CENTER = makeDistanceTable(CENTER);
+
+    inline constexpr Table<uint8_t> ANGLE_FROM_EYE = makeAngleTable(ANCHOR_EYE);
+    inline constexpr Table<uint8_t> ANGLE_FROM_NOSE = makeAngleTable(ANCHOR_NOSE);
+    inline constexpr Table<uint8_t> ANGLE_FROM_CENTER = makeAngleTable(CENTER);
+
+    inline constexpr Table<uint8_t> NORMALIZED_X = makeNormalizedTable(false);
+    inline constexpr Table<uint8_t> NORMALIZED_Y = makeNormalizedTable(true);
+
+    static_assert(isqrt(0) == 0 && isqrt(15) == 3 && isqrt(16) == 4 && isqrt(0xFFFFFFFF) == 0xFFFF, "isqrt broken");
+    static_assert(angle(1, 0) == 0 && angle(0, 1) == 64 && angle(-1, 0) == 128 && angle(0, -1) == 192, "angle broken");
+    static_assert(angle(1, 1) == 32 && angle(-1, -1) == 160, "angle broken");
+    static_assert(DISTANCE_FROM_EYE[EFLED_DRAGON_EYE_IDX] == 0, "eye anchor broken");
+}
+
+#endif /* EFLEDGEOMETRY_H_ */
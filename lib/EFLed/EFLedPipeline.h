@@ -0,0 +1,270 @@
+#ifndef EFLEDPIPELINE_H_
+#define EFLEDPIPELINE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Snapshot of a complete LED frame as it is sent over the wire: raw RGB
+ * bytes (in strip order) and the global brightness scale to apply.
+ *
+ * @tparam N Number of LEDs
+ */
+template<uint8_t N>
+struct EFLedFrame {
+    uint8_t rgb[N * 3];   //!< Raw RGB data, three bytes per LED
+    uint8_t brightness;   //!< Brightness scale (0-255) to apply during transmission
+    uint32_t seq;         //!< Sequence number assigned by EFLedPipeline::publish()
+};
+
+
+/**
+ * @brief Sink that transmits completed frames to the LEDs
+ *
+ * @tparam N Number of LEDs
+ */
+template<uint8_t N>
+class EFLedBackend {
+
+    public:
+
+        virtual ~EFLedBackend() {}
+
+        /**
+         * @brief Transmits the given frame. May block until the frame is on the wire.
+         *
+         * @param frame Frame to transmit
+         * @return True, if the frame was transmitted, false if it had to be discarded
+         */
+        virtual bool write(const EFLedFrame<N>& frame) = 0;
+};
+
+
+/**
+ * @brief Lock-free single-producer / single-consumer frame handoff between the
+ * render loop and the LED output task.
+ *
+ * Double buffering with a third in-flight slot (triple buffer): the producer
+ * always owns one slot it can render into, the consumer always owns the slot
+ * currently being transmitted and the third slot holds the newest completed
+ * frame. Neither side ever blocks. If the producer publishes again before the
+ * consumer picked up the previous frame, the older frame is replaced by the
+ * newer one (coalesced), so the wire always transmits the latest state.
+ *
+ * The pipeline does not depend on Arduino / FreeRTOS and can be driven
+ * manually on the host using service().
+ *
+ * @tparam N Number of LEDs
+ */
+template<uint8_t N>
+class EFLedPipeline {
+
+    protected:
+
+        static constexpr uint8_t SLOT_MASK = 0x03;   //!< Bits of shared_slot holding the slot index
+        static constexpr uint8_t FLAG_FRESH = 0x04;  //!< Set in shared_slot if it holds an unconsumed frame
+
+        EFLedFrame<N> slots[3];                 //!< Frame storage
+        uint8_t back_slot;                      //!< Slot owned by the producer
+        uint8_t front_slot;                     //!< Slot owned by the consumer
+        std::atomic<uint8_t> shared_slot;       //!< Slot exchanged between both sides incl. FLAG_FRESH
+        std::atomic<bool> busy;                 //!< True while the consumer is transmitting a frame
+
+        uint32_t next_seq;                      //!< Sequence number for the next published frame
+        std::atomic<uint32_t> published;        //!< Number of frames published by the producer
+        std::atomic<uint32_t> transmitted;      //!< Number of frames successfully transmitted
+        std::atomic<uint32_t> coalesced;        //!< Number of frames replaced by a newer one before transmission
+        std::atomic<uint32_t> dropped;          //!< Number of frames the backend failed to transmit
+
+    public:
+
+        EFLedPipeline()
+        : back_slot(0)
+        , front_slot(1)
+        , shared_slot(2)
+        , busy(false)
+        , next_seq(0)
+        , published(0)
+        , transmitted(0)
+        , coalesced(0)
+        , dropped(0)
+        {
+            memset(this->slots, 0, sizeof(this->slots));
+        }
+
+        /**
+         * @brief Provides the frame owned by the producer. Fill it and call publish().
+         *
+         * @return Frame to render into
+         */
+        EFLedFrame<N>& back() {
+            return this->slots[this->back_slot];
+        }
+
+        /**
+         * @brief Copies the given LED data into the producer frame and publishes it
+         *
+         * @param rgb Raw RGB data, three bytes per LED
+         * @param brightness Brightness scale (0-255)
+         */
+        void publish(const uint8_t* rgb, uint8_t brightness) {
+            EFLedFrame<N>& frame = this->back();
+            memcpy(frame.rgb, rgb, sizeof(frame.rgb));
+            frame.brightness = brightness;
+            this->publish();
+        }
+
+        /**
+         * @brief Hands the producer frame over to the consumer. The producer
+         * receives a new frame to render into. Never blocks.
+         */
+        void publish() {
+            this->slots[this->back_slot].seq = this->next_seq++;
+            uint8_t prev = this->shared_slot.exchange(this->back_slot | FLAG_FRESH);
+            this->back_slot = prev & SLOT_MASK;
+            this->published.fetch_add(1, std::memory_order_relaxed);
+            if (prev & FLAG_FRESH) {
+                this->coalesced.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Determines if a published frame is waiting for transmission
+         *
+         * @return True, if service() would transmit a frame
+         */
+        bool pending() const {
+            return this->shared_slot.load() & FLAG_FRESH;
+        }
+
+        /**
+         * @brief Takes the newest published frame, if any. Consumer side.
+         *
+         * @return Pointer to the frame, valid until the next call to acquire(),
+         * or nullptr if no new frame was published since the last call.
+         */
+        const EFLedFrame<N>* acquire() {
+            if (!this->pending()) {
+                return nullptr;
+            }
+            uint8_t prev = this->shared_slot.exchange(this->front_slot);
+            this->front_slot = prev & SLOT_MASK;
+            return &this->slots[this->front_slot];
+        }
+
+        /**
+         * @brief Transmits the newest published frame, if any. Consumer side.
+         *
+         * @param backend Backend to transmit the frame with
+         * @return True, if a frame was handed to the backend
+         */
+        bool service(EFLedBackend<N>& backend) {
+            this->busy.store(true);
+            const EFLedFrame<N>* frame = this->acquire();
+            if (frame == nullptr) {
+                this->busy.store(false);
+                return false;
+            }
+            if (backend.write(*frame)) {
+                this->transmitted.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                this->dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            this->busy.store(false);
+            return true;
+        }
+
+        /**
+         * @brief Determines if all published frames were handed to the backend
+         * and no transmission is in progress
+         *
+         * @return True, if the pipeline is drained
+         */
+        bool idle() const {
+            return !this->pending() && !this->busy.load();
+        }
+
+        /**
+         * @brief Records a frame that was discarded without entering the
+         * pipeline (e.g. because the output task is not running)
+         */
+        void drop() {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint32_t getPublishedCount() const { return this->published.load(std::memory_order_relaxed); }
+        uint32_t getTransmittedCount() const { return this->transmitted.load(std::memory_order_relaxed); }
+        uint32_t getCoalescedCount() const { return this->coalesced.load(std::memory_order_relaxed); }
+        uint32_t getDroppedCount() const { return this->dropped.load(std::memory_order_relaxed); }
+};
+
+
+/**
+ * @brief Backend that keeps transmitted frames in memory instead of driving
+ * LEDs. Allows the pipeline to be exercised on the host.
+ *
+ * @tparam N Number of LEDs
+ */
+template<uint8_t N>
+class EFLedMockBackend : public EFLedBackend<N> {
+
+    protected:
+
+        EFLedFrame<N> last;     //!< Last successfully written frame
+        uint32_t writes;        //!< Number of successfully written frames
+        uint32_t fail_next;     //!< Number of upcoming writes to reject
+
+    public:
+
+        EFLedMockBackend()
+        : writes(0)
+        , fail_next(0)
+        {
+            memset(&this->last, 0, sizeof(this->last));
+        }
+
+        bool write(const EFLedFrame<N>& frame) override {
+            if (this->fail_next > 0) {
+                this->fail_next--;
+                return false;
+            }
+            this->last = frame;
+            this->writes++;
+            return true;
+        }
+
+        /**
+         * @brief Lets the next writes fail to simulate transmission errors
+         *
+         * @param count Number of writes to reject
+         */
+        void failNext(uint32_t count) { this->fail_next = count; }
+
+        const EFLedFrame<N>& getLastFrame() const { return this->last; }
+        uint32_t getWriteCount() const { return this->writes; }
+};
+
+#endif /* EFLEDPIPELINE_H_ */
@@ -0,0 +1,134 @@
+#ifndef EFLEDPOWER_H_
+#define EFLEDPOWER_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cstdint>
+
+/**
+ * @brief Current model for WS2812B LEDs. Values are the typical draw of a
+ * single channel at full duty cycle and the quiescent draw of a single LED,
+ * measured at the 5V rail (same model as FastLED's power management).
+ */
+#define EFLED_CURRENT_RED_MA   16
+#define EFLED_CURRENT_GREEN_MA 11
+#define EFLED_CURRENT_BLUE_MA  15
+#define EFLED_CURRENT_IDLE_MA   1
+
+/**
+ * @brief Pure functions to estimate and limit the current drawn by a frame.
+ * Independent of FastLED / Arduino, so they can be used on the host as well.
+ */
+namespace EFLedPower {
+
+    /**
+     * @brief Calculates the sum of all channels, each weighted by its current
+     * draw in mA at full duty cycle
+     *
+     * @param rgb Raw RGB data, three bytes per LED
+     * @param count Number of LEDs
+     * @return Weighted channel sum (mA * 255)
+     */
+    constexpr uint32_t weightedChannelSum(const uint8_t* rgb, uint8_t count) {
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            sum += rgb[3 * i + 0] * EFLED_CURRENT_RED_MA;
+            sum += rgb[3 * i + 1] * EFLED_CURRENT_GREEN_MA;
+            sum += rgb[3 * i + 2] * EFLED_CURRENT_BLUE_MA;
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Estimates the current drawn by the given frame
+     *
+     * @param rgb Raw RGB data, three bytes per LED
+     * @param count Number of LEDs
+     * @param brightness Global brightness scale (0-255) the frame is shown with
+     * @return Estimated current in mA, including the quiescent current
+     */
+    constexpr uint32_t estimateMilliamps(const uint8_t* rgb, uint8_t count, uint8_t brightness) {
+        return (weightedChannelSum(rgb, count) * brightness) / (255 * 255) + count * EFLED_CURRENT_IDLE_MA;
+    }
+
+    /**
+     * @brief Determines the highest brightness, not exceeding the requested
+     * one, at which the given frame stays within the current budget
+     *
+     * @param rgb Raw RGB data, three bytes per LED
+     * @param count Number of LEDs
+     * @param brightness Requested global brightness scale (0-255)
+     * @param budget_ma Maximum current in mA the LEDs may draw
+     * @return Brightness scale (0-255) to show the frame with
+     */
+    constexpr uint8_t limitBrightness(const uint8_t* rgb, uint8_t count, uint8_t brightness, uint32_t budget_ma) {
+        const uint32_t idle_ma = count * EFLED_CURRENT_IDLE_MA;
+        const uint32_t sum = weightedChannelSum(rgb, count);
+        if (sum == 0 || (sum * brightness) / (255 * 255) + idle_ma <= budget_ma) {
+            return brightness;
+        }
+        if (budget_ma <= idle_ma) {
+            return 0;
+        }
+
+        // Largest b with (sum * b) / 255² <= budget - idle
+        const uint32_t limited = ((budget_ma - idle_ma + 1) * 255 * 255 - 1) / sum;
+        return limited < brightness ? limited : brightness;
+    }
+
+    /**
+     * @brief Determines the brightness to show the given frame with, scaling
+     * sparse frames beyond the nominal maximum up to the hardware ceiling
+     *
+     * The brightness is mapped from the nominal scale (0 to nominal_max) to
+     * the ceiling and then limited by the current budget. The part of the
+     * budget above the quiescent current shrinks in proportion to the
+     * requested brightness. Frames lighting up all LEDs therefore stay at
+     * about the requested brightness, while sparse frames get brighter.
+     *
+     * @param rgb Raw RGB data, three bytes per LED
+     * @param count Number of LEDs
+     * @param brightness Requested brightness on the nominal scale
+     * @param nominal_max Brightness a request of 100 % maps to
+     * @param ceiling Highest brightness scale (0-255) the LEDs may be driven with
+     * @param budget_ma Maximum current in mA the LEDs may draw at nominal_max
+     * @return Brightness scale (0-255) to show the frame with
+     */
+    constexpr uint8_t scaleBrightness(
+        const uint8_t* rgb, uint8_t count, uint8_t brightness,
+        uint8_t nominal_max, uint8_t ceiling, uint32_t budget_ma
+    ) {
+        if (nominal_max == 0 || brightness == 0) {
+            return 0;
+        }
+        const uint32_t idle_ma = count * EFLED_CURRENT_IDLE_MA;
+        const uint32_t scaled = static_cast<uint32_t>(brightness) * ceiling / nominal_max;
+        const uint32_t scaled_budget_ma = budget_ma <= idle_ma
+            ? budget_ma
+            : idle_ma + (budget_ma - idle_ma) * brightness / nominal_max;
+        return limitBrightness(rgb, count, scaled > 255 ? 255 : scaled, scaled_budget_ma);
+    }
+
+}
+
+#endif /* EFLEDPOWER_H_ */
@@ -0,0 +1,179 @@
+#ifndef EFLEDRING_H_
+#define EFLEDRING_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cstdint>
+#include <initializer_list>
+
+/**
+ * @brief Fixed-capacity LED pattern with O(1) rotation and mirroring.
+ *
+ * The pattern is stored inline (no heap) and never moved in memory. Rotating
+ * or mirroring only changes how logical indices map onto the storage. The
+ * pattern is transferred into the frame using writeTo() / copyTo(), which
+ * allows concatenating multiple patterns into a single segment.
+ *
+ * @tparam T Element type, usually CRGB
+ * @tparam N Number of elements
+ */
+template<typename T, uint8_t N>
+class EFLedRing {
+
+    static_assert(N > 0, "EFLedRing requires at least one element");
+
+    protected:
+
+        T storage[N];       //!< Pattern data
+        uint8_t origin;     //!< Storage index of logical element 0
+        bool mirrored;      //!< If true, logical indices run backwards through storage
+
+        uint8_t physical(uint8_t idx) const {
+            return this->mirrored
+                ? (this->origin + N - (idx % N)) % N
+                : (this->origin + idx) % N;
+        }
+
+    public:
+
+        /**
+         * @brief Constructs a new pattern. Missing elements are value-initialized
+         * (black for CRGB), surplus elements are ignored.
+         *
+         * @param init Initial elements
+         */
+        EFLedRing(std::initializer_list<T> init = {})
+        : origin(0)
+        , mirrored(false)
+        {
+            uint8_t i = 0;
+            for (const T& element : init) {
+                if (i == N) {
+                    break;
+                }
+                this->storage[i++] = element;
+            }
+            for (; i < N; i++) {
+                this->storage[i] = T{};
+            }
+        }
+
+        /**
+         * @brief Constructs a new pattern from the first N elements of the given array
+         *
+         * @param src Array holding at least N elements
+         */
+        explicit EFLedRing(const T* src)
+        : origin(0)
+        , mirrored(false)
+        {
+            for (uint8_t i = 0; i < N; i++) {
+                this->storage[i] = src[i];
+            }
+        }
+
+        static constexpr uint8_t size() { return N; }
+
+        T& operator[](uint8_t idx) { return this->storage[this->physical(idx)]; }
+        const T& operator[](uint8_t idx) const { return this->storage[this->physical(idx)]; }
+
+        /**
+         * @brief Sets all elements to the given value
+         */
+        void fill(const T& value) {
+            for (uint8_t i = 0; i < N; i++) {
+                this->storage[i] = value;
+            }
+        }
+
+        /**
+         * @brief Rotates the pattern towards the front: element k becomes element 0.
+         * Same as std::rotate(begin, begin + k, end).
+         *
+         * @param k Number of positions to rotate by
+         */
+        void rotate(uint32_t k) {
+            k %= N;
+            this->origin = this->mirrored
+                ? (this->origin + N - k) % N
+                : (this->origin + k) % N;
+        }
+
+        /**
+         * @brief Rotates the pattern towards the back: element 0 becomes element k.
+         * Same as std::rotate(rbegin, rbegin + k, rend).
+         *
+         * @param k Number of positions to rotate by
+         */
+        void rotateBack(uint32_t k) {
+            this->rotate(N - (k % N));
+        }
+
+        /**
+         * @brief Reverses the order of all elements
+         */
+        void mirror() {
+            this->origin = this->physical(N - 1);
+            this->mirrored = !this->mirrored;
+        }
+
+        /**
+         * @brief Copies elements in logical order into the given array
+         *
+         * @param dst Destination array
+         * @param count Number of elements to copy, at most N - first
+         * @param first Logical index of the first element to copy
+         * @return Number of elements copied
+         */
+        uint8_t copyTo(T* dst, uint8_t count, uint8_t first = 0) const {
+            if (first >= N) {
+                return 0;
+            }
+            if (count > N - first) {
+                count = N - first;
+            }
+            for (uint8_t i = 0; i < count; i++) {
+                dst[i] = (*this)[first + i];
+            }
+            return count;
+        }
+
+        /**
+         * @brief Writes the whole pattern into a segment (e.g. EFLedSegment),
+         * clipped to the end of the segment. Consecutive calls with increasing
+         * offsets concatenate patterns.
+         *
+         * @param segment Destination providing size() and data()
+         * @param offset Index inside the segment to start writing at
+         * @return Index inside the segment after the last written element
+         */
+        template<typename Segment>
+        uint8_t writeTo(const Segment& segment, uint8_t offset = 0) const {
+            if (offset >= segment.size()) {
+                return segment.size();
+            }
+            return offset + this->copyTo(segment.data() + offset, segment.size() - offset);
+        }
+};
+
+#endif /* EFLEDRING_H_ */
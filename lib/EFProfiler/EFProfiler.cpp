@@ -0,0 +1,191 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EFProfiler.h"
+
+#ifdef EFPROFILER
+
+#include <string.h>
+
+#ifdef EFSIM
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+
+const char* toString(EFProfilerSection section) {
+    switch (section) {
+        case EFProfilerSection::Run: return "run";
+        case EFProfilerSection::Touch: return "touch";
+        case EFProfilerSection::Persist: return "persist";
+        case EFProfilerSection::Transition: return "transition";
+        default: return "UNKNOWN";
+    }
+}
+
+uint32_t efprofilerTicks() {
+#ifdef EFSIM
+    // Host: wall clock, the simulators CPU cycle counter follows virtual time
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+#else
+    return ESP.getCycleCount();
+#endif
+}
+
+uint32_t efprofilerTicksPerUs() {
+#ifdef EFSIM
+    return 1000;
+#else
+    return getCpuFrequencyMhz();
+#endif
+}
+
+/**
+ * @brief Maps a sample to its histogram bucket
+ */
+static uint8_t bucketOf(uint32_t ns) {
+    if (ns < (1UL << EFPROFILER_HISTOGRAM_MIN_SHIFT)) {
+        return 0;
+    }
+    const uint8_t octave = 31 - __builtin_clz(ns);
+    const uint8_t sub = (ns >> (octave - 2)) & (EFPROFILER_HISTOGRAM_SUBBUCKETS - 1);
+    return 1 + (octave - EFPROFILER_HISTOGRAM_MIN_SHIFT) * EFPROFILER_HISTOGRAM_SUBBUCKETS + sub;
+}
+
+/**
+ * @brief Retrieves the largest sample that maps to the given bucket
+ */
+static uint32_t bucketUpperBound(uint8_t bucket) {
+    if (bucket == 0) {
+        return (1UL << EFPROFILER_HISTOGRAM_MIN_SHIFT) - 1;
+    }
+    const uint8_t octave = EFPROFILER_HISTOGRAM_MIN_SHIFT + (bucket - 1) / EFPROFILER_HISTOGRAM_SUBBUCKETS;
+    const uint8_t sub = (bucket - 1) % EFPROFILER_HISTOGRAM_SUBBUCKETS;
+    const uint64_t upper = (static_cast<uint64_t>(EFPROFILER_HISTOGRAM_SUBBUCKETS + sub + 1) << (octave - 2)) - 1;
+    return upper > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(upper);
+}
+
+uint32_t EFProfilerRow::getPercentile(uint8_t percent) const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < EFPROFILER_HISTOGRAM_BUCKETS; i++) {
+        total += this->histogram[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const uint32_t rank = (total * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < EFPROFILER_HISTOGRAM_BUCKETS; i++) {
+        seen += this->histogram[i];
+        if (seen >= rank) {
+            // The bucket bound may exceed the actual maximum
+            const uint32_t upper = bucketUpperBound(i);
+            return upper < this->max ? upper : this->max;
+        }
+    }
+    return this->max;
+}
+
+EFProfilerClass::EFProfilerClass()
+: num_rows(0)
+, dropped(0)
+{
+}
+
+EFProfilerRow* EFProfilerClass::getRow(const char* name, EFProfilerSection section) {
+    for (uint8_t i = 0; i < this->num_rows; i++) {
+        if (this->rows[i].section == section && (this->rows[i].name == name || strcmp(this->rows[i].name, name) == 0)) {
+            return &this->rows[i];
+        }
+    }
+
+    if (this->num_rows >= EFPROFILER_MAX_ROWS) {
+        return nullptr;
+    }
+    EFProfilerRow* row = &this->rows[this->num_rows++];
+    memset(row, 0, sizeof(EFProfilerRow));
+    row->name = name;
+    row->section = section;
+    row->min = UINT32_MAX;
+    return row;
+}
+
+void EFProfilerClass::record(const char* name, EFProfilerSection section, uint32_t ns) {
+    EFProfilerRow* row = this->getRow(name, section);
+    if (row == nullptr) {
+        this->dropped++;
+        return;
+    }
+
+    row->count++;
+    row->sum += ns;
+    if (ns < row->min) {
+        row->min = ns;
+    }
+    if (ns > row->max) {
+        row->max = ns;
+    }
+    uint16_t& bucket = row->histogram[bucketOf(ns)];
+    if (bucket < UINT16_MAX) {
+        bucket++;
+    }
+}
+
+uint8_t EFProfilerClass::getRowCount() const {
+    return this->num_rows;
+}
+
+const EFProfilerRow* EFProfilerClass::getRow(uint8_t idx) const {
+    return idx < this->num_rows ? &this->rows[idx] : nullptr;
+}
+
+uint32_t EFProfilerClass::getDroppedCount() const {
+    return this->dropped;
+}
+
+void EFProfilerClass::reset() {
+    this->num_rows = 0;
+    this->dropped = 0;
+}
+
+EFProfilerScope::EFProfilerScope(const char* name, EFProfilerSection section)
+: name(name)
+, section(section)
+, start(efprofilerTicks())
+, ticks_per_us(efprofilerTicksPerUs())
+{
+}
+
+EFProfilerScope::~EFProfilerScope() {
+    const uint32_t ticks = efprofilerTicks() - this->start;
+    const uint64_t ns = static_cast<uint64_t>(ticks) * 1000 / this->ticks_per_us;
+    EFProfiler.record(this->name, this->section, ns > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(ns));
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFPROFILER)
+EFProfilerClass EFProfiler;
+#endif
+
+#endif /* EFPROFILER */
@@ -0,0 +1,192 @@
+#ifndef EFPROFILER_H_
+#define EFPROFILER_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of (name, section) pairs the profiler keeps statistics for
+ */
+#define EFPROFILER_MAX_ROWS 32
+
+/**
+ * @brief Samples below 2^EFPROFILER_HISTOGRAM_MIN_SHIFT ns share the first histogram bucket
+ */
+#define EFPROFILER_HISTOGRAM_MIN_SHIFT 6
+
+/**
+ * @brief Histogram buckets per power of two. Percentiles are accurate to 1/4 octave.
+ */
+#define EFPROFILER_HISTOGRAM_SUBBUCKETS 4
+
+/**
+ * @brief Number of histogram buckets covering all 32 bit tick counts
+ */
+#define EFPROFILER_HISTOGRAM_BUCKETS (1 + (32 - EFPROFILER_HISTOGRAM_MIN_SHIFT) * EFPROFILER_HISTOGRAM_SUBBUCKETS)
+
+
+/**
+ * @brief Kind of work a profiled section performs
+ */
+enum class EFProfilerSection : uint8_t {
+    Run,         //!< FSMState::run()
+    Touch,       //!< FSMState touch event handlers
+    Persist,     //!< FSM::persistGlobals()
+    Transition,  //!< FSM::transition(), including exit() and entry()
+};
+
+const char* toString(EFProfilerSection section);
+
+/**
+ * @brief Reads the profiler clock. CPU cycles on the badge, steady clock
+ * nanoseconds on the host.
+ */
+uint32_t efprofilerTicks();
+
+/**
+ * @brief Retrieves the number of profiler clock ticks per microsecond. Follows
+ * the CPU frequency on the badge, which EFGovernor switches at runtime.
+ */
+uint32_t efprofilerTicksPerUs();
+
+/**
+ * @brief Execution time statistics of a single profiled section
+ */
+struct EFProfilerRow {
+    const char* name;           //!< Name of the profiled entity (e.g., the FSM state)
+    EFProfilerSection section;  //!< Profiled section
+    uint32_t count;             //!< Number of samples
+    uint32_t min;               //!< Shortest sample in nanoseconds
+    uint32_t max;               //!< Longest sample in nanoseconds
+    uint64_t sum;               //!< Sum of all samples in nanoseconds
+    uint16_t histogram[EFPROFILER_HISTOGRAM_BUCKETS];  //!< Logarithmic histogram, saturating counts
+
+    /**
+     * @brief Calculates the nearest-rank percentile from the histogram
+     *
+     * @param percent Percentile to calculate, 1 to 100
+     * @return Upper bound of the bucket containing the percentile in nanoseconds
+     */
+    uint32_t getPercentile(uint8_t percent) const;
+};
+
+/**
+ * @brief Fixed-size table of execution time statistics
+ *
+ * Only compiled into the firmware if EFPROFILER is defined. Instrumentation
+ * points use EFPROFILER_SCOPE(), which expands to nothing otherwise, so that a
+ * regular build carries no overhead at all.
+ */
+class EFProfilerClass {
+
+    protected:
+
+        EFProfilerRow rows[EFPROFILER_MAX_ROWS];  //!< Statistics table
+        uint8_t num_rows;                         //!< Number of used rows
+        uint32_t dropped;                         //!< Samples dropped because the table was full
+
+        /**
+         * @brief Retrieves the row of the given pair. Allocates a new row if required.
+         *
+         * @return Row or nullptr if the table is full
+         */
+        EFProfilerRow* getRow(const char* name, EFProfilerSection section);
+
+    public:
+
+        /**
+         * @brief Constructs a new, empty EFProfilerClass instance
+         */
+        EFProfilerClass();
+
+        /**
+         * @brief Records a single sample
+         *
+         * @param name Name of the profiled entity. Must be a string with static lifetime.
+         * @param section Profiled section
+         * @param ns Duration of the section in nanoseconds
+         */
+        void record(const char* name, EFProfilerSection section, uint32_t ns);
+
+        /**
+         * @brief Retrieves the number of used rows
+         */
+        uint8_t getRowCount() const;
+
+        /**
+         * @brief Retrieves the row at the given index
+         *
+         * @return Row or nullptr if idx is out of range
+         */
+        const EFProfilerRow* getRow(uint8_t idx) const;
+
+        /**
+         * @brief Retrieves the number of samples dropped because the table was full
+         */
+        uint32_t getDroppedCount() const;
+
+        /**
+         * @brief Discards all statistics
+         */
+        void reset();
+};
+
+/**
+ * @brief Measures the lifetime of a scope and records it to EFProfiler
+ *
+ * Cycles are converted with the CPU frequency at the start of the scope. A
+ * scope spanning a frequency switch by EFGovernor is therefore only
+ * approximated.
+ */
+class EFProfilerScope {
+
+    protected:
+
+        const char* name;
+        EFProfilerSection section;
+        uint32_t start;         //!< Profiler clock at the start of the scope
+        uint32_t ticks_per_us;  //!< Profiler clock rate at the start of the scope
+
+    public:
+
+        EFProfilerScope(const char* name, EFProfilerSection section);
+        ~EFProfilerScope();
+};
+
+#ifdef EFPROFILER
+#define EFPROFILER_CONCAT_(a, b) a##b
+#define EFPROFILER_CONCAT(a, b) EFPROFILER_CONCAT_(a, b)
+/**
+ * @brief Profiles the remainder of the enclosing scope
+ */
+#define EFPROFILER_SCOPE(name, section) EFProfilerScope EFPROFILER_CONCAT(efprofiler_scope_, __LINE__)((name), (section))
+#else
+#define EFPROFILER_SCOPE(name, section)
+#endif
+
+#if defined(EFPROFILER) && !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFPROFILER)
+extern EFProfilerClass EFProfiler;
+#endif
+
+#endif /* EFPROFILER_H_ */
@@ -0,0 +1,145 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <BLEDevice.h>
+#include <WiFi.h>
+
+#include <EFGovernor.h>
+#include <EFLogging.h>
+
+#include "EFRadio.h"
+
+const char* toString(EFRadioResource resource) {
+    switch (resource) {
+        case EFRadioResource::BLE: return "BLE";
+        case EFRadioResource::WiFiSTA: return "WiFi-STA";
+        case EFRadioResource::WiFiAP: return "WiFi-AP";
+        default: return "UNKNOWN";
+    }
+}
+
+EFRadioClass::EFRadioClass()
+: users{0, 0, 0}
+{
+}
+
+bool EFRadioClass::acquire(EFRadioResource resource, const char* ble_name) {
+    uint8_t& count = this->users[static_cast<uint8_t>(resource)];
+    if (count == UINT8_MAX) {
+        LOGF_ERROR("(EFRadio) Too many users of %s\r\n", toString(resource));
+        return false;
+    }
+
+    count++;
+    if (count > 1) {
+        return true;
+    }
+
+    // The radio stacks fail to come up below their minimum CPU frequency
+    EFGovernor.ensureMhz(EFGOVERNOR_RADIO_MIN_MHZ);
+
+    const uint32_t heap_before = ESP.getFreeHeap();
+    if (resource == EFRadioResource::BLE) {
+        BLEDevice::init(ble_name);
+    } else {
+        this->applyWifiMode();
+    }
+    this->logChange(resource, "up", heap_before);
+
+    return true;
+}
+
+void EFRadioClass::release(EFRadioResource resource) {
+    uint8_t& count = this->users[static_cast<uint8_t>(resource)];
+    if (count == 0) {
+        LOGF_WARNING("(EFRadio) Released %s without being acquired\r\n", toString(resource));
+        return;
+    }
+
+    count--;
+    if (count > 0) {
+        return;
+    }
+
+    const uint32_t heap_before = ESP.getFreeHeap();
+    if (resource == EFRadioResource::BLE) {
+        BLEDevice::getAdvertising()->stop();
+        // Keep the controller memory, releasing it prevents BLE from being initialized again until reboot
+        BLEDevice::deinit(false);
+    } else {
+        this->applyWifiMode();
+    }
+    this->logChange(resource, "down", heap_before);
+}
+
+void EFRadioClass::shutdown() {
+    const uint32_t heap_before = ESP.getFreeHeap();
+    if (this->isActive(EFRadioResource::BLE)) {
+        BLEDevice::getAdvertising()->stop();
+        BLEDevice::deinit(false);
+    }
+    for (uint8_t& count : this->users) {
+        count = 0;
+    }
+    this->applyWifiMode();
+
+    LOGF_INFO(
+        "(EFRadio) All radios down. Free heap: %lu -> %lu bytes\r\n",
+        (unsigned long) heap_before,
+        (unsigned long) ESP.getFreeHeap()
+    );
+}
+
+uint8_t EFRadioClass::getUserCount(EFRadioResource resource) const {
+    return this->users[static_cast<uint8_t>(resource)];
+}
+
+bool EFRadioClass::isActive(EFRadioResource resource) const {
+    return this->getUserCount(resource) > 0;
+}
+
+void EFRadioClass::applyWifiMode() {
+    const bool sta = this->isActive(EFRadioResource::WiFiSTA);
+    const bool ap = this->isActive(EFRadioResource::WiFiAP);
+
+    if (!sta && !ap) {
+        // WIFI_OFF stops and deinitializes the driver, freeing its buffers
+        WiFi.disconnect(true, true);
+        WiFi.mode(WIFI_OFF);
+    } else {
+        WiFi.mode(sta && ap ? WIFI_AP_STA : (sta ? WIFI_STA : WIFI_AP));
+    }
+}
+
+void EFRadioClass::logChange(EFRadioResource resource, const char* action, uint32_t heap_before) {
+    LOGF_INFO(
+        "(EFRadio) %s %s. Free heap: %lu -> %lu bytes\r\n",
+        toString(resource),
+        action,
+        (unsigned long) heap_before,
+        (unsigned long) ESP.getFreeHeap()
+    );
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFRADIO)
+EFRadioClass EFRadio;
+#endif
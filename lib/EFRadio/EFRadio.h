@@ -0,0 +1,116 @@
+#ifndef EFRADIO_H_
+#define EFRADIO_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <Arduino.h>
+
+/**
+ * @brief Number of distinct radio resources managed by EFRadio
+ */
+#define EFRADIO_NUM_RESOURCES 3
+
+/**
+ * @brief Radio stacks that can be shared between multiple users
+ */
+enum class EFRadioResource : uint8_t {
+    BLE = 0,      //!< Bluetooth LE controller and host stack
+    WiFiSTA = 1,  //!< WiFi station interface
+    WiFiAP = 2,   //!< WiFi access point interface (e.g., used by the mesh)
+};
+
+const char* toString(EFRadioResource resource);
+
+/**
+ * @brief Reference counting lifecycle manager for the radio stacks
+ *
+ * Every user acquires the resources it needs on entry and releases them on
+ * exit. A stack is brought up by its first user and torn down as soon as its
+ * last user leaves, so that the heap used by the stack is returned while
+ * only LED animations are running.
+ */
+class EFRadioClass {
+
+    protected:
+
+        uint8_t users[EFRADIO_NUM_RESOURCES];  //!< Number of active users per resource
+
+        /**
+         * @brief Switches the WiFi driver to the mode required by current
+         * STA / AP users. Deinitializes the driver if no user remains.
+         */
+        void applyWifiMode();
+
+        /**
+         * @brief Logs a change of the given resource together with the free heap
+         */
+        void logChange(EFRadioResource resource, const char* action, uint32_t heap_before);
+
+    public:
+
+        /**
+         * @brief Constructs a new EFRadioClass instance with all radios off
+         */
+        EFRadioClass();
+
+        /**
+         * @brief Registers a new user of the given resource. Brings the radio
+         * stack up if this is the first user.
+         *
+         * @param resource Radio resource to acquire
+         * @param ble_name Device name to initialize BLE with. Only used if BLE is brought up.
+         * @return True if the resource is available
+         */
+        bool acquire(EFRadioResource resource, const char* ble_name = "EF28");
+
+        /**
+         * @brief Unregisters a user of the given resource. Tears the radio
+         * stack down if this was the last user.
+         *
+         * @param resource Radio resource to release
+         */
+        void release(EFRadioResource resource);
+
+        /**
+         * @brief Tears all radio stacks down at once, regardless of their
+         * users, e.g., on a brown out. Also switches off WiFi that was not
+         * brought up by EFRadio. Users must not release afterwards.
+         */
+        void shutdown();
+
+        /**
+         * @brief Retrieves the number of active users of the given resource
+         */
+        uint8_t getUserCount(EFRadioResource resource) const;
+
+        /**
+         * @brief Determines if the given radio stack is currently up
+         */
+        bool isActive(EFRadioResource resource) const;
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFRADIO)
+extern EFRadioClass EFRadio;
+#endif
+
+#endif /* EFRADIO_H_ */
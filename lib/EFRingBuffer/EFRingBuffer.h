@@ -0,0 +1,142 @@
+#ifndef EFRINGBUFFER_H_
+#define EFRINGBUFFER_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Fixed-capacity, wait-free single-producer / single-consumer ring buffer
+ *
+ * Intended for handing data from an interrupt service routine to the main
+ * loop without heap allocations or masking interrupts. The producer only ever
+ * writes head, the consumer only ever writes tail. Both indices run freely
+ * and are masked on access, so all N slots are usable.
+ *
+ * Exactly one context may call push() and exactly one context may call
+ * pop() / peek() / discard(). Pushing into a full buffer drops the new
+ * element and counts it as overflow.
+ *
+ * The ring buffer does not depend on Arduino / FreeRTOS and works on the host.
+ *
+ * @tparam T Element type. Must be trivially copyable.
+ * @tparam N Capacity. Must be a power of two.
+ */
+template<typename T, uint32_t N>
+class EFRingBuffer {
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "EFRingBuffer capacity must be a power of two");
+
+    protected:
+
+        T slots[N];                       //!< Element storage
+        std::atomic<uint32_t> head;       //!< Free-running write index, owned by the producer
+        std::atomic<uint32_t> tail;       //!< Free-running read index, owned by the consumer
+        std::atomic<uint32_t> overflows;  //!< Elements dropped because the buffer was full
+
+    public:
+
+        EFRingBuffer() : head(0), tail(0), overflows(0) {}
+
+        /**
+         * @brief Appends an element. Producer side, safe to call from an ISR.
+         *
+         * @param value Element to append
+         * @return True on success, false if the buffer was full and the element was dropped
+         */
+        bool push(const T& value) {
+            const uint32_t h = this->head.load(std::memory_order_relaxed);
+            if (h - this->tail.load(std::memory_order_acquire) >= N) {
+                this->overflows.store(this->overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+            this->slots[h & (N - 1)] = value;
+            this->head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Removes the oldest element. Consumer side.
+         *
+         * @param value Receives the element
+         * @return True if an element was removed, false if the buffer was empty
+         */
+        bool pop(T& value) {
+            const uint32_t t = this->tail.load(std::memory_order_relaxed);
+            if (t == this->head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = this->slots[t & (N - 1)];
+            this->tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Accesses an element without removing it. Consumer side.
+         *
+         * @param offset Position relative to the oldest element
+         * @return Pointer to the element or nullptr if fewer than offset + 1 elements are buffered
+         */
+        const T* peek(uint32_t offset = 0) const {
+            const uint32_t t = this->tail.load(std::memory_order_relaxed);
+            if (this->head.load(std::memory_order_acquire) - t <= offset) {
+                return nullptr;
+            }
+            return &this->slots[(t + offset) & (N - 1)];
+        }
+
+        /**
+         * @brief Removes the given number of oldest elements. Consumer side.
+         */
+        void discard(uint32_t count) {
+            const uint32_t t = this->tail.load(std::memory_order_relaxed);
+            const uint32_t available = this->head.load(std::memory_order_acquire) - t;
+            this->tail.store(t + (count < available ? count : available), std::memory_order_release);
+        }
+
+        /**
+         * @brief Retrieves the number of buffered elements. Exact on the consumer
+         * side, a lower bound for the producer.
+         */
+        uint32_t size() const {
+            return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire);
+        }
+
+        bool empty() const {
+            return this->size() == 0;
+        }
+
+        static constexpr uint32_t capacity() {
+            return N;
+        }
+
+        /**
+         * @brief Retrieves the number of elements dropped because the buffer was full
+         */
+        uint32_t getOverflowCount() const {
+            return this->overflows.load(std::memory_order_relaxed);
+        }
+};
+
+#endif /* EFRINGBUFFER_H_ */
@@ -0,0 +1,255 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <Arduino.h>
+#include <EFLogging.h>
+
+#include "EFScheduler.h"
+
+const char* toString(EFSchedulerPolicy policy) {
+    switch (policy) {
+        case EFSchedulerPolicy::CatchUp: return "catchup";
+        case EFSchedulerPolicy::Drop: return "drop";
+        default: return "UNKNOWN";
+    }
+}
+
+void EFSchedulerHistogram::record(uint32_t value_ms) {
+    uint8_t bucket = 0;
+    while (value_ms >> bucket && bucket < EFSCHEDULER_HISTOGRAM_BUCKETS - 1) {
+        bucket++;
+    }
+    this->buckets[bucket]++;
+    if (value_ms > this->max) {
+        this->max = value_ms;
+    }
+}
+
+void EFSchedulerHistogram::reset() {
+    for (uint8_t i = 0; i < EFSCHEDULER_HISTOGRAM_BUCKETS; i++) {
+        this->buckets[i] = 0;
+    }
+    this->max = 0;
+}
+
+uint32_t EFSchedulerHistogram::getBucketLowerBound(uint8_t bucket) {
+    return bucket == 0 ? 0 : 1UL << (bucket - 1);
+}
+
+EFSchedulerTask::EFSchedulerTask(const char* name, uint32_t period_ms, EFSchedulerPolicy policy, void (*callback)())
+: name(name)
+, callback(callback)
+, idle_hint(nullptr)
+, period_ms(period_ms)
+, policy(policy)
+, enabled(true)
+, deadline(0)
+, last_start(0)
+, has_last_start(false)
+, runs(0)
+, missed(0)
+{
+    this->resetStats();
+}
+
+void EFSchedulerTask::reset(uint32_t now) {
+    this->deadline = now;
+    this->has_last_start = false;
+}
+
+void EFSchedulerTask::setPeriod(uint32_t period_ms) {
+    this->period_ms = period_ms;
+}
+
+void EFSchedulerTask::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool EFSchedulerTask::isDue(uint32_t now) const {
+    return this->enabled && efschedulerIsReached(now, this->deadline);
+}
+
+uint32_t EFSchedulerTask::getTimeUntilDue(uint32_t now) const {
+    if (!this->enabled) {
+        return UINT32_MAX;
+    }
+    return efschedulerIsReached(now, this->deadline) ? 0 : this->deadline - now;
+}
+
+void EFSchedulerTask::setIdleHint(uint32_t (*hint)(uint32_t now)) {
+    this->idle_hint = hint;
+}
+
+uint32_t EFSchedulerTask::getTimeUntilWork(uint32_t now) const {
+    const uint32_t due = this->getTimeUntilDue(now);
+    if (this->idle_hint == nullptr || due == UINT32_MAX) {
+        return due;
+    }
+    return max(due, this->idle_hint(now));
+}
+
+void EFSchedulerTask::begin(uint32_t now) {
+    const uint32_t late = now - this->deadline;
+    this->lateness.record(late);
+    if (this->has_last_start) {
+        const uint32_t interval = now - this->last_start;
+        this->jitter.record(interval > this->period_ms ? interval - this->period_ms : this->period_ms - interval);
+    }
+    this->last_start = now;
+    this->has_last_start = true;
+    this->runs++;
+
+    // Period 0 means "whenever polled", but at most once per millisecond
+    if (this->period_ms == 0) {
+        this->deadline = now + 1;
+        return;
+    }
+
+    const uint32_t behind = late / this->period_ms;
+    if (this->policy == EFSchedulerPolicy::Drop) {
+        // Skip all periods that already passed but stay on the period grid
+        this->missed += behind;
+        this->deadline += (behind + 1) * this->period_ms;
+    } else if (behind >= EFSCHEDULER_MAX_CATCHUP) {
+        // Too far behind to catch up in a reasonable burst. Re-synchronize.
+        this->missed += behind;
+        this->deadline = now + this->period_ms;
+    } else {
+        this->deadline += this->period_ms;
+    }
+}
+
+uint8_t EFSchedulerTask::run(uint32_t now) {
+    if (this->callback == nullptr) {
+        return 0;
+    }
+
+    uint8_t n = 0;
+    while (n < EFSCHEDULER_MAX_CATCHUP && this->isDue(now)) {
+        this->begin(now);
+        this->callback();
+        n++;
+    }
+    return n;
+}
+
+void EFSchedulerTask::resetStats() {
+    this->runs = 0;
+    this->missed = 0;
+    this->lateness.reset();
+    this->jitter.reset();
+}
+
+bool EFSchedulerTask::hasCallback() const {
+    return this->callback != nullptr;
+}
+
+const char* EFSchedulerTask::getName() const {
+    return this->name;
+}
+
+uint32_t EFSchedulerTask::getPeriodMs() const {
+    return this->period_ms;
+}
+
+EFSchedulerPolicy EFSchedulerTask::getPolicy() const {
+    return this->policy;
+}
+
+uint32_t EFSchedulerTask::getRunCount() const {
+    return this->runs;
+}
+
+uint32_t EFSchedulerTask::getMissedCount() const {
+    return this->missed;
+}
+
+const EFSchedulerHistogram& EFSchedulerTask::getLateness() const {
+    return this->lateness;
+}
+
+const EFSchedulerHistogram& EFSchedulerTask::getJitter() const {
+    return this->jitter;
+}
+
+EFSchedulerClass::EFSchedulerClass()
+: num_tasks(0)
+{
+}
+
+bool EFSchedulerClass::add(EFSchedulerTask& task) {
+    if (this->num_tasks >= EFSCHEDULER_MAX_TASKS) {
+        LOGF_ERROR("(EFScheduler) Cannot add task %s, all %d slots in use\r\n", task.getName(), EFSCHEDULER_MAX_TASKS);
+        return false;
+    }
+    this->tasks[this->num_tasks++] = &task;
+    return true;
+}
+
+uint32_t EFSchedulerClass::poll() {
+    uint32_t n = 0;
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+        // Re-read the clock for every task so lateness reflects preceding tasks
+        n += this->tasks[i]->run(millis());
+    }
+    return n;
+}
+
+uint32_t EFSchedulerClass::getTimeUntilNextDeadline() const {
+    const uint32_t now = millis();
+    uint32_t next = UINT32_MAX;
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+        if (this->tasks[i]->hasCallback()) {
+            next = min(next, this->tasks[i]->getTimeUntilDue(now));
+        }
+    }
+    return next;
+}
+
+uint32_t EFSchedulerClass::getTimeUntilNextWork() const {
+    const uint32_t now = millis();
+    uint32_t next = UINT32_MAX;
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+        if (this->tasks[i]->hasCallback()) {
+            next = min(next, this->tasks[i]->getTimeUntilWork(now));
+        }
+    }
+    return next;
+}
+
+uint8_t EFSchedulerClass::getTaskCount() const {
+    return this->num_tasks;
+}
+
+EFSchedulerTask* EFSchedulerClass::getTask(uint8_t idx) const {
+    return idx < this->num_tasks ? this->tasks[idx] : nullptr;
+}
+
+void EFSchedulerClass::resetStats() {
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+        this->tasks[i]->resetStats();
+    }
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFSCHEDULER)
+EFSchedulerClass EFScheduler;
+#endif
@@ -0,0 +1,251 @@
+#ifndef EFSCHEDULER_H_
+#define EFSCHEDULER_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of tasks that can be registered with the scheduler
+ */
+#define EFSCHEDULER_MAX_TASKS 8
+
+/**
+ * @brief Maximum number of back-to-back runs a CatchUp task performs within a
+ * single poll. Tasks lagging further behind are re-synchronized.
+ */
+#define EFSCHEDULER_MAX_CATCHUP 4
+
+/**
+ * @brief Number of buckets in lateness / jitter histograms. Bucket 0 counts
+ * 0 ms, bucket n counts [2^(n-1), 2^n) ms, the last bucket everything above.
+ */
+#define EFSCHEDULER_HISTOGRAM_BUCKETS 8
+
+
+/**
+ * @brief Wrap-safe check if the given deadline has been reached
+ *
+ * @param now Current time in milliseconds
+ * @param deadline Deadline in milliseconds
+ * @return True if now is at or after deadline, even across millis() overflow
+ */
+inline bool efschedulerIsReached(uint32_t now, uint32_t deadline) {
+    return static_cast<int32_t>(now - deadline) >= 0;
+}
+
+/**
+ * @brief What a task does after missing one or more of its deadlines
+ */
+enum class EFSchedulerPolicy : uint8_t {
+    CatchUp,  //!< Run once for every missed period (bounded by EFSCHEDULER_MAX_CATCHUP), keeps the long-term rate
+    Drop,     //!< Skip missed periods and stay on the original period grid
+};
+
+const char* toString(EFSchedulerPolicy policy);
+
+/**
+ * @brief Histogram with power-of-two millisecond buckets
+ */
+struct EFSchedulerHistogram {
+    uint32_t buckets[EFSCHEDULER_HISTOGRAM_BUCKETS];  //!< Sample count per bucket
+    uint32_t max;                                     //!< Largest sample recorded
+
+    /**
+     * @brief Adds a sample to the histogram
+     */
+    void record(uint32_t value_ms);
+
+    /**
+     * @brief Clears all samples
+     */
+    void reset();
+
+    /**
+     * @brief Retrieves the lower bound of the given bucket in milliseconds
+     */
+    static uint32_t getBucketLowerBound(uint8_t bucket);
+};
+
+/**
+ * @brief A periodic task with an absolute deadline
+ *
+ * Deadlines advance by exactly one period per run instead of being derived
+ * from the time a run happened. Blocking code therefore delays a task, but
+ * does not shift its period grid.
+ */
+class EFSchedulerTask {
+
+    protected:
+
+        const char* name;                //!< Name used in statistics output
+        void (*callback)();              //!< Function executed by EFSchedulerClass::poll() or nullptr if run manually
+        uint32_t (*idle_hint)(uint32_t); //!< Reports when the callback has actual work or nullptr if it always has
+        uint32_t period_ms;              //!< Nominal time between two runs
+        EFSchedulerPolicy policy;        //!< Behavior after missed deadlines
+        bool enabled;                    //!< Disabled tasks are never due
+
+        uint32_t deadline;               //!< Absolute time of the next run
+        uint32_t last_start;             //!< Time the previous run started
+        bool has_last_start;             //!< False until the first run after a reset
+
+        uint32_t runs;                   //!< Number of runs
+        uint32_t missed;                 //!< Number of periods skipped due to Drop policy or re-sync
+        EFSchedulerHistogram lateness;   //!< Time between deadline and actual start
+        EFSchedulerHistogram jitter;     //!< Deviation of the time between two starts from the period
+
+    public:
+
+        /**
+         * @brief Constructs a new task. The task is due immediately once reset.
+         *
+         * @param name Name used in statistics output
+         * @param period_ms Nominal time between two runs. 0 makes the task due
+         * whenever polled, at most once per millisecond.
+         * @param policy Behavior after missed deadlines
+         * @param callback Function to run or nullptr if the owner runs it via begin()
+         */
+        EFSchedulerTask(const char* name, uint32_t period_ms, EFSchedulerPolicy policy, void (*callback)() = nullptr);
+
+        /**
+         * @brief Makes the task due at the given time and forgets the previous run
+         */
+        void reset(uint32_t now);
+
+        /**
+         * @brief Changes the period. The current deadline is kept.
+         */
+        void setPeriod(uint32_t period_ms);
+
+        void setEnabled(bool enabled);
+
+        /**
+         * @brief Sets a function reporting the milliseconds until the callback
+         * has actual work. Lets tasks that poll at a fixed period (e.g. for
+         * events) tell the idle governor that it may sleep past their deadline.
+         *
+         * @param hint Function receiving the current time or nullptr to clear
+         */
+        void setIdleHint(uint32_t (*hint)(uint32_t now));
+
+        /**
+         * @brief Determines if the task should run at the given time
+         */
+        bool isDue(uint32_t now) const;
+
+        /**
+         * @brief Milliseconds until the task becomes due. 0 if already due.
+         */
+        uint32_t getTimeUntilDue(uint32_t now) const;
+
+        /**
+         * @brief Milliseconds until the task is due and has work according to
+         * its idle hint. Equals getTimeUntilDue() for tasks without a hint.
+         */
+        uint32_t getTimeUntilWork(uint32_t now) const;
+
+        /**
+         * @brief Marks the start of a run. Records lateness and jitter and moves
+         * the deadline according to the task's policy. Must only be called if
+         * isDue() returned true.
+         */
+        void begin(uint32_t now);
+
+        /**
+         * @brief Runs the callback while the task is due, at most
+         * EFSCHEDULER_MAX_CATCHUP times. Does nothing for tasks without callback.
+         *
+         * @return Number of runs
+         */
+        uint8_t run(uint32_t now);
+
+        /**
+         * @brief Clears all statistics
+         */
+        void resetStats();
+
+        bool hasCallback() const;
+        const char* getName() const;
+        uint32_t getPeriodMs() const;
+        EFSchedulerPolicy getPolicy() const;
+        uint32_t getRunCount() const;
+        uint32_t getMissedCount() const;
+        const EFSchedulerHistogram& getLateness() const;
+        const EFSchedulerHistogram& getJitter() const;
+};
+
+/**
+ * @brief Runs registered periodic tasks at their deadlines
+ */
+class EFSchedulerClass {
+
+    protected:
+
+        EFSchedulerTask* tasks[EFSCHEDULER_MAX_TASKS];  //!< Registered tasks
+        uint8_t num_tasks;                              //!< Number of registered tasks
+
+    public:
+
+        EFSchedulerClass();
+
+        /**
+         * @brief Registers a task. Tasks with a callback are run by poll(),
+         * tasks without one only show up in statistics.
+         *
+         * @param task Task to register. Must outlive the scheduler.
+         * @return True on success, false if EFSCHEDULER_MAX_TASKS is exceeded
+         */
+        bool add(EFSchedulerTask& task);
+
+        /**
+         * @brief Runs all due tasks with a callback in order of registration
+         *
+         * @return Number of task runs performed
+         */
+        uint32_t poll();
+
+        /**
+         * @brief Milliseconds until the next task with a callback becomes due
+         */
+        uint32_t getTimeUntilNextDeadline() const;
+
+        /**
+         * @brief Milliseconds until the next task with a callback is due and has
+         * work, i.e., how long the CPU may sleep. Respects idle hints.
+         */
+        uint32_t getTimeUntilNextWork() const;
+
+        uint8_t getTaskCount() const;
+        EFSchedulerTask* getTask(uint8_t idx) const;
+
+        /**
+         * @brief Clears statistics of all registered tasks
+         */
+        void resetStats();
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFSCHEDULER)
+extern EFSchedulerClass EFScheduler;
+#endif
+
+#endif /* EFSCHEDULER_H_ */
@@ -0,0 +1,125 @@
+#ifndef EFSNAPSHOT_H_
+#define EFSNAPSHOT_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief Lock-free single-producer / single-consumer handoff of the latest
+ * value of a state struct between two cores
+ *
+ * Triple buffer: the producer writes into the slot it owns and swaps it with
+ * the shared slot on publish(), the consumer swaps the shared slot with the
+ * slot it reads from on update(). Neither side ever blocks or sees a partially
+ * written value. Values published before the consumer picked them up are
+ * replaced by the newer one (coalesced), so the consumer always reads the
+ * latest state.
+ *
+ * Exactly one context may call publish() and exactly one context may call
+ * update() / read(). Like EFRingBuffer, the snapshot does not depend on
+ * Arduino / FreeRTOS and works on the host.
+ *
+ * @tparam T State type. Must be trivially copyable.
+ */
+template<typename T>
+class EFSnapshot {
+
+    static_assert(std::is_trivially_copyable<T>::value, "EFSnapshot state must be trivially copyable");
+
+    protected:
+
+        static constexpr uint8_t SLOT_MASK = 0x03;   //!< Bits of shared_slot holding the slot index
+        static constexpr uint8_t FLAG_FRESH = 0x04;  //!< Set in shared_slot if it holds an unread value
+
+        T slots[3];                             //!< Value storage
+        uint8_t back_slot;                      //!< Slot owned by the producer
+        uint8_t front_slot;                     //!< Slot owned by the consumer
+        std::atomic<uint8_t> shared_slot;       //!< Slot exchanged between both sides incl. FLAG_FRESH
+
+        std::atomic<uint32_t> published;        //!< Number of values published by the producer
+        std::atomic<uint32_t> coalesced;        //!< Number of values replaced by a newer one before they were read
+
+    public:
+
+        EFSnapshot()
+        : slots()
+        , back_slot(0)
+        , front_slot(1)
+        , shared_slot(2)
+        , published(0)
+        , coalesced(0)
+        {}
+
+        /**
+         * @brief Hands a copy of the given value over to the consumer. Producer side, never blocks.
+         *
+         * @param value Value to publish
+         */
+        void publish(const T& value) {
+            this->slots[this->back_slot] = value;
+            uint8_t prev = this->shared_slot.exchange(this->back_slot | FLAG_FRESH);
+            this->back_slot = prev & SLOT_MASK;
+            this->published.fetch_add(1, std::memory_order_relaxed);
+            if (prev & FLAG_FRESH) {
+                this->coalesced.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Determines if a value was published since the last update()
+         */
+        bool pending() const {
+            return this->shared_slot.load() & FLAG_FRESH;
+        }
+
+        /**
+         * @brief Takes over the newest published value, if any. Consumer side, never blocks.
+         *
+         * @return True, if read() now returns a newer value
+         */
+        bool update() {
+            if (!this->pending()) {
+                return false;
+            }
+            uint8_t prev = this->shared_slot.exchange(this->front_slot);
+            this->front_slot = prev & SLOT_MASK;
+            return true;
+        }
+
+        /**
+         * @brief Accesses the value taken over by the last update(). Consumer side.
+         *
+         * @return Latest value, or a value-initialized T if nothing was published yet
+         */
+        const T& read() const {
+            return this->slots[this->front_slot];
+        }
+
+        uint32_t getPublishedCount() const { return this->published.load(std::memory_order_relaxed); }
+        uint32_t getCoalescedCount() const { return this->coalesced.load(std::memory_order_relaxed); }
+};
+
+#endif /* EFSNAPSHOT_H_ */
@@ -28,26 +28,67 @@
 
 #include "EFTouch.h"
 
+#if defined(EFTOUCH_HW_FILTER) && !defined(EFSIM)
+#include <driver/touch_sensor.h>
+#endif
+
+/**
+ * @brief Builds the baseline tracker tuning for the given detection step
+ */
+static EFTouchBaselineConfig baselineConfig(touch_value_t detection_step) {
+    return {
+        detection_step,
+        EFTOUCH_BASELINE_NOISE_FACTOR,
+        EFTOUCH_RELEASE_THRESHOLD_PERCENT,
+        EFTOUCH_BASELINE_IIR_SHIFT,
+        EFTOUCH_BASELINE_MAX_TOUCH_MS
+    };
+}
+
+/**
+ * @brief Determines if the press threshold moved by more than 1/8 of the current interrupt threshold
+ */
+static bool thresholdMoved(touch_value_t current, touch_value_t press) {
+    const touch_value_t distance = press > current ? press - current : current - press;
+    return distance > current / 8;
+}
+
+void ARDUINO_ISR_ATTR _eftouch_isr_fingerprint() {
+    EFTouch._handleInterrupt(
+        EFTouchZone::Fingerprint,
+        touchInterruptGetLastStatus(EFTOUCH_PIN_TOUCH_FINGERPRINT)
+    );
+}
+
+void ARDUINO_ISR_ATTR _eftouch_isr_nose() {
+    EFTouch._handleInterrupt(
+        EFTouchZone::Nose,
+        touchInterruptGetLastStatus(EFTOUCH_PIN_TOUCH_NOSE)
+    );
+}
+
 EFTouchClass::EFTouchClass()
 : pin_fingerprint(EFTOUCH_PIN_TOUCH_FINGERPRINT)
 , pin_nose(EFTOUCH_PIN_TOUCH_NOSE)
 , detection_step(10000)
-, noise_fingerprint(0)
-, noise_nose(0)
-, last_release_millis_fingerprint(0)
-, last_release_millis_nose(0)
-, last_touch_millis_fingerprint(0)
-, last_touch_millis_nose(0)
-, last_multitouch_long(0)
-, last_multitouch_short(0)
-, onFingerprintTouchIsr(nullptr)
-, onFingerprintReleaseIsr(nullptr)
-, onFingerprintShortpressIsr(nullptr)
-, onFingerprintLongpressIsr(nullptr)
-, onNoseTouchIsr(nullptr)
-, onNoseReleaseIsr(nullptr)
-, onNoseShortpressIsr(nullptr)
-, onNoseLongpressIsr(nullptr)
+, baseline_fingerprint(baselineConfig(10000))
+, baseline_nose(baselineConfig(10000))
+, threshold_fingerprint(10000)
+, threshold_nose(10000)
+, baseline_sampled_ms(0)
+, event_timestamp_us(0)
+, onFingerprintTouchHandler(nullptr)
+, onFingerprintReleaseHandler(nullptr)
+, onFingerprintShortpressHandler(nullptr)
+, onFingerprintLongpressHandler(nullptr)
+, onFingerprintHoldHandler(nullptr)
+, onNoseTouchHandler(nullptr)
+, onNoseReleaseHandler(nullptr)
+, onNoseShortpressHandler(nullptr)
+, onNoseLongpressHandler(nullptr)
+, onNoseHoldHandler(nullptr)
+, onAllShortpressHandler(nullptr)
+, onAllLongpressHandler(nullptr)
 {
 }
 
@@ -65,101 +106,251 @@ void EFTouchClass::init(touch_value_t detection_step, uint8_t pin_fingerprint, u
     this->detection_step = detection_step;
     this->pin_fingerprint = pin_fingerprint;
     this->pin_nose = pin_nose;
-    this->last_release_millis_fingerprint = 0;
-    this->last_release_millis_nose = 0;
-    this->last_touch_millis_fingerprint = 0;
-    this->last_touch_millis_nose = 0;
-    this->last_multitouch_long = 0;
-    this->last_multitouch_short = 0;
-    this->onFingerprintTouchIsr = nullptr;
-    this->onFingerprintReleaseIsr = nullptr;
-    this->onFingerprintShortpressIsr = nullptr;
-    this->onFingerprintLongpressIsr = nullptr;
-    this->onNoseTouchIsr = nullptr;
-    this->onNoseReleaseIsr = nullptr;
-    this->onNoseShortpressIsr = nullptr;
-    this->onNoseLongpressIsr = nullptr;
+    this->baseline_fingerprint = EFTouchBaseline(baselineConfig(detection_step));
+    this->baseline_nose = EFTouchBaseline(baselineConfig(detection_step));
+    this->threshold_fingerprint = detection_step;
+    this->threshold_nose = detection_step;
+    this->gestures.reset();
+    this->event_timestamp_us = 0;
+    this->onFingerprintTouchHandler = nullptr;
+    this->onFingerprintReleaseHandler = nullptr;
+    this->onFingerprintShortpressHandler = nullptr;
+    this->onFingerprintLongpressHandler = nullptr;
+    this->onFingerprintHoldHandler = nullptr;
+    this->onNoseTouchHandler = nullptr;
+    this->onNoseReleaseHandler = nullptr;
+    this->onNoseShortpressHandler = nullptr;
+    this->onNoseLongpressHandler = nullptr;
+    this->onNoseHoldHandler = nullptr;
+    this->onAllShortpressHandler = nullptr;
+    this->onAllLongpressHandler = nullptr;
 
     LOGF_INFO("(EFTouch) Initialized EFTouch instance with detection_step=%d\r\n", detection_step);
     LOGF_DEBUG("(EFTouch) Registered: pin_fingerprint=%d pin_nose=%d\r\n", pin_fingerprint, pin_nose);
 
+    this->configureHardwareFilter();
     this->calibrate();
     this->enableInterrupts(EFTouchZone::Fingerprint);
     this->enableInterrupts(EFTouchZone::Nose);
 }
 
 void EFTouchClass::calibrate() {
-    // Reset calibration values
-    this->noise_fingerprint = 0;
-    this->noise_nose = 0;
+    touch_value_t sum_fingerprint = 0;
+    touch_value_t sum_nose = 0;
+    touch_value_t max_fingerprint = 0;
+    touch_value_t max_nose = 0;
 
-    // Calibrate
+    // Sample
     touch_value_t reading = 0;
     for (uint8_t i = 0; i < EFTOUCH_CALIBRATE_NUM_SAMPLES; i++) {
         // Fingerprint
         reading = touchRead(this->pin_fingerprint);
-        if (reading > this->noise_fingerprint) {
-            this->noise_fingerprint = reading;
-            LOGF_INFO("(EFTouch) Calibrated fingerprint noise floor to: %d\r\n", this->noise_fingerprint);
-        }
+        sum_fingerprint += reading;
+        max_fingerprint = max(max_fingerprint, reading);
 
         // Nose
         reading = touchRead(this->pin_nose);
-        if (reading > this->noise_nose) {
-            this->noise_nose = reading;
-            LOGF_INFO("(EFTouch) Calibrated nose noise floor to: %d\r\n", this->noise_nose);
-        }
+        sum_nose += reading;
+        max_nose = max(max_nose, reading);
     }
+
+    // Start tracking from the mean, the peak deviation seeds the noise estimate
+    const touch_value_t mean_fingerprint = sum_fingerprint / EFTOUCH_CALIBRATE_NUM_SAMPLES;
+    const touch_value_t mean_nose = sum_nose / EFTOUCH_CALIBRATE_NUM_SAMPLES;
+    this->baseline_fingerprint.reset(mean_fingerprint, max_fingerprint - mean_fingerprint);
+    this->baseline_nose.reset(mean_nose, max_nose - mean_nose);
+    this->baseline_sampled_ms = millis();
+    LOGF_INFO(
+        "(EFTouch) Calibrated fingerprint baseline to: %d (noise %d)\r\n",
+        this->baseline_fingerprint.getBaseline(),
+        this->baseline_fingerprint.getNoise()
+    );
+    LOGF_INFO(
+        "(EFTouch) Calibrated nose baseline to: %d (noise %d)\r\n",
+        this->baseline_nose.getBaseline(),
+        this->baseline_nose.getNoise()
+    );
+}
+
+void EFTouchClass::configureHardwareFilter() {
+#if defined(EFTOUCH_HW_FILTER) && !defined(EFSIM)
+    // The first reading initializes the touch peripheral
+    touchRead(this->pin_fingerprint);
+
+    touch_pad_fsm_stop();
+
+    // Smooths the values the interrupt compares against the hardware benchmark
+    touch_filter_config_t filter = {};
+    filter.mode = TOUCH_PAD_FILTER_IIR_16;
+    filter.debounce_cnt = 1;
+    filter.noise_thr = 0;
+    filter.jitter_step = 4;
+    filter.smh_lvl = TOUCH_PAD_SMOOTH_IIR_2;
+    touch_pad_filter_set_config(&filter);
+    touch_pad_filter_enable();
+
+    // Subtracts the common mode noise measured on the internal denoise channel
+    touch_pad_denoise_t denoise = {};
+    denoise.grade = TOUCH_PAD_DENOISE_BIT4;
+    denoise.cap_level = TOUCH_PAD_DENOISE_CAP_L4;
+    touch_pad_denoise_set_config(&denoise);
+    touch_pad_denoise_enable();
+
+    touch_pad_fsm_start();
+    LOG_INFO("(EFTouch) Enabled hardware touch filter and denoise");
+#endif
 }
 
 touch_value_t EFTouchClass::getFingerprintNoiseLevel() {
-    return this->noise_fingerprint;
+    return this->baseline_fingerprint.getBaseline();
 }
 
 touch_value_t EFTouchClass::getNoseNoiseLevel() {
-    return this->noise_nose;
+    return this->baseline_nose.getBaseline();
+}
+
+const EFTouchBaseline& EFTouchClass::getBaseline(EFTouchZone zone) const {
+    return zone == EFTouchZone::Nose ? this->baseline_nose : this->baseline_fingerprint;
 }
 
 bool EFTouchClass::isFingerprintTouched() {
-    return touchRead(this->pin_fingerprint) > this->noise_fingerprint + this->detection_step;
+    return this->baseline_fingerprint.update(touchRead(this->pin_fingerprint), millis());
 }
 
 bool EFTouchClass::isNoseTouched() {
-    return touchRead(this->pin_nose) > this->noise_nose + this->detection_step;
+    return this->baseline_nose.update(touchRead(this->pin_nose), millis());
+}
+
+bool EFTouchClass::isTouchActive() {
+    return touchInterruptGetLastStatus(this->pin_fingerprint) ||
+           touchInterruptGetLastStatus(this->pin_nose) ||
+           !this->edges.empty();
+}
+
+void EFTouchClass::poll() {
+    EFTouchEdge edge;
+    EFTouchGestureEvent events[EFTOUCH_GESTURES_MAX_EVENTS];
+    uint8_t num_events;
+
+    while (this->edges.pop(edge)) {
+        num_events = this->gestures.feed(edge, events);
+        for (uint8_t i = 0; i < num_events; i++) {
+            this->dispatch(events[i]);
+        }
+    }
+
+    // Longpress and hold fire while the zone is still held
+    num_events = this->gestures.tick(millis(), micros(), events);
+    for (uint8_t i = 0; i < num_events; i++) {
+        this->dispatch(events[i]);
+    }
+
+    if (millis() - this->baseline_sampled_ms >= EFTOUCH_BASELINE_INTERVAL_MS) {
+        this->trackBaselines();
+    }
+}
+
+void EFTouchClass::trackBaselines() {
+    const uint32_t now = millis();
+    this->baseline_sampled_ms = now;
+    this->baseline_fingerprint.update(touchRead(this->pin_fingerprint), now);
+    this->baseline_nose.update(touchRead(this->pin_nose), now);
+
+    // Only move interrupt thresholds between touches, so no edge gets lost
+    if (this->baseline_fingerprint.isTouched() || this->baseline_nose.isTouched() || this->isTouchActive()) {
+        return;
+    }
+
+    // Follow the press thresholds once they moved noticeably
+    const touch_value_t press_fingerprint = this->baseline_fingerprint.getPressThreshold();
+    if (thresholdMoved(this->threshold_fingerprint, press_fingerprint)) {
+        LOGF_DEBUG("(EFTouch) Fingerprint threshold: %d -> %d\r\n", this->threshold_fingerprint, press_fingerprint);
+        this->threshold_fingerprint = press_fingerprint;
+        touchAttachInterrupt(this->pin_fingerprint, _eftouch_isr_fingerprint, this->threshold_fingerprint);
+    }
+    const touch_value_t press_nose = this->baseline_nose.getPressThreshold();
+    if (thresholdMoved(this->threshold_nose, press_nose)) {
+        LOGF_DEBUG("(EFTouch) Nose threshold: %d -> %d\r\n", this->threshold_nose, press_nose);
+        this->threshold_nose = press_nose;
+        touchAttachInterrupt(this->pin_nose, _eftouch_isr_nose, this->threshold_nose);
+    }
+}
+
+void EFTouchClass::dispatch(const EFTouchGestureEvent& event) {
+    void (*handler)(void) = nullptr;
+
+    switch (event.gesture) {
+        case EFTouchGesture::Touch:
+            handler = event.zone == EFTouchZone::Fingerprint ? this->onFingerprintTouchHandler : this->onNoseTouchHandler;
+            break;
+        case EFTouchGesture::Release:
+            handler = event.zone == EFTouchZone::Fingerprint ? this->onFingerprintReleaseHandler : this->onNoseReleaseHandler;
+            break;
+        case EFTouchGesture::Shortpress:
+            switch (event.zone) {
+                case EFTouchZone::All: handler = this->onAllShortpressHandler; break;
+                case EFTouchZone::Fingerprint: handler = this->onFingerprintShortpressHandler; break;
+                case EFTouchZone::Nose: handler = this->onNoseShortpressHandler; break;
+            }
+            break;
+        case EFTouchGesture::Longpress:
+            switch (event.zone) {
+                case EFTouchZone::All: handler = this->onAllLongpressHandler; break;
+                case EFTouchZone::Fingerprint: handler = this->onFingerprintLongpressHandler; break;
+                case EFTouchZone::Nose: handler = this->onNoseLongpressHandler; break;
+            }
+            break;
+        case EFTouchGesture::Hold:
+            handler = event.zone == EFTouchZone::Fingerprint ? this->onFingerprintHoldHandler : this->onNoseHoldHandler;
+            break;
+    }
+
+    if (handler != nullptr) {
+        this->event_timestamp_us = event.timestamp_us;
+        handler();
+    }
+}
+
+uint32_t EFTouchClass::getEventTimestampUs() const {
+    return this->event_timestamp_us;
+}
+
+uint32_t EFTouchClass::getDroppedEdgeCount() const {
+    return this->edges.getOverflowCount();
 }
 
 uint8_t EFTouchClass::readFingerprint() {
-    touch_value_t reading = touchRead(this->pin_fingerprint); 
+    const uint32_t delta = this->baseline_fingerprint.getDelta(touchRead(this->pin_fingerprint));
 
-    if (reading < this->noise_fingerprint + this->detection_step) {
+    if (delta < this->baseline_fingerprint.getPressThreshold()) {
         return 0;
     } else {
-        return (reading - this->noise_fingerprint) / this->detection_step;
+        return delta / this->detection_step;
     }
 }
 
 uint8_t EFTouchClass::readNose() {
-    touch_value_t reading = touchRead(this->pin_nose); 
+    const uint32_t delta = this->baseline_nose.getDelta(touchRead(this->pin_nose));
 
-    if (reading < this->noise_nose + this->detection_step) {
+    if (delta < this->baseline_nose.getPressThreshold()) {
         return 0;
     } else {
-        return (reading - this->noise_nose) / this->detection_step;
+        return delta / this->detection_step;
     }
 }
 
-void ARDUINO_ISR_ATTR _eftouch_isr_fingerprint() {
-    EFTouch._handleInterrupt(
-        EFTouchZone::Fingerprint,
-        touchInterruptGetLastStatus(EFTOUCH_PIN_TOUCH_FINGERPRINT)
-    );
+EFTouchSample EFTouchClass::readRaw() {
+    return {touchRead(this->pin_fingerprint), touchRead(this->pin_nose)};
 }
 
-void ARDUINO_ISR_ATTR _eftouch_isr_nose() {
-    EFTouch._handleInterrupt(
-        EFTouchZone::Nose,
-        touchInterruptGetLastStatus(EFTOUCH_PIN_TOUCH_NOSE)
-    );
+void EFTouchClass::enableWakeup(EFTouchZone zone) {
+    // Only a single pad can wake the ESP32-S3 from deep sleep
+    if (zone == EFTouchZone::Nose) {
+        touchSleepWakeUpEnable(this->pin_nose, this->threshold_nose);
+    } else {
+        touchSleepWakeUpEnable(this->pin_fingerprint, this->threshold_fingerprint);
+    }
+    esp_sleep_enable_touchpad_wakeup();
 }
 
 void EFTouchClass::enableInterrupts(EFTouchZone zone) {
@@ -168,7 +359,7 @@ void EFTouchClass::enableInterrupts(EFTouchZone zone) {
             touchAttachInterrupt(
                 this->pin_fingerprint,
                 _eftouch_isr_fingerprint,
-                this->detection_step
+                this->threshold_fingerprint
             );
             LOG_INFO("(EFTouch) Enabled fingerprint interrupts");
             break;
@@ -176,7 +367,7 @@ void EFTouchClass::enableInterrupts(EFTouchZone zone) {
             touchAttachInterrupt(
                 this->pin_nose,
                 _eftouch_isr_nose,
-                this->detection_step
+                this->threshold_nose
             );
             LOG_INFO("(EFTouch) Enabled nose interrupts");
             break;
@@ -203,257 +394,185 @@ void EFTouchClass::disableInterrupts(EFTouchZone zone) {
 }
 
 void ARDUINO_ISR_ATTR EFTouchClass::_handleInterrupt(EFTouchZone zone, bool raising_flank) {
+    // Classification happens in poll(), a dropped edge is counted by the buffer
+    this->edges.push({zone, raising_flank, (uint32_t) millis(), (uint32_t) micros()});
+}
+
+void EFTouchClass::attachHandlerOnTouch(EFTouchZone zone, void (*handler)(void)) {
     switch (zone) {
+        case EFTouchZone::All:
+            LOG_ERROR("(EFTouch) Attaching onTouch handler to all zones is currently not supported");
+            break;
         case EFTouchZone::Fingerprint:
-            if (raising_flank) {
-                // Register first touch timestamp
-                this->last_touch_millis_fingerprint = millis();
-
-                // Fire onFingerprintTouchIsr()
-                if (this->onFingerprintTouchIsr != nullptr) {
-                    this->onFingerprintTouchIsr();
-                }
+            if (handler) {
+                this->onFingerprintTouchHandler = handler;
+                LOG_INFO("(EFTouch) Attached onTouch handler to fingerprint zone");
             } else {
-                // Register last release timestamp
-                this->last_release_millis_fingerprint = millis();
-
-                // Fire onFingerprintShortpressIsr() if applicable
-                if (this->onFingerprintShortpressIsr != nullptr) {
-                    if (this->last_touch_millis_fingerprint + EFTOUCH_SHORTPRESS_DURATION_MS < millis()) {
-                        // Check if all touch zones were short pressed 
-                        if (this->onAllShortpressIsr != nullptr && (this->last_multitouch_short + EFTOUCH_MULTITOUCH_COOLDOWN_MS < millis())) {
-                            if ((this->isNoseTouched() || millis() - this->last_release_millis_nose < EFTOUCH_MULTITOUCH_COOLDOWN_MS) &&
-                                (this->last_touch_millis_nose + EFTOUCH_SHORTPRESS_DURATION_MS < millis()))
-                            {
-                                this->last_multitouch_short = millis();
-                                this->onAllShortpressIsr();
-                            }
-                        }
-
-                        // Execute zone ISR
-                        this->onFingerprintShortpressIsr();
-                    }
-                }
-                // Fire onFingerperintLongpressIsr() if applicable
-                if (this->onFingerprintLongpressIsr != nullptr) {
-                    if (this->last_touch_millis_fingerprint + EFTOUCH_LONGPRESS_DURATION_MS < millis()) {
-                        // Check if all touch zones were long pressed 
-                        if (this->onAllLongpressIsr != nullptr && (this->last_multitouch_long + EFTOUCH_MULTITOUCH_COOLDOWN_MS < millis())) {
-                            if ((this->isNoseTouched() || millis() - this->last_release_millis_nose < EFTOUCH_MULTITOUCH_COOLDOWN_MS ) &&
-                                (this->last_touch_millis_nose + EFTOUCH_LONGPRESS_DURATION_MS < millis()))
-                            {
-                                this->last_multitouch_long = millis();
-                                this->onAllLongpressIsr();
-                            }
-                        }
-
-                        // Execute zone ISR
-                        this->onFingerprintLongpressIsr();
-                    }
-                }
-                // Fire onFingerprintReleaseIsr()
-                if (this->onFingerprintReleaseIsr != nullptr) {
-                    this->onFingerprintReleaseIsr();
-                }
+                this->onFingerprintTouchHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onTouch handler from fingerprint zone");
             }
             break;
         case EFTouchZone::Nose:
-            if (raising_flank) {
-                // Register first touch timestamp
-                this->last_touch_millis_nose = millis();
-
-                // Fire onNoseTouchIsr()
-                if (this->onNoseTouchIsr != nullptr) {
-                    this->onNoseTouchIsr();
-                }
+            if (handler) {
+                this->onNoseTouchHandler = handler;
+                LOG_INFO("(EFTouch) Attached onTouch handler to nose zone");
             } else {
-                // Register last release timestamp
-                this->last_release_millis_nose = millis();
-
-                // Fire onNoseShortpressIsr() if applicable
-                if (this->onNoseShortpressIsr != nullptr) {
-                    if (this->last_touch_millis_nose + EFTOUCH_SHORTPRESS_DURATION_MS < millis()) {
-                        // Check if all touch zones were short pressed 
-                        if (this->onAllShortpressIsr != nullptr && (this->last_multitouch_short + EFTOUCH_MULTITOUCH_COOLDOWN_MS < millis())) {
-                            if ((this->isFingerprintTouched() || millis() - this->last_release_millis_fingerprint < EFTOUCH_MULTITOUCH_COOLDOWN_MS) &&
-                                (this->last_touch_millis_fingerprint + EFTOUCH_SHORTPRESS_DURATION_MS < millis()))
-                            {
-                                this->last_multitouch_short = millis();
-                                this->onAllShortpressIsr();
-                            }
-                        }
-                        // Execute zone ISR
-                        this->onNoseShortpressIsr();
-                    }
-                }
-                // Fire onFingerperintLongpressIsr() if applicable
-                if (this->onNoseLongpressIsr != nullptr) {
-                    if (this->last_touch_millis_nose + EFTOUCH_LONGPRESS_DURATION_MS < millis()) {
-                        // Check if all touch zones were long pressed 
-                        if (this->onAllLongpressIsr != nullptr && (this->last_multitouch_long + EFTOUCH_MULTITOUCH_COOLDOWN_MS < millis())) {
-                            if ((this->isFingerprintTouched() || millis() - this->last_release_millis_fingerprint < EFTOUCH_MULTITOUCH_COOLDOWN_MS) &&
-                                (this->last_touch_millis_fingerprint + EFTOUCH_LONGPRESS_DURATION_MS < millis()))
-                            {
-                                this->last_multitouch_long = millis();
-                                this->onAllLongpressIsr();
-                            }
-                        }
-
-                        // Execute zone ISR
-                        this->onNoseLongpressIsr();
-                    }
-                }
-                // Fire onNoseReleaseIsr()
-                if (this->onNoseReleaseIsr != nullptr) {
-                    this->onNoseReleaseIsr();
-                }
+                this->onNoseTouchHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onTouch handler from nose zone");
             }
             break;
+        default:
+            LOGF_ERROR("(EFTouch) Cannot attach onTouch handler to invalid touch zone: %d\r\n", zone);
+            break;
     }
 }
 
-void EFTouchClass::attachInterruptOnTouch(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void)) {
+void EFTouchClass::attachHandlerOnRelease(EFTouchZone zone, void (*handler)(void)) {
     switch (zone) {
         case EFTouchZone::All:
-            LOG_ERROR("(EFTouch) Attaching onTouch interrupt to all zones is currently not supported");
+            LOG_ERROR("(EFTouch) Attaching onRelease handler to all zones is currently not supported");
             break;
         case EFTouchZone::Fingerprint:
-            if (isr) {
-                this->onFingerprintTouchIsr = isr;
-                LOG_INFO("(EFTouch) Attached onTouch interrupt to fingerprint zone");
+            if (handler) {
+                this->onFingerprintReleaseHandler = handler;
+                LOG_INFO("(EFTouch) Attached onRelease handler to fingerprint zone");
             } else {
-                this->onFingerprintTouchIsr = nullptr;
-                LOG_INFO("(EFTouch) Detached onTouch interrupt from fingerprint zone");
+                this->onFingerprintReleaseHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onRelease handler from fingerprint zone");
             }
             break;
         case EFTouchZone::Nose:
-            if (isr) {
-                this->onNoseTouchIsr = isr;
-                LOG_INFO("(EFTouch) Attached onTouch interrupt to nose zone");
+            if (handler) {
+                this->onNoseReleaseHandler = handler;
+                LOG_INFO("(EFTouch) Attached onRelease handler to nose zone");
             } else {
-                this->onNoseTouchIsr = nullptr;
-                LOG_INFO("(EFTouch) Detatched onTouch interrupt from nose zone");
+                this->onNoseReleaseHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onRelease handler from nose zone");
             }
             break;
         default:
-            LOGF_ERROR("(EFTouch) Cannot attach onTouch interrupt to invalid touch zone: %d\r\n", zone);
+            LOGF_ERROR("(EFTouch) Cannot attach onRelease handler to invalid touch zone: %d\r\n", zone);
             break;
     }
 }
 
-void EFTouchClass::attachInterruptOnRelease(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void)) {
+void EFTouchClass::attachHandlerOnShortpress(EFTouchZone zone, void (*handler)(void)) {
     switch (zone) {
         case EFTouchZone::All:
-            LOG_ERROR("(EFTouch) Attaching onRelease interrupt to all zones is currently not supported");
+            if (handler) {
+                this->onAllShortpressHandler = handler;
+                LOG_INFO("(EFTouch) Attached onShortpress handler to the combined 'All' zone");
+            } else {
+                this->onAllShortpressHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onShortpress handler from the combined 'All' zone");
+            }
             break;
         case EFTouchZone::Fingerprint:
-            if (isr) {
-                this->onFingerprintReleaseIsr = isr;
-                LOG_INFO("(EFTouch) Attached onRelease interrupt to fingerprint zone");
+            if (handler) {
+                this->onFingerprintShortpressHandler = handler;
+                LOG_INFO("(EFTouch) Attached onShortpress handler to fingerprint zone");
             } else {
-                this->onFingerprintReleaseIsr = nullptr;
-                LOG_INFO("(EFTouch) Detached onRelease interrupt from fingerprint zone");
+                this->onFingerprintShortpressHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onShortpress handler from fingerprint zone");
             }
             break;
         case EFTouchZone::Nose:
-            if (isr) {
-                this->onNoseReleaseIsr = isr;
-                LOG_INFO("(EFTouch) Attached onRelease interrupt to nose zone");
+            if (handler) {
+                this->onNoseShortpressHandler = handler;
+                LOG_INFO("(EFTouch) Attached onShortpress handler to nose zone");
             } else {
-                this->onNoseReleaseIsr = nullptr;
-                LOG_INFO("(EFTouch) Detatched onRelease interrupt from nose zone");
+                this->onNoseShortpressHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onShortpress handler from nose zone");
             }
             break;
         default:
-            LOGF_ERROR("(EFTouch) Cannot attach onRelease interrupt to invalid touch zone: %d\r\n", zone);
+            LOGF_ERROR("(EFTouch) Cannot attach onShortpress handler to invalid touch zone: %d\r\n", zone);
             break;
     }
 }
 
-void EFTouchClass::attachInterruptOnShortpress(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void)) {
+void EFTouchClass::attachHandlerOnLongpress(EFTouchZone zone, void (*handler)(void)) {
     switch (zone) {
         case EFTouchZone::All:
-            if (isr) {
-                this->onAllShortpressIsr = isr;
-                LOG_INFO("(EFTouch) Attached onShortpress interrupt to the combined 'All' zone");
+            if (handler) {
+                this->onAllLongpressHandler = handler;
+                LOG_INFO("(EFTouch) Attached onLongpress handler to the combined 'All' touch zone");
             } else {
-                this->onAllShortpressIsr = nullptr;
-                LOG_INFO("(EFTouch) Detached onShortpress interrupt from the combined 'All' zone");
+                this->onAllLongpressHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onLongpress handler from the combined 'All' touch zone");
             }
             break;
         case EFTouchZone::Fingerprint:
-            if (isr) {
-                this->onFingerprintShortpressIsr = isr;
-                LOG_INFO("(EFTouch) Attached onShortpress interrupt to fingerprint zone");
+            if (handler) {
+                this->onFingerprintLongpressHandler = handler;
+                LOG_INFO("(EFTouch) Attached onLongpress handler to fingerprint zone");
             } else {
-                this->onFingerprintShortpressIsr = nullptr;
-                LOG_INFO("(EFTouch) Detached onShortpress interrupt from fingerprint zone");
+                this->onFingerprintLongpressHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onLongpress handler from fingerprint zone");
             }
             break;
         case EFTouchZone::Nose:
-            if (isr) {
-                this->onNoseShortpressIsr = isr;
-                LOG_INFO("(EFTouch) Attached onShortpress interrupt to nose zone");
+            if (handler) {
+                this->onNoseLongpressHandler = handler;
+                LOG_INFO("(EFTouch) Attached onLongpress handler to nose zone");
             } else {
-                this->onNoseShortpressIsr = nullptr;
-                LOG_INFO("(EFTouch) Detatched onShortpress interrupt from nose zone");
+                this->onNoseLongpressHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onLongpress handler from nose zone");
             }
             break;
         default:
-            LOGF_ERROR("(EFTouch) Cannot attach onShortpress interrupt to invalid touch zone: %d\r\n", zone);
+            LOGF_ERROR("(EFTouch) Cannot attach onLongpress handler to invalid touch zone: %d\r\n", zone);
             break;
     }
 }
 
-void EFTouchClass::attachInterruptOnLongpress(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void)) {
+void EFTouchClass::attachHandlerOnHold(EFTouchZone zone, void (*handler)(void)) {
     switch (zone) {
         case EFTouchZone::All:
-            if (isr) {
-                this->onAllLongpressIsr = isr;
-                LOG_INFO("(EFTouch) Attached onLongpress interrupt to the combined 'All' touch zone");
-            } else {
-                this->onAllLongpressIsr = nullptr;
-                LOG_INFO("(EFTouch) Detached onLongpress interrupt from the combined 'All' touch zone");
-            }
+            LOG_ERROR("(EFTouch) Attaching onHold handler to all zones is currently not supported");
             break;
         case EFTouchZone::Fingerprint:
-            if (isr) {
-                this->onFingerprintLongpressIsr = isr;
-                LOG_INFO("(EFTouch) Attached onLongpress interrupt to fingerprint zone");
+            if (handler) {
+                this->onFingerprintHoldHandler = handler;
+                LOG_INFO("(EFTouch) Attached onHold handler to fingerprint zone");
             } else {
-                this->onFingerprintLongpressIsr = nullptr;
-                LOG_INFO("(EFTouch) Detached onLongpress interrupt from fingerprint zone");
+                this->onFingerprintHoldHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onHold handler from fingerprint zone");
             }
             break;
         case EFTouchZone::Nose:
-            if (isr) {
-                this->onNoseLongpressIsr = isr;
-                LOG_INFO("(EFTouch) Attached onLongpress interrupt to nose zone");
+            if (handler) {
+                this->onNoseHoldHandler = handler;
+                LOG_INFO("(EFTouch) Attached onHold handler to nose zone");
             } else {
-                this->onNoseLongpressIsr = nullptr;
-                LOG_INFO("(EFTouch) Detatched onLongpress interrupt from nose zone");
+                this->onNoseHoldHandler = nullptr;
+                LOG_INFO("(EFTouch) Detached onHold handler from nose zone");
             }
             break;
         default:
-            LOGF_ERROR("(EFTouch) Cannot attach onLongpress interrupt to invalid touch zone: %d\r\n", zone);
+            LOGF_ERROR("(EFTouch) Cannot attach onHold handler to invalid touch zone: %d\r\n", zone);
             break;
     }
 }
 
-void EFTouchClass::detatchInterruptOnTouch(EFTouchZone zone) {
-    this->attachInterruptOnTouch(zone, nullptr);
+void EFTouchClass::detachHandlerOnTouch(EFTouchZone zone) {
+    this->attachHandlerOnTouch(zone, nullptr);
+}
+
+void EFTouchClass::detachHandlerOnRelease(EFTouchZone zone) {
+    this->attachHandlerOnRelease(zone, nullptr);
 }
 
-void EFTouchClass::detatchInterruptOnRelease(EFTouchZone zone) {
-    this->attachInterruptOnRelease(zone, nullptr);
+void EFTouchClass::detachHandlerOnShortpress(EFTouchZone zone) {
+    this->attachHandlerOnShortpress(zone, nullptr);
 }
 
-void EFTouchClass::detatchInterruptOnShortpress(EFTouchZone zone) {
-    this->attachInterruptOnShortpress(zone, nullptr);
+void EFTouchClass::detachHandlerOnLongpress(EFTouchZone zone) {
+    this->attachHandlerOnLongpress(zone, nullptr);
 }
 
-void EFTouchClass::detatchInterruptOnLongpress(EFTouchZone zone) {
-    this->attachInterruptOnLongpress(zone, nullptr);
+void EFTouchClass::detachHandlerOnHold(EFTouchZone zone) {
+    this->attachHandlerOnHold(zone, nullptr);
 }
 
 
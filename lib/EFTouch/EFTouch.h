@@ -29,18 +29,28 @@
 
 #include <Arduino.h>
 #include <EFConfig.h>
+#include <EFRingBuffer.h>
+#include "EFTouchBaseline.h"
+#include "EFTouchGestures.h"
+#include "EFTouchTrace.h"
 #include "EFTouchZone.h"
 
 #define EFTOUCH_PIN_TOUCH_FINGERPRINT 3
 #define EFTOUCH_PIN_TOUCH_NOSE 1
 
 #define EFTOUCH_CALIBRATE_NUM_SAMPLES 10
-#define EFTOUCH_SHORTPRESS_DURATION_MS 450
-#define EFTOUCH_LONGPRESS_DURATION_MS  1800
-#define EFTOUCH_MULTITOUCH_COOLDOWN_MS 1000
+#define EFTOUCH_EDGE_CAPACITY 16  //!< Edges buffered between ISR and poll(), must be a power of two
 
 /**
  * @brief Driver for touch sensors
+ *
+ * The touch ISRs only record timestamped edges. Gestures are classified by
+ * EFTouchGestures and the attached handlers are executed from poll(), in
+ * task context.
+ *
+ * The untouched baseline of each pad is tracked by an EFTouchBaseline from
+ * samples taken in poll(). Its noise-adaptive press threshold is also used
+ * as the interrupt threshold.
  */
 class EFTouchClass {
 
@@ -51,28 +61,47 @@ class EFTouchClass {
 
         touch_value_t detection_step;  //!< Value change required per registered touch intensity level
 
-        touch_value_t noise_fingerprint;  //!< Calibrated noise floor for fingerprint touch pad
-        touch_value_t noise_nose;         //!< Calibrated noise floor for nose touch pad 
+        EFTouchBaseline baseline_fingerprint;  //!< Baseline tracking for fingerprint touch pad
+        EFTouchBaseline baseline_nose;         //!< Baseline tracking for nose touch pad
+        touch_value_t threshold_fingerprint;   //!< Interrupt threshold currently set for fingerprint touch pad
+        touch_value_t threshold_nose;          //!< Interrupt threshold currently set for nose touch pad
+        uint32_t baseline_sampled_ms;          //!< Time the baselines were last sampled by poll()
 
-        volatile unsigned long last_release_millis_fingerprint; //!< Timestamp when the fingerprint was last released
-        volatile unsigned long last_release_millis_nose;        //!< Timestamp when the nose was last released
-        volatile unsigned long last_touch_millis_fingerprint;   //!< Timestamp when the fingerprint was last touched
-        volatile unsigned long last_touch_millis_nose;          //!< Timestamp when the nose was last touched
-        volatile unsigned long last_multitouch_short;           //!< Timestamp when the last short multitouch event was processed
-        volatile unsigned long last_multitouch_long;            //!< Timestamp when the last long multitouch event was processed
+        EFRingBuffer<EFTouchEdge, EFTOUCH_EDGE_CAPACITY> edges;  //!< Edges recorded by the ISRs, consumed by poll()
+        EFTouchGestures gestures;                                //!< Classifies edges into gestures
+        uint32_t event_timestamp_us;                             //!< micros() of the edge currently dispatched by poll()
 
-        void (*onFingerprintTouchIsr)(void);       //!< ISR to execute if the fingerprint is first touched
-        void (*onFingerprintReleaseIsr)(void);     //!< ISR to execute if the fingerprint is fully released
-        void (*onFingerprintShortpressIsr)(void);  //!< ISR to execute if the fingerprint was held for at least a short amount of time
-        void (*onFingerprintLongpressIsr)(void);   //!< ISR to execute if the fingerprint was held for a long amount of time
+        void (*onFingerprintTouchHandler)(void);       //!< Handler to execute if the fingerprint is first touched
+        void (*onFingerprintReleaseHandler)(void);     //!< Handler to execute if the fingerprint is fully released
+        void (*onFingerprintShortpressHandler)(void);  //!< Handler to execute if the fingerprint was held for at least a short amount of time
+        void (*onFingerprintLongpressHandler)(void);   //!< Handler to execute if the fingerprint was held for a long amount of time
+        void (*onFingerprintHoldHandler)(void);        //!< Handler to execute repeatedly while the fingerprint is held after a longpress
 
-        void (*onNoseTouchIsr)(void);              //!< ISR to execute if the nose is first touched
-        void (*onNoseReleaseIsr)(void);            //!< ISR to execute if the nose is fully released
-        void (*onNoseShortpressIsr)(void);         //!< ISR to execute if the nose was held for at least a short amount of time
-        void (*onNoseLongpressIsr)(void);          //!< ISR to execute if the nose was held for a long amount of time
+        void (*onNoseTouchHandler)(void);              //!< Handler to execute if the nose is first touched
+        void (*onNoseReleaseHandler)(void);            //!< Handler to execute if the nose is fully released
+        void (*onNoseShortpressHandler)(void);         //!< Handler to execute if the nose was held for at least a short amount of time
+        void (*onNoseLongpressHandler)(void);          //!< Handler to execute if the nose was held for a long amount of time
+        void (*onNoseHoldHandler)(void);               //!< Handler to execute repeatedly while the nose is held after a longpress
 
-        void (*onAllShortpressIsr)(void);          //!< ISR to execute if all touch zones were held for at least a short amount of time
-        void (*onAllLongpressIsr)(void);           //!< ISR to execute if all touch zones were held for a long amount of time
+        void (*onAllShortpressHandler)(void);          //!< Handler to execute if all touch zones were held for at least a short amount of time
+        void (*onAllLongpressHandler)(void);           //!< Handler to execute if all touch zones were held for a long amount of time
+
+        /**
+         * @brief Executes the handler attached for the given gesture, if any
+         */
+        void dispatch(const EFTouchGestureEvent& event);
+
+        /**
+         * @brief Samples both pads, updates their baselines and follows changed
+         * press thresholds with the interrupt thresholds
+         */
+        void trackBaselines();
+
+        /**
+         * @brief Enables the hardware IIR filter and denoise channel if
+         * EFTOUCH_HW_FILTER is defined
+         */
+        void configureHardwareFilter();
 
     public:
 
@@ -102,40 +131,78 @@ class EFTouchClass {
         void init(touch_value_t detection_step, uint8_t pin_fingerprint, uint8_t pin_nose);
 
         /**
-         * @brief Calibrates the noise floor for the analog touch pin readings.
+         * @brief Restarts baseline tracking from fresh analog touch pin readings.
+         * Pads must not be touched.
          */
         void calibrate();
 
         /**
-         * @brief Retrieves the current calibrated noise floor value for the
-         * fingerprint touch pad.
+         * @brief Retrieves the current untouched baseline of the fingerprint
+         * touch pad.
          * 
-         * @return Calibrated touch value for noise floor. 0 if uncalibrated.
+         * @return Raw touch value of the untouched pad. 0 if uncalibrated.
          */
         touch_value_t getFingerprintNoiseLevel();
 
         /**
-         * @brief Retrieves the current calibrated noise floor value for the
-         * nose touch pad.
+         * @brief Retrieves the current untouched baseline of the nose touch pad.
          * 
-         * @return Calibrated touch value for noise floor. 0 if uncalibrated.
+         * @return Raw touch value of the untouched pad. 0 if uncalibrated.
          */
         touch_value_t getNoseNoiseLevel();
 
         /**
-         * @brief Determines if the fingerprint is touched
+         * @brief Retrieves the baseline tracking state of the given touch zone
+         *
+         * @param zone EFTouchZone::Fingerprint or EFTouchZone::Nose
+         */
+        const EFTouchBaseline& getBaseline(EFTouchZone zone) const;
+
+        /**
+         * @brief Samples the fingerprint pad and determines if it is touched,
+         * with hysteresis between press and release
          * 
          * @return True, if fingerprint is touched
          */
         bool isFingerprintTouched();
 
         /**
-         * @brief Determines if the nose is touched
+         * @brief Samples the nose pad and determines if it is touched, with
+         * hysteresis between press and release
          * 
          * @return True, if nose is touched
          */
         bool isNoseTouched();
 
+        /**
+         * @brief Determines if any zone is touched according to the last touch
+         * interrupt or if recorded edges still await poll(). Cheap enough to be
+         * polled on every loop().
+         *
+         * @return True, if a touch is in progress
+         */
+        bool isTouchActive();
+
+        /**
+         * @brief Classifies all edges recorded since the last call and executes
+         * the attached handlers. Samples the pads every
+         * EFTOUCH_BASELINE_INTERVAL_MS to track their baselines. Must be called
+         * regularly from a single task.
+         */
+        void poll();
+
+        /**
+         * @brief Retrieves the micros() timestamp of the edge that caused the
+         * handler currently being executed. Only valid inside a handler.
+         */
+        uint32_t getEventTimestampUs() const;
+
+        /**
+         * @brief Retrieves the number of edges dropped because poll() was not
+         * called in time
+         */
+        uint32_t getDroppedEdgeCount() const;
+
         /**
          * @brief Reads the touch intensity of the fingerprint pad
          * 
@@ -150,6 +217,11 @@ class EFTouchClass {
          */
         uint8_t readNose();
 
+        /**
+         * @brief Reads the raw touchRead() values of both pads, e.g., for EFTouchRecorder
+         */
+        EFTouchSample readRaw();
+
         /**
          * @brief Enable interrupt handling for the given touch zone
          * 
@@ -165,77 +237,106 @@ class EFTouchClass {
         void disableInterrupts(EFTouchZone zone);
 
         /**
-         * @brief Attaches an interrupt service routine (ISR) to the given touch zone
-         * that will be executed once the touch zone is first touched
+         * @brief Arms the given touch zone to wake the badge from deep sleep,
+         * using the current interrupt threshold
+         *
+         * @param zone EFTouchZone::Fingerprint or EFTouchZone::Nose
+         */
+        void enableWakeup(EFTouchZone zone);
+
+        /**
+         * @brief Attaches a handler to the given touch zone that will be executed
+         * by poll() once the touch zone is first touched
          * 
-         * @param zone Touch zone to attach the given ISR to
-         * @param isr Interrupt service routine to execute
+         * @param zone Touch zone to attach the given handler to
+         * @param handler Handler to execute
          */
-        void attachInterruptOnTouch(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void));
+        void attachHandlerOnTouch(EFTouchZone zone, void (*handler)(void));
 
         /**
-         * @brief Attaches an interrupt service routine (ISR) to the given touch zone
-         * that will be executed once the touch zone is fully released
+         * @brief Attaches a handler to the given touch zone that will be executed
+         * by poll() once the touch zone is fully released
          * 
-         * @param zone Touch zone to attach the given ISR to
-         * @param isr Interrupt service routine to execute
+         * @param zone Touch zone to attach the given handler to
+         * @param handler Handler to execute
          */
-        void attachInterruptOnRelease(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void));
+        void attachHandlerOnRelease(EFTouchZone zone, void (*handler)(void));
 
         /**
-         * @brief Attaches an interrupt service routine (ISR) to the given touch zone
-         * that will be executed once the touch zone is fully released and the touch
-         * duration was at least EFTOUCH_SHORTPRESS_DURATION_MS long
+         * @brief Attaches a handler to the given touch zone that will be executed
+         * by poll() once the touch zone is fully released and the touch
+         * duration was at least EFTOUCH_SHORTPRESS_DURATION_MS long, unless the
+         * touch already fired a longpress
          * 
-         * @param zone Touch zone to attach the given ISR to
-         * @param isr Interrupt service routine to execute
+         * @param zone Touch zone to attach the given handler to
+         * @param handler Handler to execute
          */
-        void attachInterruptOnShortpress(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void));
+        void attachHandlerOnShortpress(EFTouchZone zone, void (*handler)(void));
 
         /**
-         * @brief Attaches an interrupt service routine (ISR) to the given touch zone
-         * that will be executed once the touch zone is fully released and the touch
-         * duration was at least EFTOUCH_LONGPRESS_DURATION_MS long
+         * @brief Attaches a handler to the given touch zone that will be executed
+         * by poll() as soon as the touch zone was held for
+         * EFTOUCH_LONGPRESS_DURATION_MS. The shortpress of the same touch is
+         * skipped.
          * 
-         * @param zone Touch zone to attach the given ISR to
-         * @param isr Interrupt service routine to execute
+         * @param zone Touch zone to attach the given handler to
+         * @param handler Handler to execute
          */
-        void attachInterruptOnLongpress(EFTouchZone zone, void ARDUINO_ISR_ATTR (*isr)(void));
+        void attachHandlerOnLongpress(EFTouchZone zone, void (*handler)(void));
 
         /**
-         * @brief Detatches the ISR attached by attachInterruptOnTouch() for the given
+         * @brief Attaches a handler to the given touch zone that will be executed
+         * by poll() every EFTOUCH_HOLD_INTERVAL_MS while the touch zone is
+         * still held after a longpress
+         * 
+         * @param zone Touch zone to attach the given handler to
+         * @param handler Handler to execute
+         */
+        void attachHandlerOnHold(EFTouchZone zone, void (*handler)(void));
+
+        /**
+         * @brief Detaches the handler attached by attachHandlerOnTouch() for the given
          * touch zone, if any.
          * 
-         * @param zone Touch zone to detatch the ISR from.
+         * @param zone Touch zone to detach the handler from.
          */
-        void detatchInterruptOnTouch(EFTouchZone zone);
+        void detachHandlerOnTouch(EFTouchZone zone);
 
         /**
-         * @brief Detatches the ISR attached by attachInterruptOnRelease() for the given
+         * @brief Detaches the handler attached by attachHandlerOnRelease() for the given
          * touch zone, if any.
          * 
-         * @param zone Touch zone to detatch the ISR from.
+         * @param zone Touch zone to detach the handler from.
+         */
+        void detachHandlerOnRelease(EFTouchZone zone);
+
+        /**
+         * @brief Detaches the handler attached by attachHandlerOnShortpress() for the
+         * given touch zone, if any.
+         * 
+         * @param zone Touch zone to detach the handler from.
          */
-        void detatchInterruptOnRelease(EFTouchZone zone);
+        void detachHandlerOnShortpress(EFTouchZone zone);
 
         /**
-         * @brief Detatches the ISR attached by attachInterruptOnShortpress() for the
+         * @brief Detaches the handler attached by attachHandlerOnLongpress() for the
          * given touch zone, if any.
          * 
-         * @param zone Touch zone to detatch the ISR from.
+         * @param zone Touch zone to detach the handler from.
          */
-        void detatchInterruptOnShortpress(EFTouchZone zone);
+        void detachHandlerOnLongpress(EFTouchZone zone);
 
         /**
-         * @brief Detatches the ISR attached by attachInterruptOnLongpress() for the
+         * @brief Detaches the handler attached by attachHandlerOnHold() for the
          * given touch zone, if any.
          * 
-         * @param zone Touch zone to detatch the ISR from.
+         * @param zone Touch zone to detach the handler from.
          */
-        void detatchInterruptOnLongpress(EFTouchZone zone);
+        void detachHandlerOnHold(EFTouchZone zone);
 
         /**
-         * @brief INTERNAL interrupt handler. DO NOT EXECUTE DIRECTLY!
+         * @brief INTERNAL interrupt handler. DO NOT EXECUTE DIRECTLY! Only
+         * records the edge for poll().
          * 
          * @param zone Touch zone the interrupt was fired for
          * @param raising_flank True, if the touch zone was and remains touched
@@ -0,0 +1,130 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EFTouchBaseline.h"
+
+/**
+ * @brief Readings below the baseline move it by 1/2^N per sample. Faster than
+ * the regular tracking, since a touch can never lower the reading.
+ */
+#define EFTOUCHBASELINE_FALL_SHIFT 1
+
+EFTouchBaseline::EFTouchBaseline()
+: EFTouchBaseline({0, 1, 100, 0, 0})
+{
+}
+
+EFTouchBaseline::EFTouchBaseline(const EFTouchBaselineConfig& config)
+: config(config)
+{
+    this->reset(0);
+}
+
+void EFTouchBaseline::reset(uint32_t baseline, uint32_t noise) {
+    this->window_len = 0;
+    this->window_pos = 0;
+    this->baseline_q = baseline << this->config.iir_shift;
+    this->noise_q = noise << this->config.iir_shift;
+    this->touched = false;
+    this->touched_ms = 0;
+}
+
+uint32_t EFTouchBaseline::filter(uint32_t reading) {
+    this->window[this->window_pos] = reading;
+    this->window_pos = (this->window_pos + 1) % 3;
+    if (this->window_len < 3) {
+        this->window_len++;
+        return reading;
+    }
+
+    const uint32_t a = this->window[0];
+    const uint32_t b = this->window[1];
+    const uint32_t c = this->window[2];
+    if ((a <= b && b <= c) || (c <= b && b <= a)) {
+        return b;
+    }
+    if ((b <= a && a <= c) || (c <= a && a <= b)) {
+        return a;
+    }
+    return c;
+}
+
+bool EFTouchBaseline::update(uint32_t reading, uint32_t now_ms) {
+    const uint32_t sample = this->filter(reading);
+    const uint32_t delta = this->getDelta(sample);
+
+    if (this->touched) {
+        if (delta < this->getReleaseThreshold()) {
+            this->touched = false;
+        } else if (this->config.max_touch_ms > 0 && now_ms - this->touched_ms > this->config.max_touch_ms) {
+            // Nobody holds a pad that long. The baseline drifted, relearn it.
+            this->reset(sample, this->getNoise());
+        }
+        return this->touched;
+    }
+
+    if (delta >= this->getPressThreshold()) {
+        this->touched = true;
+        this->touched_ms = now_ms;
+        return true;
+    }
+
+    // Released: follow drift, but ignore a finger approaching the pad
+    if (delta < this->getReleaseThreshold()) {
+        const uint8_t shift = this->config.iir_shift;
+        const int64_t sample_q = static_cast<int64_t>(sample) << shift;
+        const int64_t error_q = sample_q - this->baseline_q;
+        const uint8_t step_shift = error_q < 0 ? EFTOUCHBASELINE_FALL_SHIFT : shift;
+        this->baseline_q += error_q / (1 << step_shift);
+
+        const int64_t deviation_q = error_q < 0 ? -error_q : error_q;
+        this->noise_q += (deviation_q - static_cast<int64_t>(this->noise_q)) / (1 << shift);
+    }
+
+    return false;
+}
+
+bool EFTouchBaseline::isTouched() const {
+    return this->touched;
+}
+
+uint32_t EFTouchBaseline::getBaseline() const {
+    return this->baseline_q >> this->config.iir_shift;
+}
+
+uint32_t EFTouchBaseline::getNoise() const {
+    return this->noise_q >> this->config.iir_shift;
+}
+
+uint32_t EFTouchBaseline::getPressThreshold() const {
+    const uint32_t adaptive = this->getNoise() * this->config.noise_factor;
+    return adaptive > this->config.min_press_delta ? adaptive : this->config.min_press_delta;
+}
+
+uint32_t EFTouchBaseline::getReleaseThreshold() const {
+    return static_cast<uint64_t>(this->getPressThreshold()) * this->config.release_percent / 100;
+}
+
+uint32_t EFTouchBaseline::getDelta(uint32_t reading) const {
+    const uint32_t baseline = this->getBaseline();
+    return reading > baseline ? reading - baseline : 0;
+}
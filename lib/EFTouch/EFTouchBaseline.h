@@ -0,0 +1,133 @@
+#ifndef EFTOUCHBASELINE_H_
+#define EFTOUCHBASELINE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+/**
+ * @brief Tuning of an EFTouchBaseline
+ */
+struct EFTouchBaselineConfig {
+    uint32_t min_press_delta;   //!< Lower bound for the press threshold above the baseline
+    uint8_t noise_factor;       //!< Press threshold as multiple of the measured noise
+    uint8_t release_percent;    //!< Release threshold in percent of the press threshold
+    uint8_t iir_shift;          //!< The baseline moves 1/2^iir_shift of the way towards each released sample
+    uint32_t max_touch_ms;      //!< Touches held longer are relearned as the new baseline, 0 to disable
+};
+
+/**
+ * @brief Tracks the untouched baseline of a single touch pad and detects
+ * touches with hysteresis
+ *
+ * Samples pass a median-of-3 filter to reject single spikes. While the pad is
+ * released, the baseline and the mean deviation from it (noise) follow the
+ * samples through an IIR filter. A sample falling below the baseline is
+ * followed quickly, since touches only ever increase the reading. The pad is
+ * considered touched once a sample exceeds the baseline by the press
+ * threshold and released once it falls below the lower release threshold.
+ * While touched, the baseline is frozen.
+ *
+ * Does not depend on Arduino, so recorded traces can be replayed on the host.
+ */
+class EFTouchBaseline {
+
+    protected:
+
+        EFTouchBaselineConfig config;  //!< Tuning parameters
+        uint32_t window[3];            //!< Last raw samples for the median filter
+        uint8_t window_len;            //!< Number of valid samples in window
+        uint8_t window_pos;            //!< Next slot to write in window
+        uint32_t baseline_q;           //!< Baseline, fixed point scaled by 2^iir_shift
+        uint32_t noise_q;              //!< Mean absolute deviation while released, fixed point scaled by 2^iir_shift
+        bool touched;                  //!< Current detection state
+        uint32_t touched_ms;           //!< Time the current touch started
+
+        /**
+         * @brief Adds a sample to the median window and returns the filtered value
+         */
+        uint32_t filter(uint32_t reading);
+
+    public:
+
+        /**
+         * @brief Creates a tracker without a baseline. Call reset() before use.
+         */
+        EFTouchBaseline();
+
+        /**
+         * @brief Creates a tracker with the given tuning. Call reset() before use.
+         */
+        explicit EFTouchBaseline(const EFTouchBaselineConfig& config);
+
+        /**
+         * @brief Forgets all samples and restarts tracking from the given values
+         *
+         * @param baseline Raw reading of the untouched pad
+         * @param noise Expected mean deviation of untouched readings
+         */
+        void reset(uint32_t baseline, uint32_t noise = 0);
+
+        /**
+         * @brief Processes the next raw sample
+         *
+         * @param reading Raw touchRead() value
+         * @param now_ms millis() at the time of the sample
+         * @return True, if the pad is touched
+         */
+        bool update(uint32_t reading, uint32_t now_ms);
+
+        /**
+         * @brief Determines if the pad is touched according to the samples so far
+         */
+        bool isTouched() const;
+
+        /**
+         * @brief Retrieves the current baseline as raw reading
+         */
+        uint32_t getBaseline() const;
+
+        /**
+         * @brief Retrieves the mean deviation of untouched readings from the baseline
+         */
+        uint32_t getNoise() const;
+
+        /**
+         * @brief Retrieves the increase over the baseline required to detect a touch
+         */
+        uint32_t getPressThreshold() const;
+
+        /**
+         * @brief Retrieves the increase over the baseline below which a touch ends
+         */
+        uint32_t getReleaseThreshold() const;
+
+        /**
+         * @brief Calculates the increase of the given reading over the baseline
+         *
+         * @return Difference to the baseline, 0 for readings below it
+         */
+        uint32_t getDelta(uint32_t reading) const;
+};
+
+#endif /* EFTOUCHBASELINE_H_ */
@@ -0,0 +1,156 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EFTouchGestures.h"
+
+/**
+ * @brief Wrap-safe check if more than duration_ms passed between since_ms and now_ms
+ */
+static bool elapsed(uint32_t now_ms, uint32_t since_ms, uint32_t duration_ms) {
+    return now_ms - since_ms > duration_ms;
+}
+
+EFTouchGestures::EFTouchGestures() {
+    this->reset();
+}
+
+void EFTouchGestures::reset() {
+    this->fingerprint = {false, false, false, 0, 0, 0};
+    this->nose = {false, false, false, 0, 0, 0};
+    this->multitouch_short_ms = 0;
+    this->multitouch_long_ms = 0;
+}
+
+uint8_t EFTouchGestures::feed(const EFTouchEdge& edge, EFTouchGestureEvent* out) {
+    Zone* zone;
+    Zone* other;
+    switch (edge.zone) {
+        case EFTouchZone::Fingerprint: zone = &this->fingerprint; other = &this->nose; break;
+        case EFTouchZone::Nose: zone = &this->nose; other = &this->fingerprint; break;
+        default: return 0;
+    }
+
+    if (edge.touched) {
+        zone->touched = true;
+        zone->longpressed = false;
+        zone->holding = false;
+        zone->touch_ms = edge.timestamp_ms;
+        out[0] = {edge.zone, EFTouchGesture::Touch, edge.timestamp_us};
+        return 1;
+    }
+
+    return this->release(*zone, *other, edge, out);
+}
+
+uint8_t EFTouchGestures::tick(uint32_t now_ms, uint32_t now_us, EFTouchGestureEvent* out) {
+    uint8_t n = this->tick(this->fingerprint, this->nose, EFTouchZone::Fingerprint, now_ms, now_us, out);
+    n += this->tick(this->nose, this->fingerprint, EFTouchZone::Nose, now_ms, now_us, out + n);
+    return n;
+}
+
+uint8_t EFTouchGestures::tick(Zone& zone, Zone& other, EFTouchZone id, uint32_t now_ms, uint32_t now_us, EFTouchGestureEvent* out) {
+    if (!zone.touched) {
+        return 0;
+    }
+
+    if (zone.longpressed) {
+        if (zone.holding && now_ms - zone.hold_ms >= EFTOUCH_HOLD_INTERVAL_MS) {
+            zone.hold_ms = now_ms;
+            out[0] = {id, EFTouchGesture::Hold, now_us};
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!elapsed(now_ms, zone.touch_ms, EFTOUCH_LONGPRESS_DURATION_MS)) {
+        return 0;
+    }
+    if (other.touched && !other.longpressed && !elapsed(now_ms, other.touch_ms, EFTOUCH_LONGPRESS_DURATION_MS)) {
+        // Other zone might still complete an all-zone longpress
+        return 0;
+    }
+
+    return this->longpress(zone, other, id, now_ms, now_us, out);
+}
+
+uint8_t EFTouchGestures::longpress(Zone& zone, Zone& other, EFTouchZone id, uint32_t now_ms, uint32_t now_us, EFTouchGestureEvent* out) {
+    uint8_t n = 0;
+
+    // The other zone counts if it is still held or was let go just before
+    const bool other_involved = other.touched || !elapsed(now_ms, other.release_ms, EFTOUCH_MULTITOUCH_COOLDOWN_MS - 1);
+    if (elapsed(now_ms, this->multitouch_long_ms, EFTOUCH_MULTITOUCH_COOLDOWN_MS) &&
+        other_involved && elapsed(now_ms, other.touch_ms, EFTOUCH_LONGPRESS_DURATION_MS))
+    {
+        this->multitouch_long_ms = now_ms;
+        out[n++] = {EFTouchZone::All, EFTouchGesture::Longpress, now_us};
+        if (other.touched) {
+            other.longpressed = true;
+        }
+        other.holding = false;
+        zone.holding = false;
+    } else {
+        zone.holding = true;
+    }
+    out[n++] = {id, EFTouchGesture::Longpress, now_us};
+    zone.longpressed = true;
+    zone.hold_ms = now_ms;
+
+    return n;
+}
+
+uint8_t EFTouchGestures::release(Zone& zone, Zone& other, const EFTouchEdge& edge, EFTouchGestureEvent* out) {
+    const uint32_t now = edge.timestamp_ms;
+    uint8_t n = 0;
+    zone.touched = false;
+    zone.release_ms = now;
+
+    // A touch that already longpressed was consumed, only report the release
+    if (!zone.longpressed) {
+        // The other zone counts if it is still held or was let go just before
+        const bool other_involved = other.touched || !elapsed(now, other.release_ms, EFTOUCH_MULTITOUCH_COOLDOWN_MS - 1);
+
+        if (elapsed(now, zone.touch_ms, EFTOUCH_LONGPRESS_DURATION_MS)) {
+            // Longpress deferred for the other zone, or released before tick() caught up
+            n += this->longpress(zone, other, edge.zone, now, edge.timestamp_us, out + n);
+        } else if (elapsed(now, zone.touch_ms, EFTOUCH_SHORTPRESS_DURATION_MS)) {
+            if (elapsed(now, this->multitouch_short_ms, EFTOUCH_MULTITOUCH_COOLDOWN_MS) &&
+                other_involved && elapsed(now, other.touch_ms, EFTOUCH_SHORTPRESS_DURATION_MS))
+            {
+                this->multitouch_short_ms = now;
+                out[n++] = {EFTouchZone::All, EFTouchGesture::Shortpress, edge.timestamp_us};
+            }
+            out[n++] = {edge.zone, EFTouchGesture::Shortpress, edge.timestamp_us};
+        }
+    }
+    zone.longpressed = false;
+    out[n++] = {edge.zone, EFTouchGesture::Release, edge.timestamp_us};
+
+    return n;
+}
+
+bool EFTouchGestures::isTouched(EFTouchZone zone) const {
+    switch (zone) {
+        case EFTouchZone::Fingerprint: return this->fingerprint.touched;
+        case EFTouchZone::Nose: return this->nose.touched;
+        default: return this->fingerprint.touched && this->nose.touched;
+    }
+}
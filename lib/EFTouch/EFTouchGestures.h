@@ -0,0 +1,174 @@
+#ifndef EFTOUCHGESTURES_H_
+#define EFTOUCHGESTURES_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+#include "EFTouchZone.h"
+
+// Defaults, EFConfig.h takes precedence when included first
+#ifndef EFTOUCH_SHORTPRESS_DURATION_MS
+#define EFTOUCH_SHORTPRESS_DURATION_MS 450
+#endif
+#ifndef EFTOUCH_LONGPRESS_DURATION_MS
+#define EFTOUCH_LONGPRESS_DURATION_MS  1800
+#endif
+#ifndef EFTOUCH_MULTITOUCH_COOLDOWN_MS
+#define EFTOUCH_MULTITOUCH_COOLDOWN_MS 1000
+#endif
+#ifndef EFTOUCH_HOLD_INTERVAL_MS
+#define EFTOUCH_HOLD_INTERVAL_MS 150
+#endif
+
+/**
+ * @brief Maximum number of gestures a single call to feed() or tick() can
+ * complete, e.g., [AllLongpress] [Longpress] Release
+ */
+#define EFTOUCH_GESTURES_MAX_EVENTS 5
+
+
+/**
+ * @brief A touch zone changing between touched and released, as recorded by the ISR
+ */
+struct EFTouchEdge {
+    EFTouchZone zone;       //!< Zone that changed, EFTouchZone::Fingerprint or EFTouchZone::Nose
+    bool touched;           //!< True if the zone became touched, false if it was released
+    uint32_t timestamp_ms;  //!< millis() at the time of the edge
+    uint32_t timestamp_us;  //!< micros() at the time of the edge
+};
+
+/**
+ * @brief Kinds of gestures recognized from edges
+ */
+enum class EFTouchGesture : uint8_t {
+    Touch,       //!< Zone was first touched
+    Release,     //!< Zone was fully released
+    Shortpress,  //!< Zone was released after at least EFTOUCH_SHORTPRESS_DURATION_MS
+    Longpress,   //!< Zone was held for EFTOUCH_LONGPRESS_DURATION_MS
+    Hold,        //!< Zone is still held, repeated every EFTOUCH_HOLD_INTERVAL_MS after a single-zone longpress
+};
+
+/**
+ * @brief A recognized gesture. Zone EFTouchZone::All denotes a gesture
+ * performed on all zones at once.
+ */
+struct EFTouchGestureEvent {
+    EFTouchZone zone;       //!< Zone the gesture was performed on
+    EFTouchGesture gesture; //!< Recognized gesture
+    uint32_t timestamp_us;  //!< micros() of the edge that completed the gesture
+};
+
+/**
+ * @brief Classifies touch edges into touch, release, short-, long- and
+ * all-zone presses
+ *
+ * A longpress is emitted by tick() as soon as a zone was held for
+ * EFTOUCH_LONGPRESS_DURATION_MS, followed by a hold every
+ * EFTOUCH_HOLD_INTERVAL_MS until the zone is released. A release completes a
+ * shortpress if the zone was held long enough, but not as long as a longpress.
+ *
+ * If the other zone was held equally long and is still touched or was
+ * released less than EFTOUCH_MULTITOUCH_COOLDOWN_MS ago, the all-zone variant
+ * is emitted first, at most once per cooldown. An all-zone longpress consumes
+ * the touch of both zones and suppresses their holds. To give the other zone the chance to join, the
+ * longpress of a zone is deferred while the other zone is touched but not
+ * held long enough yet.
+ *
+ * Runs in task context and does not depend on Arduino, so it can be fed
+ * synthetic edges on the host.
+ */
+class EFTouchGestures {
+
+    protected:
+
+        /**
+         * @brief Tracked state of a single zone
+         */
+        struct Zone {
+            bool touched;           //!< Zone is currently touched
+            bool longpressed;       //!< Current touch already emitted its longpress
+            bool holding;           //!< Current touch emits holds, false after an all-zone longpress
+            uint32_t hold_ms;       //!< Time of the last longpress or hold of the current touch
+            uint32_t touch_ms;      //!< Time the zone was last touched
+            uint32_t release_ms;    //!< Time the zone was last released
+        };
+
+        Zone fingerprint;               //!< State of the fingerprint zone
+        Zone nose;                      //!< State of the nose zone
+        uint32_t multitouch_short_ms;   //!< Time the last all-zone shortpress was emitted
+        uint32_t multitouch_long_ms;    //!< Time the last all-zone longpress was emitted
+
+        /**
+         * @brief Classifies a release of the given zone
+         */
+        uint8_t release(Zone& zone, Zone& other, const EFTouchEdge& edge, EFTouchGestureEvent* out);
+
+        /**
+         * @brief Emits the longpress of the given zone, preceded by the all-zone
+         * longpress if applicable
+         */
+        uint8_t longpress(Zone& zone, Zone& other, EFTouchZone id, uint32_t now_ms, uint32_t now_us, EFTouchGestureEvent* out);
+
+        /**
+         * @brief Emits longpresses and holds that became due for the given zone
+         */
+        uint8_t tick(Zone& zone, Zone& other, EFTouchZone id, uint32_t now_ms, uint32_t now_us, EFTouchGestureEvent* out);
+
+    public:
+
+        EFTouchGestures();
+
+        /**
+         * @brief Forgets all tracked touches
+         */
+        void reset();
+
+        /**
+         * @brief Feeds the next edge, in the order they occurred
+         *
+         * @param edge Edge to process
+         * @param out Receives up to EFTOUCH_GESTURES_MAX_EVENTS gestures completed by the edge
+         * @return Number of gestures written to out
+         */
+        uint8_t feed(const EFTouchEdge& edge, EFTouchGestureEvent* out);
+
+        /**
+         * @brief Emits the longpresses and holds that became due. Must be
+         * called regularly while a zone is touched, after all edges up to
+         * now_ms were fed.
+         *
+         * @param now_ms Current millis()
+         * @param now_us Current micros(), used as timestamp of the gestures
+         * @param out Receives up to EFTOUCH_GESTURES_MAX_EVENTS gestures
+         * @return Number of gestures written to out
+         */
+        uint8_t tick(uint32_t now_ms, uint32_t now_us, EFTouchGestureEvent* out);
+
+        /**
+         * @brief Determines if the given zone is touched according to the edges fed so far
+         */
+        bool isTouched(EFTouchZone zone) const;
+};
+
+#endif /* EFTOUCHGESTURES_H_ */
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "EFTouchRecorder.h"
+
+#ifdef EFTOUCH_RECORDER
+
+EFTouchRecorderClass::EFTouchRecorderClass()
+: head(0)
+, count(0)
+, last_ms(0)
+{
+}
+
+void EFTouchRecorderClass::record(uint32_t now_ms, const EFTouchSample& sample) {
+    this->samples[this->head] = sample;
+    this->head = (this->head + 1) % EFTOUCH_RECORDER_CAPACITY;
+    if (this->count < EFTOUCH_RECORDER_CAPACITY) {
+        this->count++;
+    }
+    this->last_ms = now_ms;
+}
+
+uint32_t EFTouchRecorderClass::getCount() const {
+    return this->count;
+}
+
+const EFTouchSample& EFTouchRecorderClass::getSample(uint32_t idx) const {
+    return this->samples[(this->head + EFTOUCH_RECORDER_CAPACITY - this->count + idx) % EFTOUCH_RECORDER_CAPACITY];
+}
+
+EFTouchTraceHeader EFTouchRecorderClass::getHeader() const {
+    const uint32_t span_ms = this->count > 0 ? (this->count - 1) * EFTOUCH_RECORDER_INTERVAL_MS : 0;
+    return {EFTOUCH_RECORDER_INTERVAL_MS, this->last_ms - span_ms, this->count};
+}
+
+size_t EFTouchRecorderClass::getEncodedSize() const {
+    EFTouchTraceWriter writer;
+    uint8_t buf[EFTOUCH_TRACE_HEADER_SIZE];
+    size_t total = writer.writeHeader(this->getHeader(), buf);
+    for (uint32_t i = 0; i < this->count; i++) {
+        total += writer.writeSample(this->getSample(i), buf);
+    }
+    return total + EFTOUCH_TRACE_TRAILER_SIZE;
+}
+
+void EFTouchRecorderClass::reset() {
+    this->head = 0;
+    this->count = 0;
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFTOUCHRECORDER)
+EFTouchRecorderClass EFTouchRecorder;
+#endif
+
+#endif /* EFTOUCH_RECORDER */
@@ -0,0 +1,127 @@
+#ifndef EFTOUCHRECORDER_H_
+#define EFTOUCHRECORDER_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "EFTouchTrace.h"
+
+// Defaults, EFConfig.h takes precedence when included first
+#ifndef EFTOUCH_RECORDER_INTERVAL_MS
+#define EFTOUCH_RECORDER_INTERVAL_MS 20
+#endif
+#ifndef EFTOUCH_RECORDER_CAPACITY
+#define EFTOUCH_RECORDER_CAPACITY 3000
+#endif
+
+
+/**
+ * @brief Keeps the most recent raw touch readings in RAM to capture what the
+ * touch classification saw right before an unexpected event
+ *
+ * Only compiled into the firmware if EFTOUCH_RECORDER is defined. Samples are
+ * taken every EFTOUCH_RECORDER_INTERVAL_MS. Once EFTOUCH_RECORDER_CAPACITY
+ * samples are recorded, the oldest one is overwritten. dump() writes the
+ * recording as touch trace (see EFTouchTraceWriter), which the simulator
+ * replays via --touch-trace.
+ */
+class EFTouchRecorderClass {
+
+    protected:
+
+        EFTouchSample samples[EFTOUCH_RECORDER_CAPACITY];  //!< Ring of recorded samples
+        uint32_t head;                                      //!< Index the next sample is written to
+        uint32_t count;                                     //!< Number of valid samples
+        uint32_t last_ms;                                   //!< millis() of the most recent sample
+
+    public:
+
+        /**
+         * @brief Constructs a new, empty EFTouchRecorderClass instance
+         */
+        EFTouchRecorderClass();
+
+        /**
+         * @brief Records a single sample, overwriting the oldest one if full
+         *
+         * @param now_ms millis() at the time the sample was taken
+         * @param sample Raw readings of both pads
+         */
+        void record(uint32_t now_ms, const EFTouchSample& sample);
+
+        /**
+         * @brief Retrieves the number of recorded samples
+         */
+        uint32_t getCount() const;
+
+        /**
+         * @brief Retrieves the recorded sample at the given index, 0 being the oldest
+         */
+        const EFTouchSample& getSample(uint32_t idx) const;
+
+        /**
+         * @brief Retrieves the header describing the current recording
+         */
+        EFTouchTraceHeader getHeader() const;
+
+        /**
+         * @brief Retrieves the number of bytes dump() will write
+         */
+        size_t getEncodedSize() const;
+
+        /**
+         * @brief Writes the current recording as touch trace
+         *
+         * @param out Sink providing write(const uint8_t*, size_t), e.g., a serial port
+         * @return Number of bytes written
+         */
+        template<typename T>
+        size_t dump(T& out) const {
+            EFTouchTraceWriter writer;
+            uint8_t buf[EFTOUCH_TRACE_HEADER_SIZE + EFTOUCH_TRACE_MAX_SAMPLE_SIZE];
+            size_t total = 0;
+
+            uint8_t len = writer.writeHeader(this->getHeader(), buf);
+            for (uint32_t i = 0; i < this->count; i++) {
+                len += writer.writeSample(this->getSample(i), buf + len);
+                total += out.write(buf, len);
+                len = 0;
+            }
+            len += writer.writeTrailer(buf + len);
+            total += out.write(buf, len);
+            return total;
+        }
+
+        /**
+         * @brief Discards all recorded samples
+         */
+        void reset();
+};
+
+#if defined(EFTOUCH_RECORDER) && !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFTOUCHRECORDER)
+extern EFTouchRecorderClass EFTouchRecorder;
+#endif
+
+#endif /* EFTOUCHRECORDER_H_ */
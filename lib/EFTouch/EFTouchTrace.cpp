@@ -0,0 +1,201 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <string.h>
+
+#include "EFTouchTrace.h"
+
+/**
+ * @brief Updates a running CRC-32 (IEEE 802.3) with the given data
+ */
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static void writeLe(uint8_t* out, uint32_t value, uint8_t len) {
+    for (uint8_t i = 0; i < len; i++) {
+        out[i] = value >> (8 * i);
+    }
+}
+
+static uint32_t readLe(const uint8_t* in, uint8_t len) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        value |= static_cast<uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Writes the difference between two readings as zigzag varint
+ */
+static uint8_t writeDelta(uint8_t* out, uint32_t previous, uint32_t current) {
+    const int32_t delta = static_cast<int32_t>(current - previous);
+    uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+    uint8_t len = 0;
+    while (zigzag >= 0x80) {
+        out[len++] = (zigzag & 0x7F) | 0x80;
+        zigzag >>= 7;
+    }
+    out[len++] = zigzag;
+    return len;
+}
+
+/**
+ * @brief Reads a zigzag varint written by writeDelta() and applies it to the previous reading
+ *
+ * @return False if the varint is truncated or longer than 5 bytes
+ */
+static bool readDelta(const uint8_t* data, size_t size, size_t& pos, uint32_t& value) {
+    uint32_t zigzag = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (pos >= size) {
+            return false;
+        }
+        const uint8_t byte = data[pos++];
+        zigzag |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            value += (zigzag >> 1) ^ -(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+EFTouchTraceWriter::EFTouchTraceWriter()
+: crc(0)
+, previous({0, 0})
+{
+}
+
+void EFTouchTraceWriter::checksum(const uint8_t* data, uint8_t len) {
+    this->crc = crc32Update(this->crc, data, len);
+}
+
+uint8_t EFTouchTraceWriter::writeHeader(const EFTouchTraceHeader& header, uint8_t* out) {
+    this->crc = 0;
+    this->previous = {0, 0};
+
+    memcpy(out, EFTOUCH_TRACE_MAGIC, 4);
+    out[4] = EFTOUCH_TRACE_VERSION;
+    out[5] = 0;
+    writeLe(out + 6, header.interval_ms, 2);
+    writeLe(out + 8, header.start_ms, 4);
+    writeLe(out + 12, header.num_samples, 4);
+    this->checksum(out, EFTOUCH_TRACE_HEADER_SIZE);
+    return EFTOUCH_TRACE_HEADER_SIZE;
+}
+
+uint8_t EFTouchTraceWriter::writeSample(const EFTouchSample& sample, uint8_t* out) {
+    uint8_t len = writeDelta(out, this->previous.fingerprint, sample.fingerprint);
+    len += writeDelta(out + len, this->previous.nose, sample.nose);
+    this->previous = sample;
+    this->checksum(out, len);
+    return len;
+}
+
+uint8_t EFTouchTraceWriter::writeTrailer(uint8_t* out) {
+    writeLe(out, this->crc, EFTOUCH_TRACE_TRAILER_SIZE);
+    return EFTOUCH_TRACE_TRAILER_SIZE;
+}
+
+EFTouchTraceReader::EFTouchTraceReader()
+: data(nullptr)
+, size(0)
+, encoded_size(0)
+, pos(0)
+, remaining(0)
+, header({0, 0, 0})
+, previous({0, 0})
+{
+}
+
+void EFTouchTraceReader::rewind() {
+    this->pos = EFTOUCH_TRACE_HEADER_SIZE;
+    this->remaining = this->header.num_samples;
+    this->previous = {0, 0};
+}
+
+bool EFTouchTraceReader::open(const uint8_t* data, size_t size) {
+    this->data = data;
+    this->size = size;
+    this->encoded_size = 0;
+    this->remaining = 0;
+
+    if (size < EFTOUCH_TRACE_HEADER_SIZE + EFTOUCH_TRACE_TRAILER_SIZE ||
+        memcmp(data, EFTOUCH_TRACE_MAGIC, 4) != 0 ||
+        data[4] != EFTOUCH_TRACE_VERSION) {
+        return false;
+    }
+    this->header.interval_ms = readLe(data + 6, 2);
+    this->header.start_ms = readLe(data + 8, 4);
+    this->header.num_samples = readLe(data + 12, 4);
+    if (this->header.interval_ms == 0) {
+        return false;
+    }
+
+    // Walk all samples once to find the trailer
+    this->rewind();
+    EFTouchSample sample;
+    while (this->remaining > 0) {
+        if (!this->next(sample)) {
+            return false;
+        }
+    }
+    if (this->pos + EFTOUCH_TRACE_TRAILER_SIZE > size ||
+        readLe(data + this->pos, EFTOUCH_TRACE_TRAILER_SIZE) != crc32Update(0, data, this->pos)) {
+        return false;
+    }
+
+    this->encoded_size = this->pos + EFTOUCH_TRACE_TRAILER_SIZE;
+    this->rewind();
+    return true;
+}
+
+const EFTouchTraceHeader& EFTouchTraceReader::getHeader() const {
+    return this->header;
+}
+
+size_t EFTouchTraceReader::getEncodedSize() const {
+    return this->encoded_size;
+}
+
+bool EFTouchTraceReader::next(EFTouchSample& sample) {
+    if (this->remaining == 0) {
+        return false;
+    }
+    if (!readDelta(this->data, this->size, this->pos, this->previous.fingerprint) ||
+        !readDelta(this->data, this->size, this->pos, this->previous.nose)) {
+        this->remaining = 0;
+        return false;
+    }
+    this->remaining--;
+    sample = this->previous;
+    return true;
+}
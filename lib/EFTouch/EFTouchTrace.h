@@ -0,0 +1,185 @@
+#ifndef EFTOUCHTRACE_H_
+#define EFTOUCHTRACE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Identifies the start of a touch trace
+ */
+#define EFTOUCH_TRACE_MAGIC "EFTT"
+
+/**
+ * @brief Version of the touch trace format
+ */
+#define EFTOUCH_TRACE_VERSION 1
+
+/**
+ * @brief Size of the encoded header in bytes
+ */
+#define EFTOUCH_TRACE_HEADER_SIZE 16
+
+/**
+ * @brief Upper bound of the encoded size of a single sample in bytes (two 5 byte varints)
+ */
+#define EFTOUCH_TRACE_MAX_SAMPLE_SIZE 10
+
+/**
+ * @brief Size of the encoded trailer in bytes
+ */
+#define EFTOUCH_TRACE_TRAILER_SIZE 4
+
+
+/**
+ * @brief Raw touchRead() values of both pads taken at the same time
+ */
+struct EFTouchSample {
+    uint32_t fingerprint;  //!< Reading of the fingerprint pad
+    uint32_t nose;         //!< Reading of the nose pad
+};
+
+/**
+ * @brief Describes the samples of a touch trace
+ */
+struct EFTouchTraceHeader {
+    uint16_t interval_ms;  //!< Time between two samples
+    uint32_t start_ms;     //!< millis() at the time of the first sample
+    uint32_t num_samples;  //!< Number of samples following the header
+};
+
+/**
+ * @brief Encodes raw touch readings into the compact touch trace format
+ *
+ * Layout, all integers little-endian:
+ *   - 16 byte header: magic "EFTT", version, reserved byte, interval_ms (u16),
+ *     start_ms (u32), num_samples (u32)
+ *   - One entry per sample: Difference to the previous reading of the same
+ *     pad as zigzag varint, first fingerprint then nose. The first sample is
+ *     relative to 0.
+ *   - 4 byte trailer: CRC-32 (IEEE 802.3) of all preceding bytes
+ *
+ * Untouched pads only jitter by a few counts, so a sample usually takes two to
+ * four bytes instead of eight.
+ *
+ * Encodes into caller provided chunks, so a trace can be streamed without
+ * buffering it as a whole. Does not depend on Arduino and works on the host.
+ */
+class EFTouchTraceWriter {
+
+    protected:
+
+        uint32_t crc;            //!< Running CRC-32 of all bytes written so far
+        EFTouchSample previous;  //!< Last written sample
+
+        /**
+         * @brief Adds the given bytes to the running CRC
+         */
+        void checksum(const uint8_t* data, uint8_t len);
+
+    public:
+
+        EFTouchTraceWriter();
+
+        /**
+         * @brief Starts a new trace
+         *
+         * @param header Header to write
+         * @param out Receives EFTOUCH_TRACE_HEADER_SIZE bytes
+         * @return Number of bytes written to out
+         */
+        uint8_t writeHeader(const EFTouchTraceHeader& header, uint8_t* out);
+
+        /**
+         * @brief Appends the next sample
+         *
+         * @param sample Sample to write
+         * @param out Receives up to EFTOUCH_TRACE_MAX_SAMPLE_SIZE bytes
+         * @return Number of bytes written to out
+         */
+        uint8_t writeSample(const EFTouchSample& sample, uint8_t* out);
+
+        /**
+         * @brief Completes the trace
+         *
+         * @param out Receives EFTOUCH_TRACE_TRAILER_SIZE bytes
+         * @return Number of bytes written to out
+         */
+        uint8_t writeTrailer(uint8_t* out);
+};
+
+/**
+ * @brief Decodes a touch trace written by EFTouchTraceWriter
+ */
+class EFTouchTraceReader {
+
+    protected:
+
+        const uint8_t* data;         //!< Encoded trace
+        size_t size;                 //!< Number of bytes available at data
+        size_t encoded_size;         //!< Number of bytes the trace occupies, 0 if not opened
+        size_t pos;                  //!< Read position of the next sample
+        uint32_t remaining;          //!< Number of samples not read yet
+        EFTouchTraceHeader header;   //!< Decoded header
+        EFTouchSample previous;      //!< Last decoded sample
+
+        /**
+         * @brief Positions the reader at the first sample
+         */
+        void rewind();
+
+    public:
+
+        EFTouchTraceReader();
+
+        /**
+         * @brief Opens the trace starting at the given data. Validates the
+         * header, all samples and the checksum.
+         *
+         * @param data Encoded trace, may be followed by unrelated bytes
+         * @param size Number of bytes available at data
+         * @return True if data starts with a complete and intact trace
+         */
+        bool open(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Retrieves the header of the opened trace
+         */
+        const EFTouchTraceHeader& getHeader() const;
+
+        /**
+         * @brief Retrieves the number of bytes the opened trace occupies
+         */
+        size_t getEncodedSize() const;
+
+        /**
+         * @brief Decodes the next sample
+         *
+         * @param sample Receives the sample
+         * @return True on success, false after the last sample
+         */
+        bool next(EFTouchSample& sample);
+};
+
+#endif /* EFTOUCHTRACE_H_ */
@@ -0,0 +1,141 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <algorithm>
+
+#include "EFTrace.h"
+
+const char* toString(EFTraceStage stage) {
+    switch (stage) {
+        case EFTraceStage::Queue: return "queue";
+        case EFTraceStage::Handler: return "handler";
+        case EFTraceStage::Photon: return "photon";
+        case EFTraceStage::Total: return "total";
+        default: return "UNKNOWN";
+    }
+}
+
+EFTraceClass::EFTraceClass()
+: head(0)
+, count(0)
+, enabled(false)
+{
+}
+
+void EFTraceClass::setEnabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool EFTraceClass::isEnabled() const {
+    return this->enabled;
+}
+
+int16_t EFTraceClass::begin(uint8_t event, uint8_t zone, uint32_t isr_us, uint32_t now_us) {
+    if (!this->enabled) {
+        return EFTRACE_NO_SLOT;
+    }
+
+    const int16_t slot = this->head;
+    this->records[slot] = {event, zone, false, false, isr_us, now_us, 0, 0};
+    this->head = (this->head + 1) % EFTRACE_CAPACITY;
+    if (this->count < EFTRACE_CAPACITY) {
+        this->count++;
+    }
+    return slot;
+}
+
+void EFTraceClass::handled(int16_t slot, uint32_t now_us) {
+    if (slot == EFTRACE_NO_SLOT || !this->enabled) {
+        return;
+    }
+    this->records[slot].handled_us = now_us;
+    this->records[slot].handled = true;
+}
+
+void EFTraceClass::commit(uint32_t now_us) {
+    if (!this->enabled) {
+        return;
+    }
+
+    // Walk backwards from the newest record. Records older than the first
+    // committed one were completed by an earlier frame.
+    for (uint16_t n = 0; n < this->count; n++) {
+        EFTraceRecord& rec = this->records[(this->head + EFTRACE_CAPACITY - 1 - n) % EFTRACE_CAPACITY];
+        if (rec.committed) {
+            break;
+        }
+        // Also completes records whose handler is still running, i.e. the
+        // handler pushed the frame itself
+        rec.commit_us = now_us;
+        rec.committed = true;
+    }
+}
+
+EFTracePercentiles EFTraceClass::getPercentiles(EFTraceStage stage) const {
+    uint32_t samples[EFTRACE_CAPACITY];
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; i < this->count; i++) {
+        const EFTraceRecord& rec = this->records[i];
+        switch (stage) {
+            case EFTraceStage::Queue:
+                samples[n++] = rec.dequeue_us - rec.isr_us;
+                break;
+            case EFTraceStage::Handler:
+                if (rec.handled) samples[n++] = rec.handled_us - rec.dequeue_us;
+                break;
+            case EFTraceStage::Photon:
+                // Frames pushed from within the handler count as zero
+                if (rec.committed && rec.handled) samples[n++] = std::max<int32_t>(rec.commit_us - rec.handled_us, 0);
+                break;
+            case EFTraceStage::Total:
+                if (rec.committed) samples[n++] = rec.commit_us - rec.isr_us;
+                break;
+        }
+    }
+
+    EFTracePercentiles result = {n, 0, 0, 0, 0};
+    if (n == 0) {
+        return result;
+    }
+
+    // Nearest-rank percentiles
+    std::sort(samples, samples + n);
+    result.p50 = samples[(n * 50 + 99) / 100 - 1];
+    result.p90 = samples[(n * 90 + 99) / 100 - 1];
+    result.p99 = samples[(n * 99 + 99) / 100 - 1];
+    result.max = samples[n - 1];
+    return result;
+}
+
+uint16_t EFTraceClass::getCount() const {
+    return this->count;
+}
+
+void EFTraceClass::reset() {
+    this->head = 0;
+    this->count = 0;
+}
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFTRACE)
+EFTraceClass EFTrace;
+#endif
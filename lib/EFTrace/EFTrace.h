@@ -0,0 +1,140 @@
+#ifndef EFTRACE_H_
+#define EFTRACE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdint.h>
+
+/**
+ * @brief Number of input events kept in the latency trace ring buffer
+ */
+#define EFTRACE_CAPACITY 64
+
+/**
+ * @brief Slot value returned if an event is not traced
+ */
+#define EFTRACE_NO_SLOT -1
+
+
+/**
+ * @brief Segments of the input-to-photon path of an event
+ */
+enum class EFTraceStage : uint8_t {
+    Queue,    //!< ISR capture until the FSM dequeued the event
+    Handler,  //!< Dequeue until the state handler (incl. transition) returned
+    Photon,   //!< Handler return until the next LED frame was pushed (0 if the handler pushed it)
+    Total,    //!< ISR capture until the next LED frame was pushed
+};
+
+const char* toString(EFTraceStage stage);
+
+/**
+ * @brief Timestamps of a single traced event in microseconds
+ */
+struct EFTraceRecord {
+    uint8_t event;         //!< Traced event, FSMEvent value
+    uint8_t zone;          //!< Source touch zone, EFTouchZone value
+    bool handled;          //!< Handler returned, handled_us is valid
+    bool committed;        //!< LED frame was pushed, commit_us is valid
+    uint32_t isr_us;       //!< Time the ISR captured the event
+    uint32_t dequeue_us;   //!< Time the FSM dequeued the event
+    uint32_t handled_us;   //!< Time the state handler returned
+    uint32_t commit_us;    //!< Time of the first LED frame pushed after the event was dequeued
+};
+
+/**
+ * @brief Latency distribution of a single stage in microseconds
+ */
+struct EFTracePercentiles {
+    uint16_t count;  //!< Number of samples
+    uint32_t p50;    //!< Median
+    uint32_t p90;    //!< 90th percentile
+    uint32_t p99;    //!< 99th percentile
+    uint32_t max;    //!< Worst case
+};
+
+/**
+ * @brief Opt-in tracer for the latency between an input ISR and the resulting
+ * LED update. Records live in a fixed ring buffer, the oldest record is
+ * overwritten once EFTRACE_CAPACITY events have been traced. Disabled by
+ * default, all hooks return immediately while disabled.
+ */
+class EFTraceClass {
+
+    protected:
+
+        EFTraceRecord records[EFTRACE_CAPACITY];  //!< Ring buffer of traced events
+        uint16_t head;                            //!< Index the next record is written to
+        uint16_t count;                           //!< Number of valid records
+        bool enabled;                             //!< Tracing is active
+
+    public:
+
+        EFTraceClass();
+
+        void setEnabled(bool enabled);
+        bool isEnabled() const;
+
+        /**
+         * @brief Starts tracing an event that was just dequeued
+         *
+         * @param event FSMEvent value
+         * @param zone EFTouchZone value of the source
+         * @param isr_us Capture timestamp of the event
+         * @param now_us Current time
+         * @return Slot to pass to handled() or EFTRACE_NO_SLOT if disabled
+         */
+        int16_t begin(uint8_t event, uint8_t zone, uint32_t isr_us, uint32_t now_us);
+
+        /**
+         * @brief Marks the state handler for the given slot as returned
+         */
+        void handled(int16_t slot, uint32_t now_us);
+
+        /**
+         * @brief Notifies the tracer that a LED frame was pushed. Completes all
+         * records that were dequeued since the previous frame.
+         */
+        void commit(uint32_t now_us);
+
+        /**
+         * @brief Calculates percentiles over all records that completed the given stage
+         */
+        EFTracePercentiles getPercentiles(EFTraceStage stage) const;
+
+        /**
+         * @brief Retrieves the number of records in the ring buffer
+         */
+        uint16_t getCount() const;
+
+        /**
+         * @brief Discards all records
+         */
+        void reset();
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_EFTRACE)
+extern EFTraceClass EFTrace;
+#endif
+
+#endif /* EFTRACE_H_ */
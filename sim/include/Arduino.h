@@ -0,0 +1,234 @@
+#ifndef EFSIM_ARDUINO_H_
+#define EFSIM_ARDUINO_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for the subset of the Arduino-ESP32 core used by the badge
+ * firmware. Time is virtual and only advances through delay() or the simulator.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint32_t touch_value_t;
+
+#define ARDUINO_ISR_ATTR
+#define IRAM_ATTR
+#define RTC_DATA_ATTR __attribute__((section("efsim_rtc")))  //!< Collected for EFSim::setRtcFile()
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT  0x01
+#define OUTPUT 0x03
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define log_e(format, ...) fprintf(stderr, "[E] " format "\n", ##__VA_ARGS__)
+
+// ---------- Time ----------
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// ---------- GPIO / ADC / Touch ----------
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+
+touch_value_t touchRead(uint8_t pin);
+void touchAttachInterrupt(uint8_t pin, void (*userFunc)(void), touch_value_t threshold);
+void touchDetachInterrupt(uint8_t pin);
+bool touchInterruptGetLastStatus(uint8_t pin);
+void touchSleepWakeUpEnable(uint8_t pin, touch_value_t threshold);
+
+void noInterrupts();
+void interrupts();
+
+// ---------- Misc ----------
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+inline bool isPrintable(int c) { return c >= 0x20 && c < 0x7F; }
+
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+uint32_t getCpuFrequencyMhz();
+
+// ---------- String ----------
+class String {
+
+    protected:
+
+        std::string s;
+
+    public:
+
+        String() {}
+        String(const char* cstr) : s(cstr ? cstr : "") {}
+        String(const std::string& str) : s(str) {}
+        String(char c) : s(1, c) {}
+        String(int value) : s(std::to_string(value)) {}
+        String(unsigned int value) : s(std::to_string(value)) {}
+        String(long value) : s(std::to_string(value)) {}
+        String(unsigned long value) : s(std::to_string(value)) {}
+        String(float value, unsigned int decimals = 2) { this->setFloat(value, decimals); }
+        String(double value, unsigned int decimals = 2) { this->setFloat(value, decimals); }
+
+        const char* c_str() const { return this->s.c_str(); }
+        unsigned int length() const { return this->s.length(); }
+        bool isEmpty() const { return this->s.empty(); }
+        char operator[](unsigned int idx) const { return this->s[idx]; }
+
+        String substring(unsigned int from) const { return from < this->s.length() ? String(this->s.substr(from)) : String(); }
+        String substring(unsigned int from, unsigned int to) const { return from < this->s.length() ? String(this->s.substr(from, to - from)) : String(); }
+        bool startsWith(const String& prefix) const { return this->s.rfind(prefix.s, 0) == 0; }
+        int indexOf(char c) const { size_t pos = this->s.find(c); return pos == std::string::npos ? -1 : (int) pos; }
+        long toInt() const { return strtol(this->s.c_str(), nullptr, 10); }
+        float toFloat() const { return strtof(this->s.c_str(), nullptr); }
+        void remove(unsigned int index) { if (index < this->s.length()) this->s.erase(index); }
+        void trim() {
+            size_t start = this->s.find_first_not_of(" \t\r\n");
+            size_t end = this->s.find_last_not_of(" \t\r\n");
+            this->s = (start == std::string::npos) ? "" : this->s.substr(start, end - start + 1);
+        }
+        void toUpperCase() { for (auto &c : this->s) c = toupper(c); }
+
+        String& operator+=(const String& rhs) { this->s += rhs.s; return *this; }
+        String& operator+=(const char* rhs) { this->s += rhs; return *this; }
+        String& operator+=(char rhs) { this->s += rhs; return *this; }
+        friend String operator+(const String& lhs, const String& rhs) { return String(lhs.s + rhs.s); }
+        friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs.s); }
+        friend String operator+(const String& lhs, const char* rhs) { return String(lhs.s + rhs); }
+        bool operator==(const String& rhs) const { return this->s == rhs.s; }
+        bool operator==(const char* rhs) const { return this->s == rhs; }
+        bool operator!=(const String& rhs) const { return this->s != rhs.s; }
+
+    private:
+
+        void setFloat(double value, unsigned int decimals) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+            this->s = buf;
+        }
+};
+
+// ---------- Serial ----------
+class HWCDC {
+
+    public:
+
+        void begin(unsigned long baud) {}
+        int available();
+        int read();
+        size_t write(uint8_t c);
+        size_t write(const uint8_t* buf, size_t len);
+        size_t print(const String& s) { return this->printf("%s", s.c_str()); }
+        size_t print(const char* s) { return this->printf("%s", s); }
+        size_t print(int v) { return this->printf("%d", v); }
+        size_t println() { return this->printf("\r\n"); }
+        size_t println(const String& s) { return this->printf("%s\r\n", s.c_str()); }
+        size_t println(const char* s) { return this->printf("%s\r\n", s); }
+        size_t println(int v) { return this->printf("%d\r\n", v); }
+        size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+        void flush() {}
+        operator bool() const { return true; }
+};
+
+extern HWCDC USBSerial;
+extern HWCDC Serial;
+
+// ---------- ESP-IDF / FreeRTOS ----------
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+    ESP_SLEEP_WAKEUP_UART,
+    ESP_SLEEP_WAKEUP_WIFI,
+    ESP_SLEEP_WAKEUP_COCPU,
+    ESP_SLEEP_WAKEUP_COCPU_TRAP_TRIG,
+    ESP_SLEEP_WAKEUP_BT,
+} esp_sleep_wakeup_cause_t;
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_touchpad_wakeup();
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t source);
+esp_err_t esp_light_sleep_start();
+void esp_deep_sleep_start();
+
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define ARDUINO_RUNNING_CORE 1
+
+BaseType_t xTaskCreatePinnedToCore(
+    void (*task)(void*), const char* name, uint32_t stack_depth, void* param,
+    unsigned int priority, TaskHandle_t* handle, int core_id
+);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+class EspClass {
+
+    public:
+
+        uint32_t getFreeHeap();
+        uint32_t getMinFreeHeap();
+        uint32_t getCycleCount();
+        void restart();
+};
+
+extern EspClass ESP;
+
+#endif /* EFSIM_ARDUINO_H_ */
@@ -0,0 +1,111 @@
+#ifndef EFSIM_BLEDEVICE_H_
+#define EFSIM_BLEDEVICE_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for the Arduino-ESP32 BLE library. Advertising and scanning
+ * are accepted but no other device is ever seen.
+ */
+
+#include <string>
+
+#include <Arduino.h>
+
+class BLEAddress {
+
+    protected:
+
+        uint8_t address[6];
+
+    public:
+
+        BLEAddress(const uint8_t* addr) { memcpy(this->address, addr, 6); }
+        std::string toString() const { return "00:00:00:00:00:00"; }
+};
+
+class BLEAdvertisedDevice {
+
+    public:
+
+        bool haveManufacturerData() { return false; }
+        std::string getManufacturerData() { return std::string(); }
+        bool haveName() { return false; }
+        std::string getName() { return std::string(); }
+        int getRSSI() { return -127; }
+        BLEAddress getAddress() { return BLEAddress((const uint8_t*) "\0\0\0\0\0\0"); }
+};
+
+class BLEAdvertisedDeviceCallbacks {
+
+    public:
+
+        virtual ~BLEAdvertisedDeviceCallbacks() {}
+        virtual void onResult(BLEAdvertisedDevice advertisedDevice) = 0;
+};
+
+class BLEAdvertisementData {
+
+    public:
+
+        void setManufacturerData(const std::string& data) {}
+        void setName(const std::string& name) {}
+};
+
+class BLEAdvertising {
+
+    public:
+
+        void setAdvertisementData(BLEAdvertisementData& data) {}
+        void setScanResponseData(BLEAdvertisementData& data) {}
+        void start() {}
+        void stop() {}
+};
+
+class BLEScanResults {};
+
+class BLEScan {
+
+    public:
+
+        void setActiveScan(bool active) {}
+        void setInterval(uint16_t interval) {}
+        void setWindow(uint16_t window) {}
+        void setAdvertisedDeviceCallbacks(BLEAdvertisedDeviceCallbacks* callbacks, bool wantDuplicates = false) {}
+        BLEScanResults start(uint32_t duration, bool is_continue = false) { delay(duration * 1000); return BLEScanResults(); }
+        void stop() {}
+        void clearResults() {}
+};
+
+class BLEDevice {
+
+    public:
+
+        static void init(const std::string& deviceName);
+        static void deinit(bool release_memory = false);
+        static bool getInitialized();
+        static BLEScan* getScan();
+        static BLEAdvertising* getAdvertising();
+};
+
+#endif /* EFSIM_BLEDEVICE_H_ */
@@ -0,0 +1,304 @@
+#ifndef EFSIM_H_
+#define EFSIM_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host-native badge simulator. Owns the virtual clock, replays scripted
+ * input (touch, console, battery) or recorded touch traces and records every
+ * LED frame pushed to FastLED.
+ *
+ * Time only moves when the firmware calls delay() / light sleep or when the
+ * simulator main loop advances it between two loop() iterations. This makes a
+ * run fully deterministic: the same script and seed always yield the same
+ * frame digest.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <EFTouchTrace.h>
+#include <FastLED.h>
+
+#define EFSIM_TOUCH_NUM_PINS 15          //!< Number of touch capable pins emulated
+#define EFSIM_TOUCH_NOISE_FLOOR 20000    //!< Raw touchRead() value of an untouched pad
+#define EFSIM_TOUCH_DELTA 25000          //!< Raw touchRead() increase while a pad is touched
+#define EFSIM_TOUCH_BENCHMARK_SHIFT 4    //!< Benchmark of a replayed pad moves 1/2^N towards each untouched sample
+#define EFSIM_TOUCH_TRACE_TAIL_MS 2000   //!< Time a replay keeps running after the last sample if no --until is given
+#define EFSIM_DEFAULT_VBAT 3.9f          //!< Default battery voltage in volts
+#define EFSIM_HEAP_SIZE (256 * 1024)     //!< Free heap reported with all radios off
+#define EFSIM_HEAP_BLE (60 * 1024)       //!< Heap held by an initialized BLE stack
+#define EFSIM_HEAP_WIFI (50 * 1024)      //!< Heap held by the WiFi driver while not WIFI_OFF
+
+/**
+ * @brief Number of heap allocations performed by the process so far. Counted
+ * by the global operator new replacement in EFSimHeap.cpp.
+ */
+extern uint64_t efsim_heap_allocations;
+
+/**
+ * @brief Type of a scripted simulator event
+ */
+enum class EFSimEventType : uint8_t {
+    Touch,       //!< Pad starts being touched
+    Release,     //!< Pad stops being touched
+    Console,     //!< Line is written to the serial console
+    Battery,     //!< Battery voltage changes
+};
+
+/**
+ * @brief A single scripted simulator event
+ */
+struct EFSimEvent {
+    uint64_t at_us;        //!< Virtual time at which the event fires
+    EFSimEventType type;   //!< Type of the event
+    uint8_t pin;           //!< Touch pin for Touch / Release events
+    float value;           //!< Voltage for Battery events
+    std::string text;      //!< Line for Console events
+};
+
+/**
+ * @brief CPU time accounting for a single FSM state
+ */
+struct EFSimStateStats {
+    uint64_t cpu_ns;       //!< Host CPU time spent inside loop() while this state was active
+    uint64_t loops;        //!< Number of loop() iterations while this state was active
+    uint64_t virtual_us;   //!< Virtual time spent while this state was active
+};
+
+class EFSimClass {
+
+    protected:
+
+        uint64_t now_us;                      //!< Current virtual time
+        uint64_t end_us;                      //!< Virtual time at which the simulation ends
+        bool finishing;                       //!< True once finish() has been entered
+
+        std::vector<EFSimEvent> script;       //!< Scripted events, sorted by time
+        size_t script_pos;                    //!< Index of the next script event to fire
+
+        bool touched[EFSIM_TOUCH_NUM_PINS];                 //!< Current touch state per pin
+        bool touch_last_status[EFSIM_TOUCH_NUM_PINS];       //!< Last edge reported to the touch ISR
+        void (*touch_isr[EFSIM_TOUCH_NUM_PINS])(void);      //!< Attached touch ISRs
+        touch_value_t touch_threshold[EFSIM_TOUCH_NUM_PINS];   //!< Thresholds passed to touchAttachInterrupt()
+        uint32_t touch_benchmark[EFSIM_TOUCH_NUM_PINS];        //!< Emulated hardware benchmark of replayed pads
+        uint64_t touch_edges;                 //!< Number of touch edges applied so far
+
+        std::vector<EFTouchSample> touch_trace;   //!< Replayed raw touch readings, empty if none
+        uint16_t touch_trace_interval_ms;         //!< Time between two replayed samples
+        uint64_t touch_trace_start_us;            //!< Virtual time of the first replayed sample
+        size_t touch_trace_pos;                   //!< Index of the next sample to apply
+        bool touch_trace_running;                 //!< True once startTouchTrace() was called
+        float vbat;                           //!< Simulated battery voltage
+
+        std::string console_rx;               //!< Pending console input
+        bool verbose;                         //!< Forward serial output to stderr
+
+        FILE* frames_file;                    //!< LED frame log or nullptr
+        uint64_t frame_count;                 //!< Number of frames pushed via FastLED.show()
+        uint32_t frame_digest;                //!< Running FNV-1a hash over all frames
+        bool has_expected_digest;             //!< Whether finish() validates the digest
+        uint32_t expected_digest;             //!< Digest the run is expected to produce
+
+        std::string nvs_path;                 //!< Path NVS contents are loaded from / saved to
+        std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;  //!< Emulated NVS
+
+        std::string rtc_path;                 //!< Path RTC memory is loaded from / saved to
+        esp_sleep_wakeup_cause_t wakeup_cause;  //!< Reported by esp_sleep_get_wakeup_cause()
+
+        FILE* events_file;                    //!< FSM event log or nullptr
+        uint64_t event_count;                 //!< Number of events handled by the FSM
+
+        std::map<std::string, EFSimStateStats> state_stats;  //!< Per-state accounting
+
+        /**
+         * @brief Fires all script events and applies all touch trace samples
+         * that are due at or before the given time, in chronological order
+         */
+        void dispatchScript(uint64_t until_us);
+
+        /**
+         * @brief Virtual time of the next touch trace sample, UINT64_MAX if none
+         */
+        uint64_t getNextTraceUs() const;
+
+        /**
+         * @brief Applies the next touch trace sample to both pads
+         */
+        void applyTraceSample();
+
+        /**
+         * @brief Emulates the touch peripheral for a replayed reading: Fires the
+         * ISR once the reading exceeds the benchmark by more than the interrupt
+         * threshold and again once it falls back. The benchmark only follows
+         * untouched readings.
+         */
+        void applyTraceReading(uint8_t pin, uint32_t reading);
+
+        /**
+         * @brief Applies a touch state change and fires the attached ISR on an edge
+         */
+        void setTouched(uint8_t pin, bool is_touched);
+
+    public:
+
+        /**
+         * @brief Constructs the simulator with an empty script at t = 0
+         */
+        EFSimClass();
+
+        /**
+         * @brief Parses a simulator script. Each non-empty line that does not start
+         * with '#' has the form "<time_ms> <command> [args]". Commands:
+         *   - touch <fingerprint|nose|all>
+         *   - release <fingerprint|nose|all>
+         *   - tap <fingerprint|nose|all> <duration_ms>
+         *   - console <line>
+         *   - vbat <volts> (0 simulates USB power)
+         *
+         * @param path Script file
+         * @return True if the script was parsed successfully
+         */
+        bool loadScript(const char* path);
+
+        /**
+         * @brief Opens the LED frame log. One line per frame: time, brightness, hash, RGB hex.
+         */
+        bool openFrames(const char* path);
+
+        /**
+         * @brief Loads a touch trace to replay instead of scripted touch input.
+         * The trace may be embedded in a serial capture of GET TOUCHTRACE, the
+         * first intact trace in the file is used.
+         *
+         * @param path Trace or serial capture containing a trace
+         * @return True if a trace was found
+         */
+        bool loadTouchTrace(const char* path);
+
+        /**
+         * @brief Starts replaying the loaded touch trace at the current time.
+         * Before, touchRead() returns the first sample, e.g., for calibration.
+         */
+        void startTouchTrace();
+
+        /**
+         * @brief Retrieves the duration of the loaded touch trace, 0 if none
+         */
+        uint64_t getTouchTraceDurationMs() const;
+
+        /**
+         * @brief Opens the FSM event log. One line per handled event: time, event, state.
+         * "-" writes to stdout.
+         */
+        bool openEvents(const char* path);
+
+        /**
+         * @brief Sets the file emulated NVS contents are loaded from and saved to on finish()
+         */
+        bool setNvsFile(const char* path);
+
+        /**
+         * @brief Sets the file RTC_DATA_ATTR variables are loaded from and saved
+         * to on finish(). Loading must happen before setup().
+         */
+        bool setRtcFile(const char* path);
+
+        /**
+         * @brief Sets the wakeup cause reported to the firmware, e.g., to boot
+         * as if woken up from deep sleep
+         */
+        void setWakeupCause(esp_sleep_wakeup_cause_t cause);
+        esp_sleep_wakeup_cause_t getWakeupCause() const;
+
+        /**
+         * @brief Makes finish() fail with a non-zero exit code if the frame digest differs
+         */
+        void expectDigest(uint32_t digest);
+
+        void setVerbose(bool verbose);
+        void setEnd(uint64_t end_ms);
+        bool isVerbose() const;
+
+        /**
+         * @brief Current virtual time in microseconds
+         */
+        uint64_t now() const;
+
+        /**
+         * @brief Advances the virtual clock, firing due script events on the way.
+         * Ends the simulation once the end time is reached.
+         */
+        void advance(uint64_t us);
+
+        /**
+         * @brief Advances the virtual clock to the next script event or until
+         * the given number of microseconds passed, whichever comes first.
+         * Used to emulate light sleep with touch wakeup.
+         */
+        void sleep(uint64_t us);
+
+        // Touch pad emulation
+        touch_value_t touchRead(uint8_t pin) const;
+        void attachTouchInterrupt(uint8_t pin, void (*isr)(void), touch_value_t threshold);
+        void detachTouchInterrupt(uint8_t pin);
+        bool getTouchLastStatus(uint8_t pin) const;
+
+        // ADC emulation
+        uint32_t readMilliVolts(uint8_t pin) const;
+
+        // Console emulation
+        int consoleAvailable() const;
+        int consoleRead();
+
+        // NVS emulation
+        std::map<std::string, std::vector<uint8_t>>& getNvsNamespace(const std::string& name);
+
+        /**
+         * @brief Records a frame pushed to the LEDs
+         */
+        void recordFrame(const CRGB* leds, int num_leds, uint8_t brightness);
+
+        /**
+         * @brief Records an event handled by the FSM
+         */
+        void recordEvent(const char* event, const char* state);
+
+        /**
+         * @brief Accounts a single loop() iteration to the given state
+         */
+        void accountLoop(const char* state, uint64_t cpu_ns, uint64_t virtual_us);
+
+        /**
+         * @brief Prints the summary, saves NVS and RTC memory and terminates the process
+         */
+        [[noreturn]] void finish(int exitcode = 0);
+};
+
+extern EFSimClass EFSim;
+
+#endif /* EFSIM_H_ */
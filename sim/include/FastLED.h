@@ -0,0 +1,148 @@
+#ifndef EFSIM_FASTLED_H_
+#define EFSIM_FASTLED_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for the subset of FastLED used by the badge firmware.
+ * Frames pushed via show() are handed to EFSim for recording.
+ */
+
+#include <Arduino.h>
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return ((uint16_t) i * (1 + (uint16_t) scale)) >> 8; }
+inline uint8_t qadd8(uint8_t i, uint8_t j) { unsigned int t = i + j; return t > 255 ? 255 : t; }
+inline uint8_t qsub8(uint8_t i, uint8_t j) { int t = i - j; return t < 0 ? 0 : t; }
+
+struct CRGB;
+
+struct CHSV {
+    union {
+        struct {
+            union { uint8_t hue; uint8_t h; };
+            union { uint8_t sat; uint8_t saturation; uint8_t s; };
+            union { uint8_t val; uint8_t value; uint8_t v; };
+        };
+        uint8_t raw[3];
+    };
+
+    CHSV() : h(0), s(0), v(0) {}
+    CHSV(uint8_t ih, uint8_t is, uint8_t iv) : h(ih), s(is), v(iv) {}
+};
+
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+
+struct CRGB {
+    union {
+        struct {
+            union { uint8_t r; uint8_t red; };
+            union { uint8_t g; uint8_t green; };
+            union { uint8_t b; uint8_t blue; };
+        };
+        uint8_t raw[3];
+    };
+
+    typedef enum {
+        Black    = 0x000000,
+        Blue     = 0x0000FF,
+        DarkBlue = 0x00008B,
+        Green    = 0x008000,
+        Purple   = 0x800080,
+        Red      = 0xFF0000,
+        Silver   = 0xC0C0C0,
+        White    = 0xFFFFFF,
+        Yellow   = 0xFFFF00,
+    } HTMLColorCode;
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+    CRGB(int colorcode) : CRGB((uint32_t) colorcode) {}
+    CRGB(HTMLColorCode colorcode) : CRGB((uint32_t) colorcode) {}
+    CRGB(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); }
+
+    CRGB& operator=(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); return *this; }
+    uint8_t& operator[](uint8_t x) { return this->raw[x]; }
+    const uint8_t& operator[](uint8_t x) const { return this->raw[x]; }
+
+    CRGB& nscale8(uint8_t scaledown) {
+        this->r = ::scale8(this->r, scaledown);
+        this->g = ::scale8(this->g, scaledown);
+        this->b = ::scale8(this->b, scaledown);
+        return *this;
+    }
+    CRGB scale8(uint8_t scaledown) const { CRGB out = *this; out.nscale8(scaledown); return out; }
+    CRGB& fadeLightBy(uint8_t fadefactor) { return this->nscale8(255 - fadefactor); }
+    CRGB& fadeToBlackBy(uint8_t fadefactor) { return this->nscale8(255 - fadefactor); }
+    CRGB& operator+=(const CRGB& rhs) { this->r = qadd8(this->r, rhs.r); this->g = qadd8(this->g, rhs.g); this->b = qadd8(this->b, rhs.b); return *this; }
+    explicit operator bool() const { return this->r || this->g || this->b; }
+};
+
+inline bool operator==(const CRGB& lhs, const CRGB& rhs) { return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b; }
+inline bool operator!=(const CRGB& lhs, const CRGB& rhs) { return !(lhs == rhs); }
+
+void fill_solid(CRGB* leds, int num_leds, const CRGB& color);
+void fill_rainbow(CRGB* leds, int num_leds, uint8_t initialhue, uint8_t deltahue = 5);
+void fill_rainbow_circular(CRGB* leds, int num_leds, uint8_t initialhue, bool reversed = false);
+void fadeLightBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy);
+void fadeToBlackBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy);
+CRGB blend(const CRGB& p1, const CRGB& p2, uint8_t amountOfP2);
+CRGB* blend(const CRGB* src1, const CRGB* src2, CRGB* dest, uint16_t count, uint8_t amountOfsrc2);
+uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z);
+uint8_t inoise8(uint16_t x, uint16_t y);
+uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z);
+uint16_t inoise16(uint32_t x, uint32_t y);
+
+enum ESPIChipsets { WS2812B };
+enum EOrder { RGB, GRB };
+
+class CFastLED {
+
+    protected:
+
+        CRGB* leds = nullptr;
+        int num_leds = 0;
+        uint8_t brightness = 255;
+
+    public:
+
+        template<ESPIChipsets CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+        CFastLED& addLeds(CRGB* data, int n) {
+            this->leds = data;
+            this->num_leds = n;
+            return *this;
+        }
+
+        void show() { this->show(this->brightness); }
+        void show(uint8_t scale);
+        void clearData() { if (this->leds) fill_solid(this->leds, this->num_leds, CRGB::Black); }
+        void clear(bool writeData = false) { this->clearData(); if (writeData) this->show(); }
+        void setBrightness(uint8_t scale) { this->brightness = scale; }
+        uint8_t getBrightness() const { return this->brightness; }
+        const CRGB* getLeds() const { return this->leds; }
+        int size() const { return this->num_leds; }
+};
+
+extern CFastLED FastLED;
+
+#endif /* EFSIM_FASTLED_H_ */
@@ -0,0 +1,58 @@
+#ifndef EFSIM_PREFERENCES_H_
+#define EFSIM_PREFERENCES_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for the NVS backed Preferences library. All namespaces are
+ * kept in memory and can be loaded from / saved to a file by EFSim.
+ */
+
+#include <Arduino.h>
+
+class Preferences {
+
+    protected:
+
+        std::string ns;
+        bool readonly = true;
+        bool opened = false;
+
+    public:
+
+        bool begin(const char* name, bool readOnly = false);
+        void end();
+        bool clear();
+        bool remove(const char* key);
+        bool isKey(const char* key);
+
+        size_t putUInt(const char* key, uint32_t value);
+        uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+        size_t putString(const char* key, const String& value);
+        String getString(const char* key, const String& defaultValue = String());
+        size_t putBytes(const char* key, const void* value, size_t len);
+        size_t getBytesLength(const char* key);
+        size_t getBytes(const char* key, void* buf, size_t maxLen);
+};
+
+#endif /* EFSIM_PREFERENCES_H_ */
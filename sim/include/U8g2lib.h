@@ -0,0 +1,64 @@
+#ifndef EFSIM_U8G2LIB_H_
+#define EFSIM_U8G2LIB_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for the U8g2 OLED driver. Drawing calls are discarded.
+ */
+
+#include <Arduino.h>
+
+typedef const void* u8g2_cb_t_ptr;
+#define U8G2_R0 nullptr
+#define U8G2_R3 nullptr
+#define U8X8_PIN_NONE 255
+
+extern const uint8_t u8g2_font_5x8_tr[];
+
+class U8G2 {
+
+    public:
+
+        bool begin() { return true; }
+        void setDisplayRotation(const void* rotation) {}
+        void setFont(const uint8_t* font) {}
+        void clearBuffer() {}
+        void sendBuffer() {}
+        void drawStr(int x, int y, const char* s) {}
+        void drawPixel(int x, int y) {}
+        void drawLine(int x0, int y0, int x1, int y1) {}
+        void drawHLine(int x, int y, int w) {}
+        int getStrWidth(const char* s) { return 5 * strlen(s); }
+        int getMaxCharHeight() { return 8; }
+        void setPowerSave(uint8_t is_enable) {}
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_4W_HW_SPI : public U8G2 {
+
+    public:
+
+        U8G2_SSD1306_128X64_NONAME_F_4W_HW_SPI(const void* rotation, uint8_t cs, uint8_t dc, uint8_t reset = U8X8_PIN_NONE) {}
+};
+
+#endif /* EFSIM_U8G2LIB_H_ */
@@ -0,0 +1,66 @@
+#ifndef EFSIM_WIFI_H_
+#define EFSIM_WIFI_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for the Arduino-ESP32 WiFi library. The radio is never
+ * available, connection attempts fail.
+ */
+
+#include <Arduino.h>
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef wifi_mode_t WiFiMode_t;
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 } wl_status_t;
+
+class IPAddress {
+
+    public:
+
+        String toString() const { return "0.0.0.0"; }
+};
+
+class WiFiClass {
+
+    protected:
+
+        wifi_mode_t current_mode = WIFI_OFF;
+
+    public:
+
+        bool mode(wifi_mode_t m) { this->current_mode = m; return true; }
+        wifi_mode_t getMode() const { return this->current_mode; }
+        wl_status_t begin(const char* ssid, const char* passphrase = nullptr) { this->current_mode = WIFI_STA; return WL_CONNECT_FAILED; }
+        wl_status_t status() const { return WL_CONNECT_FAILED; }
+        bool disconnect(bool wifioff = false, bool eraseap = false) { if (wifioff) this->current_mode = WIFI_OFF; return true; }
+        bool enableSTA(bool enable) { this->current_mode = enable ? WIFI_STA : WIFI_OFF; return true; }
+        bool setSleep(bool enable) { return true; }
+        IPAddress localIP() const { return IPAddress(); }
+        uint8_t* macAddress(uint8_t* mac) const { const uint8_t fake[6] = {0x02, 0xEF, 0x28, 0x00, 0x51, 0x4D}; memcpy(mac, fake, 6); return mac; }
+        String macAddress() const { return "02:EF:28:00:51:4D"; }
+};
+
+extern WiFiClass WiFi;
+
+#endif /* EFSIM_WIFI_H_ */
@@ -0,0 +1,95 @@
+#ifndef EFSIM_PAINLESSMESH_H_
+#define EFSIM_PAINLESSMESH_H_
+
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host shim for painlessMesh and TaskScheduler. The mesh never finds
+ * other nodes, scheduled tasks are executed by Scheduler::execute().
+ */
+
+#include <functional>
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define TASK_MILLISECOND 1UL
+#define TASK_SECOND      1000UL
+#define TASK_FOREVER     (-1)
+
+#define ERROR      (1 << 0)
+#define STARTUP    (1 << 1)
+#define CONNECTION (1 << 4)
+
+class Task {
+
+    public:
+
+        unsigned long interval;
+        long iterations;
+        void (*callback)();
+        bool enabled = false;
+        unsigned long last_run = 0;
+        Task* next = nullptr;       //!< Next task in the scheduler chain
+
+        Task(unsigned long aInterval, long aIterations, void (*aCallback)())
+        : interval(aInterval), iterations(aIterations), callback(aCallback) {}
+
+        void enable() { this->enabled = true; this->last_run = millis(); }
+        void disable() { this->enabled = false; }
+        bool isEnabled() const { return this->enabled; }
+};
+
+class Scheduler {
+
+    protected:
+
+        Task* first = nullptr;      //!< Intrusive task chain, as in TaskScheduler. Never allocates.
+
+    public:
+
+        void addTask(Task& task);
+        void deleteTask(Task& task);
+        bool execute();
+};
+
+class painlessMesh {
+
+    protected:
+
+        Scheduler* scheduler = nullptr;
+
+    public:
+
+        void setDebugMsgTypes(uint16_t types) {}
+        void init(String ssid, String password, Scheduler* baseScheduler, uint16_t port = 5555, WiFiMode_t connectMode = WIFI_AP_STA, uint8_t channel = 1, uint8_t hidden = 0, uint8_t maxconn = 4);
+        void stop();
+        void update();
+        bool sendBroadcast(String msg, bool includeSelf = false) { return true; }
+        void onReceive(void (*cb)(uint32_t from, String& msg)) {}
+        void onNewConnection(void (*cb)(uint32_t nodeId)) {}
+        void onChangedConnections(void (*cb)()) {}
+        void onNodeTimeAdjusted(void (*cb)(int32_t offset)) {}
+};
+
+#endif /* EFSIM_PAINLESSMESH_H_ */
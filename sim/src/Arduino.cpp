@@ -0,0 +1,273 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host implementation of the Arduino-ESP32 core shim. Everything time
+ * or I/O related is routed through EFSim.
+ */
+
+#include <random>
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <WiFi.h>
+#include <esp_system.h>
+
+#include "EFSim.h"
+
+HWCDC USBSerial;
+HWCDC Serial;
+EspClass ESP;
+
+static std::mt19937 rng(0);
+static uint32_t cpu_freq_mhz = 240;
+static uint32_t min_free_heap = EFSIM_HEAP_SIZE;
+
+// ---------- Time ----------
+
+unsigned long millis() {
+    return EFSim.now() / 1000;
+}
+
+unsigned long micros() {
+    return EFSim.now();
+}
+
+void delay(uint32_t ms) {
+    EFSim.advance((uint64_t) ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    EFSim.advance(us);
+}
+
+void yield() {}
+
+// ---------- GPIO / ADC / Touch ----------
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t val) {}
+int digitalRead(uint8_t pin) { return LOW; }
+
+uint16_t analogRead(uint8_t pin) {
+    // 12 bit ADC, full scale as assumed by EFBoard
+    return std::min<uint32_t>(EFSim.readMilliVolts(pin) * 4095 / 3500, 4095);
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin) {
+    return EFSim.readMilliVolts(pin);
+}
+
+void analogReadResolution(uint8_t bits) {}
+
+touch_value_t touchRead(uint8_t pin) {
+    return EFSim.touchRead(pin);
+}
+
+void touchAttachInterrupt(uint8_t pin, void (*userFunc)(void), touch_value_t threshold) {
+    EFSim.attachTouchInterrupt(pin, userFunc, threshold);
+}
+
+void touchDetachInterrupt(uint8_t pin) {
+    EFSim.detachTouchInterrupt(pin);
+}
+
+bool touchInterruptGetLastStatus(uint8_t pin) {
+    return EFSim.getTouchLastStatus(pin);
+}
+
+void touchSleepWakeUpEnable(uint8_t pin, touch_value_t threshold) {}
+
+void noInterrupts() {}
+void interrupts() {}
+
+// ---------- Misc ----------
+
+long random(long howbig) {
+    return howbig > 0 ? (long) (rng() % (uint32_t) howbig) : 0;
+}
+
+long random(long howsmall, long howbig) {
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+    // Keep runs reproducible: the badge seeds from a floating ADC pin, which
+    // reads a constant in the simulator anyway.
+    rng.seed(seed);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+uint32_t esp_random() {
+    return rng();
+}
+
+bool setCpuFrequencyMhz(uint32_t mhz) {
+    cpu_freq_mhz = mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return cpu_freq_mhz;
+}
+
+// ---------- Serial ----------
+
+int HWCDC::available() {
+    return EFSim.consoleAvailable();
+}
+
+int HWCDC::read() {
+    return EFSim.consoleRead();
+}
+
+size_t HWCDC::write(uint8_t c) {
+    return this->write(&c, 1);
+}
+
+size_t HWCDC::write(const uint8_t* buf, size_t len) {
+    if (EFSim.isVerbose()) {
+        fwrite(buf, 1, len, stderr);
+    }
+    return len;
+}
+
+size_t HWCDC::printf(const char* format, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return this->write((const uint8_t*) buf, std::min<size_t>(len, sizeof(buf) - 1));
+}
+
+// ---------- ESP-IDF / FreeRTOS ----------
+
+static uint64_t sleep_timer_us = 0;
+static bool sleep_touchpad = false;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return EFSim.getWakeupCause();
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+    sleep_timer_us = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_touchpad_wakeup() {
+    sleep_touchpad = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t source) {
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == ESP_SLEEP_WAKEUP_TIMER) {
+        sleep_timer_us = 0;
+    }
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == ESP_SLEEP_WAKEUP_TOUCHPAD) {
+        sleep_touchpad = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start() {
+    const uint64_t start = EFSim.now();
+    EFSim.sleep(sleep_timer_us);
+    EFSim.setWakeupCause((EFSim.now() - start < sleep_timer_us) ? ESP_SLEEP_WAKEUP_TOUCHPAD : ESP_SLEEP_WAKEUP_TIMER);
+    return ESP_OK;
+}
+
+void esp_deep_sleep_start() {
+    // Wakeup sources stay armed, so report what ends this deep sleep
+    fprintf(stderr, "[EFSim] Entered deep sleep, wakeup:");
+    if (sleep_timer_us) {
+        fprintf(stderr, " timer after %llu ms", (unsigned long long) (sleep_timer_us / 1000));
+    }
+    if (sleep_touchpad) {
+        fprintf(stderr, " touchpad");
+    }
+    if (!sleep_timer_us && !sleep_touchpad) {
+        fprintf(stderr, " none");
+    }
+    fprintf(stderr, "\n");
+    EFSim.finish();
+}
+
+BaseType_t xTaskCreatePinnedToCore(
+    void (*task)(void*), const char* name, uint32_t stack_depth, void* param,
+    unsigned int priority, TaskHandle_t* handle, int core_id
+) {
+    // There is no scheduler to run background tasks on. Callers must tolerate
+    // a task that never gets CPU time.
+    fprintf(stderr, "[EFSim] Task '%s' created but not scheduled\n", name);
+    if (handle) {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return pdPASS;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    // Only the radio stacks are modelled, they dominate the badges heap usage
+    uint32_t free_heap = EFSIM_HEAP_SIZE;
+    if (BLEDevice::getInitialized()) {
+        free_heap -= EFSIM_HEAP_BLE;
+    }
+    if (WiFi.getMode() != WIFI_OFF) {
+        free_heap -= EFSIM_HEAP_WIFI;
+    }
+    min_free_heap = std::min(min_free_heap, free_heap);
+    return free_heap;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    this->getFreeHeap();
+    return min_free_heap;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t) (EFSim.now() * cpu_freq_mhz);
+}
+
+void EspClass::restart() {
+    fprintf(stderr, "[EFSim] Restart requested\n");
+    EFSim.finish();
+}
@@ -0,0 +1,580 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cinttypes>
+#include <cstring>
+#include <ctime>
+
+#include <EFConfig.h>
+
+#include "EFSim.h"
+
+#define FNV1A_OFFSET 2166136261u
+#define FNV1A_PRIME  16777619u
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+static double wallSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const double wall_start = wallSeconds();
+
+// Bounds of the section RTC_DATA_ATTR places variables in, provided by the linker
+extern uint8_t __start_efsim_rtc[] __attribute__((weak));
+extern uint8_t __stop_efsim_rtc[] __attribute__((weak));
+
+EFSimClass::EFSimClass()
+: now_us(0)
+, end_us(UINT64_MAX)
+, finishing(false)
+, script_pos(0)
+, touch_edges(0)
+, touch_trace_interval_ms(0)
+, touch_trace_start_us(0)
+, touch_trace_pos(0)
+, touch_trace_running(false)
+, vbat(EFSIM_DEFAULT_VBAT)
+, verbose(false)
+, frames_file(nullptr)
+, frame_count(0)
+, frame_digest(FNV1A_OFFSET)
+, has_expected_digest(false)
+, expected_digest(0)
+, wakeup_cause(ESP_SLEEP_WAKEUP_UNDEFINED)
+, events_file(nullptr)
+, event_count(0)
+{
+    for (uint8_t i = 0; i < EFSIM_TOUCH_NUM_PINS; i++) {
+        this->touched[i] = false;
+        this->touch_last_status[i] = false;
+        this->touch_isr[i] = nullptr;
+        this->touch_threshold[i] = 0;
+        this->touch_benchmark[i] = 0;
+    }
+}
+
+static bool parseZone(const char* zone, std::vector<uint8_t>& pins) {
+    if (strcmp(zone, "fingerprint") == 0) {
+        pins = {EFTOUCH_PIN_TOUCH_FINGERPRINT};
+    } else if (strcmp(zone, "nose") == 0) {
+        pins = {EFTOUCH_PIN_TOUCH_NOSE};
+    } else if (strcmp(zone, "all") == 0) {
+        pins = {EFTOUCH_PIN_TOUCH_FINGERPRINT, EFTOUCH_PIN_TOUCH_NOSE};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool EFSimClass::loadScript(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "[EFSim] Cannot open script: %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    unsigned int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        unsigned long long at_ms;
+        char cmd[16];
+        int consumed = 0;
+        if (line[strspn(line, " \t")] == '#' || line[strspn(line, " \t")] == '\0') {
+            continue;
+        }
+        if (sscanf(line, "%llu %15s %n", &at_ms, cmd, &consumed) < 2) {
+            fprintf(stderr, "[EFSim] %s:%u: Expected '<time_ms> <command>'\n", path, lineno);
+            fclose(f);
+            return false;
+        }
+        const char* args = line + consumed;
+        const uint64_t at_us = at_ms * 1000;
+
+        bool ok = true;
+        if (strcmp(cmd, "touch") == 0 || strcmp(cmd, "release") == 0 || strcmp(cmd, "tap") == 0) {
+            char zone[16];
+            unsigned long duration_ms = 0;
+            std::vector<uint8_t> pins;
+            int n = sscanf(args, "%15s %lu", zone, &duration_ms);
+            ok = n >= 1 && parseZone(zone, pins) && (strcmp(cmd, "tap") != 0 || n == 2);
+            for (uint8_t pin : pins) {
+                if (strcmp(cmd, "release") != 0) {
+                    this->script.push_back({at_us, EFSimEventType::Touch, pin, 0.0f, ""});
+                }
+                if (strcmp(cmd, "touch") != 0) {
+                    const uint64_t release_us = (strcmp(cmd, "tap") == 0) ? at_us + duration_ms * 1000 : at_us;
+                    this->script.push_back({release_us, EFSimEventType::Release, pin, 0.0f, ""});
+                }
+            }
+        } else if (strcmp(cmd, "console") == 0) {
+            this->script.push_back({at_us, EFSimEventType::Console, 0, 0.0f, args});
+        } else if (strcmp(cmd, "vbat") == 0) {
+            float volts;
+            ok = sscanf(args, "%f", &volts) == 1;
+            this->script.push_back({at_us, EFSimEventType::Battery, 0, volts, ""});
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "[EFSim] %s:%u: Invalid command: %s\n", path, lineno, line);
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+
+    std::stable_sort(this->script.begin(), this->script.end(), [](const EFSimEvent& a, const EFSimEvent& b) {
+        return a.at_us < b.at_us;
+    });
+    return true;
+}
+
+bool EFSimClass::openFrames(const char* path) {
+    this->frames_file = fopen(path, "w");
+    if (!this->frames_file) {
+        fprintf(stderr, "[EFSim] Cannot open frame log: %s\n", path);
+        return false;
+    }
+    fprintf(this->frames_file, "# time_ms brightness hash rgb...\n");
+    return true;
+}
+
+bool EFSimClass::loadTouchTrace(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "[EFSim] Cannot open touch trace: %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + len);
+    }
+    fclose(f);
+
+    // Skip serial output surrounding the trace
+    EFTouchTraceReader reader;
+    size_t offset = 0;
+    for (; offset + 4 <= data.size(); offset++) {
+        if (memcmp(data.data() + offset, EFTOUCH_TRACE_MAGIC, 4) == 0 && reader.open(data.data() + offset, data.size() - offset)) {
+            break;
+        }
+    }
+    if (offset + 4 > data.size() || reader.getHeader().num_samples == 0) {
+        fprintf(stderr, "[EFSim] No intact touch trace found in: %s\n", path);
+        return false;
+    }
+
+    EFTouchSample sample;
+    this->touch_trace.clear();
+    while (reader.next(sample)) {
+        this->touch_trace.push_back(sample);
+    }
+    this->touch_trace_interval_ms = reader.getHeader().interval_ms;
+    this->touch_trace_pos = 0;
+    this->touch_benchmark[EFTOUCH_PIN_TOUCH_FINGERPRINT] = this->touch_trace[0].fingerprint;
+    this->touch_benchmark[EFTOUCH_PIN_TOUCH_NOSE] = this->touch_trace[0].nose;
+    printf(
+        "[EFSim] Loaded touch trace: %zu samples every %u ms, recorded at %lu ms\n",
+        this->touch_trace.size(),
+        this->touch_trace_interval_ms,
+        (unsigned long) reader.getHeader().start_ms
+    );
+    return true;
+}
+
+void EFSimClass::startTouchTrace() {
+    this->touch_trace_start_us = this->now_us;
+    this->touch_trace_running = !this->touch_trace.empty();
+}
+
+uint64_t EFSimClass::getTouchTraceDurationMs() const {
+    return (uint64_t) this->touch_trace.size() * this->touch_trace_interval_ms;
+}
+
+bool EFSimClass::openEvents(const char* path) {
+    this->events_file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!this->events_file) {
+        fprintf(stderr, "[EFSim] Cannot open event log: %s\n", path);
+        return false;
+    }
+    fprintf(this->events_file, "# time_ms event state\n");
+    return true;
+}
+
+bool EFSimClass::setNvsFile(const char* path) {
+    this->nvs_path = path;
+
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        // Missing file simply means empty NVS
+        return true;
+    }
+
+    char ns[64], key[64], hex[1024];
+    while (fscanf(f, "%63s %63s %1023s", ns, key, hex) == 3) {
+        std::vector<uint8_t> value;
+        for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+            unsigned int byte;
+            sscanf(hex + i, "%2x", &byte);
+            value.push_back(byte);
+        }
+        this->nvs[ns][key] = value;
+    }
+    fclose(f);
+    return true;
+}
+
+bool EFSimClass::setRtcFile(const char* path) {
+    this->rtc_path = path;
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        // Missing file means RTC memory was never retained, i.e., power on
+        return true;
+    }
+
+    const size_t size = __stop_efsim_rtc - __start_efsim_rtc;
+    std::vector<uint8_t> data(size + 1);
+    const size_t len = fread(data.data(), 1, data.size(), f);
+    fclose(f);
+    if (len != size) {
+        // Layout changed since the file was written, which a real badge would not survive either
+        fprintf(stderr, "[EFSim] Ignoring RTC file of %zu bytes, expected %zu: %s\n", len, size, path);
+        return true;
+    }
+    memcpy(__start_efsim_rtc, data.data(), size);
+    return true;
+}
+
+void EFSimClass::setWakeupCause(esp_sleep_wakeup_cause_t cause) {
+    this->wakeup_cause = cause;
+}
+
+esp_sleep_wakeup_cause_t EFSimClass::getWakeupCause() const {
+    return this->wakeup_cause;
+}
+
+void EFSimClass::expectDigest(uint32_t digest) {
+    this->has_expected_digest = true;
+    this->expected_digest = digest;
+}
+
+void EFSimClass::setVerbose(bool verbose) {
+    this->verbose = verbose;
+}
+
+void EFSimClass::setEnd(uint64_t end_ms) {
+    this->end_us = end_ms * 1000;
+}
+
+bool EFSimClass::isVerbose() const {
+    return this->verbose;
+}
+
+uint64_t EFSimClass::now() const {
+    return this->now_us;
+}
+
+uint64_t EFSimClass::getNextTraceUs() const {
+    if (!this->touch_trace_running || this->touch_trace_pos >= this->touch_trace.size()) {
+        return UINT64_MAX;
+    }
+    return this->touch_trace_start_us + (uint64_t) this->touch_trace_pos * this->touch_trace_interval_ms * 1000;
+}
+
+void EFSimClass::applyTraceSample() {
+    const EFTouchSample& sample = this->touch_trace[this->touch_trace_pos++];
+    this->applyTraceReading(EFTOUCH_PIN_TOUCH_FINGERPRINT, sample.fingerprint);
+    this->applyTraceReading(EFTOUCH_PIN_TOUCH_NOSE, sample.nose);
+}
+
+void EFSimClass::applyTraceReading(uint8_t pin, uint32_t reading) {
+    uint32_t& benchmark = this->touch_benchmark[pin];
+    const uint32_t delta = reading > benchmark ? reading - benchmark : 0;
+
+    if (!this->touched[pin]) {
+        if (this->touch_isr[pin] != nullptr && delta > this->touch_threshold[pin]) {
+            this->setTouched(pin, true);
+        } else {
+            benchmark += static_cast<int32_t>(reading - benchmark) >> EFSIM_TOUCH_BENCHMARK_SHIFT;
+        }
+    } else if (delta <= this->touch_threshold[pin]) {
+        this->setTouched(pin, false);
+    }
+}
+
+void EFSimClass::dispatchScript(uint64_t until_us) {
+    while (true) {
+        const uint64_t trace_us = this->getNextTraceUs();
+        const bool has_script = this->script_pos < this->script.size() && this->script[this->script_pos].at_us <= until_us;
+        if (trace_us <= until_us && (!has_script || trace_us < this->script[this->script_pos].at_us)) {
+            this->now_us = std::max(this->now_us, trace_us);
+            this->applyTraceSample();
+            continue;
+        }
+        if (!has_script) {
+            break;
+        }
+
+        // Copy, the event may be processed while another one is appended
+        const EFSimEvent ev = this->script[this->script_pos++];
+        this->now_us = std::max(this->now_us, ev.at_us);
+
+        switch (ev.type) {
+            case EFSimEventType::Touch:
+                this->setTouched(ev.pin, true);
+                break;
+            case EFSimEventType::Release:
+                this->setTouched(ev.pin, false);
+                break;
+            case EFSimEventType::Console:
+                this->console_rx += ev.text;
+                this->console_rx += '\n';
+                break;
+            case EFSimEventType::Battery:
+                this->vbat = ev.value;
+                break;
+        }
+    }
+}
+
+void EFSimClass::advance(uint64_t us) {
+    uint64_t target = this->now_us + us;
+    if (target > this->end_us) {
+        target = this->end_us;
+    }
+
+    this->dispatchScript(target);
+    this->now_us = target;
+
+    if (this->now_us >= this->end_us) {
+        this->finish();
+    }
+}
+
+void EFSimClass::sleep(uint64_t us) {
+    uint64_t wakeup_us = this->now_us + us;
+    for (size_t i = this->script_pos; i < this->script.size(); i++) {
+        if (this->script[i].type == EFSimEventType::Touch) {
+            wakeup_us = std::min(wakeup_us, this->script[i].at_us);
+            break;
+        }
+    }
+
+    // A replayed touch trace wakes up at the first sample causing an edge
+    const uint64_t edges = this->touch_edges;
+    while (this->touch_edges == edges && this->getNextTraceUs() < wakeup_us) {
+        this->advance(this->getNextTraceUs() - this->now_us);
+    }
+    if (this->touch_edges == edges) {
+        this->advance(wakeup_us - this->now_us);
+    }
+}
+
+void EFSimClass::setTouched(uint8_t pin, bool is_touched) {
+    if (pin >= EFSIM_TOUCH_NUM_PINS || this->touched[pin] == is_touched) {
+        return;
+    }
+
+    this->touched[pin] = is_touched;
+    this->touch_last_status[pin] = is_touched;
+    this->touch_edges++;
+    if (this->touch_isr[pin] != nullptr) {
+        this->touch_isr[pin]();
+    }
+}
+
+touch_value_t EFSimClass::touchRead(uint8_t pin) const {
+    if (pin >= EFSIM_TOUCH_NUM_PINS) {
+        return 0;
+    }
+    if (!this->touch_trace.empty() && (pin == EFTOUCH_PIN_TOUCH_FINGERPRINT || pin == EFTOUCH_PIN_TOUCH_NOSE)) {
+        // Most recently applied sample, the first one until the replay starts
+        const EFTouchSample& sample = this->touch_trace[this->touch_trace_pos > 0 ? this->touch_trace_pos - 1 : 0];
+        return pin == EFTOUCH_PIN_TOUCH_FINGERPRINT ? sample.fingerprint : sample.nose;
+    }
+    return EFSIM_TOUCH_NOISE_FLOOR + (this->touched[pin] ? EFSIM_TOUCH_DELTA : 0);
+}
+
+void EFSimClass::attachTouchInterrupt(uint8_t pin, void (*isr)(void), touch_value_t threshold) {
+    if (pin < EFSIM_TOUCH_NUM_PINS) {
+        this->touch_isr[pin] = isr;
+        this->touch_threshold[pin] = threshold;
+    }
+}
+
+void EFSimClass::detachTouchInterrupt(uint8_t pin) {
+    if (pin < EFSIM_TOUCH_NUM_PINS) {
+        this->touch_isr[pin] = nullptr;
+    }
+}
+
+bool EFSimClass::getTouchLastStatus(uint8_t pin) const {
+    return pin < EFSIM_TOUCH_NUM_PINS && this->touch_last_status[pin];
+}
+
+uint32_t EFSimClass::readMilliVolts(uint8_t pin) const {
+    if (pin != EFBOARD_PIN_VBAT) {
+        return 0;
+    }
+    // Voltage divider on the badge: 100k / 51.1k
+    return (uint32_t) (this->vbat * 1000.0f * 100.0f / 151.1f);
+}
+
+int EFSimClass::consoleAvailable() const {
+    return this->console_rx.size();
+}
+
+int EFSimClass::consoleRead() {
+    if (this->console_rx.empty()) {
+        return -1;
+    }
+    const char c = this->console_rx.front();
+    this->console_rx.erase(0, 1);
+    return c;
+}
+
+std::map<std::string, std::vector<uint8_t>>& EFSimClass::getNvsNamespace(const std::string& name) {
+    return this->nvs[name];
+}
+
+void EFSimClass::recordFrame(const CRGB* leds, int num_leds, uint8_t brightness) {
+    uint32_t hash = fnv1a(FNV1A_OFFSET, &brightness, 1);
+    for (int i = 0; i < num_leds; i++) {
+        hash = fnv1a(hash, leds[i].raw, 3);
+    }
+
+    const uint64_t now_ms = this->now_us / 1000;
+    this->frame_digest = fnv1a(this->frame_digest, &now_ms, sizeof(now_ms));
+    this->frame_digest = fnv1a(this->frame_digest, &hash, sizeof(hash));
+    this->frame_count++;
+
+    if (this->frames_file) {
+        fprintf(this->frames_file, "%" PRIu64 " %u %08x", now_ms, brightness, hash);
+        for (int i = 0; i < num_leds; i++) {
+            fprintf(this->frames_file, " %02x%02x%02x", leds[i].r, leds[i].g, leds[i].b);
+        }
+        fputc('\n', this->frames_file);
+    }
+}
+
+void EFSimClass::recordEvent(const char* event, const char* state) {
+    this->event_count++;
+    if (this->events_file) {
+        fprintf(this->events_file, "%" PRIu64 " %s %s\n", this->now_us / 1000, event, state);
+    }
+}
+
+void EFSimClass::accountLoop(const char* state, uint64_t cpu_ns, uint64_t virtual_us) {
+    EFSimStateStats& stats = this->state_stats[state];
+    stats.cpu_ns += cpu_ns;
+    stats.loops++;
+    stats.virtual_us += virtual_us;
+}
+
+void EFSimClass::finish(int exitcode) {
+    if (this->finishing) {
+        // finish() must not recurse when firmware code runs during shutdown
+        fflush(nullptr);
+        _Exit(exitcode);
+    }
+    this->finishing = true;
+
+    if (this->frames_file) {
+        fclose(this->frames_file);
+        this->frames_file = nullptr;
+    }
+    if (this->events_file && this->events_file != stdout) {
+        fclose(this->events_file);
+    }
+    this->events_file = nullptr;
+
+    if (!this->nvs_path.empty()) {
+        FILE* f = fopen(this->nvs_path.c_str(), "w");
+        if (f) {
+            for (const auto& ns : this->nvs) {
+                for (const auto& kv : ns.second) {
+                    fprintf(f, "%s %s ", ns.first.c_str(), kv.first.c_str());
+                    for (uint8_t byte : kv.second) {
+                        fprintf(f, "%02x", byte);
+                    }
+                    fputc('\n', f);
+                }
+            }
+            fclose(f);
+        } else {
+            fprintf(stderr, "[EFSim] Cannot write NVS file: %s\n", this->nvs_path.c_str());
+        }
+    }
+    if (!this->rtc_path.empty()) {
+        FILE* f = fopen(this->rtc_path.c_str(), "wb");
+        if (f) {
+            fwrite(__start_efsim_rtc, 1, __stop_efsim_rtc - __start_efsim_rtc, f);
+            fclose(f);
+        } else {
+            fprintf(stderr, "[EFSim] Cannot write RTC file: %s\n", this->rtc_path.c_str());
+        }
+    }
+
+    const double simulated_s = this->now_us / 1e6;
+    const double wall_s = wallSeconds() - wall_start;
+    printf("[EFSim] Simulated %.3f s in %.3f s wall time (%.0fx)\n", simulated_s, wall_s, wall_s > 0 ? simulated_s / wall_s : 0.0);
+    printf("[EFSim] Frames: %" PRIu64 ", digest: %08x\n", this->frame_count, this->frame_digest);
+    printf("[EFSim] Events: %" PRIu64 "\n", this->event_count);
+    printf("[EFSim] CPU time per state:\n");
+    for (const auto& entry : this->state_stats) {
+        printf(
+            "[EFSim]   %-24s %10.3f ms CPU %10" PRIu64 " loops %10.3f s active\n",
+            entry.first.c_str(),
+            entry.second.cpu_ns / 1e6,
+            entry.second.loops,
+            entry.second.virtual_us / 1e6
+        );
+    }
+
+    if (this->has_expected_digest && this->expected_digest != this->frame_digest) {
+        printf("[EFSim] Digest mismatch! Expected %08x\n", this->expected_digest);
+        exitcode = exitcode ? exitcode : 2;
+    }
+
+    // Skip static destructors, firmware globals are not meant to be torn down
+    fflush(nullptr);
+    _Exit(exitcode);
+}
+
+EFSimClass EFSim;
@@ -0,0 +1,184 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Entry point of the native badge simulator. Runs the unmodified
+ * setup() / loop() from src/main.cpp under the EFSim virtual clock.
+ *
+ * Usage: badge-sim [options]
+ *   --script <file>   Scripted input, see EFSimClass::loadScript()
+ *   --until <ms>      Virtual time at which the simulation ends (default: 60000,
+ *                     or shortly after the end of a touch trace)
+ *   --touch-trace <file>
+ *                     Replay raw touch readings recorded by GET TOUCHTRACE,
+ *                     starting right after setup()
+ *   --frames <file>   Write every LED frame to the given file
+ *   --events <file>   Write every event handled by the FSM to the given file,
+ *                     "-" for stdout
+ *   --nvs <file>      Load NVS contents from and persist them back to the given file
+ *   --rtc <file>      Load RTC memory from and persist it back to the given file
+ *   --wakeup <touchpad|timer>
+ *                     Boot as if woken up from deep sleep by the given source
+ *   --step <us>       Virtual time between two loop() iterations (default: 1000)
+ *   --expect <hex>    Exit with code 2 if the frame digest differs
+ *   --verbose         Forward serial output to stderr
+ *   --check-transitions
+ *                     After setup(), transition through all states and report
+ *                     the heap allocations of each transition. Exits with
+ *                     code 3 if any transition allocated.
+ */
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <FSM.h>
+
+#include "EFSim.h"
+
+extern FSM fsm;
+void setup();
+void loop();
+
+static uint64_t cpuNs() {
+    // The simulator is single threaded, so monotonic time equals CPU time closely
+    // enough while being a vDSO call instead of a syscall on Linux
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int checkTransitions() {
+    const uint8_t first = static_cast<uint8_t>(FSMStateId::None) + 1;
+    // DeepSleep only goes to sleep from run(), so entering it is safe
+    const uint8_t last = static_cast<uint8_t>(FSMStateId::DeepSleep);
+    int exitcode = 0;
+
+    // First pass lets states perform one-time lazy initialization
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (uint8_t id = first; id <= last; id++) {
+            const char* from = fsm.getStateName();
+            const uint64_t allocations_start = efsim_heap_allocations;
+            fsm.transition(static_cast<FSMStateId>(id));
+            const uint64_t allocations = efsim_heap_allocations - allocations_start;
+            if (pass == 0) {
+                continue;
+            }
+            printf("[EFSim] Transition %-18s -> %-18s %4" PRIu64 " allocation(s)\n", from, fsm.getStateName(), allocations);
+            if (allocations > 0) {
+                exitcode = 3;
+            }
+        }
+    }
+
+    return exitcode;
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "Usage: %s [--script <file>] [--until <ms>] [--touch-trace <file>] [--frames <file>]\n"
+        "          [--events <file>] [--nvs <file>] [--rtc <file>] [--wakeup <touchpad|timer>]\n"
+        "          [--step <us>] [--expect <hex>] [--verbose] [--check-transitions]\n",
+        argv0
+    );
+    exit(1);
+}
+
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char** argv) {
+    uint64_t until_ms = 60000;
+    uint64_t step_us = 1000;
+    bool has_until = false;
+    bool has_touch_trace = false;
+    bool check_transitions = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--script") == 0 && has_value) {
+            if (!EFSim.loadScript(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--until") == 0 && has_value) {
+            until_ms = strtoull(argv[++i], nullptr, 10);
+            has_until = true;
+        } else if (strcmp(argv[i], "--touch-trace") == 0 && has_value) {
+            if (!EFSim.loadTouchTrace(argv[++i])) return 1;
+            has_touch_trace = true;
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            if (!EFSim.openFrames(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--events") == 0 && has_value) {
+            if (!EFSim.openEvents(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--nvs") == 0 && has_value) {
+            if (!EFSim.setNvsFile(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--rtc") == 0 && has_value) {
+            if (!EFSim.setRtcFile(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "--wakeup") == 0 && has_value) {
+            const char* source = argv[++i];
+            if (strcmp(source, "touchpad") == 0) {
+                EFSim.setWakeupCause(ESP_SLEEP_WAKEUP_TOUCHPAD);
+            } else if (strcmp(source, "timer") == 0) {
+                EFSim.setWakeupCause(ESP_SLEEP_WAKEUP_TIMER);
+            } else {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "--step") == 0 && has_value) {
+            step_us = std::max<uint64_t>(strtoull(argv[++i], nullptr, 10), 1);
+        } else if (strcmp(argv[i], "--expect") == 0 && has_value) {
+            EFSim.expectDigest(strtoul(argv[++i], nullptr, 16));
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            EFSim.setVerbose(true);
+        } else if (strcmp(argv[i], "--check-transitions") == 0) {
+            check_transitions = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    EFSim.setEnd(until_ms);
+
+    // Script events at 0 ms, e.g. the battery voltage, are seen from the very start of setup()
+    EFSim.advance(0);
+
+    uint64_t cpu_start = cpuNs();
+    setup();
+    EFSim.accountLoop("setup", cpuNs() - cpu_start, EFSim.now());
+
+    if (check_transitions) {
+        EFSim.finish(checkTransitions());
+    }
+
+    // Calibration during setup() saw the first sample, the replay starts now
+    EFSim.startTouchTrace();
+    if (has_touch_trace && !has_until) {
+        EFSim.setEnd(EFSim.now() / 1000 + EFSim.getTouchTraceDurationMs() + EFSIM_TOUCH_TRACE_TAIL_MS);
+    }
+
+    // Never returns: EFSim::advance() calls finish() once the end time is reached
+    while (true) {
+        const char* state = fsm.getStateName();
+        const uint64_t virtual_start = EFSim.now();
+        cpu_start = cpuNs();
+        loop();
+        EFSim.accountLoop(state, cpuNs() - cpu_start, EFSim.now() - virtual_start + step_us);
+        EFSim.advance(step_us);
+    }
+}
+#endif
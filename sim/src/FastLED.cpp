@@ -0,0 +1,170 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host implementation of the FastLED shim. Color math follows FastLED
+ * closely enough for visual inspection, but is not bit-exact.
+ */
+
+#include <FastLED.h>
+
+#include "EFSim.h"
+
+CFastLED FastLED;
+
+void CFastLED::show(uint8_t scale) {
+    EFSim.recordFrame(this->leds, this->num_leds, scale);
+}
+
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb) {
+    // Eight 32-step sections around the color wheel, yellow boosted like FastLED
+    const uint8_t hue = hsv.hue;
+    const uint8_t offset8 = (hue & 0x1F) << 3;
+    const uint8_t third = scale8(offset8, 85);
+    const uint8_t twothirds = scale8(offset8, 170);
+    uint8_t r, g, b;
+
+    switch (hue >> 5) {
+        case 0: r = 255 - third;     g = third;             b = 0;                 break;
+        case 1: r = 171;             g = 85 + third;        b = 0;                 break;
+        case 2: r = 171 - twothirds; g = 170 + third;       b = 0;                 break;
+        case 3: r = 0;               g = 255 - offset8;     b = offset8;           break;
+        case 4: r = 0;               g = 171 - twothirds;   b = 85 + twothirds;    break;
+        case 5: r = third;           g = 0;                 b = 255 - third;       break;
+        case 6: r = 85 + third;      g = 0;                 b = 171 - third;       break;
+        default: r = 170 + third;    g = 0;                 b = 85 - third;        break;
+    }
+
+    if (hsv.sat != 255) {
+        const uint8_t desat = 255 - hsv.sat;
+        const uint8_t brightness_floor = scale8(desat, desat);
+        r = scale8(r, hsv.sat) + brightness_floor;
+        g = scale8(g, hsv.sat) + brightness_floor;
+        b = scale8(b, hsv.sat) + brightness_floor;
+    }
+
+    if (hsv.val != 255) {
+        const uint8_t val = scale8(hsv.val, hsv.val);
+        r = scale8(r, val);
+        g = scale8(g, val);
+        b = scale8(b, val);
+    }
+
+    rgb = CRGB(r, g, b);
+}
+
+void fill_solid(CRGB* leds, int num_leds, const CRGB& color) {
+    for (int i = 0; i < num_leds; i++) {
+        leds[i] = color;
+    }
+}
+
+void fill_rainbow(CRGB* leds, int num_leds, uint8_t initialhue, uint8_t deltahue) {
+    CHSV hsv(initialhue, 240, 255);
+    for (int i = 0; i < num_leds; i++) {
+        leds[i] = hsv;
+        hsv.hue += deltahue;
+    }
+}
+
+void fill_rainbow_circular(CRGB* leds, int num_leds, uint8_t initialhue, bool reversed) {
+    if (num_leds == 0) {
+        return;
+    }
+    const uint16_t hueChange = 65535 / (uint16_t) num_leds;
+    uint16_t hueOffset = 0;
+    CHSV hsv(initialhue, 240, 255);
+    for (int i = 0; i < num_leds; i++) {
+        leds[i] = hsv;
+        hueOffset += hueChange;
+        hsv.hue = reversed ? initialhue - (uint8_t) (hueOffset >> 8) : initialhue + (uint8_t) (hueOffset >> 8);
+    }
+}
+
+void fadeLightBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy) {
+    for (uint16_t i = 0; i < num_leds; i++) {
+        leds[i].fadeLightBy(fadeBy);
+    }
+}
+
+void fadeToBlackBy(CRGB* leds, uint16_t num_leds, uint8_t fadeBy) {
+    for (uint16_t i = 0; i < num_leds; i++) {
+        leds[i].fadeToBlackBy(fadeBy);
+    }
+}
+
+static uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+    return ((uint16_t) a * (255 - amountOfB) + (uint16_t) b * amountOfB + 128) >> 8;
+}
+
+CRGB blend(const CRGB& p1, const CRGB& p2, uint8_t amountOfP2) {
+    return CRGB(blend8(p1.r, p2.r, amountOfP2), blend8(p1.g, p2.g, amountOfP2), blend8(p1.b, p2.b, amountOfP2));
+}
+
+CRGB* blend(const CRGB* src1, const CRGB* src2, CRGB* dest, uint16_t count, uint8_t amountOfsrc2) {
+    for (uint16_t i = 0; i < count; i++) {
+        dest[i] = blend(src1[i], src2[i], amountOfsrc2);
+    }
+    return dest;
+}
+
+/**
+ * @brief Hashes a lattice point to a pseudo random value
+ */
+static uint16_t latticeValue(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t h = x * 374761393u + y * 668265263u + z * 2147483647u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (h ^ (h >> 16)) & 0xFFFF;
+}
+
+static uint32_t smoothLerp(uint32_t a, uint32_t b, uint16_t frac) {
+    // Smoothstep on a 16 bit fraction
+    const uint64_t t = frac;
+    const uint64_t s = (t * t * (3 * 65536 - 2 * t)) >> 32;
+    return (a * (65536 - s) + b * s) >> 16;
+}
+
+uint16_t inoise16(uint32_t x, uint32_t y, uint32_t z) {
+    // Value noise on a 16.16 fixed point lattice
+    const uint32_t xi = x >> 16, yi = y >> 16, zi = z >> 16;
+    const uint16_t xf = x & 0xFFFF, yf = y & 0xFFFF, zf = z & 0xFFFF;
+
+    uint32_t plane[2];
+    for (uint8_t dz = 0; dz < 2; dz++) {
+        const uint32_t row0 = smoothLerp(latticeValue(xi, yi, zi + dz), latticeValue(xi + 1, yi, zi + dz), xf);
+        const uint32_t row1 = smoothLerp(latticeValue(xi, yi + 1, zi + dz), latticeValue(xi + 1, yi + 1, zi + dz), xf);
+        plane[dz] = smoothLerp(row0, row1, yf);
+    }
+    return smoothLerp(plane[0], plane[1], zf);
+}
+
+uint16_t inoise16(uint32_t x, uint32_t y) {
+    return inoise16(x, y, 0);
+}
+
+uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z) {
+    return inoise16((uint32_t) x << 8, (uint32_t) y << 8, (uint32_t) z << 8) >> 8;
+}
+
+uint8_t inoise8(uint16_t x, uint16_t y) {
+    return inoise8(x, y, 0);
+}
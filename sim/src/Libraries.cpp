@@ -0,0 +1,289 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Host implementations for the peripheral libraries used by the badge
+ * firmware (NVS, radios, display, crypto helpers).
+ */
+
+#include <ArduinoOTA.h>
+#include <BLEDevice.h>
+#include <Preferences.h>
+#include <SPI.h>
+#include <U8g2lib.h>
+#include <WiFi.h>
+#include <mbedtls/base64.h>
+#include <painlessMesh.h>
+
+#include "EFSim.h"
+
+WiFiClass WiFi;
+ArduinoOTAClass ArduinoOTA;
+SPIClass SPI;
+const uint8_t u8g2_font_5x8_tr[] = {0};
+
+// ---------- Preferences ----------
+
+/**
+ * @brief Excludes allocations of the emulated NVS from efsim_heap_allocations.
+ * On the badge, NVS lives in flash and does not use the firmware heap.
+ */
+class EFSimNvsAllocationScope {
+
+    protected:
+
+        uint64_t allocations;
+
+    public:
+
+        EFSimNvsAllocationScope() : allocations(efsim_heap_allocations) {}
+        ~EFSimNvsAllocationScope() { efsim_heap_allocations = this->allocations; }
+};
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    this->ns = name;
+    this->readonly = readOnly;
+    this->opened = true;
+    return true;
+}
+
+void Preferences::end() {
+    this->opened = false;
+}
+
+bool Preferences::clear() {
+    if (!this->opened || this->readonly) {
+        return false;
+    }
+    EFSimNvsAllocationScope scope;
+    EFSim.getNvsNamespace(this->ns).clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!this->opened || this->readonly) {
+        return false;
+    }
+    return EFSim.getNvsNamespace(this->ns).erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return this->opened && EFSim.getNvsNamespace(this->ns).count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!this->opened || this->readonly) {
+        return 0;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    EFSimNvsAllocationScope scope;
+    EFSim.getNvsNamespace(this->ns)[key].assign(bytes, bytes + len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!this->isKey(key)) {
+        return 0;
+    }
+    return EFSim.getNvsNamespace(this->ns)[key].size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    const size_t len = this->getBytesLength(key);
+    if (len == 0 || len > maxLen) {
+        return 0;
+    }
+    memcpy(buf, EFSim.getNvsNamespace(this->ns)[key].data(), len);
+    return len;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return this->putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value = defaultValue;
+    if (this->getBytesLength(key) == sizeof(value)) {
+        this->getBytes(key, &value, sizeof(value));
+    }
+    return value;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return this->putBytes(key, value.c_str(), value.length());
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    if (!this->isKey(key)) {
+        return defaultValue;
+    }
+    const std::vector<uint8_t>& value = EFSim.getNvsNamespace(this->ns)[key];
+    return String(std::string(value.begin(), value.end()));
+}
+
+// ---------- BLE ----------
+
+static bool ble_initialized = false;
+static BLEScan ble_scan;
+static BLEAdvertising ble_advertising;
+
+void BLEDevice::init(const std::string& deviceName) {
+    ble_initialized = true;
+}
+
+void BLEDevice::deinit(bool release_memory) {
+    ble_initialized = false;
+}
+
+bool BLEDevice::getInitialized() {
+    return ble_initialized;
+}
+
+BLEScan* BLEDevice::getScan() {
+    return &ble_scan;
+}
+
+BLEAdvertising* BLEDevice::getAdvertising() {
+    return &ble_advertising;
+}
+
+// ---------- painlessMesh ----------
+
+void Scheduler::addTask(Task& task) {
+    Task** link = &this->first;
+    while (*link != nullptr) {
+        if (*link == &task) {
+            return;
+        }
+        link = &(*link)->next;
+    }
+    task.next = nullptr;
+    *link = &task;
+}
+
+void Scheduler::deleteTask(Task& task) {
+    for (Task** link = &this->first; *link != nullptr; link = &(*link)->next) {
+        if (*link == &task) {
+            *link = task.next;
+            task.next = nullptr;
+            return;
+        }
+    }
+}
+
+bool Scheduler::execute() {
+    bool idle = true;
+    for (Task* task = this->first, *next = nullptr; task != nullptr; task = next) {
+        next = task->next;
+        if (!task->enabled || millis() - task->last_run < task->interval) {
+            continue;
+        }
+        task->last_run = millis();
+        task->callback();
+        idle = false;
+        if (task->iterations > 0 && --task->iterations == 0) {
+            task->enabled = false;
+        }
+    }
+    return idle;
+}
+
+void painlessMesh::init(String ssid, String password, Scheduler* baseScheduler, uint16_t port, WiFiMode_t connectMode, uint8_t channel, uint8_t hidden, uint8_t maxconn) {
+    this->scheduler = baseScheduler;
+    WiFi.mode(connectMode);
+}
+
+void painlessMesh::stop() {
+    // Like painlessMesh, only drop the connections. The WiFi mode is left to the owner.
+    this->scheduler = nullptr;
+    WiFi.disconnect();
+}
+
+void painlessMesh::update() {
+    if (this->scheduler) {
+        this->scheduler->execute();
+    }
+}
+
+// ---------- mbedtls base64 ----------
+
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+    const size_t needed = 4 * ((slen + 2) / 3) + 1;
+    if (dst == nullptr || dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+
+    size_t o = 0;
+    for (size_t i = 0; i < slen; i += 3) {
+        const uint32_t n = (src[i] << 16)
+            | ((i + 1 < slen ? src[i + 1] : 0) << 8)
+            | (i + 2 < slen ? src[i + 2] : 0);
+        dst[o++] = base64_alphabet[(n >> 18) & 0x3F];
+        dst[o++] = base64_alphabet[(n >> 12) & 0x3F];
+        dst[o++] = i + 1 < slen ? base64_alphabet[(n >> 6) & 0x3F] : '=';
+        dst[o++] = i + 2 < slen ? base64_alphabet[n & 0x3F] : '=';
+    }
+    dst[o] = '\0';
+    *olen = o;
+    return 0;
+}
+
+int mbedtls_base64_decode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+    // First pass validates the input and computes the output length
+    size_t symbols = 0;
+    size_t padding = 0;
+    for (size_t i = 0; i < slen; i++) {
+        if (src[i] == '=') {
+            padding++;
+        } else if (strchr(base64_alphabet, src[i]) && src[i] != '\0' && padding == 0) {
+            symbols++;
+        } else {
+            return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+        }
+    }
+    if ((symbols + padding) % 4 != 0 || padding > 2) {
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    }
+
+    const size_t needed = (symbols * 6) / 8;
+    if (dst == nullptr || dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+
+    uint32_t acc = 0;
+    uint8_t bits = 0;
+    size_t o = 0;
+    for (size_t i = 0; i < symbols; i++) {
+        acc = (acc << 6) | (strchr(base64_alphabet, src[i]) - base64_alphabet);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            dst[o++] = (acc >> bits) & 0xFF;
+        }
+    }
+    *olen = o;
+    return 0;
+}
@@ -24,57 +24,168 @@
  * @author Honigeintopf
  */
 
+#include <cstring>
+#include <new>
+
 #include <Arduino.h>
 #include <Preferences.h>
 
+#include <EFBoard.h>
 #include <EFLed.h>
 #include <EFLogging.h>
+#include <EFProfiler.h>
+#include <EFRadio.h>
+#include <EFTrace.h>
+
+#ifdef EFSIM
+#include <EFSim.h>
+#endif
 
 #include "FSM.h"
 
 Preferences pref;
 
+/**
+ * @brief Computes the CRC-32 (IEEE 802.3) of the given data
+ */
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Reads a field from the per-key NVS layout used before the globals blob
+ *
+ * @return True if the key existed
+ */
+template<typename T>
+static bool restoreLegacyField(const char* key, T& field) {
+    if (key == nullptr || !pref.isKey(key)) {
+        return false;
+    }
+    field = pref.getUInt(key, field);
+    return true;
+}
+
+/**
+ * @brief Value-initializes a state of type T inside the given storage
+ */
+template<typename T>
+static FSMState* emplaceState(void* mem) {
+    static_assert(sizeof(T) <= FSMStateArenaSlot::size, "State type missing from FSMStateArenaSlot");
+    static_assert(alignof(T) <= FSMStateArenaSlot::align, "State type missing from FSMStateArenaSlot");
+    return new (mem) T();
+}
+
 FSM::FSM(unsigned int tickrate_ms)
-: state(nullptr)
-, tickrate_ms(tickrate_ms)
-, state_last_run(0)
+: tickrate_ms(tickrate_ms)
+, state_run("state", 0, EFSchedulerPolicy::CatchUp)
+, state_slot(0)
+, state(nullptr)
+, state_id(FSMStateId::DisplayPrideFlag)
+, resume_id(FSMStateId::None)
+, resume_tick(0)
+, last_event_ms(0)
+, burst_len(0)
+, burst_pos(0)
+, longpressed_zones(0)
+, reported_overflows(0)
+, globals()
+, persisted{}
+, persisted_legacy(false)
+, persist_pending(false)
+, persist_deadline(0)
+, persist_latest(0)
+, persist_requests(0)
+, persist_writes(0)
 {
-    this->globals = std::make_shared<FSMGlobals>();
-    this->state = std::make_unique<DisplayPrideFlag>();
-    this->state->attachGlobals(this->globals);
+    this->state = this->create(FSMStateId::DisplayPrideFlag, this->state_slot);
+    this->state->attachGlobals(&this->globals);
 }
 
 FSM::~FSM() {
     this->state->exit();
+    this->state->~FSMState();
+}
+
+FSMState* FSM::create(FSMStateId id, uint8_t slot) {
+    void* mem = this->arena[slot];
+
+    switch (id) {
+        case FSMStateId::DisplayPrideFlag: return emplaceState<DisplayPrideFlag>(mem);
+        case FSMStateId::AnimateRainbow: return emplaceState<AnimateRainbow>(mem);
+        case FSMStateId::AnimateMatrix: return emplaceState<AnimateMatrix>(mem);
+        case FSMStateId::AnimateSnake: return emplaceState<AnimateSnake>(mem);
+        case FSMStateId::AnimateHeartbeat: return emplaceState<AnimateHeartbeat>(mem);
+        case FSMStateId::AnimatePerlin: return emplaceState<AnimatePerlin>(mem);
+        case FSMStateId::OTAUpdate: return emplaceState<OTAUpdate>(mem);
+        case FSMStateId::GameHuemesh: return emplaceState<GameHuemesh>(mem);
+        case FSMStateId::GameFoxHuntBle: return emplaceState<GameFoxHuntBle>(mem);
+        case FSMStateId::VUMeter: return emplaceState<VUMeter>(mem);
+        case FSMStateId::MenuMain: return emplaceState<MenuMain>(mem);
+        case FSMStateId::DeepSleep: return emplaceState<DeepSleep>(mem);
+        case FSMStateId::None:
+        default:
+            return nullptr;
+    }
 }
 
 void FSM::resume() {
     // Restore FSM data
     this->restoreGlobals();
 
+    // Expose state run() timing statistics
+    EFScheduler.add(this->state_run);
+
     // Restore LED brightness setting
-    EFLed.setBrightnessPercent(this->globals->ledBrightnessPercent);
-    
+    EFLed.setBrightnessPercent(this->globals.ledBrightnessPercent);
+    this->last_event_ms = millis();
+
+    // Continue where deep sleep interrupted the animation
+    uint8_t resume_state;
+    uint32_t resume_tick;
+    if (EFBoard.getResumePoint(resume_state, resume_tick)) {
+        const FSMStateId id = static_cast<FSMStateId>(resume_state);
+        if (id > FSMStateId::None && id < FSMStateId::DeepSleep) {
+            LOGF_INFO("(FSM) Resuming after deep sleep at tick %lu\r\n", (unsigned long) resume_tick);
+            this->transition(id);
+            this->state->setTick(resume_tick);
+            return;
+        }
+        LOGF_WARNING("(FSM) Ignoring invalid resume point: %d\r\n", resume_state);
+    }
+
     // Resume last remembered state
-    switch (this->globals->resumeStateIdx) {
-        case 0: this->transition(std::make_unique<DisplayPrideFlag>()); break;
-        case 1: this->transition(std::make_unique<AnimateRainbow>()); break;
-        case 2: this->transition(std::make_unique<AnimateMatrix>()); break;
-        case 3: this->transition(std::make_unique<AnimateSnake>()); break;
-        case 4: this->transition(std::make_unique<AnimateHeartbeat>()); break;
-        case 6: this->transition(std::make_unique<AnimatePerlin>()); break;
-		case 7: this->transition(std::make_unique<GameHuemesh>()); break;
-		case 8: this->transition(std::make_unique<VUMeter>()); break;
-        case 9: this->transition(std::make_unique<GameFoxHuntBle>()); break;
+    switch (this->globals.resumeStateIdx) {
+        case 0: this->transition(FSMStateId::DisplayPrideFlag); break;
+        case 1: this->transition(FSMStateId::AnimateRainbow); break;
+        case 2: this->transition(FSMStateId::AnimateMatrix); break;
+        case 3: this->transition(FSMStateId::AnimateSnake); break;
+        case 4: this->transition(FSMStateId::AnimateHeartbeat); break;
+        case 6: this->transition(FSMStateId::AnimatePerlin); break;
+		case 7: this->transition(FSMStateId::GameHuemesh); break;
+		case 8: this->transition(FSMStateId::VUMeter); break;
+        case 9: this->transition(FSMStateId::GameFoxHuntBle); break;
         default:
-            LOGF_WARNING("(FSM) Failed to resume to unknown state: %d\r\n", this->globals->resumeStateIdx);
-            this->transition(std::make_unique<DisplayPrideFlag>());
+            LOGF_WARNING("(FSM) Failed to resume to unknown state: %d\r\n", this->globals.resumeStateIdx);
+            this->transition(FSMStateId::DisplayPrideFlag);
             break;
 
     }
 }
 
-void FSM::transition(std::unique_ptr<FSMState> next) {
+void FSM::transition(FSMStateId id) {
+    EFPROFILER_SCOPE(this->state->getName(), EFProfilerSection::Transition);
+
+    // Construct next state in the unoccupied slot, the current one stays valid until exit
+    const uint8_t next_slot = this->state_slot ^ 1;
+    FSMState* next = this->create(id, next_slot);
     if (next == nullptr) {
         LOG_WARNING("(FSM) Failed to transition to null state. Aborting.");
         return;
@@ -82,62 +193,242 @@ void FSM::transition(std::unique_ptr<FSMState> next) {
 
     // State exit
     LOGF_INFO("(FSM) Transition %s -> %s\r\n", this->state->getName(), next->getName());
+    const uint32_t heap_before = ESP.getFreeHeap();
+    if (this->state->shouldBeRemembered()) {
+        this->resume_id = this->state_id;
+        this->resume_tick = this->state->getTick();
+    }
     this->state->exit();
 
     // Persist globals if state dirtied it or next state wants to be persisted
     if (next->shouldBeRemembered()) {
-        this->globals->resumeStateIdx = this->globals->menuMainPointerIdx;
+        this->globals.resumeStateIdx = this->globals.menuMainPointerIdx;
     }
     if (this->state->isGlobalsDirty() || next->shouldBeRemembered()) {
-        this->persistGlobals();
         this->state->resetGlobalsDirty();
+        this->schedulePersistGlobals(millis());
     }
 
     // Transition to next state
-    this->state = std::move(next);
-    this->state->attachGlobals(this->globals);
-    this->state_last_run = 0;
+    this->state->~FSMState();
+    this->state = next;
+    this->state_id = id;
+    this->state_slot = next_slot;
+    this->state->attachGlobals(&this->globals);
+    this->state_run.reset(millis());
     this->state->entry();
+    // After entry(), so radios acquired by the state raise the frequency floor
+    EFGovernor.setPerf(this->state->getPerfClass());
+
+    // RAM is lost during deep sleep, keep everything needed to resume
+    if (id == FSMStateId::DeepSleep) {
+        EFBoard.setResumePoint(static_cast<uint8_t>(this->resume_id), this->resume_tick);
+        this->persistGlobals();
+    }
+
+    // Report heap usage to spot states that keep resources after exit()
+    LOGF_INFO(
+        "(FSM) Free heap: %lu -> %lu bytes (min %lu)\r\n",
+        (unsigned long) heap_before,
+        (unsigned long) ESP.getFreeHeap(),
+        (unsigned long) ESP.getMinFreeHeap()
+    );
 }
 
 unsigned int FSM::getTickRateMs() {
     return this->tickrate_ms;
 }
 
+const char* FSM::getStateName() {
+    return this->state ? this->state->getName() : "None";
+}
+
 void FSM::queueEvent(FSMEvent event) {
-    FSMEvent test = std::move(event);
-    noInterrupts();
-    {
-        this->eventqueue.push(test);
-    }
-    interrupts();
+    this->queueEvent(event, micros());
+}
+
+void FSM::queueEvent(FSMEvent event, uint32_t timestamp_us) {
+    this->eventqueue.push({event, toZone(event), timestamp_us});
+}
+
+uint32_t FSM::getDroppedEventCount() {
+    return this->eventqueue.getOverflowCount();
 }
 
 unsigned int FSM::getQueueSize() {
-    unsigned int queuesize;
+    return this->eventqueue.size() + (this->burst_len - this->burst_pos);
+}
+
+uint32_t FSM::getTimeUntilNextDeadline(uint32_t now) {
+    if (this->getQueueSize() > 0 || EFLed.isEffectPlaying() || this->state->isGlobalsDirty()) {
+        return 0;
+    }
+    uint32_t next = this->state_run.getTimeUntilDue(now);
+    if (this->persist_pending) {
+        next = min(next, efschedulerIsReached(now, this->persist_deadline) ? 0 : this->persist_deadline - now);
+    }
+    return next;
+}
+
+static bool isTouchEvent(FSMEvent event) {
+    return event == FSMEvent::FingerprintTouch || event == FSMEvent::NoseTouch;
+}
+
+static bool isReleaseEvent(FSMEvent event) {
+    return event == FSMEvent::FingerprintRelease || event == FSMEvent::NoseRelease;
+}
+
+static bool isLongpressEvent(FSMEvent event) {
+    return event == FSMEvent::FingerprintLongpress || event == FSMEvent::NoseLongpress;
+}
+
+static bool isHoldEvent(FSMEvent event) {
+    return event == FSMEvent::FingerprintHold || event == FSMEvent::NoseHold;
+}
+
+static uint8_t zoneBit(EFTouchZone zone) {
+    return zone == EFTouchZone::All ? (1 << EFTouchZone::Fingerprint) | (1 << EFTouchZone::Nose) : 1 << zone;
+}
+
+bool FSM::resolveBurst() {
+    // EFTouch.poll() emits for a released zone, in this order:
+    //   [AllShortpress] [Shortpress] [AllLongpress] [Longpress] Release
+    // and for a zone held long enough, before it is released:
+    //   [AllLongpress] Longpress
+    uint32_t len = 0;
+    bool complete = false;
+    while (const FSMEventData* event = this->eventqueue.peek(len)) {
+        if (isTouchEvent(event->type) || isHoldEvent(event->type)) {
+            complete = true;
+            break;
+        }
+        len++;
+        if (isReleaseEvent(event->type) || isLongpressEvent(event->type)) {
+            complete = true;
+            break;
+        }
+    }
+    if (!complete && len < FSM_EVENT_QUEUE_CAPACITY) {
+        // Burst could still be in flight. Wait for it unless it went stale.
+        if (micros() - this->eventqueue.peek()->timestamp_us < FSM_EVENT_BURST_TIMEOUT_US) {
+            return false;
+        }
+    }
 
-    noInterrupts();
-    {
-        queuesize = this->eventqueue.size();
+    const FSMEventData* all_shortpress = nullptr;
+    const FSMEventData* all_longpress = nullptr;
+    const FSMEventData* shortpress = nullptr;
+    const FSMEventData* longpress = nullptr;
+    const FSMEventData* release = nullptr;
+    for (uint32_t i = 0; i < len; i++) {
+        const FSMEventData* event = this->eventqueue.peek(i);
+        switch (event->type) {
+            case FSMEvent::AllShortpress: all_shortpress = event; break;
+            case FSMEvent::AllLongpress: all_longpress = event; break;
+            case FSMEvent::FingerprintShortpress:
+            case FSMEvent::NoseShortpress: shortpress = event; break;
+            case FSMEvent::FingerprintLongpress:
+            case FSMEvent::NoseLongpress: longpress = event; break;
+            default: release = event; break;
+        }
     }
-    interrupts();
 
-    return queuesize;
+    // A multi-touch gesture or a longpress suppresses the less specific events
+    this->burst_len = 0;
+    this->burst_pos = 0;
+    if (all_longpress) {
+        this->burst[this->burst_len++] = *all_longpress;
+        this->longpressed_zones |= zoneBit(EFTouchZone::All);
+    } else if (longpress) {
+        if (all_shortpress) {
+            this->burst[this->burst_len++] = *all_shortpress;
+        }
+        this->burst[this->burst_len++] = *longpress;
+        this->longpressed_zones |= zoneBit(longpress->zone);
+    } else if (all_shortpress) {
+        this->burst[this->burst_len++] = *all_shortpress;
+    } else if (shortpress) {
+        this->burst[this->burst_len++] = *shortpress;
+    } else if (release && !(this->longpressed_zones & zoneBit(release->zone))) {
+        // A release that does not end a longpress is a tap
+        this->burst[this->burst_len++] = *release;
+    }
+    if (release) {
+        this->longpressed_zones &= ~zoneBit(release->zone);
+    }
+    this->eventqueue.discard(len);
+
+    return true;
 }
 
-FSMEvent FSM::dequeueEvent() {
-    FSMEvent event = FSMEvent::NoOp;
+FSMEventData FSM::dequeueEvent() {
+    FSMEventData event = {FSMEvent::NoOp, EFTouchZone::All, 0};
 
-    noInterrupts();
-    {
-        if (this->eventqueue.size() > 0) {
-            event = std::move(this->eventqueue.front());
-            this->eventqueue.pop();
+    while (this->burst_pos >= this->burst_len) {
+        const FSMEventData* next = this->eventqueue.peek();
+        if (next == nullptr) {
+            return event;
+        }
+        if (isTouchEvent(next->type) || isHoldEvent(next->type)) {
+            this->eventqueue.pop(event);
+            if (isTouchEvent(event.type)) {
+                this->longpressed_zones &= ~zoneBit(event.zone);
+            }
+            return event;
+        }
+        if (!this->resolveBurst()) {
+            return event;
         }
     }
-    interrupts();
 
-    return event;
+    return this->burst[this->burst_pos++];
+}
+
+FSMStateId FSM::propagateEvent(FSMEvent event) {
+    EFPROFILER_SCOPE(this->state->getName(), EFProfilerSection::Touch);
+
+    switch(event) {
+        case FSMEvent::FingerprintTouch:
+            LOGF_DEBUG("(FSM) Processing Event: FingerprintTouch@%s\r\n", this->state->getName());
+            return this->state->touchEventFingerprintTouch();
+        case FSMEvent::FingerprintRelease:
+            LOGF_DEBUG("(FSM) Processing Event: FingerprintRelease@%s\r\n", this->state->getName());
+            return this->state->touchEventFingerprintRelease();
+        case FSMEvent::FingerprintShortpress:
+            LOGF_DEBUG("(FSM) Processing Event: FingerprintShortpress@%s\r\n", this->state->getName());
+            return this->state->touchEventFingerprintShortpress();
+        case FSMEvent::FingerprintLongpress:
+            LOGF_DEBUG("(FSM) Processing Event: FingerprintLongpress@%s\r\n", this->state->getName());
+            return this->state->touchEventFingerprintLongpress();
+        case FSMEvent::NoseTouch:
+            LOGF_DEBUG("(FSM) Processing Event: NoseTouch@%s\r\n", this->state->getName());
+            return this->state->touchEventNoseTouch();
+        case FSMEvent::NoseRelease:
+            LOGF_DEBUG("(FSM) Processing Event: NoseRelease@%s\r\n", this->state->getName());
+            return this->state->touchEventNoseRelease();
+        case FSMEvent::NoseShortpress:
+            LOGF_DEBUG("(FSM) Processing Event: NoseShortpress@%s\r\n", this->state->getName());
+            return this->state->touchEventNoseShortpress();
+        case FSMEvent::NoseLongpress:
+            LOGF_DEBUG("(FSM) Processing Event: NoseLongpress@%s\r\n", this->state->getName());
+            return this->state->touchEventNoseLongpress();
+        // Holds repeat every EFTOUCH_HOLD_INTERVAL_MS and are not logged
+        case FSMEvent::FingerprintHold:
+            return this->state->touchEventFingerprintHold();
+        case FSMEvent::NoseHold:
+            return this->state->touchEventNoseHold();
+        case FSMEvent::AllShortpress:
+            LOGF_DEBUG("(FSM) Processing Event: AllShortpress@%s\r\n", this->state->getName());
+            return this->state->touchEventAllShortpress();
+        case FSMEvent::AllLongpress:
+            LOGF_DEBUG("(FSM) Processing Event: AllLongpress@%s\r\n", this->state->getName());
+            return this->state->touchEventAllLongpress();
+        case FSMEvent::NoOp:
+            return FSMStateId::None;
+        default:
+            LOGF_WARNING("(FSM) Failed to handle unknown event: %d\r\n", event);
+            return FSMStateId::None;
+    }
 }
 
 void FSM::handle() {
@@ -145,136 +436,205 @@ void FSM::handle() {
 }
 
 void FSM::handle(unsigned int num_events) {
-    // Handle dirtied FSM globals
+    // Report events lost due to a full queue
+    const uint32_t overflows = this->eventqueue.getOverflowCount();
+    if (overflows != this->reported_overflows) {
+        LOGF_WARNING("(FSM) Event queue full, dropped %lu event(s)\r\n", (unsigned long) (overflows - this->reported_overflows));
+        this->reported_overflows = overflows;
+    }
+
+    // Handle dirtied FSM globals. Writes are deferred to keep flash access off the hot path.
+    const uint32_t now = millis();
     if (this->state->isGlobalsDirty()) {
-        this->persistGlobals();
         this->state->resetGlobalsDirty();
+        this->schedulePersistGlobals(now);
+    }
+    if (this->persist_pending && efschedulerIsReached(now, this->persist_deadline)) {
+        this->persistGlobals();
     }
 
-    // Handle state run()
+    // Save the battery if nobody touched the badge for a long time. States
+    // holding a radio (e.g., games talking to other badges) are busy anyway.
     if (
-        this->state->getTickRateMs() == 0 ||
-        millis() >= this->state_last_run + this->state->getTickRateMs()
+        FSM_SLEEP_INACTIVITY_MS > 0 &&
+        this->state_id != FSMStateId::DeepSleep &&
+        EFBoard.getPowerState() != EFBoardPowerState::USB &&
+        now - this->last_event_ms >= FSM_SLEEP_INACTIVITY_MS &&
+        this->state->allowsInactivitySleep() &&
+        !EFRadio.isActive(EFRadioResource::BLE) &&
+        !EFRadio.isActive(EFRadioResource::WiFiSTA) &&
+        !EFRadio.isActive(EFRadioResource::WiFiAP)
     ) {
-        this->state_last_run = millis();
-        this->state->run();
+        LOG_INFO("(FSM) No touch for a long time. Going to sleep.");
+        this->transition(FSMStateId::DeepSleep);
     }
 
-    // Handle events
+    // Handle state run() and advance LED effects
+    this->state_run.setPeriod(this->state->getTickRateMs());
+    if (this->state_run.isDue(now) || EFLed.isEffectPlaying()) {
+        EFLed.beginFrame();
+        // Missed ticks are caught up within a single frame. States counting
+        // ticks keep their pace without causing a burst of LED updates.
+        for (uint8_t n = 0; n < EFSCHEDULER_MAX_CATCHUP && this->state_run.isDue(now); n++) {
+            this->state_run.begin(now);
+            EFPROFILER_SCOPE(this->state->getName(), EFProfilerSection::Run);
+            this->state->run();
+        }
+        EFLed.updateEffect();
+        EFLed.commitFrame();
+    }
+
+    // Handle events. Handlers and the entry() of the next state draw into
+    // a single frame, so each event results in at most one LED push.
+    EFLed.beginFrame();
     for (; num_events > 0; num_events--) {
-        FSMEvent event = this->dequeueEvent();
-        std::unique_ptr<FSMState> next = nullptr;
+        FSMEventData event = this->dequeueEvent();
+        if (event.type == FSMEvent::NoOp) {
+            break;
+        }
+        this->last_event_ms = millis();
+        const int16_t trace = EFTrace.begin(
+            static_cast<uint8_t>(event.type), static_cast<uint8_t>(event.zone), event.timestamp_us, micros()
+        );
+#ifdef EFSIM
+        // Lets the simulator report the event sequence, e.g., of a replayed touch trace
+        EFSim.recordEvent(toString(event.type), this->state->getName());
+#endif
 
         // Propagate event to current state
-        switch(event) {
-            case FSMEvent::FingerprintTouch:
-                LOGF_DEBUG("(FSM) Processing Event: FingerprintTouch@%s\r\n", this->state->getName());
-                next = this->state->touchEventFingerprintTouch();
-                break;
-            case FSMEvent::FingerprintRelease:
-                LOGF_DEBUG("(FSM) Processing Event: FingerprintRelease@%s\r\n", this->state->getName());
-                next = this->state->touchEventFingerprintRelease();
-                break;
-            case FSMEvent::FingerprintShortpress:
-                LOGF_DEBUG("(FSM) Processing Event: FingerprintShortpress@%s\r\n", this->state->getName());
-                next = this->state->touchEventFingerprintShortpress();
-                break;
-            case FSMEvent::FingerprintLongpress:
-                LOGF_DEBUG("(FSM) Processing Event: FingerprintLongpress@%s\r\n", this->state->getName());
-                next = this->state->touchEventFingerprintLongpress();
-                break;
-            case FSMEvent::NoseTouch:
-                LOGF_DEBUG("(FSM) Processing Event: NoseTouch@%s\r\n", this->state->getName());
-                next = this->state->touchEventNoseTouch();
-                break;
-            case FSMEvent::NoseRelease:
-                LOGF_DEBUG("(FSM) Processing Event: NoseRelease@%s\r\n", this->state->getName());
-                next = this->state->touchEventNoseRelease();
-                break;
-            case FSMEvent::NoseShortpress:
-                LOGF_DEBUG("(FSM) Processing Event: NoseShortpress@%s\r\n", this->state->getName());
-                next = this->state->touchEventNoseShortpress();
-                break;
-            case FSMEvent::NoseLongpress:
-                LOGF_DEBUG("(FSM) Processing Event: NoseLongpress@%s\r\n", this->state->getName());
-                next = this->state->touchEventNoseLongpress();
-                break;
-            case FSMEvent::AllShortpress:
-                LOGF_DEBUG("(FSM) Processing Event: AllShortpress@%s\r\n", this->state->getName());
-                next = this->state->touchEventAllShortpress();
-                break;
-            case FSMEvent::AllLongpress:
-                LOGF_DEBUG("(FSM) Processing Event: AllLongpress@%s\r\n", this->state->getName());
-                next = this->state->touchEventAllLongpress();
-                break;
-            case FSMEvent::NoOp:
-                return;
-            default:
-                LOGF_WARNING("(FSM) Failed to handle unknown event: %d\r\n", event);
-                return;
-        } 
+        const FSMStateId next = this->propagateEvent(event.type);
 
         // Handle state transition
-        if (next != nullptr) {
-            this->transition(move(next));
+        if (next != FSMStateId::None) {
+            this->transition(next);
         }
+        EFTrace.handled(trace, micros());
     }
+    EFLed.commitFrame();
 }
 
+void FSM::schedulePersistGlobals(uint32_t now) {
+    this->persist_requests++;
+    if (!this->persist_pending) {
+        this->persist_pending = true;
+        this->persist_latest = now + FSM_PERSIST_MAX_DELAY_MS;
+    }
+    this->persist_deadline = now + FSM_PERSIST_DELAY_MS;
+    if (efschedulerIsReached(this->persist_deadline, this->persist_latest)) {
+        this->persist_deadline = this->persist_latest;
+    }
+}
+
+void FSM::serializeGlobals(uint8_t* blob) {
+    uint8_t* pos = blob;
+    *pos++ = FSMGLOBALS_BLOB_VERSION;
+    *pos++ = FSMGLOBALS_PAYLOAD_SIZE;
+#define FSM_SERIALIZE_FIELD(type, name, value, legacy_key) \
+    memcpy(pos, &this->globals.name, sizeof(type)); \
+    pos += sizeof(type);
+    FSMGLOBALS_PERSISTED_FIELDS(FSM_SERIALIZE_FIELD)
+#undef FSM_SERIALIZE_FIELD
+    const uint32_t crc = crc32(blob, pos - blob);
+    memcpy(pos, &crc, sizeof(crc));
+}
+
+bool FSM::deserializeGlobals(const uint8_t* blob) {
+    uint32_t crc;
+    memcpy(&crc, blob + FSMGLOBALS_BLOB_SIZE - sizeof(crc), sizeof(crc));
+    if (blob[0] != FSMGLOBALS_BLOB_VERSION || blob[1] != FSMGLOBALS_PAYLOAD_SIZE) {
+        LOGF_WARNING("(FSM) Ignoring globals blob with version %d and length %d\r\n", blob[0], blob[1]);
+        return false;
+    }
+    if (crc != crc32(blob, FSMGLOBALS_BLOB_SIZE - sizeof(crc))) {
+        LOG_WARNING("(FSM) Ignoring globals blob with CRC mismatch");
+        return false;
+    }
+
+    const uint8_t* pos = blob + 2;
+#define FSM_DESERIALIZE_FIELD(type, name, value, legacy_key) \
+    memcpy(&this->globals.name, pos, sizeof(type)); \
+    pos += sizeof(type);
+    FSMGLOBALS_PERSISTED_FIELDS(FSM_DESERIALIZE_FIELD)
+#undef FSM_DESERIALIZE_FIELD
+    return true;
+}
+
+bool FSM::restoreLegacyGlobals() {
+    bool found = false;
+#define FSM_RESTORE_LEGACY_FIELD(type, name, value, legacy_key) \
+    found |= restoreLegacyField(legacy_key, this->globals.name);
+    FSMGLOBALS_PERSISTED_FIELDS(FSM_RESTORE_LEGACY_FIELD)
+#undef FSM_RESTORE_LEGACY_FIELD
+    return found;
+}
+
+#define FSM_LOG_FIELD(type, name, value, legacy_key) \
+    LOGF_DEBUG("(FSM)  -> " #name " = %d\r\n", this->globals.name);
+
 void FSM::persistGlobals() {
+    EFPROFILER_SCOPE(this->state->getName(), EFProfilerSection::Persist);
+    this->persist_pending = false;
+
+    uint8_t blob[FSMGLOBALS_BLOB_SIZE];
+    this->serializeGlobals(blob);
+    if (!this->persisted_legacy && memcmp(blob, this->persisted, sizeof(blob)) == 0) {
+        LOG_DEBUG("(FSM) FSM state data unchanged. Skipping NVS write.");
+        return;
+    }
+
     pref.begin(this->NVS_NAMESPACE, false);
     LOGF_INFO("(FSM) Persisting FSM state data to NVS area: %s\r\n", this->NVS_NAMESPACE);
-    pref.clear();
-    LOG_DEBUG("(FSM)  -> Clear storage area");
-    pref.putUInt("resumeStateIdx", this->globals->resumeStateIdx);
-    LOGF_DEBUG("(FSM)  -> resumeStateIdx = %d\r\n", this->globals->resumeStateIdx);
-    pref.putUInt("menuIdx", this->globals->menuMainPointerIdx);
-    LOGF_DEBUG("(FSM)  -> menuIdx = %d\r\n", this->globals->menuMainPointerIdx);
-    pref.putUInt("prideFlagMode", this->globals->prideFlagModeIdx);
-    LOGF_DEBUG("(FSM)  -> prideFlagMode = %d\r\n", this->globals->prideFlagModeIdx);
-    pref.putUInt("animRainbow", this->globals->animRainbowIdx);
-    LOGF_DEBUG("(FSM)  -> animRainbow = %d\r\n", this->globals->animRainbowIdx);
-    pref.putUInt("animSnakeIdx", this->globals->animSnakeAnimationIdx);
-    LOGF_DEBUG("(FSM)  -> animSnakeIdx = %d\r\n", this->globals->animSnakeAnimationIdx);
-    pref.putUInt("animSnakeHueIdx", this->globals->animSnakeHueIdx);
-    LOGF_DEBUG("(FSM)  -> animSnakeHueIdx = %d\r\n", this->globals->animSnakeHueIdx);
-    pref.putUInt("animHbHue", this->globals->animHeartbeatHue);
-    LOGF_DEBUG("(FSM)  -> animHbHue = %d\r\n", this->globals->animHeartbeatHue);
-    pref.putUInt("animHbSpeed", this->globals->animHeartbeatSpeed);
-    LOGF_DEBUG("(FSM)  -> animHbSpeed = %d\r\n", this->globals->animHeartbeatSpeed);
-    pref.putUInt("animMatrixIdx", this->globals->animMatrixIdx);
-    LOGF_DEBUG("(FSM)  -> animMatrixIdx = %d\r\n", this->globals->animMatrixIdx);
-    pref.putUInt("ledBrightPcent", this->globals->ledBrightnessPercent);
-    LOGF_DEBUG("(FSM)  -> ledBrightPcent = %d\r\n", this->globals->ledBrightnessPercent);
-	pref.putUInt("huemeshOwnHue", this->globals->huemeshOwnHue);
-    LOGF_DEBUG("(FSM)  -> huemeshOwnHue = %d\r\n", this->globals->huemeshOwnHue);
+    if (this->persisted_legacy) {
+        pref.clear();
+        LOG_DEBUG("(FSM)  -> Cleared legacy per-key storage area");
+    }
+    if (pref.putBytes(this->NVS_KEY_GLOBALS, blob, sizeof(blob)) == sizeof(blob)) {
+        memcpy(this->persisted, blob, sizeof(blob));
+        this->persisted_legacy = false;
+        this->persist_writes++;
+        FSMGLOBALS_PERSISTED_FIELDS(FSM_LOG_FIELD)
+        LOGF_DEBUG(
+            "(FSM)  -> writes = %lu, avoided = %lu\r\n",
+            (unsigned long) this->getPersistWriteCount(),
+            (unsigned long) this->getPersistAvoidedCount()
+        );
+    } else {
+        LOG_ERROR("(FSM) Failed to write FSM state data to NVS");
+    }
     pref.end();
 }
 
 void FSM::restoreGlobals() {
+    uint8_t blob[FSMGLOBALS_BLOB_SIZE];
+
     pref.begin(this->NVS_NAMESPACE, true);
     LOGF_INFO("(FSM) Restoring FSM state data from NVS area: %s\r\n", this->NVS_NAMESPACE);
-    this->globals->resumeStateIdx = pref.getUInt("resumeStateIdx", random(0, 3));
-    LOGF_DEBUG("(FSM)  -> resumeStateIdx = %d\r\n", this->globals->resumeStateIdx);
-    this->globals->menuMainPointerIdx = pref.getUInt("menuIdx", 0);
-    LOGF_DEBUG("(FSM)  -> menuIdx = %d\r\n", this->globals->menuMainPointerIdx);
-    this->globals->prideFlagModeIdx = pref.getUInt("prideFlagMode", 1);
-    LOGF_DEBUG("(FSM)  -> prideFlagMode = %d\r\n", this->globals->prideFlagModeIdx);
-    this->globals->animRainbowIdx = pref.getUInt("animRainbow", 0);
-    LOGF_DEBUG("(FSM)  -> animRainbow = %d\r\n", this->globals->animRainbowIdx);
-    this->globals->animSnakeAnimationIdx = pref.getUInt("animSnakeIdx", 0);
-    LOGF_DEBUG("(FSM)  -> animSnakeIdx = %d\r\n", this->globals->animSnakeAnimationIdx);
-    this->globals->animSnakeHueIdx = pref.getUInt("animSnakeHueIdx", 0);
-    LOGF_DEBUG("(FSM)  -> animSnakeHueIdx = %d\r\n", this->globals->animSnakeHueIdx);
-    this->globals->animHeartbeatHue = pref.getUInt("animHbHue", 0);
-    LOGF_DEBUG("(FSM)  -> animHbHue = %d\r\n", this->globals->animHeartbeatHue);
-    this->globals->animHeartbeatSpeed = pref.getUInt("animHbSpeed", 1);
-    LOGF_DEBUG("(FSM)  -> animHbSpeed = %d\r\n", this->globals->animHeartbeatSpeed);
-    this->globals->animMatrixIdx = pref.getUInt("animMatrixIdx", 0);
-    LOGF_DEBUG("(FSM)  -> animMatrixIdx = %d\r\n", this->globals->animMatrixIdx);
-    this->globals->ledBrightnessPercent = pref.getUInt("ledBrightPcent", 40);
-    LOGF_DEBUG("(FSM)  -> ledBrightPcent = %d\r\n", this->globals->ledBrightnessPercent);
-	this->globals->huemeshOwnHue = pref.getUInt("huemeshOwnHue", 0);
-    LOGF_DEBUG("(FSM)  -> huemeshOwnHue = %d\r\n", this->globals->huemeshOwnHue);
+    this->persisted_legacy = false;
+    if (pref.getBytes(this->NVS_KEY_GLOBALS, blob, sizeof(blob)) == sizeof(blob) && this->deserializeGlobals(blob)) {
+        memcpy(this->persisted, blob, sizeof(blob));
+    } else if (this->restoreLegacyGlobals()) {
+        LOG_INFO("(FSM)  -> Migrating from legacy per-key storage layout");
+        this->persisted_legacy = true;
+    } else {
+        LOG_INFO("(FSM)  -> No stored FSM state data. Using defaults.");
+        this->globals = FSMGlobals();
+        this->globals.resumeStateIdx = random(0, 3);
+    }
     pref.end();
+
+    FSMGLOBALS_PERSISTED_FIELDS(FSM_LOG_FIELD)
+}
+
+#undef FSM_LOG_FIELD
+
+uint32_t FSM::getPersistRequestCount() {
+    return this->persist_requests;
+}
+
+uint32_t FSM::getPersistWriteCount() {
+    return this->persist_writes;
+}
+
+uint32_t FSM::getPersistAvoidedCount() {
+    return this->persist_requests > this->persist_writes ? this->persist_requests - this->persist_writes : 0;
 }
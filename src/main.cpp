@@ -34,9 +34,16 @@
 #include <WiFi.h>
 
 #include <EFBoard.h>
+#include <EFEnergy.h>
+#include <EFGovernor.h>
+#include <EFIdle.h>
 #include <EFLogging.h>
 #include <EFLed.h>
+#include <EFLedGeometry.h>
+#include <EFRadio.h>
+#include <EFScheduler.h>
 #include <EFTouch.h>
+#include <EFTouchRecorder.h>
 #ifdef HasDisplay
     #include <EFDisplay.h>
 #endif
@@ -44,46 +51,31 @@
 #include "FSMGlobals.h"
 #include "util.h"
 
+#if defined(EF_DUALCORE) && EF_DUALCORE_LOGIC_CORE == ARDUINO_RUNNING_CORE
+    #error "EF_DUALCORE_LOGIC_CORE must differ from the core loop() runs on"
+#endif
+
 // Global objects and states
 constexpr unsigned int INTERVAL_BATTERY_CHECK = 10000;
-// Initializing the board with a brightness above 48 can cause stability issues!
+// Raw brightness persisted brightness percentages refer to. Sparse frames are scaled up to
+// EFLED_BRIGHTNESS_CEILING within EFLED_CURRENT_BUDGET_MA, full frames stay at about this level.
 constexpr uint8_t ABSOLUTE_MAX_BRIGHTNESS = 45;
 FSM fsm(10);
 EFBoardPowerState pwrstate;
 
-// Task counters
-unsigned long task_fsm_handle = 0;
-unsigned long task_blinkled = 0;
-unsigned long task_battery = 0;
-unsigned long task_brownout = 0;
-
-/**
- * @brief Struct for interrupt event tracking / handling
- */
-volatile struct ISREventsType {
-    unsigned char fingerprintTouch:      1;
-    unsigned char fingerprintRelease:    1;
-    unsigned char fingerprintShortpress: 1;
-    unsigned char fingerprintLongpress:  1;
-    unsigned char noseTouch:             1;
-    unsigned char noseRelease:           1;
-    unsigned char noseShortpress:        1;
-    unsigned char noseLongpress:         1;
-    unsigned char allShortpress:         1;
-    unsigned char allLongpress:          1;
-} isrEvents;
-
-// Interrupt service routines to update ISR struct upon triggering
-void ARDUINO_ISR_ATTR isr_fingerprintTouch()      { isrEvents.fingerprintTouch = 1; }
-void ARDUINO_ISR_ATTR isr_fingerprintRelease()    { isrEvents.fingerprintRelease = 1; }
-void ARDUINO_ISR_ATTR isr_fingerprintShortpress() { isrEvents.fingerprintShortpress = 1; }
-void ARDUINO_ISR_ATTR isr_fingerprintLongpress()  { isrEvents.fingerprintLongpress = 1; }
-void ARDUINO_ISR_ATTR isr_noseTouch()             { isrEvents.noseTouch = 1; }
-void ARDUINO_ISR_ATTR isr_noseRelease()           { isrEvents.noseRelease = 1; }
-void ARDUINO_ISR_ATTR isr_noseShortpress()        { isrEvents.noseShortpress = 1; }
-void ARDUINO_ISR_ATTR isr_noseLongpress()         { isrEvents.noseLongpress = 1; }
-void ARDUINO_ISR_ATTR isr_allShortpress()         { isrEvents.allShortpress = 1; }
-void ARDUINO_ISR_ATTR isr_allLongpress()          { isrEvents.allLongpress = 1; }
+// Touch handlers to pass touch events to the FSM, executed by EFTouch.poll()
+void touch_fingerprintTouch()      { fsm.queueEvent(FSMEvent::FingerprintTouch, EFTouch.getEventTimestampUs()); }
+void touch_fingerprintRelease()    { fsm.queueEvent(FSMEvent::FingerprintRelease, EFTouch.getEventTimestampUs()); }
+void touch_fingerprintShortpress() { fsm.queueEvent(FSMEvent::FingerprintShortpress, EFTouch.getEventTimestampUs()); }
+void touch_fingerprintLongpress()  { fsm.queueEvent(FSMEvent::FingerprintLongpress, EFTouch.getEventTimestampUs()); }
+void touch_fingerprintHold()       { fsm.queueEvent(FSMEvent::FingerprintHold, EFTouch.getEventTimestampUs()); }
+void touch_noseTouch()             { fsm.queueEvent(FSMEvent::NoseTouch, EFTouch.getEventTimestampUs()); }
+void touch_noseRelease()           { fsm.queueEvent(FSMEvent::NoseRelease, EFTouch.getEventTimestampUs()); }
+void touch_noseShortpress()        { fsm.queueEvent(FSMEvent::NoseShortpress, EFTouch.getEventTimestampUs()); }
+void touch_noseLongpress()         { fsm.queueEvent(FSMEvent::NoseLongpress, EFTouch.getEventTimestampUs()); }
+void touch_noseHold()              { fsm.queueEvent(FSMEvent::NoseHold, EFTouch.getEventTimestampUs()); }
+void touch_allShortpress()         { fsm.queueEvent(FSMEvent::AllShortpress, EFTouch.getEventTimestampUs()); }
+void touch_allLongpress()          { fsm.queueEvent(FSMEvent::AllLongpress, EFTouch.getEventTimestampUs()); }
 
 /**
  * @brief Handles hard brown out events
@@ -94,24 +86,13 @@ void _hardBrownOutHandler() {
         "HARD BROWN OUT DETECTED (V_BAT = %.2f V). Panic!\r\n",
         EFBoard.getBatteryVoltage()
     );
-    EFBoard.disableWifi();
-    // Try getting the LEDs into some known state
-    EFLed.setBrightnessPercent(30);
-    EFLed.clear();
-    EFLed.setDragonNose(CRGB::Red);
+    EFRadio.shutdown();
+    #ifdef HasDisplay
+        EFDisplay.setPowerSave(true);
+    #endif
 
-    // Hard brown out can only be cleared by board reset
-    while (1) {
-        // Low brightness blink every few seconds
-        EFLed.enablePower();
-        EFLed.setDragonNose(CRGB::Red);
-        esp_sleep_enable_timer_wakeup(200 * 1000);  // 200 ms
-        EFLed.disablePower();
-        // sleep most of the time.
-        esp_sleep_enable_timer_wakeup(2 * 1000 * 1000);  // 2s
-        esp_light_sleep_start();
-        // TODO: Go to deep sleep, but save the reason so when waking up, we can blink and deep sleep again
-    }
+    // Deep sleeps, waking up only to blink and check V_BAT until it recovered
+    EFBoard.hardBrownOut(EFBoardBrownOutReason::Runtime);
 }
 
 /**
@@ -123,11 +104,14 @@ void _softBrownOutHandler() {
         "Soft brown out detected (V_BAT = %.2f V). Aborting main loop and display warning LED.\r\n",
         EFBoard.getBatteryVoltage()
     );
-    EFBoard.disableWifi();
+    EFRadio.shutdown();
     EFLed.clear();
     EFLed.enablePower();
     EFLed.setBrightnessPercent(40);
 
+    // Main loop stops here, write out globals changes that are still pending
+    fsm.persistGlobals();
+
     // Soft brown out can only be cleared by board reset but can escalate to hard brown out
     while (1) {
         // Check for hard brown out
@@ -138,6 +122,8 @@ void _softBrownOutHandler() {
 
         // Blink LED to signal brown out to user
         for (uint8_t n = 0; n < 30; n++) {
+            // The scheduler no longer runs, keep the battery readings fresh
+            EFBoard.sampleBattery();
             EFLed.enablePower();
             EFLed.setDragonNose(CRGB::Red);
             esp_sleep_enable_timer_wakeup(300 * 1000);
@@ -180,6 +166,109 @@ void batteryCheck() {
     }
 }
 
+void batterySample() {
+    EFBoard.sampleBattery();
+    // Right after sampling, so the discharge curve sees the fresh voltage
+    EFEnergy.sample(fsm.getStateName(), millis());
+}
+
+void governorUpdate() {
+    EFGovernor.update(millis());
+}
+
+/**
+ * @brief Runs all due tasks and accounts the time spent on them as CPU load
+ */
+void schedulerPoll() {
+    const uint32_t start_us = micros();
+    // Polls without due tasks only check deadlines, they are no load
+    if (EFScheduler.poll() > 0) {
+        EFGovernor.addBusy(micros() - start_us);
+    }
+}
+
+void fsmHandle() {
+    fsm.handle();
+}
+
+uint32_t fsmIdleHint(uint32_t now) {
+    return fsm.getTimeUntilNextDeadline(now);
+}
+
+#ifdef HasDisplay
+void displayLoop() {
+    EFDisplay.loop();
+}
+#endif
+
+// Periodic tasks. Missing a tick of any of them is harmless, so all drop missed periods.
+EFSchedulerTask task_fsm_handle("fsm", fsm.getTickRateMs(), EFSchedulerPolicy::Drop, fsmHandle);
+EFSchedulerTask task_battery("battery", INTERVAL_BATTERY_CHECK, EFSchedulerPolicy::Drop, batteryCheck);
+EFSchedulerTask task_battery_sample("vbat", EFBOARD_VBAT_SAMPLE_INTERVAL_MS, EFSchedulerPolicy::Drop, batterySample);
+EFSchedulerTask task_governor("governor", EFGOVERNOR_WINDOW_MS, EFSchedulerPolicy::Drop, governorUpdate);
+#ifdef HasDisplay
+EFSchedulerTask task_display("display", EFDISPLAY_FRAME_INTERVAL_MS, EFSchedulerPolicy::Drop, displayLoop);
+#endif
+
+#ifdef EFTOUCH_RECORDER
+void touchRecord() {
+    EFTouchRecorder.record(millis(), EFTouch.readRaw());
+}
+
+// Catches up missed samples to keep the fixed sample rate a touch trace assumes
+EFSchedulerTask task_touch_recorder("touchrec", EFTOUCH_RECORDER_INTERVAL_MS, EFSchedulerPolicy::CatchUp, touchRecord);
+#endif
+
+// Tasks added in setup(), plus the state run() statistics added by fsm.resume()
+constexpr uint8_t NUM_SCHEDULER_TASKS = 5
+#ifdef EFTOUCH_RECORDER
+    + 1
+#endif
+#if defined(HasDisplay) && !defined(EF_DUALCORE)
+    + 1
+#endif
+;
+static_assert(NUM_SCHEDULER_TASKS <= EFSCHEDULER_MAX_TASKS, "More periodic tasks than EFSCHEDULER_MAX_TASKS");
+
+#ifdef EF_DUALCORE
+TaskHandle_t task_logic = nullptr;
+
+/**
+ * @brief Logic task: Runs console, FSM, radio and persistence on EF_DUALCORE_LOGIC_CORE
+ * while loop() renders the display on the other core. State reaches the render
+ * side only through lock-free snapshots (LED frames, EFDisplayState).
+ */
+void logicTask(void*) {
+    while (true) {
+        EFBoard.loop();
+        EFTouch.poll();
+        schedulerPoll();
+        // Let the idle task of this core feed the task watchdog
+        vTaskDelay(1);
+    }
+}
+#endif
+
+/**
+ * @brief Last part of the bootup animation: The dragon opens its eye and boops its nose
+ */
+const EFLedKeyframe effect_awaken[] = {
+    {EFLedMask::EYE,  CRGB(10, 0, 0),   60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(50, 0, 0),   80,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(100, 0, 0),  150, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(200, 0, 0),  700, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(100, 0, 0),  80,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(50, 0, 0),   80,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(10, 0, 0),   60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE,  CRGB(0, 0, 0),    200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::NOSE, CRGB(0, 50, 100), 60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::NOSE, CRGB(0, 0, 0),    60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::NOSE, CRGB(0, 50, 100), 60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::NOSE, CRGB(0, 0, 0),    60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::NOSE, CRGB(0, 50, 100), 60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::NOSE, CRGB(0, 0, 0),    60,  EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+};
+
 /**
  * @brief Displays a fancy bootup animation
  */
@@ -189,9 +278,7 @@ void boopupAnimation() {
     EFLed.setAll(data);
     delay(100);
 
-    // Origin point. Power-Button is 11, 25. Make it originate from where the hand is
-    constexpr int16_t pwrX = -30;
-    constexpr int16_t pwrY = 16;
+    // Origin point is EFLedGeometry::ANCHOR_POWER_BUTTON. Power-Button is 11, 25. Make it originate from where the hand is
     uint8_t hue = 120;  // Green
 
     for (uint16_t n = 0; n < 30; n++) {
@@ -201,9 +288,7 @@ void boopupAnimation() {
             batteryCheck();
         }
         for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
-            int16_t dx = EFLedClass::getLEDPosition(i).x - pwrX;
-            int16_t dy = EFLedClass::getLEDPosition(i).y - pwrY;
-            float distance = sqrt(dx * dx + dy * dy);
+            float distance = EFLedGeometry::toMillimeters(EFLedGeometry::DISTANCE_FROM_POWER_BUTTON[i]);
 
             float intensity = wave_function(distance, n_scaled / 2 - 30, n_scaled * 2 + 20, 1.0);
             intensity = intensity * intensity; // sharpen wave
@@ -219,35 +304,8 @@ void boopupAnimation() {
     delay(400);
 
     batteryCheck();
-    // dragon awakens ;-)
-    EFLed.setDragonEye(CRGB(10,0, 0));
-    delay(60);
-    EFLed.setDragonEye(CRGB(50,0, 0));
-    delay(80);
-    EFLed.setDragonEye(CRGB(100,0, 0));
-    delay(150);
-    EFLed.setDragonEye(CRGB(200,0, 0));
-    delay(700);
-    EFLed.setDragonEye(CRGB(100,0, 0));
-    delay(80);
-    EFLed.setDragonEye(CRGB(50,0, 0));
-    delay(80);
-    EFLed.setDragonEye(CRGB(10,0, 0));
-    delay(60);
-    EFLed.setDragonEye(CRGB(0,0, 0));
-    delay(200);
-    EFLed.setDragonNose(CRGB(0,50,100));
-    delay(60);
-    EFLed.setDragonNose(CRGB(0,0,0));
-    delay(60);
-    EFLed.setDragonNose(CRGB(0,50,100));
-    delay(60);
-    EFLed.setDragonNose(CRGB(0,0,0));
-    delay(60);
-    EFLed.setDragonNose(CRGB(0,50,100));
-    delay(60);
-    EFLed.setDragonNose(CRGB(0,0,0));
-    delay(60);
+    // dragon awakens ;-) Keeps playing while the FSM starts up
+    EFLed.playEffect(effect_awaken, EFLedMask::ALL);
 }
 
 /**
@@ -258,107 +316,83 @@ void setup() {
     EFBoard.setup();
     EFLed.init(ABSOLUTE_MAX_BRIGHTNESS);
     EFLed.setBrightnessPercent(40);  // We do not have access to the settings yet, default to 40
+    // Waking up from deep sleep continues the animation right away
+    const bool resuming = EFBoard.isResuming();
     #ifdef HasDisplay
-        EFDisplay.init();//Display Bootup Animation
+        EFDisplay.init(!resuming);//Display Bootup Animation
     #endif
-    boopupAnimation();
+    if (!resuming) {
+        boopupAnimation();
+    }
 
     // Touchy stuff
     EFTouch.init();
-    EFTouch.attachInterruptOnTouch(EFTouchZone::Fingerprint, isr_fingerprintTouch);
-    EFTouch.attachInterruptOnRelease(EFTouchZone::Fingerprint, isr_fingerprintRelease);
-    EFTouch.attachInterruptOnShortpress(EFTouchZone::Fingerprint, isr_fingerprintShortpress);
-    EFTouch.attachInterruptOnLongpress(EFTouchZone::Fingerprint, isr_fingerprintLongpress);
-    EFTouch.attachInterruptOnTouch(EFTouchZone::Nose, isr_noseTouch);
-    EFTouch.attachInterruptOnRelease(EFTouchZone::Nose, isr_noseRelease);
-    EFTouch.attachInterruptOnShortpress(EFTouchZone::Nose, isr_noseShortpress);
-    EFTouch.attachInterruptOnLongpress(EFTouchZone::Nose, isr_noseLongpress);
-    EFTouch.attachInterruptOnShortpress(EFTouchZone::All, isr_allShortpress);
-    EFTouch.attachInterruptOnLongpress(EFTouchZone::All, isr_allLongpress);
+    EFTouch.attachHandlerOnTouch(EFTouchZone::Fingerprint, touch_fingerprintTouch);
+    EFTouch.attachHandlerOnRelease(EFTouchZone::Fingerprint, touch_fingerprintRelease);
+    EFTouch.attachHandlerOnShortpress(EFTouchZone::Fingerprint, touch_fingerprintShortpress);
+    EFTouch.attachHandlerOnLongpress(EFTouchZone::Fingerprint, touch_fingerprintLongpress);
+    EFTouch.attachHandlerOnHold(EFTouchZone::Fingerprint, touch_fingerprintHold);
+    EFTouch.attachHandlerOnTouch(EFTouchZone::Nose, touch_noseTouch);
+    EFTouch.attachHandlerOnRelease(EFTouchZone::Nose, touch_noseRelease);
+    EFTouch.attachHandlerOnShortpress(EFTouchZone::Nose, touch_noseShortpress);
+    EFTouch.attachHandlerOnLongpress(EFTouchZone::Nose, touch_noseLongpress);
+    EFTouch.attachHandlerOnHold(EFTouchZone::Nose, touch_noseHold);
+    EFTouch.attachHandlerOnShortpress(EFTouchZone::All, touch_allShortpress);
+    EFTouch.attachHandlerOnLongpress(EFTouchZone::All, touch_allLongpress);
 
     // Get FSM going
+    // The FSM polls for events every tick, but only needs the CPU once it has work
+    task_fsm_handle.setIdleHint(fsmIdleHint);
+    task_fsm_handle.reset(millis());
+    task_battery.reset(millis());
+    task_battery_sample.reset(millis());
+    task_governor.reset(millis());
+    EFScheduler.add(task_fsm_handle);
+    EFScheduler.add(task_battery);
+    EFScheduler.add(task_battery_sample);
+    EFScheduler.add(task_governor);
+    #ifdef EFTOUCH_RECORDER
+        task_touch_recorder.reset(millis());
+        EFScheduler.add(task_touch_recorder);
+    #endif
+    #if defined(HasDisplay) && !defined(EF_DUALCORE)
+        // With EF_DUALCORE the display is rendered by loop() on the other core
+        task_display.reset(millis());
+        EFScheduler.add(task_display);
+    #endif
     fsm.resume();
 
+    #ifdef EF_DUALCORE
+        xTaskCreatePinnedToCore(
+            logicTask, "EFLogic",
+            EF_DUALCORE_LOGIC_STACK, nullptr, EF_DUALCORE_LOGIC_PRIORITY, &task_logic,
+            EF_DUALCORE_LOGIC_CORE
+        );
+        LOGF_INFO(
+            "Started logic task on core %d, rendering on core %d\r\n",
+            EF_DUALCORE_LOGIC_CORE, ARDUINO_RUNNING_CORE
+        );
+    #endif
+
 }
 
 /**
  * @brief Main program loop
  */
 void loop() {
-    EFBoard.loop();
+#ifdef EF_DUALCORE
+    // Render core: Console, FSM and battery checks run in logicTask()
     #ifdef HasDisplay
         EFDisplay.loop();//Display loop call
     #endif
-    // Handler: ISR Events
-    if (isrEvents.allLongpress) {
-        fsm.queueEvent(FSMEvent::AllLongpress);
-        isrEvents.noseLongpress = false;
-        isrEvents.noseShortpress = false;
-        isrEvents.noseRelease = false;
-        isrEvents.fingerprintLongpress = false;
-        isrEvents.fingerprintShortpress = false;
-        isrEvents.fingerprintRelease = false;
-        isrEvents.allLongpress = false;
-        isrEvents.allShortpress = false;
-    }
-    if (isrEvents.allShortpress) {
-        fsm.queueEvent(FSMEvent::AllShortpress);
-        isrEvents.noseShortpress = false;
-        isrEvents.noseRelease = false;
-        isrEvents.fingerprintShortpress = false;
-        isrEvents.fingerprintRelease = false;
-        isrEvents.allShortpress = false;
-    }
-    if (isrEvents.fingerprintTouch) {
-        fsm.queueEvent(FSMEvent::FingerprintTouch);
-        isrEvents.fingerprintTouch = false;
-    }
-    if (isrEvents.fingerprintLongpress) {
-        fsm.queueEvent(FSMEvent::FingerprintLongpress);
-        isrEvents.fingerprintLongpress = false;
-        isrEvents.fingerprintShortpress = false;
-        isrEvents.fingerprintRelease = false;
-    }
-    if (isrEvents.fingerprintShortpress) {
-        fsm.queueEvent(FSMEvent::FingerprintShortpress);
-        isrEvents.fingerprintShortpress = false;
-        isrEvents.fingerprintRelease = false;
-    }
-    if (isrEvents.fingerprintRelease) {
-        fsm.queueEvent(FSMEvent::FingerprintRelease);
-        isrEvents.fingerprintRelease = false;
-    }
-
-    if (isrEvents.noseTouch) {
-        fsm.queueEvent(FSMEvent::NoseTouch);
-        isrEvents.noseTouch = false;
-    }
-    if (isrEvents.noseLongpress) {
-        fsm.queueEvent(FSMEvent::NoseLongpress);
-        isrEvents.noseLongpress = false;
-        isrEvents.noseShortpress = false;
-        isrEvents.noseRelease = false;
-    }
-    if (isrEvents.noseShortpress) {
-        fsm.queueEvent(FSMEvent::NoseShortpress);
-        isrEvents.noseShortpress = false;
-        isrEvents.noseRelease = false;
-    }
-    if (isrEvents.noseRelease) {
-        fsm.queueEvent(FSMEvent::NoseRelease);
-        isrEvents.noseRelease = false;
-    }
-
-    // Task: Handle FSM
-    if (task_fsm_handle < millis()) {
-        fsm.handle();
-        task_fsm_handle = millis() + fsm.getTickRateMs();
-    }
-
-    // Task: Battery checks
-    if (task_battery < millis()) {
-        batteryCheck();
-        task_battery = millis() + INTERVAL_BATTERY_CHECK;
-    }
-
+    delay(EFDISPLAY_FRAME_INTERVAL_MS);
+#else
+    EFBoard.loop();
+    // Classify touch edges recorded by the ISRs and queue FSM events
+    EFTouch.poll();
+    // Tasks: Handle FSM, battery checks, display
+    schedulerPoll();
+    // Light sleep until the next task has work, touch interrupts wake up early
+    EFIdle.idle(fsm.getStateName(), EFScheduler.getTimeUntilNextWork());
+#endif
 }
@@ -21,6 +21,7 @@
 // IN THE SOFTWARE.
 
 #include <EFLed.h>
+#include <EFLedGeometry.h>
 #include <EFLogging.h>
 
 #include "FSMState.h"
@@ -42,13 +43,10 @@ void AnimateHeartbeat::entry() {
 }
 
 void AnimateHeartbeat::run() {
-    CRGB data[EFLED_TOTAL_NUM];
-    fill_solid(data, EFLED_TOTAL_NUM, CRGB::Black);
+    EFLedSegment data = EFLed.all();
 
     for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
-        float dx = EFLedClass::getLEDPosition(i).x - EFLedClass::getLEDPosition(EFLED_DRAGON_EYE_IDX).x;
-        float dy = EFLedClass::getLEDPosition(i).y - EFLedClass::getLEDPosition(EFLED_DRAGON_EYE_IDX).y;
-        float distance = sqrt(dx * dx + dy * dy);
+        float distance = EFLedGeometry::toMillimeters(EFLedGeometry::DISTANCE_FROM_EYE[i]);
 
         // LEDs further away from the eye lag behind
         float t = tick / 40.0 - distance / 80.0;
@@ -60,27 +58,25 @@ void AnimateHeartbeat::run() {
         data[i] = CHSV(this->globals->animHeartbeatHue, 255, value);
     }
 
-    EFLed.setAll(data);
-
     // Prepare next tick
     this->tick = this->tick + this->globals->animHeartbeatSpeed + 1;
 }
 
-std::unique_ptr<FSMState> AnimateHeartbeat::touchEventFingerprintShortpress() {
+FSMStateId AnimateHeartbeat::touchEventFingerprintShortpress() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
-    return std::make_unique<MenuMain>();
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> AnimateHeartbeat::touchEventFingerprintLongpress() {
+FSMStateId AnimateHeartbeat::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
 
-std::unique_ptr<FSMState> AnimateHeartbeat::touchEventNoseRelease() {
+FSMStateId AnimateHeartbeat::touchEventNoseRelease() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     uint8_t oldHue = this->globals->animHeartbeatHue;
@@ -91,42 +87,37 @@ std::unique_ptr<FSMState> AnimateHeartbeat::touchEventNoseRelease() {
     }
     this->is_globals_dirty = true;
 
-    EFLed.setDragonEye(CRGB::Black);
-    delay(100);
-    EFLed.setDragonEye(CHSV(this->globals->animHeartbeatHue, 255, 255));
-    delay(300);
-    EFLed.setDragonEye(CRGB::Black);
+    const EFLedKeyframe effect_hue[] = {
+        {EFLedMask::EYE, CRGB::Black, 100, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {EFLedMask::EYE, CHSV(this->globals->animHeartbeatHue, 255, 255), 300, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    };
+    EFLed.playEffect(effect_hue);
 
     this->tick = 0;
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> AnimateHeartbeat::touchEventNoseShortpress() {
+FSMStateId AnimateHeartbeat::touchEventNoseShortpress() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     this->globals->animHeartbeatSpeed = (this->globals->animHeartbeatSpeed + 1) % 3;
     this->is_globals_dirty = true;
 
-    CRGB data[EFLED_EFBAR_NUM];
-    fill_solid(data, EFLED_EFBAR_NUM, CRGB::Black);
-    EFLed.setEFBar(data);
-    delay(100);
-    fill_solid(data, this->globals->animHeartbeatSpeed + 1, CRGB::Red);
-    EFLed.setEFBar(data);
-    delay(300);
-    fill_solid(data, this->globals->animHeartbeatSpeed + 1, CRGB::Black);
-    EFLed.setEFBar(data);
-    delay(200);
-    fill_solid(data, this->globals->animHeartbeatSpeed + 1, CRGB::Red);
-    EFLed.setEFBar(data);
-    delay(400);
-
-    return nullptr;
+    const uint32_t speed_mask = EFLedMask::efbarTop(this->globals->animHeartbeatSpeed + 1);
+    const EFLedKeyframe effect_speed[] = {
+        {EFLedMask::EFBAR, CRGB::Black, 100, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {speed_mask,       CRGB::Red,   300, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {EFLedMask::EFBAR, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {speed_mask,       CRGB::Red,   400, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    };
+    EFLed.playEffect(effect_speed, EFLedMask::EFBAR);
+
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> AnimateHeartbeat::touchEventAllLongpress() {
+FSMStateId AnimateHeartbeat::touchEventAllLongpress() {
     this->toggleLock();
-    return nullptr;
+    return FSMStateId::None;
 }
@@ -25,6 +25,7 @@
  */
 
 #include <EFLed.h>
+#include <EFLedRing.h>
 #include <EFLogging.h>
 
 #include "FSMState.h"
@@ -61,7 +62,7 @@ void AnimateMatrix::run() {
     // map the 360 degree hue value to a byte
     int mappedHue = map(hue_list[this->globals->animMatrixIdx], 0, 359, 0, 255);
 
-    std::vector<CRGB> dragon = {
+    EFLedRing<CRGB, EFLED_DRAGON_NUM> dragon = {
         CRGB::Black,
         CHSV(mappedHue, 255, 40),
         CHSV(mappedHue, 255, 110),
@@ -70,7 +71,7 @@ void AnimateMatrix::run() {
         CRGB::Black
     };
 
-    std::vector<CRGB> bar = {
+    EFLedRing<CRGB, EFLED_EFBAR_NUM> bar = {
         CHSV(mappedHue, 255, 50),
         CHSV(mappedHue, 255, 110),
         CHSV(mappedHue, 255, 255),
@@ -85,41 +86,41 @@ void AnimateMatrix::run() {
     };
 
     // Calculate current pattern based on tick
-    std::rotate(dragon.begin(), dragon.begin() + this->tick % EFLED_DRAGON_NUM, dragon.end());
-    std::rotate(bar.rbegin(), bar.rbegin() + this->tick % EFLED_EFBAR_NUM, bar.rend());
+    dragon.rotate(this->tick);
+    bar.rotateBack(this->tick);
 
-    dragon.insert(dragon.end(), bar.begin(), bar.end());
-    EFLed.setAll(dragon.data());
+    dragon.writeTo(EFLed.dragon());
+    bar.writeTo(EFLed.efbar());
 
     // Prepare next tick
     this->tick++;
 }
 
-std::unique_ptr<FSMState> AnimateMatrix::touchEventFingerprintShortpress() {
+FSMStateId AnimateMatrix::touchEventFingerprintShortpress() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
-    return std::make_unique<MenuMain>();
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> AnimateMatrix::touchEventFingerprintLongpress() {
+FSMStateId AnimateMatrix::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
 
-std::unique_ptr<FSMState> AnimateMatrix::touchEventFingerprintRelease() {
+FSMStateId AnimateMatrix::touchEventFingerprintRelease() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     this->globals->animMatrixIdx = (this->globals->animMatrixIdx + 1) % 9;
     this->is_globals_dirty = true;
     this->tick = 0;
 
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> AnimateMatrix::touchEventAllLongpress() {
+FSMStateId AnimateMatrix::touchEventAllLongpress() {
     this->toggleLock();
-    return nullptr;
+    return FSMStateId::None;
 }
@@ -71,30 +71,25 @@ void AnimatePerlin::run() {
     this->tick = this->tick + 1;
 }
 
-std::unique_ptr<FSMState> AnimatePerlin::touchEventFingerprintShortpress() {
-    return std::make_unique<MenuMain>();
+FSMStateId AnimatePerlin::touchEventFingerprintShortpress() {
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> AnimatePerlin::touchEventNoseShortpress() {
+FSMStateId AnimatePerlin::touchEventNoseShortpress() {
     this->globals->animPerlinSpeed = (this->globals->animPerlinSpeed + 1) % 3;
     this->is_globals_dirty = true;
 
-    CRGB data[EFLED_EFBAR_NUM];
-    fill_solid(data, EFLED_EFBAR_NUM, CRGB::Black);
-    EFLed.setEFBar(data);
-    delay(100);
-    fill_solid(data, this->globals->animPerlinSpeed + 1, CRGB::Red);
-    EFLed.setEFBar(data);
-    delay(300);
-    fill_solid(data, this->globals->animPerlinSpeed + 1, CRGB::Black);
-    EFLed.setEFBar(data);
-    delay(200);
-    fill_solid(data, this->globals->animPerlinSpeed + 1, CRGB::Red);
-    EFLed.setEFBar(data);
-    delay(400);
-
-    return nullptr;
+    const uint32_t speed_mask = EFLedMask::efbarTop(this->globals->animPerlinSpeed + 1);
+    const EFLedKeyframe effect_speed[] = {
+        {EFLedMask::EFBAR, CRGB::Black, 100, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {speed_mask,       CRGB::Red,   300, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {EFLedMask::EFBAR, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {speed_mask,       CRGB::Red,   400, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    };
+    EFLed.playEffect(effect_speed, EFLedMask::EFBAR);
+
+    return FSMStateId::None;
 }
-std::unique_ptr<FSMState> GameHuemesh::touchEventFingerprintLongpress() {
-	return std::make_unique<MenuMain>();
+FSMStateId GameHuemesh::touchEventFingerprintLongpress() {
+	return FSMStateId::MenuMain;
 }
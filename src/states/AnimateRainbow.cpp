@@ -67,9 +67,9 @@ void AnimateRainbow::run() {
     this->tick++;
 }
 
-std::unique_ptr<FSMState> AnimateRainbow::touchEventFingerprintRelease() {
+FSMStateId AnimateRainbow::touchEventFingerprintRelease() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     this->globals->animRainbowIdx++;
@@ -82,18 +82,18 @@ std::unique_ptr<FSMState> AnimateRainbow::touchEventFingerprintRelease() {
         this->globals->animRainbowIdx % ANIMATE_RAINBOW_NUM_TOTAL
     );
 
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> AnimateRainbow::touchEventFingerprintShortpress() {
+FSMStateId AnimateRainbow::touchEventFingerprintShortpress() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
-    return std::make_unique<MenuMain>();
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> AnimateRainbow::touchEventFingerprintLongpress() {
+FSMStateId AnimateRainbow::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
 
@@ -107,7 +107,7 @@ void AnimateRainbow::_animateRainbowCircle() {
     EFLed.setAll(data);
 }
 
-std::unique_ptr<FSMState> AnimateRainbow::touchEventAllLongpress() {
+FSMStateId AnimateRainbow::touchEventAllLongpress() {
     this->toggleLock();
-    return nullptr;
+    return FSMStateId::None;
 }
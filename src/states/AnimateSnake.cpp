@@ -25,9 +25,9 @@
  */
 
 #include <EFLed.h>
+#include <EFLedRing.h>
 #include <EFLogging.h>
 #include <EFPrideFlags.h>
-#include <vector>
 
 #include "FSMState.h"
 
@@ -79,9 +79,9 @@ void AnimateSnake::run() {
     this->tick++;
 }
 
-std::unique_ptr<FSMState> AnimateSnake::touchEventFingerprintRelease() {
+FSMStateId AnimateSnake::touchEventFingerprintRelease() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     this->globals->animSnakeHueIdx++;
@@ -99,18 +99,18 @@ std::unique_ptr<FSMState> AnimateSnake::touchEventFingerprintRelease() {
         this->globals->animSnakeAnimationIdx
     );
 
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> AnimateSnake::touchEventFingerprintShortpress() {
+FSMStateId AnimateSnake::touchEventFingerprintShortpress() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
-    return std::make_unique<MenuMain>();
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> AnimateSnake::touchEventFingerprintLongpress() {
+FSMStateId AnimateSnake::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
 
@@ -139,64 +139,47 @@ void AnimateSnake::_animateKnightRider() {
 }
 
 void AnimateSnake::_animateSnake() {
-    std::vector<CRGB> pattern = {
+    // Remaining LEDs are black
+    EFLedRing<CRGB, EFLED_TOTAL_NUM> pattern = {
         hueList[this->globals->animSnakeHueIdx],
         hueList[this->globals->animSnakeHueIdx],
         hueList[this->globals->animSnakeHueIdx],
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
     };
 
-    std::rotate(pattern.rbegin(), pattern.rbegin() + this->tick % EFLED_TOTAL_NUM, pattern.rend());
-    EFLed.setAll(pattern.data());
+    pattern.rotateBack(this->tick);
+    pattern.writeTo(EFLed.all());
 }
 
-std::unique_ptr<FSMState> AnimateSnake::touchEventAllLongpress() {
+FSMStateId AnimateSnake::touchEventAllLongpress() {
     this->toggleLock();
-    return nullptr;
+    return FSMStateId::None;
 }
 
 void AnimateSnake::_animatePulse() {
 
     // Create half of the pattern
-    std::vector<CRGB> patternFirstHalf = {
+    EFLedRing<CRGB, 5> patternFirstHalf = {
         hueList[this->globals->animSnakeHueIdx],
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
-        CRGB::Black,
     };
     // shift the active LED
-    std::rotate(patternFirstHalf.rbegin(), patternFirstHalf.rbegin() + this->tick % 5, patternFirstHalf.rend());
+    patternFirstHalf.rotateBack(this->tick);
 
     // copy the pattern and flip it
-    std::vector<CRGB> patternSecondHalf = patternFirstHalf;
-    std::reverse(patternSecondHalf.begin(), patternSecondHalf.end());
+    EFLedRing<CRGB, 5> patternSecondHalf = patternFirstHalf;
+    patternSecondHalf.mirror();
+
+    // write first half, center LED and second half directly into the EF bar
+    EFLedSegment bar = EFLed.efbar();
+    uint8_t pos = patternFirstHalf.writeTo(bar);
 
     // Handle the center LED. Only light it in the last part of the animation
     if(patternSecondHalf[0] == hueList[this->globals->animSnakeHueIdx]) {
-        patternFirstHalf.insert(patternFirstHalf.end(), hueList[this->globals->animSnakeHueIdx]);
+        bar[pos++] = hueList[this->globals->animSnakeHueIdx];
     }else{
-        patternFirstHalf.insert(patternFirstHalf.end(), CRGB::Black);
+        bar[pos++] = CRGB::Black;
     }
 
-    // create the final pattern array and append the second half pattern
-    std::vector<CRGB> pattern = patternFirstHalf;
-    pattern.insert(pattern.end(), patternSecondHalf.begin(), patternSecondHalf.end());
-
-    EFLed.setEFBar(pattern.data());
+    patternSecondHalf.writeTo(bar, pos);
 }
 
 void AnimateSnake::_animateRandom() {
@@ -206,17 +189,15 @@ void AnimateSnake::_animateRandom() {
         randomLightList[random(0, EFLED_TOTAL_NUM-1)] = 255;
     }
 
-    std::vector<CRGB> pattern;
+    EFLedSegment pattern = EFLed.all();
 
     // loop through all LED brighnesses and set it. Subtract it afterward to slowly dim them
-    for(int & i : randomLightList) {
+    for(uint8_t led = 0; led < EFLED_TOTAL_NUM; led++) {
+        int& i = randomLightList[led];
         CHSV color = hueList[this->globals->animSnakeHueIdx];
         color.value = i;
-        pattern.insert(pattern.end(), color);
+        pattern[led] = color;
         i -= 20;
         if(i < 0) { i = 0; };
     }
-
-
-    EFLed.setAll(pattern.data());
 }
\ No newline at end of file
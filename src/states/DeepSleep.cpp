@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <EFLed.h>
+#include <EFLogging.h>
+#include <EFBoard.h>
+#include <EFTouch.h>
+
+#include "FSMState.h"
+
+#ifdef HasDisplay
+    #include <EFDisplay.h>
+#endif
+
+/**
+ * @brief The dragon closes its eye before the badge falls asleep
+ */
+const EFLedKeyframe effect_sleep[] = {
+    {EFLedMask::EYE, CRGB(100, 0, 0), 200, EFLedTween::Step,   EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB(50, 0, 0),  200, EFLedTween::Linear, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB(10, 0, 0),  200, EFLedTween::Linear, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB(0, 0, 0),   200, EFLedTween::Linear, EFLED_EFFECT_KEEP_BRIGHTNESS},
+};
+
+const char* DeepSleep::getName() {
+    return "DeepSleep";
+}
+
+const unsigned int DeepSleep::getTickRateMs() {
+    return 50;
+}
+
+EFGovernorPerf DeepSleep::getPerfClass() {
+    return EFGovernorPerf::Low;
+}
+
+void DeepSleep::entry() {
+    EFLed.clear();
+    EFLed.playEffect(effect_sleep);
+}
+
+void DeepSleep::run() {
+    // A touch that is still held would wake the badge right away
+    if (EFLed.isEffectPlaying() || EFTouch.isTouchActive()) {
+        return;
+    }
+
+    EFLed.clear();
+    EFLed.disablePower();
+    #ifdef HasDisplay
+        EFDisplay.setPowerSave(true);
+    #endif
+
+    LOG_INFO("(DeepSleep) Touch the fingerprint to wake up");
+    EFBoard.deepSleep();
+}
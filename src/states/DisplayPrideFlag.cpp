@@ -26,9 +26,9 @@
 
 #include <EFConfig.h>
 #include <EFLed.h>
+#include <EFLedRing.h>
 #include <EFLogging.h>
 #include <EFPrideFlags.h>
-#include <vector>
 
 #include "FSMState.h"
 
@@ -44,6 +44,11 @@ const unsigned int DisplayPrideFlag::getTickRateMs() {
     return 20;
 }
 
+EFGovernorPerf DisplayPrideFlag::getPerfClass() {
+    // Flags are static between switches
+    return EFGovernorPerf::Low;
+}
+
 void DisplayPrideFlag::entry() {
     this->switchdelay_ms = 5000;
     this->tick = 0;
@@ -108,14 +113,14 @@ void DisplayPrideFlag::run() {
     }
 
     // Animate dragon: Rotate current flag to cycle through dragon head
-    std::vector<CRGB> rotatedflag(prideFlag, prideFlag + EFLED_EFBAR_NUM);
-    std::rotate(rotatedflag.begin(), rotatedflag.begin() + (this->tick % (EFLED_EFBAR_NUM*20)) / 20, rotatedflag.end());
+    EFLedRing<CRGB, EFLED_EFBAR_NUM> rotatedflag(prideFlag);
+    rotatedflag.rotate((this->tick % (EFLED_EFBAR_NUM*20)) / 20);
 
     // Animate dragon: Create current and next dragon head patterns
     CRGB dragon[EFLED_DRAGON_NUM];
     CRGB dragon_next[EFLED_DRAGON_NUM];
-    std::copy(rotatedflag.begin(), rotatedflag.begin() + EFLED_DRAGON_NUM, dragon);
-    std::copy(rotatedflag.begin() + 1, rotatedflag.begin() + 1 + EFLED_DRAGON_NUM, dragon_next);
+    rotatedflag.copyTo(dragon, EFLED_DRAGON_NUM);
+    rotatedflag.copyTo(dragon_next, EFLED_DRAGON_NUM, 1);
 
     // Animate dragon: Blend both patterns based on current tick and reduce brightness
     CRGB dragon_now[EFLED_DRAGON_NUM];
@@ -134,31 +139,31 @@ void DisplayPrideFlag::run() {
     this->tick++;
 }
 
-std::unique_ptr<FSMState> DisplayPrideFlag::touchEventFingerprintShortpress() {
+FSMStateId DisplayPrideFlag::touchEventFingerprintShortpress() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
-    return std::make_unique<MenuMain>();
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> DisplayPrideFlag::touchEventFingerprintLongpress() {
+FSMStateId DisplayPrideFlag::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
 
-std::unique_ptr<FSMState> DisplayPrideFlag::touchEventFingerprintRelease() {
+FSMStateId DisplayPrideFlag::touchEventFingerprintRelease() {
     if (this->isLocked()) {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     this->globals->prideFlagModeIdx = (this->globals->prideFlagModeIdx + 1) % 14;
     this->is_globals_dirty = true;
     this->tick = 0;
 
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> DisplayPrideFlag::touchEventAllLongpress() {
+FSMStateId DisplayPrideFlag::touchEventAllLongpress() {
     this->toggleLock();
-    return nullptr;
+    return FSMStateId::None;
 }
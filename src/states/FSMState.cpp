@@ -30,8 +30,8 @@
 #include "FSMState.h"
 
 
-void FSMState::attachGlobals(std::shared_ptr<FSMGlobals> globals) {
-    this->globals = std::move(globals);
+void FSMState::attachGlobals(FSMGlobals* globals) {
+    this->globals = globals;
 }
 
 bool FSMState::isGlobalsDirty() {
@@ -42,27 +42,41 @@ void FSMState::resetGlobalsDirty() {
     this->is_globals_dirty = false;
 }
 
+/**
+ * @brief Blinks the dragons eye red three times
+ */
+static const EFLedKeyframe effect_lock[] = {
+    {EFLedMask::EYE, CRGB::Red,   200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Red,   200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Red,   200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+};
+
+/**
+ * @brief Blinks the dragons eye green three times
+ */
+static const EFLedKeyframe effect_unlock[] = {
+    {EFLedMask::EYE, CRGB::Green, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Green, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Green, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    {EFLedMask::EYE, CRGB::Black, 200, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+};
+
 void FSMState::lock() {
     this->is_locked = true;
     LOG_INFO("(FSM) Locked current state");
 
-    for (uint8_t i = 0; i < 3; i ++) {
-        EFLed.setDragonEye(CRGB::Red);
-        delay(200);
-        EFLed.setDragonEye(CRGB::Black);
-        delay(200);
-    }
+    EFLed.playEffect(effect_lock);
 }
 
 void FSMState::unlock() {
     this->is_locked = false;
 
-    for (uint8_t i = 0; i < 3; i ++) {
-        EFLed.setDragonEye(CRGB::Green);
-        delay(200);
-        EFLed.setDragonEye(CRGB::Black);
-        delay(200);
-    }
+    EFLed.playEffect(effect_unlock);
 
     LOG_INFO("(FSM) Unlocked current state");
 }
@@ -79,6 +93,14 @@ bool FSMState::isLocked() {
     return this->is_locked;
 }
 
+uint32_t FSMState::getTick() {
+    return this->tick;
+}
+
+void FSMState::setTick(uint32_t tick) {
+    this->tick = tick;
+}
+
 bool FSMState::shouldBeRemembered() {
     return false;
 }
@@ -91,48 +113,64 @@ const unsigned int FSMState::getTickRateMs() {
     return 0;
 }
 
+EFGovernorPerf FSMState::getPerfClass() {
+    return EFGovernorPerf::Normal;
+}
+
+bool FSMState::allowsInactivitySleep() {
+    return true;
+}
+
 void FSMState::entry() {}
 
 void FSMState::run() {}
 
 void FSMState::exit() {}
 
-std::unique_ptr<FSMState> FSMState::touchEventFingerprintTouch() {
-    return nullptr;
+FSMStateId FSMState::touchEventFingerprintTouch() {
+    return FSMStateId::None;
+}
+
+FSMStateId FSMState::touchEventFingerprintRelease() {
+    return FSMStateId::None;
+}
+
+FSMStateId FSMState::touchEventFingerprintShortpress() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventFingerprintRelease() {
-    return nullptr;
+FSMStateId FSMState::touchEventFingerprintLongpress() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventFingerprintShortpress() {
-    return nullptr;
+FSMStateId FSMState::touchEventFingerprintHold() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventFingerprintLongpress() {
-    return nullptr;
+FSMStateId FSMState::touchEventNoseTouch() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventNoseTouch() {
-    return nullptr;
+FSMStateId FSMState::touchEventNoseRelease() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventNoseRelease() {
-    return nullptr;
+FSMStateId FSMState::touchEventNoseShortpress() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventNoseShortpress() {
-    return nullptr;
+FSMStateId FSMState::touchEventNoseLongpress() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventNoseLongpress() {
-    return nullptr;
+FSMStateId FSMState::touchEventNoseHold() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventAllShortpress() {
-    return nullptr;
+FSMStateId FSMState::touchEventAllShortpress() {
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> FSMState::touchEventAllLongpress() {
-    return nullptr;
+FSMStateId FSMState::touchEventAllLongpress() {
+    return FSMStateId::None;
 }
@@ -9,6 +9,7 @@
 #include <EFLed.h>
 #include <EFBoard.h>
 #include <EFLogging.h>
+#include <EFRadio.h>
 #include "FSMState.h"
 #include <EFTouch.h>
 #ifdef HasDisplay
@@ -78,7 +79,7 @@ static uint32_t ef_defaultBadgeIdFromMac() {
   return id;
 }
 
-static TaskHandle_t s_scanTask = nullptr;
+static TaskHandle_t volatile s_scanTask = nullptr;  // cleared by the task itself right before it exits
 static volatile bool s_scanTaskRun = false;
 // --- debug counters / timing ---
 static volatile uint32_t s_seenCallbacks = 0; // already there (keeps incrementing in callback)
@@ -333,6 +334,7 @@ static void bleScanTask(void*){
     scan->clearResults();
     vTaskDelay(pdMS_TO_TICKS(5));
   }
+  s_scanTask = nullptr;
   vTaskDelete(nullptr);
 }
 
@@ -340,24 +342,34 @@ static void startScanning() {
   if (s_scanTask) return; // already running
   s_seenCallbacks = 0;
   s_scanTaskRun = true;
+  TaskHandle_t task = nullptr;
   xTaskCreatePinnedToCore(
     bleScanTask, "BLEScanTask",
-    4096, nullptr, 1, &s_scanTask,
+    4096, nullptr, 1, &task,
     0 /* Core 0 with BT controller */
   );
+  s_scanTask = task;
   LOG_INFO("[FoxHunt] scan task spawned\r\n");
 }
 
 static void stopBLE() {
   auto adv  = BLEDevice::getAdvertising(); if (adv)  adv->stop();
-  // stop the scan task cleanly
+  // stop the scan task cleanly: abort the running scan window and let it leave its loop
   s_scanTaskRun = false;
   if (s_scanTask) {
-    // let the 5s scan window finish; worst-case wait 5s
-    vTaskDelete(s_scanTask);  // if you prefer immediate, uncomment; otherwise let it self-delete
-    s_scanTask = nullptr;
+    BLEDevice::getScan()->stop();
+    for (uint32_t waited = 0; s_scanTask && waited < 2000; waited += 10) {
+      delay(10);
+    }
+    if (s_scanTask) {
+      // never tear down the stack below a task that is still using it
+      LOG_WARNING("[FoxHunt] scan task did not exit, deleting it\r\n");
+      vTaskDelete(s_scanTask);
+      s_scanTask = nullptr;
+    }
   }
-  // BLEDevice::deinit(true); // keep disabled unless you must reclaim BT RAM
+  // deinitializes BLE and returns its heap if no one else uses it
+  EFRadio.release(EFRadioResource::BLE);
 }
 
 // ---------------- GameFoxHuntBle method implementations ----------------
@@ -365,9 +377,10 @@ const char* GameFoxHuntBle::getName() { return "GameFoxHuntBle"; }
 
 bool GameFoxHuntBle::shouldBeRemembered() { return true; }
 
+EFGovernorPerf GameFoxHuntBle::getPerfClass() { return EFGovernorPerf::High; }
+
 void GameFoxHuntBle::entry() {
   LOG_INFO("[FoxHunt] enter\r\n");
-  WiFi.mode(WIFI_OFF);
   this->tick = 0;
   EFLed.clear();
   EFLed.setDragonNose(CRGB(0,50,100));
@@ -399,7 +412,7 @@ void GameFoxHuntBle::entry() {
   //}
   s_devName = devName.c_str();
 
-  BLEDevice::init(s_devName.c_str());
+  EFRadio.acquire(EFRadioResource::BLE, s_devName.c_str());
 
   LOGF_INFO("[FoxHunt] BLE inited: devName=%s\r\n", s_devName.c_str());
 
@@ -588,9 +601,7 @@ void GameFoxHuntBle::run() {
   }
 //}
 
-  #ifdef HasDisplay
-    EFDisplay.loop();
-  #endif
+  // The HUD is drawn by the render loop in main.cpp, never from the FSM
 
   this->tick++;
 }
@@ -598,7 +609,7 @@ void GameFoxHuntBle::run() {
 // touch handlers
 
 // Quick tap = lock next target (cycle & lock)
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventFingerprintRelease() {
+FSMStateId GameFoxHuntBle::touchEventFingerprintRelease() {
   int n = fillSortedByRssi(s_sortedIdx, EF_BLEFH_MAX_PEERS);
   if (n > 0) {
     s_cursor = (s_cursor + 1) % n;
@@ -609,22 +620,21 @@ std::unique_ptr<FSMState> GameFoxHuntBle::touchEventFingerprintRelease() {
   } else {
     LOG_INFO("[FoxHunt] No peers to lock\r\n");
   }
-  return nullptr;
+  return FSMStateId::None;
 }
 
 // Shortpress: unlocking lock track strongest again (keeps UX clean)
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventFingerprintShortpress() {
+FSMStateId GameFoxHuntBle::touchEventFingerprintShortpress() {
   s_lockActive = false;
   LOG_INFO("[FoxHunt] Unlocked");
-  return nullptr;
+  return FSMStateId::None;
 }
 
 // Hold = exit to main menu
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventFingerprintLongpress() {
+FSMStateId GameFoxHuntBle::touchEventFingerprintLongpress() {
   s_lockActive = false;
   s_cursor = -1;
   #ifdef HasDisplay
-    EFDisplay.loop();
     EFDisplay.setHUDEnabled(false);
     EFDisplay.setHUDLine(0, "");
     EFDisplay.setHUDLine(1, "");
@@ -632,36 +642,36 @@ std::unique_ptr<FSMState> GameFoxHuntBle::touchEventFingerprintLongpress() {
     EFDisplay.setHUDLine(3, "");
     EFDisplay.setHUDLine(4, "");
   #endif
-  return std::make_unique<MenuMain>();
+  return FSMStateId::MenuMain;
 }
 
 // -------- Nose --------
 
 // Quick tap = toggle view (TRACK <-> COUNT)
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventNoseRelease() {
+FSMStateId GameFoxHuntBle::touchEventNoseRelease() {
   s_view = (s_view == VIEW_TRACK) ? VIEW_COUNT : VIEW_TRACK;
   LOGF_INFO("[FoxHunt] View -> %s\r\n", (s_view == VIEW_TRACK) ? "TRACK" : "COUNT");
-  return nullptr;
+  return FSMStateId::None;
 }
 
 // Shortpress: treat al long press
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventNoseShortpress() {
+FSMStateId GameFoxHuntBle::touchEventNoseShortpress() {
   return this->touchEventNoseLongpress();
 }
 
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventNoseLongpress() {
+FSMStateId GameFoxHuntBle::touchEventNoseLongpress() {
 // Hold = unlock (stay in current view)
   s_lockActive = false;
   s_cursor = -1;
   LOG_INFO("[FoxHunt] Unlock\r\n");
-  return nullptr;
+  return FSMStateId::None;
 }
 // -------- All --------
 
 // Hold both = toggle lock
-std::unique_ptr<FSMState> GameFoxHuntBle::touchEventAllLongpress() {
+FSMStateId GameFoxHuntBle::touchEventAllLongpress() {
   s_lockActive = !s_lockActive;
   if (!s_lockActive) s_lockedBadgeId = 0;
   LOGF_INFO("[FoxHunt] Toggle lock -> %d\r\n", (int)s_lockActive);
-  return nullptr;
+  return FSMStateId::None;
 }
@@ -25,7 +25,9 @@
  */
 
 #include <EFLed.h>
+#include <EFLedRing.h>
 #include <EFLogging.h>
+#include <EFRadio.h>
 #include "FSMState.h"
 
 #include <algorithm>
@@ -48,7 +50,7 @@ painlessMesh mesh;
 
 uint8_t rainbow[] = {1,24,47,72,96,116,140,164,186,210,232};
 
-std::vector<CRGB> bar = {
+CRGB bar[EFLED_EFBAR_NUM] = {
   CHSV(rainbow[0], 255, 255),
   CHSV(rainbow[1], 255, 255),
   CHSV(rainbow[2], 255, 255),
@@ -156,6 +158,11 @@ bool GameHuemesh::shouldBeRemembered() {
 	return true;
 }
 
+EFGovernorPerf GameHuemesh::getPerfClass() {
+	// painlessMesh handles its JSON messages on the CPU
+	return EFGovernorPerf::High;
+}
+
 void GameHuemesh::entry() {
 	this->tick = 0;
 	own_hue = this->globals->huemeshOwnHue;
@@ -169,7 +176,9 @@ void GameHuemesh::entry() {
 	//We don't need all the power. We are eco friendly! <~<;
 	//setCpuFrequencyMhz(10);
 
-	//Setup meshing
+	//Setup meshing. The mesh runs an access point and a station at the same time.
+	EFRadio.acquire(EFRadioResource::WiFiAP);
+	EFRadio.acquire(EFRadioResource::WiFiSTA);
 	mesh.setDebugMsgTypes(ERROR | STARTUP | CONNECTION);
 
 	// The transmit power can be set from 8 (lowest power ~7dBm) to 84 (highest power 20dBm) (value is in units of 0.25 dBm)
@@ -189,13 +198,20 @@ void GameHuemesh::entry() {
 }
 
 void GameHuemesh::exit() {
+	//Stop game loop and mesh before the radio goes down
+	taskGameloop.disable();
+	userScheduler.deleteTask(taskGameloop);
+	mesh.stop();
+	EFRadio.release(EFRadioResource::WiFiSTA);
+	EFRadio.release(EFRadioResource::WiFiAP);
+
 	EFLed.clear();
 }
 
 void GameHuemesh::run() {
 	mesh.update();
 
-	std::vector<CRGB> dragon = {
+	EFLedRing<CRGB, EFLED_DRAGON_NUM> dragon = {
 	  CHSV(rainbow[own_hue], 255, 255),
 	  CHSV(rainbow[own_hue], 255, 169),
 	  CHSV(rainbow[own_hue], 255, 124),
@@ -205,7 +221,7 @@ void GameHuemesh::run() {
 	};
 	
 	if(edit_happen < 12){
-		std::rotate(dragon.begin(), dragon.begin() + this->tick % EFLED_DRAGON_NUM, dragon.end());
+		dragon.rotate(this->tick);
 		edit_happen++;
 	} else {
 		dragon = {
@@ -220,30 +236,30 @@ void GameHuemesh::run() {
 	
 	/*
 	if(refresh_happen < 11){
-		std::rotate(bar.begin(), bar.begin() + this->tick % 11, bar.end());
+		std::rotate(bar, bar + this->tick % 11, bar + EFLED_EFBAR_NUM);
 		refresh_happen++;
 	}
 	*/
 
-	dragon.insert(dragon.end(), bar.begin(), bar.end());
-	EFLed.setAll(dragon.data());
+	dragon.writeTo(EFLed.dragon());
+	std::copy(bar, bar + EFLED_EFBAR_NUM, EFLed.efbar().begin());
 
 	this->tick++;
 }
 
 
-std::unique_ptr<FSMState> GameHuemesh::touchEventFingerprintShortpress() {
+FSMStateId GameHuemesh::touchEventFingerprintShortpress() {
 	if (this->isLocked()) {
-		return nullptr;
+		return FSMStateId::None;
 	}
-	return nullptr;
+	return FSMStateId::None;
 }
 
 
 
-std::unique_ptr<FSMState> GameHuemesh::touchEventFingerprintRelease() {
+FSMStateId GameHuemesh::touchEventFingerprintRelease() {
 	if (this->isLocked()) {
-		return nullptr;
+		return FSMStateId::None;
 	}
 
 	own_hue = (this->globals->huemeshOwnHue + 1) % NUM_HUES;
@@ -251,18 +267,18 @@ std::unique_ptr<FSMState> GameHuemesh::touchEventFingerprintRelease() {
 	this->is_globals_dirty = true;
 	this->tick = 0;
 
-	return nullptr;
+	return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> GameHuemesh::touchEventNoseShortpress() {
-	return nullptr;
+FSMStateId GameHuemesh::touchEventNoseShortpress() {
+	return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> GameHuemesh::touchEventNoseLongpress() {
-	return nullptr;
+FSMStateId GameHuemesh::touchEventNoseLongpress() {
+	return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> GameHuemesh::touchEventNoseRelease() {
+FSMStateId GameHuemesh::touchEventNoseRelease() {
 	//Subtract 1 from all others
 	for(int i=0; i < NUM_HUES; i++){
 		if(hue_consensus[i] > 1 && i != own_hue) hue_consensus[i]--;
@@ -275,11 +291,11 @@ std::unique_ptr<FSMState> GameHuemesh::touchEventNoseRelease() {
 	update_bar_to_reflect_consensus();
 	
 	edit_happen = 0;
-	return nullptr;
+	return FSMStateId::None;
 }
 
 
-std::unique_ptr<FSMState> GameHuemesh::touchEventAllLongpress() {
+FSMStateId GameHuemesh::touchEventAllLongpress() {
 	this->toggleLock();
-	return nullptr;
+	return FSMStateId::None;
 }
@@ -37,9 +37,24 @@
 /**
  * @brief Number of registered menu items
  */
-#define MENUMAIN_NUM_MENU_ITEMS 10
+#define MENUMAIN_NUM_MENU_ITEMS 11
 
-CRGB menuColors[11] = {
+/**
+ * @brief Brightness percent changed per nose longpress / hold event
+ */
+#define MENUMAIN_BRIGHTNESS_STEP 5
+
+/**
+ * @brief Lowest brightness percent reachable by scrubbing
+ */
+#define MENUMAIN_BRIGHTNESS_MIN 10
+
+/**
+ * @brief Number of ticks the brightness bar stays visible after scrubbing
+ */
+#define MENUMAIN_SCRUB_DISPLAY_TICKS 8
+
+CRGB menuColors[MENUMAIN_NUM_MENU_ITEMS] = {
     CRGB(40,10,10),
     CRGB(10,10, 40),
     CRGB(40, 40,10),
@@ -49,7 +64,8 @@ CRGB menuColors[11] = {
     CRGB(40, 20, 20),
     CRGB(20, 40, 20),
     CRGB(40, 40, 20),
-    CRGB(20, 40, 40) //TODO, why is there only 10 here? (array sized 11)
+    CRGB(20, 40, 40),
+    CRGB(5, 5, 10)
 };
 
 const char *MenuMain::getName() {
@@ -64,13 +80,21 @@ void MenuMain::entry() {
     EFLed.clear();
     EFLed.setDragonCheek(CRGB::Green);
     #ifdef HasDisplay
-        String menu = "PrideFlag\nRainbow\nMatrix\nSnake\nHeartbeat\nNA-OTAUpdate\nPerlin\nHuemesh\nVUMeter\nFoxHunt";
+        const char* menu = "PrideFlag\nRainbow\nMatrix\nSnake\nHeartbeat\nNA-OTAUpdate\nPerlin\nHuemesh\nVUMeter\nFoxHunt\nSleep";
         EFDisplay.DisplayMenu(menu,true);
     #endif
     EFLed.setEFBarCursor(this->globals->menuMainPointerIdx, CRGB::Silver, CRGB::Black);
     this->tick = 0;
 }
 void MenuMain::run() {
+    if (this->scrub_ticks > 0) {
+        // Keep the brightness bar visible for a moment after scrubbing, then reset view
+        if (--this->scrub_ticks == 0) {
+            this->entry();
+        }
+        return;
+    }
+
     CRGB cursorColor = tick % 6 < 2 ? CRGB::Silver : CRGB::DarkBlue;
     EFLed.setEFBarCursor(this->globals->menuMainPointerIdx, cursorColor, menuColors[this->globals->menuMainPointerIdx]);
 
@@ -84,80 +108,74 @@ void MenuMain::exit() {
     EFLed.clear();
 }
 
-std::unique_ptr<FSMState> MenuMain::touchEventFingerprintRelease() {
+FSMStateId MenuMain::touchEventFingerprintRelease() {
     this->globals->menuMainPointerIdx = (this->globals->menuMainPointerIdx + 1) % MENUMAIN_NUM_MENU_ITEMS;
     EFLed.setEFBarCursor(this->globals->menuMainPointerIdx, CRGB::Purple, menuColors[this->globals->menuMainPointerIdx]);
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> MenuMain::touchEventFingerprintShortpress() {
+FSMStateId MenuMain::touchEventFingerprintShortpress() {
     LOGF_DEBUG("(MenuMain) menuMainPointerIdx = %d\r\n", this->globals->menuMainPointerIdx);
     switch (this->globals->menuMainPointerIdx) {
         // NOTE: Increase MENUMAIN_NUM_MENU_ITEMS define at the top of this file
         // NOTE: if you have a display dont forget to add the names of the menu entrys in the entry funktion
-        case 0: return std::make_unique<DisplayPrideFlag>();
-        case 1: return std::make_unique<AnimateRainbow>();
-        case 2: return std::make_unique<AnimateMatrix>();
-        case 3: return std::make_unique<AnimateSnake>();
-        case 4: return std::make_unique<AnimateHeartbeat>();
-//      case 5: return std::make_unique<OTAUpdate>(); // OTA Update not in production firmware
-        case 6: return std::make_unique<AnimatePerlin>();
-		case 7: return std::make_unique<GameHuemesh>(); //Game :3
-		case 8: return std::make_unique<VUMeter>(); //VUMeter :3
-        case 9: return std::make_unique<GameFoxHuntBle>(); //Game BLE FoxHunt :3
-        default: return nullptr;
+        case 0: return FSMStateId::DisplayPrideFlag;
+        case 1: return FSMStateId::AnimateRainbow;
+        case 2: return FSMStateId::AnimateMatrix;
+        case 3: return FSMStateId::AnimateSnake;
+        case 4: return FSMStateId::AnimateHeartbeat;
+//      case 5: return FSMStateId::OTAUpdate; // OTA Update not in production firmware
+        case 6: return FSMStateId::AnimatePerlin;
+		case 7: return FSMStateId::GameHuemesh; //Game :3
+		case 8: return FSMStateId::VUMeter; //VUMeter :3
+        case 9: return FSMStateId::GameFoxHuntBle; //Game BLE FoxHunt :3
+        case 10: return FSMStateId::DeepSleep;
+        default: return FSMStateId::None;
     }
 }
 
-std::unique_ptr<FSMState> MenuMain::touchEventFingerprintLongpress() {
+FSMStateId MenuMain::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
 
-std::unique_ptr<FSMState> MenuMain::touchEventNoseLongpress() {
-    EFLed.clear();
-    EFLed.setDragonEye(CRGB::White);
+FSMStateId MenuMain::touchEventNoseLongpress() {
+    // Scrub towards the farther end, holding the nose keeps going
+    this->brightness_direction = this->globals->ledBrightnessPercent < (MENUMAIN_BRIGHTNESS_MIN + 100) / 2 ? 1 : -1;
+    this->scrubBrightness();
+    return FSMStateId::None;
+}
 
-    uint8_t currentBrightness = this->globals->ledBrightnessPercent;
-    // if we start at 10, it will be 10 -> 40 -> 70 -> 100 -> 10…
-    uint8_t newBrightness =  currentBrightness + 30;
-    if (newBrightness > 100) {
-        // wrap over to minimum brightness again
-        newBrightness = 10;
+FSMStateId MenuMain::touchEventNoseHold() {
+    // Only continue a scrub started by a longpress in this state
+    if (this->brightness_direction != 0) {
+        this->scrubBrightness();
     }
-    LOGF_DEBUG("(MenuMain) Setting brightness percent to %d\r\n", newBrightness);
+    return FSMStateId::None;
+}
 
-    // animate to new brightness
-    CRGB data[EFLED_EFBAR_NUM];
-    fill_solid(data, EFLED_EFBAR_NUM, CRGB::Black);
-    float stepSize = (newBrightness - currentBrightness) / 10.0f;
-    fill_solid(data, map(currentBrightness, 0, 100, 0, EFLED_EFBAR_NUM), CRGB(30, 30, 30));
-    EFLed.setEFBar(data);
-    delay(100);
-    fill_solid(data, map(currentBrightness, 0, 100, 0, EFLED_EFBAR_NUM), CRGB(100, 100, 100));
-    EFLed.setEFBar(data);
-    delay(200);
-    for(int8_t i = 1; i <= 10; i++) {
-        float interpolatedBrightness = currentBrightness + (i * stepSize);
-        EFLed.setBrightnessPercent(interpolatedBrightness);
-        fill_solid(data, EFLED_EFBAR_NUM, CRGB::Black);
-        fill_solid(data, map(interpolatedBrightness, 0, 100, 0, EFLED_EFBAR_NUM), CRGB(100, 100, 100));
-        EFLed.setEFBar(data);
-        delay(40);
+void MenuMain::scrubBrightness() {
+    int16_t newBrightness = this->globals->ledBrightnessPercent + this->brightness_direction * MENUMAIN_BRIGHTNESS_STEP;
+    // Bounce off both ends to allow going back without letting go
+    if (newBrightness >= 100) {
+        newBrightness = 100;
+        this->brightness_direction = -1;
+    } else if (newBrightness <= MENUMAIN_BRIGHTNESS_MIN) {
+        newBrightness = MENUMAIN_BRIGHTNESS_MIN;
+        this->brightness_direction = 1;
     }
-    fill_solid(data, map(newBrightness, 0, 100, 0, EFLED_EFBAR_NUM), CRGB(100, 100, 100));
-    EFLed.setEFBar(data);
-    delay(400);
+    LOGF_DEBUG("(MenuMain) Setting brightness percent to %d\r\n", newBrightness);
+
+    EFLed.stopEffect();
+    EFLed.setBrightnessPercent(newBrightness);
+    EFLed.setDragonEye(CRGB::White);
+    EFLed.fillEFBarProportionally(newBrightness, CRGB(100, 100, 100), CRGB::Black);
+    this->scrub_ticks = MENUMAIN_SCRUB_DISPLAY_TICKS;
 
     this->globals->ledBrightnessPercent = newBrightness;
     this->is_globals_dirty = true;
-    EFLed.setBrightnessPercent(this->globals->ledBrightnessPercent);
-
-    // reset view
-    this->entry();
-    return nullptr;
 }
 
-std::unique_ptr<FSMState> MenuMain::touchEventNoseShortpress() {//if display is configures show oled boot anim
+FSMStateId MenuMain::touchEventNoseShortpress() {//if display is configures show oled boot anim
     EFLed.clear();
     EFLed.setDragonEye(CRGB(0,25,100));
     #ifdef HasDisplay
@@ -168,32 +186,24 @@ std::unique_ptr<FSMState> MenuMain::touchEventNoseShortpress() {//if display is
 
     // reset view
     this->entry();
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> MenuMain::touchEventNoseRelease() {//show Battery Precent  new funktion
-    EFLed.clear();
-    EFLed.setDragonEye(CRGB(0,25,100));
-
+FSMStateId MenuMain::touchEventNoseRelease() {//show Battery Precent  new funktion
     uint8_t BatteryChargePrecent = EFBoard.getBatteryCapacityPercent();
 
     LOGF_DEBUG("(MenuMain) Showing Battery Precentage on LEDS %d %%\r\n", BatteryChargePrecent);
 
-    // animate to new brightness
-    CRGB data[EFLED_EFBAR_NUM];
-    fill_solid(data, EFLED_EFBAR_NUM, CRGB::Black);
-
-    //fill_solid(data, map(BatteryChargePrecent, 0, 100, 0, EFLED_EFBAR_NUM), CRGB(100, 100, 100));
-
-    uint8_t ledsOn = map(BatteryChargePrecent, 0, 100, 0, EFLED_EFBAR_NUM);
     // Fill from (total - ledsOn) to end
-    fill_solid(&data[EFLED_EFBAR_NUM - ledsOn], ledsOn, CRGB(100, 100, 100));
-
-    EFLed.setEFBar(data);
-    delay(600);
+    uint8_t ledsOn = map(BatteryChargePrecent, 0, 100, 0, EFLED_EFBAR_NUM);
+    const EFLedKeyframe effect_battery[] = {
+        {EFLedMask::EYE, CRGB(0, 25, 100), 0, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+        {EFLedMask::efbarBottom(ledsOn), CRGB(100, 100, 100), 600, EFLedTween::Step, EFLED_EFFECT_KEEP_BRIGHTNESS},
+    };
+    EFLed.playEffect(effect_battery, EFLedMask::ALL);
 
     // reset view
     this->entry();
-    return nullptr;
+    return FSMStateId::None;
 }
 
@@ -28,6 +28,7 @@
 
 #include <EFBoard.h>
 #include <EFLed.h>
+#include <EFRadio.h>
 
 #include "secrets.h"
 
@@ -37,9 +38,20 @@ const char* OTAUpdate::getName() {
     return "OTAUpdate";
 }
 
+EFGovernorPerf OTAUpdate::getPerfClass() {
+    // Flashing the received image is bound by the WiFi stack
+    return EFGovernorPerf::High;
+}
+
+bool OTAUpdate::allowsInactivitySleep() {
+    // Nobody touches the badge while an update is downloaded
+    return false;
+}
+
 void OTAUpdate::entry() {
     // Connect to WiFi
     EFLed.setDragonNose(CRGB::Red);
+    EFRadio.acquire(EFRadioResource::WiFiSTA);
     if (EFBoard.connectToWifi(WIFI_SSID, WIFI_PASSWORD)) {
         EFLed.setDragonNose(CRGB::Green);
     }
@@ -55,13 +67,13 @@ void OTAUpdate::run() {
 
 void OTAUpdate::exit() {
     EFBoard.disableOTA();
-    EFBoard.disableWifi();
+    EFRadio.release(EFRadioResource::WiFiSTA);
 }
 
-std::unique_ptr<FSMState> OTAUpdate::touchEventFingerprintShortpress() {
-    return std::make_unique<MenuMain>();
+FSMStateId OTAUpdate::touchEventFingerprintShortpress() {
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> OTAUpdate::touchEventFingerprintLongpress() {
+FSMStateId OTAUpdate::touchEventFingerprintLongpress() {
     return this->touchEventFingerprintShortpress();
 }
@@ -118,37 +118,37 @@ void VUMeter::run()
 
 }
 
-std::unique_ptr<FSMState> VUMeter::touchEventFingerprintShortpress()
+FSMStateId VUMeter::touchEventFingerprintShortpress()
 {
     if (this->isLocked())
     {
-        return nullptr;
+        return FSMStateId::None;
     }
 
-    return std::make_unique<MenuMain>();
+    return FSMStateId::MenuMain;
 }
 
-std::unique_ptr<FSMState> VUMeter::touchEventFingerprintLongpress()
+FSMStateId VUMeter::touchEventFingerprintLongpress()
 {
     return this->touchEventFingerprintShortpress();
 }
 
-std::unique_ptr<FSMState> VUMeter::touchEventFingerprintRelease()
+FSMStateId VUMeter::touchEventFingerprintRelease()
 {
     if (this->isLocked())
     {
-        return nullptr;
+        return FSMStateId::None;
     }
 
     dragon_hue = (dragon_hue + 31) % 256;
 
-    return nullptr;
+    return FSMStateId::None;
 }
 
-std::unique_ptr<FSMState> VUMeter::touchEventAllLongpress()
+FSMStateId VUMeter::touchEventAllLongpress()
 {
     this->toggleLock();
-    return nullptr;
+    return FSMStateId::None;
 }
 
 long map_l(long x, long in_min, long in_max, long out_min, long out_max) {
@@ -0,0 +1,183 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Hard brown out deep sleep cycle of EFBoardBrownOut on a fake platform
+ *
+ * Run: pio test -e native -f test_brownout
+ */
+
+#include <unity.h>
+
+#include <cstring>
+
+#include <EFBoardBrownOut.h>
+
+#define RECOVER_MV 3500
+#define INTERVAL_MS 5000
+#define BLINK_MS 100
+
+/**
+ * @brief Platform that records the calls instead of touching hardware
+ */
+class FakePlatform : public EFBoardBrownOutPlatform {
+
+    public:
+
+        uint32_t vbat_mv = 0;
+        uint32_t reads = 0;
+        uint32_t blinks = 0;
+        uint32_t blink_ms = 0;
+        uint32_t sleeps = 0;
+        uint32_t sleep_ms = 0;
+
+        uint32_t readBatteryMilliVolts() override {
+            this->reads++;
+            return this->vbat_mv;
+        }
+
+        void blink(uint32_t duration_ms) override {
+            this->blinks++;
+            this->blink_ms = duration_ms;
+        }
+
+        void deepSleep(uint32_t duration_ms) override {
+            this->sleeps++;
+            this->sleep_ms = duration_ms;
+        }
+};
+
+static FakePlatform platform;
+// Zeroed like RTC memory after a power-on reset
+static EFBoardBrownOutRecord record;
+
+static EFBoardBrownOut makeBrownOut() {
+    return EFBoardBrownOut(platform, record, RECOVER_MV, INTERVAL_MS, BLINK_MS);
+}
+
+void setUp() {
+    platform = FakePlatform();
+    memset(&record, 0, sizeof(record));
+}
+
+void tearDown() {}
+
+void test_cold_boot_is_not_pending() {
+    EFBoardBrownOut brownout = makeBrownOut();
+
+    TEST_ASSERT_FALSE(brownout.isPending());
+    TEST_ASSERT_EQUAL_INT((int) EFBoardBrownOutStep::None, (int) brownout.wakeup());
+    TEST_ASSERT_EQUAL_UINT32(0, platform.reads);
+    TEST_ASSERT_EQUAL_UINT32(0, platform.sleeps);
+}
+
+void test_garbage_record_is_not_pending() {
+    // RTC memory content after a brown out reset is undefined
+    memset(&record, 0xA5, sizeof(record));
+    EFBoardBrownOut brownout = makeBrownOut();
+
+    TEST_ASSERT_FALSE(brownout.isPending());
+    TEST_ASSERT_EQUAL_INT((int) EFBoardBrownOutStep::None, (int) brownout.wakeup());
+}
+
+void test_enter_records_and_sleeps() {
+    EFBoardBrownOut brownout = makeBrownOut();
+    brownout.enter(EFBoardBrownOutReason::Runtime, 3100);
+
+    TEST_ASSERT_TRUE(brownout.isPending());
+    TEST_ASSERT_EQUAL_HEX32(EFBOARDBROWNOUT_MAGIC, record.magic);
+    TEST_ASSERT_EQUAL_UINT32(0, record.wakeups);
+    TEST_ASSERT_EQUAL_UINT16(3100, record.detected_mv);
+    TEST_ASSERT_EQUAL_UINT16(3100, record.last_mv);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t) EFBoardBrownOutReason::Runtime, record.reason);
+    TEST_ASSERT_EQUAL_UINT32(1, platform.blinks);
+    TEST_ASSERT_EQUAL_UINT32(BLINK_MS, platform.blink_ms);
+    TEST_ASSERT_EQUAL_UINT32(1, platform.sleeps);
+    TEST_ASSERT_EQUAL_UINT32(INTERVAL_MS, platform.sleep_ms);
+}
+
+void test_low_wakeup_sleeps_again() {
+    makeBrownOut().enter(EFBoardBrownOutReason::Boot, 3100);
+
+    // Every wakeup reboots, so each one constructs a fresh instance on the kept record
+    platform.vbat_mv = 3200;
+    for (uint32_t i = 1; i <= 3; i++) {
+        TEST_ASSERT_EQUAL_INT((int) EFBoardBrownOutStep::Sleep, (int) makeBrownOut().wakeup());
+        TEST_ASSERT_EQUAL_UINT32(i, record.wakeups);
+    }
+    TEST_ASSERT_EQUAL_UINT16(3200, record.last_mv);
+    TEST_ASSERT_EQUAL_UINT16(3100, record.detected_mv);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t) EFBoardBrownOutReason::Boot, record.reason);
+    TEST_ASSERT_EQUAL_UINT32(4, platform.blinks);
+    TEST_ASSERT_EQUAL_UINT32(4, platform.sleeps);
+    TEST_ASSERT_TRUE(makeBrownOut().isPending());
+}
+
+void test_recovered_wakeup_clears_record() {
+    makeBrownOut().enter(EFBoardBrownOutReason::Runtime, 3100);
+    platform.vbat_mv = RECOVER_MV - 1;
+    makeBrownOut().wakeup();
+
+    platform.vbat_mv = RECOVER_MV;
+    EFBoardBrownOut brownout = makeBrownOut();
+    TEST_ASSERT_EQUAL_INT((int) EFBoardBrownOutStep::Recovered, (int) brownout.wakeup());
+    TEST_ASSERT_FALSE(brownout.isPending());
+    TEST_ASSERT_NOT_EQUAL(EFBOARDBROWNOUT_MAGIC, record.magic);
+    // The statistics stay readable for the log after the recovery
+    TEST_ASSERT_EQUAL_UINT32(1, record.wakeups);
+    TEST_ASSERT_EQUAL_UINT16(RECOVER_MV, record.last_mv);
+    // Recovering neither blinks nor sleeps
+    TEST_ASSERT_EQUAL_UINT32(2, platform.blinks);
+    TEST_ASSERT_EQUAL_UINT32(2, platform.sleeps);
+
+    // The next boot is a regular one
+    TEST_ASSERT_EQUAL_INT((int) EFBoardBrownOutStep::None, (int) makeBrownOut().wakeup());
+}
+
+void test_wakeups_saturate() {
+    makeBrownOut().enter(EFBoardBrownOutReason::Runtime, 3100);
+    record.wakeups = UINT32_MAX - 1;
+    platform.vbat_mv = 3000;
+
+    makeBrownOut().wakeup();
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, record.wakeups);
+    TEST_ASSERT_EQUAL_INT((int) EFBoardBrownOutStep::Sleep, (int) makeBrownOut().wakeup());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, record.wakeups);
+}
+
+void test_reason_names() {
+    TEST_ASSERT_EQUAL_STRING("none", toString(EFBoardBrownOutReason::None));
+    TEST_ASSERT_EQUAL_STRING("boot", toString(EFBoardBrownOutReason::Boot));
+    TEST_ASSERT_EQUAL_STRING("runtime", toString(EFBoardBrownOutReason::Runtime));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_cold_boot_is_not_pending);
+    RUN_TEST(test_garbage_record_is_not_pending);
+    RUN_TEST(test_enter_records_and_sleeps);
+    RUN_TEST(test_low_wakeup_sleeps_again);
+    RUN_TEST(test_recovered_wakeup_clears_record);
+    RUN_TEST(test_wakeups_saturate);
+    RUN_TEST(test_reason_names);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Runs setup() from src/main.cpp in the simulator and checks that the
+ * run() methods ported to fixed-size LED patterns render frames without
+ * allocating heap memory.
+ *
+ * Run: pio test -e native -f test_frameallocations
+ */
+
+#include <unity.h>
+
+#include <EFLed.h>
+#include <FSMState.h>
+
+#include "EFSim.h"
+
+void setup();
+
+// Frames to render before counting, so one-time lazy initialization is excluded
+#define WARMUP_FRAMES 10
+#define FRAMES 1000
+// Tick rate of states without their own, fsm(10) in src/main.cpp
+#define FSM_TICK_RATE_MS 10
+
+static FSMGlobals globals;
+
+/**
+ * @brief Renders frames like FSM::handle() does and counts the frames that
+ * allocated heap memory, including the push to the LEDs
+ */
+static uint32_t allocatingFrames(FSMState& state) {
+    state.attachGlobals(&globals);
+    state.entry();
+    const unsigned int tick_ms = state.getTickRateMs() ? state.getTickRateMs() : FSM_TICK_RATE_MS;
+
+    uint32_t frames = 0;
+    for (uint32_t frame = 0; frame < WARMUP_FRAMES + FRAMES; frame++) {
+        EFSim.advance(tick_ms * 1000);
+        const uint64_t allocations_start = efsim_heap_allocations;
+        EFLed.beginFrame();
+        state.run();
+        EFLed.commitFrame();
+        if (frame >= WARMUP_FRAMES && efsim_heap_allocations != allocations_start) {
+            frames++;
+        }
+    }
+    state.exit();
+    return frames;
+}
+
+void setUp() {
+    globals = FSMGlobals();
+}
+
+void tearDown() {}
+
+void test_animate_matrix() {
+    AnimateMatrix state;
+    TEST_ASSERT_EQUAL_UINT32(0, allocatingFrames(state));
+}
+
+void test_animate_snake_every_mode() {
+    // Snake, knight rider, pulse and random
+    for (uint8_t mode = 0; mode < 4; mode++) {
+        globals.animSnakeAnimationIdx = mode;
+        AnimateSnake state;
+        char message[32];
+        snprintf(message, sizeof(message), "mode %u", mode);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocatingFrames(state), message);
+    }
+}
+
+void test_display_pride_flag() {
+    DisplayPrideFlag state;
+    TEST_ASSERT_EQUAL_UINT32(0, allocatingFrames(state));
+}
+
+void test_game_huemesh() {
+    // The mesh API takes a String, so only frames carrying the broadcast of
+    // the game loop (every 1.5 s) may allocate
+    GameHuemesh state;
+    const uint32_t broadcasts = FRAMES * (state.getTickRateMs() ? state.getTickRateMs() : FSM_TICK_RATE_MS) / 1500 + 1;
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(broadcasts, allocatingFrames(state));
+}
+
+int main() {
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_animate_matrix);
+    RUN_TEST(test_animate_snake_every_mode);
+    RUN_TEST(test_display_pride_flag);
+    RUN_TEST(test_game_huemesh);
+    return UNITY_END();
+}
@@ -0,0 +1,179 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Compares the compile-time EFLedGeometry tables against runtime
+ * trigonometry, both for correctness and speed
+ *
+ * Run: pio test -e native -f test_ledgeometry -v (prints the benchmark results)
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include <EFLedGeometry.h>
+
+#define BENCHMARK_FRAMES 200000
+
+using namespace EFLedGeometry;
+
+static float runtimeDistance(EFLedPoint a, EFLedPoint b) {
+    const float dx = a.x - b.x;
+    const float dy = a.y - b.y;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+static float runtimeAngle(EFLedPoint from, EFLedPoint to) {
+    const float turn = atan2f(to.y - from.y, to.x - from.x) / (2 * M_PI);
+    return turn < 0 ? (turn + 1) * 256 : turn * 256;
+}
+
+static float angleError(float expected, uint8_t actual) {
+    const float error = fabsf(expected - actual);
+    return error > 128 ? 256 - error : error;
+}
+
+// Positions as EFLed::getLEDPosition() returns them, unknown to the compiler
+static EFLedPoint positions[EFLED_TOTAL_NUM];
+static float distances[EFLED_TOTAL_NUM];
+
+/**
+ * @brief Keeps the compiler from hoisting work out of the frame loop or dropping
+ * the unused results
+ */
+static inline void frameBarrier() {
+    asm volatile("" : : "r"(distances), "r"(positions) : "memory");
+}
+
+/**
+ * @brief Nanoseconds spent per frame computing the distance of every LED to
+ * the eye, the way animations did it before the tables existed
+ */
+static double benchmarkRuntime() {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+            distances[i] = runtimeDistance(positions[i], positions[EFLED_DRAGON_EYE_IDX]);
+        }
+        frameBarrier();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_FRAMES;
+}
+
+/**
+ * @brief Nanoseconds spent per frame looking up the same distances
+ */
+static double benchmarkTable() {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+            distances[i] = toMillimeters(DISTANCE_FROM_EYE[i]);
+        }
+        frameBarrier();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_FRAMES;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_distance_tables_match_sqrt() {
+    const float tolerance = 0.5f / (1 << DIST_FRAC_BITS);
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, runtimeDistance(POSITIONS[i], ANCHOR_EYE), toMillimeters(DISTANCE_FROM_EYE[i]));
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, runtimeDistance(POSITIONS[i], ANCHOR_NOSE), toMillimeters(DISTANCE_FROM_NOSE[i]));
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, runtimeDistance(POSITIONS[i], ANCHOR_POWER_BUTTON), toMillimeters(DISTANCE_FROM_POWER_BUTTON[i]));
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, runtimeDistance(POSITIONS[i], CENTER), toMillimeters(DISTANCE_FROM_CENTER[i]));
+    }
+}
+
+void test_angle_tables_match_atan2() {
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        if (i != EFLED_DRAGON_EYE_IDX) {
+            TEST_ASSERT_LESS_THAN(1.0f, angleError(runtimeAngle(ANCHOR_EYE, POSITIONS[i]), ANGLE_FROM_EYE[i]));
+        }
+        if (i != EFLED_DRAGON_NOSE_IDX) {
+            TEST_ASSERT_LESS_THAN(1.0f, angleError(runtimeAngle(ANCHOR_NOSE, POSITIONS[i]), ANGLE_FROM_NOSE[i]));
+        }
+        TEST_ASSERT_LESS_THAN(1.0f, angleError(runtimeAngle(CENTER, POSITIONS[i]), ANGLE_FROM_CENTER[i]));
+    }
+}
+
+void test_angle_approximation_error() {
+    for (int32_t dy = -64; dy <= 64; dy++) {
+        for (int32_t dx = -64; dx <= 64; dx++) {
+            if (dx == 0 && dy == 0) {
+                continue;
+            }
+            TEST_ASSERT_LESS_THAN(1.0f, angleError(runtimeAngle({0, 0}, {(int16_t) dx, (int16_t) dy}), angle(dx, dy)));
+        }
+    }
+}
+
+void test_normalized_tables_span_full_range() {
+    uint8_t min_x = 255, max_x = 0, min_y = 255, max_y = 0;
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        min_x = std::min(min_x, NORMALIZED_X[i]);
+        max_x = std::max(max_x, NORMALIZED_X[i]);
+        min_y = std::min(min_y, NORMALIZED_Y[i]);
+        max_y = std::max(max_y, NORMALIZED_Y[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, min_x);
+    TEST_ASSERT_EQUAL_UINT8(255, max_x);
+    TEST_ASSERT_EQUAL_UINT8(0, min_y);
+    TEST_ASSERT_EQUAL_UINT8(255, max_y);
+}
+
+void test_benchmark_table_against_runtime() {
+    for (uint8_t i = 0; i < EFLED_TOTAL_NUM; i++) {
+        positions[i] = POSITIONS[i];
+    }
+    // Warm up caches and the CPU clock before measuring
+    benchmarkRuntime();
+    const double runtime_ns = benchmarkRuntime();
+    const double table_ns = benchmarkTable();
+
+    char message[128];
+    snprintf(
+        message,
+        sizeof(message),
+        "Distances of %d LEDs per frame: sqrt %.1f ns, table %.1f ns",
+        EFLED_TOTAL_NUM,
+        runtime_ns,
+        table_ns
+    );
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_distance_tables_match_sqrt);
+    RUN_TEST(test_angle_tables_match_atan2);
+    RUN_TEST(test_angle_approximation_error);
+    RUN_TEST(test_normalized_tables_span_full_range);
+    RUN_TEST(test_benchmark_table_against_runtime);
+    return UNITY_END();
+}
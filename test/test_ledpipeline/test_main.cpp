@@ -0,0 +1,177 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Frame handoff of EFLedPipeline into EFLedMockBackend
+ *
+ * Run: pio test -e native -f test_ledpipeline
+ */
+
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include <EFLedPipeline.h>
+
+#define TEST_LEDS 18
+
+/**
+ * @brief Backend checking that every frame is consistent, i.e. all bytes
+ * equal the low byte of its sequence number, and sequence numbers increase
+ */
+class ConsistencyBackend : public EFLedBackend<TEST_LEDS> {
+
+    public:
+
+        uint32_t writes = 0;
+        uint32_t torn = 0;
+        uint32_t out_of_order = 0;
+        int64_t last_seq = -1;
+
+        bool write(const EFLedFrame<TEST_LEDS>& frame) override {
+            for (uint8_t i = 0; i < sizeof(frame.rgb); i++) {
+                if (frame.rgb[i] != (uint8_t) frame.seq || frame.brightness != (uint8_t) frame.seq) {
+                    this->torn++;
+                    break;
+                }
+            }
+            if ((int64_t) frame.seq <= this->last_seq) {
+                this->out_of_order++;
+            }
+            this->last_seq = frame.seq;
+            this->writes++;
+            return true;
+        }
+};
+
+static void publishFilled(EFLedPipeline<TEST_LEDS>& pipeline, uint8_t value) {
+    uint8_t rgb[TEST_LEDS * 3];
+    memset(rgb, value, sizeof(rgb));
+    pipeline.publish(rgb, value);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_service_without_frame() {
+    EFLedPipeline<TEST_LEDS> pipeline;
+    EFLedMockBackend<TEST_LEDS> backend;
+
+    TEST_ASSERT_TRUE(pipeline.idle());
+    TEST_ASSERT_FALSE(pipeline.service(backend));
+    TEST_ASSERT_EQUAL_UINT32(0, backend.getWriteCount());
+}
+
+void test_published_frame_reaches_backend() {
+    EFLedPipeline<TEST_LEDS> pipeline;
+    EFLedMockBackend<TEST_LEDS> backend;
+
+    publishFilled(pipeline, 0x2A);
+    TEST_ASSERT_TRUE(pipeline.pending());
+    TEST_ASSERT_FALSE(pipeline.idle());
+
+    TEST_ASSERT_TRUE(pipeline.service(backend));
+    TEST_ASSERT_TRUE(pipeline.idle());
+    TEST_ASSERT_EQUAL_UINT32(1, backend.getWriteCount());
+    TEST_ASSERT_EQUAL_UINT8(0x2A, backend.getLastFrame().brightness);
+    TEST_ASSERT_EQUAL_UINT8(0x2A, backend.getLastFrame().rgb[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x2A, backend.getLastFrame().rgb[TEST_LEDS * 3 - 1]);
+    TEST_ASSERT_EQUAL_UINT32(0, backend.getLastFrame().seq);
+
+    // Each frame is transmitted once
+    TEST_ASSERT_FALSE(pipeline.service(backend));
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.getTransmittedCount());
+}
+
+void test_newest_frame_wins() {
+    EFLedPipeline<TEST_LEDS> pipeline;
+    EFLedMockBackend<TEST_LEDS> backend;
+
+    publishFilled(pipeline, 1);
+    publishFilled(pipeline, 2);
+    publishFilled(pipeline, 3);
+    TEST_ASSERT_TRUE(pipeline.service(backend));
+    TEST_ASSERT_FALSE(pipeline.service(backend));
+
+    TEST_ASSERT_EQUAL_UINT32(1, backend.getWriteCount());
+    TEST_ASSERT_EQUAL_UINT8(3, backend.getLastFrame().rgb[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, backend.getLastFrame().seq);
+    TEST_ASSERT_EQUAL_UINT32(3, pipeline.getPublishedCount());
+    TEST_ASSERT_EQUAL_UINT32(2, pipeline.getCoalescedCount());
+}
+
+void test_failed_write_is_dropped() {
+    EFLedPipeline<TEST_LEDS> pipeline;
+    EFLedMockBackend<TEST_LEDS> backend;
+
+    backend.failNext(1);
+    publishFilled(pipeline, 1);
+    TEST_ASSERT_TRUE(pipeline.service(backend));
+    publishFilled(pipeline, 2);
+    TEST_ASSERT_TRUE(pipeline.service(backend));
+
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.getDroppedCount());
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.getTransmittedCount());
+    TEST_ASSERT_EQUAL_UINT8(2, backend.getLastFrame().rgb[0]);
+}
+
+void test_concurrent_handoff() {
+    const uint32_t frames = 200000;
+    EFLedPipeline<TEST_LEDS> pipeline;
+    ConsistencyBackend backend;
+    std::atomic<bool> done(false);
+
+    std::thread consumer([&]() {
+        while (!done.load() || pipeline.pending()) {
+            pipeline.service(backend);
+        }
+    });
+    for (uint32_t seq = 0; seq < frames; seq++) {
+        // Frames are rendered in place, so a slot still read by the consumer would tear
+        EFLedFrame<TEST_LEDS>& frame = pipeline.back();
+        memset(frame.rgb, (uint8_t) seq, sizeof(frame.rgb));
+        frame.brightness = (uint8_t) seq;
+        pipeline.publish();
+    }
+    done.store(true);
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, backend.torn);
+    TEST_ASSERT_EQUAL_UINT32(0, backend.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(frames - 1, backend.last_seq);
+    TEST_ASSERT_EQUAL_UINT32(frames, pipeline.getPublishedCount());
+    TEST_ASSERT_EQUAL_UINT32(frames, pipeline.getTransmittedCount() + pipeline.getCoalescedCount());
+    TEST_ASSERT_EQUAL_UINT32(backend.writes, pipeline.getTransmittedCount());
+    TEST_ASSERT_TRUE(pipeline.idle());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_service_without_frame);
+    RUN_TEST(test_published_frame_reaches_backend);
+    RUN_TEST(test_newest_frame_wins);
+    RUN_TEST(test_failed_write_is_dropped);
+    RUN_TEST(test_concurrent_handoff);
+    return UNITY_END();
+}
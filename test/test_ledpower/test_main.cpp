@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Current estimate and brightness limit of EFLedPower
+ *
+ * Run: pio test -e native -f test_ledpower
+ */
+
+#include <unity.h>
+
+#include <cstdlib>
+
+#include <EFConfig.h>
+#include <EFLedPower.h>
+
+#define TEST_LEDS 18
+
+constexpr uint8_t black[TEST_LEDS * 3] = {};
+constexpr uint8_t red[3] = {255, 0, 0};
+constexpr uint8_t green[3] = {0, 255, 0};
+constexpr uint8_t white[3] = {255, 255, 255};
+
+struct WhiteFrame {
+    uint8_t rgb[TEST_LEDS * 3];
+
+    constexpr WhiteFrame() : rgb() {
+        for (uint8_t& channel : this->rgb) {
+            channel = 255;
+        }
+    }
+};
+constexpr WhiteFrame all_white;
+
+// Evaluated by the compiler, so the functions stay usable in constant expressions
+static_assert(EFLedPower::estimateMilliamps(black, TEST_LEDS, 255) == TEST_LEDS * EFLED_CURRENT_IDLE_MA);
+static_assert(EFLedPower::estimateMilliamps(red, 1, 255) == EFLED_CURRENT_RED_MA + EFLED_CURRENT_IDLE_MA);
+static_assert(EFLedPower::estimateMilliamps(white, 1, 255) == 43);
+static_assert(EFLedPower::estimateMilliamps(all_white.rgb, TEST_LEDS, 255) == TEST_LEDS * 43);
+static_assert(EFLedPower::limitBrightness(all_white.rgb, TEST_LEDS, 255, 10000) == 255);
+static_assert(EFLedPower::limitBrightness(all_white.rgb, TEST_LEDS, 255, TEST_LEDS) == 0);
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_estimate_scales_with_brightness() {
+    TEST_ASSERT_EQUAL_UINT32(TEST_LEDS, EFLedPower::estimateMilliamps(all_white.rgb, TEST_LEDS, 0));
+    // Half brightness halves the channel current, the quiescent current stays
+    TEST_ASSERT_UINT32_WITHIN(1, TEST_LEDS * 42 / 2 + TEST_LEDS, EFLedPower::estimateMilliamps(all_white.rgb, TEST_LEDS, 128));
+    TEST_ASSERT_EQUAL_UINT32(
+        EFLED_CURRENT_GREEN_MA + EFLED_CURRENT_IDLE_MA,
+        EFLedPower::estimateMilliamps(green, 1, 255)
+    );
+}
+
+void test_black_frame_keeps_brightness() {
+    TEST_ASSERT_EQUAL_UINT8(200, EFLedPower::limitBrightness(black, TEST_LEDS, 200, 0));
+}
+
+void test_limit_is_largest_brightness_within_budget() {
+    srand(1);
+    uint8_t rgb[TEST_LEDS * 3];
+    for (uint32_t run = 0; run < 2000; run++) {
+        for (uint8_t& channel : rgb) {
+            channel = rand() & 0xFF;
+        }
+        const uint8_t brightness = rand() & 0xFF;
+        const uint32_t budget_ma = TEST_LEDS + rand() % 600;
+
+        const uint8_t limited = EFLedPower::limitBrightness(rgb, TEST_LEDS, brightness, budget_ma);
+        TEST_ASSERT_LESS_OR_EQUAL(brightness, limited);
+        TEST_ASSERT_LESS_OR_EQUAL(budget_ma, EFLedPower::estimateMilliamps(rgb, TEST_LEDS, limited));
+        if (limited < brightness) {
+            TEST_ASSERT_GREATER_THAN(budget_ma, EFLedPower::estimateMilliamps(rgb, TEST_LEDS, limited + 1));
+        }
+    }
+}
+
+void test_budget_below_idle_turns_off() {
+    TEST_ASSERT_EQUAL_UINT8(0, EFLedPower::limitBrightness(all_white.rgb, TEST_LEDS, 255, TEST_LEDS - 1));
+}
+
+// ABSOLUTE_MAX_BRIGHTNESS in src/main.cpp
+#define NOMINAL_MAX_BRIGHTNESS 45
+
+void test_sparse_frame_exceeds_nominal_max() {
+    uint8_t rgb[EFLED_TOTAL_NUM * 3] = {};
+    rgb[0] = rgb[1] = rgb[2] = 255;
+    rgb[3 * 8 + 0] = 255;
+
+    const uint8_t brightness = EFLedPower::scaleBrightness(
+        rgb, EFLED_TOTAL_NUM, NOMINAL_MAX_BRIGHTNESS, NOMINAL_MAX_BRIGHTNESS,
+        EFLED_BRIGHTNESS_CEILING, EFLED_CURRENT_BUDGET_MA
+    );
+    TEST_ASSERT_GREATER_THAN(NOMINAL_MAX_BRIGHTNESS, brightness);
+    TEST_ASSERT_EQUAL_UINT8(EFLED_BRIGHTNESS_CEILING, brightness);
+    TEST_ASSERT_LESS_OR_EQUAL(EFLED_CURRENT_BUDGET_MA, EFLedPower::estimateMilliamps(rgb, EFLED_TOTAL_NUM, brightness));
+}
+
+void test_full_white_frame_stays_within_budget() {
+    const uint8_t brightness = EFLedPower::scaleBrightness(
+        all_white.rgb, EFLED_TOTAL_NUM, NOMINAL_MAX_BRIGHTNESS, NOMINAL_MAX_BRIGHTNESS,
+        EFLED_BRIGHTNESS_CEILING, EFLED_CURRENT_BUDGET_MA
+    );
+    TEST_ASSERT_LESS_OR_EQUAL(EFLED_CURRENT_BUDGET_MA, EFLedPower::estimateMilliamps(all_white.rgb, EFLED_TOTAL_NUM, brightness));
+    // Frames lighting up all LEDs keep the brightness of the nominal scale
+    TEST_ASSERT_UINT8_WITHIN(2, NOMINAL_MAX_BRIGHTNESS, brightness);
+}
+
+void test_scaled_brightness_follows_setting() {
+    srand(2);
+    uint8_t rgb[EFLED_TOTAL_NUM * 3];
+    for (uint32_t run = 0; run < 2000; run++) {
+        for (uint8_t& channel : rgb) {
+            channel = (rand() % 4 == 0) ? rand() & 0xFF : 0;
+        }
+        uint8_t last = 0;
+        for (uint8_t percent = 0; percent <= 100; percent += 10) {
+            const uint8_t requested = percent * NOMINAL_MAX_BRIGHTNESS / 100;
+            const uint8_t brightness = EFLedPower::scaleBrightness(
+                rgb, EFLED_TOTAL_NUM, requested, NOMINAL_MAX_BRIGHTNESS,
+                EFLED_BRIGHTNESS_CEILING, EFLED_CURRENT_BUDGET_MA
+            );
+            TEST_ASSERT_LESS_OR_EQUAL(EFLED_BRIGHTNESS_CEILING, brightness);
+            TEST_ASSERT_LESS_OR_EQUAL(EFLED_CURRENT_BUDGET_MA, EFLedPower::estimateMilliamps(rgb, EFLED_TOTAL_NUM, brightness));
+            // A higher setting never shows a frame darker
+            TEST_ASSERT_GREATER_OR_EQUAL(last, brightness);
+            last = brightness;
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_estimate_scales_with_brightness);
+    RUN_TEST(test_black_frame_keeps_brightness);
+    RUN_TEST(test_limit_is_largest_brightness_within_budget);
+    RUN_TEST(test_budget_below_idle_turns_off);
+    RUN_TEST(test_sparse_frame_exceeds_nominal_max);
+    RUN_TEST(test_full_white_frame_stays_within_budget);
+    RUN_TEST(test_scaled_brightness_follows_setting);
+    return UNITY_END();
+}
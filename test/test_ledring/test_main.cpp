@@ -0,0 +1,196 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Checks EFLedRing rotation and mirroring against the std::rotate /
+ * std::reverse semantics they document, and the transfer into segments.
+ *
+ * Run: pio test -e native -f test_ledring
+ */
+
+#include <unity.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#include <EFLedRing.h>
+
+#define RING_SIZE 7
+
+/**
+ * @brief Minimal stand-in for EFLedSegment
+ */
+struct TestSegment {
+    uint8_t* ptr;
+    uint8_t count;
+
+    uint8_t* data() const { return this->ptr; }
+    uint8_t size() const { return this->count; }
+};
+
+using Ring = EFLedRing<uint8_t, RING_SIZE>;
+using Reference = std::array<uint8_t, RING_SIZE>;
+
+static Ring makeRing() {
+    return Ring({1, 2, 3, 4, 5, 6, 7});
+}
+
+static Reference makeReference() {
+    return {1, 2, 3, 4, 5, 6, 7};
+}
+
+static void assertEqual(const Reference& expected, const Ring& ring, const char* message) {
+    for (uint8_t i = 0; i < RING_SIZE; i++) {
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected[i], ring[i], message);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_initializer_list_pads_and_truncates() {
+    const EFLedRing<uint8_t, 4> padded = {9, 8};
+    TEST_ASSERT_EQUAL_UINT8(9, padded[0]);
+    TEST_ASSERT_EQUAL_UINT8(8, padded[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, padded[2]);
+    TEST_ASSERT_EQUAL_UINT8(0, padded[3]);
+
+    const EFLedRing<uint8_t, 2> truncated = {9, 8, 7};
+    TEST_ASSERT_EQUAL_UINT8(9, truncated[0]);
+    TEST_ASSERT_EQUAL_UINT8(8, truncated[1]);
+}
+
+void test_rotate_matches_std_rotate() {
+    for (uint32_t k = 0; k < 3 * RING_SIZE; k++) {
+        Ring ring = makeRing();
+        Reference expected = makeReference();
+        ring.rotate(k);
+        std::rotate(expected.begin(), expected.begin() + k % RING_SIZE, expected.end());
+        assertEqual(expected, ring, "rotate");
+    }
+}
+
+void test_rotate_back_matches_std_rotate() {
+    for (uint32_t k = 0; k < 3 * RING_SIZE; k++) {
+        Ring ring = makeRing();
+        Reference expected = makeReference();
+        ring.rotateBack(k);
+        std::rotate(expected.rbegin(), expected.rbegin() + k % RING_SIZE, expected.rend());
+        assertEqual(expected, ring, "rotateBack");
+    }
+}
+
+void test_mirror_reverses() {
+    Ring ring = makeRing();
+    Reference expected = makeReference();
+    ring.mirror();
+    std::reverse(expected.begin(), expected.end());
+    assertEqual(expected, ring, "mirror");
+
+    ring.mirror();
+    assertEqual(makeReference(), ring, "mirror twice");
+}
+
+void test_random_operation_sequences() {
+    srand(1);
+    Ring ring = makeRing();
+    Reference expected = makeReference();
+    for (uint32_t step = 0; step < 10000; step++) {
+        const uint32_t k = rand() % 100;
+        switch (rand() % 4) {
+            case 0:
+                ring.rotate(k);
+                std::rotate(expected.begin(), expected.begin() + k % RING_SIZE, expected.end());
+                break;
+            case 1:
+                ring.rotateBack(k);
+                std::rotate(expected.rbegin(), expected.rbegin() + k % RING_SIZE, expected.rend());
+                break;
+            case 2:
+                ring.mirror();
+                std::reverse(expected.begin(), expected.end());
+                break;
+            case 3:
+                // Writes go through the same index mapping as reads
+                ring[k % RING_SIZE] = step & 0xFF;
+                expected[k % RING_SIZE] = step & 0xFF;
+                break;
+        }
+        assertEqual(expected, ring, "random sequence");
+    }
+}
+
+void test_copy_to_clips_to_ring() {
+    Ring ring = makeRing();
+    ring.rotate(2);
+    uint8_t dst[RING_SIZE + 2] = {};
+
+    TEST_ASSERT_EQUAL_UINT8(3, ring.copyTo(dst, 3, 1));
+    TEST_ASSERT_EQUAL_UINT8(4, dst[0]);
+    TEST_ASSERT_EQUAL_UINT8(6, dst[2]);
+
+    TEST_ASSERT_EQUAL_UINT8(2, ring.copyTo(dst, 10, RING_SIZE - 2));
+    TEST_ASSERT_EQUAL_UINT8(1, dst[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, dst[1]);
+
+    TEST_ASSERT_EQUAL_UINT8(0, ring.copyTo(dst, 1, RING_SIZE));
+}
+
+void test_write_to_concatenates_and_clips() {
+    // The byte after the segment guards against writes past its end
+    uint8_t leds[11] = {};
+    leds[10] = 0xAA;
+    const TestSegment segment = {leds, 10};
+    const EFLedRing<uint8_t, 4> first = {1, 2, 3, 4};
+    EFLedRing<uint8_t, 4> second = {5, 6, 7, 8};
+    second.mirror();
+
+    uint8_t pos = first.writeTo(segment);
+    TEST_ASSERT_EQUAL_UINT8(4, pos);
+    pos = second.writeTo(segment, pos);
+    TEST_ASSERT_EQUAL_UINT8(8, pos);
+    // Only two elements fit
+    pos = first.writeTo(segment, pos);
+    TEST_ASSERT_EQUAL_UINT8(10, pos);
+
+    const uint8_t expected[11] = {1, 2, 3, 4, 8, 7, 6, 5, 1, 2, 0xAA};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, leds, 11);
+
+    // Offsets at or past the end write nothing
+    TEST_ASSERT_EQUAL_UINT8(10, first.writeTo(segment, 10));
+    TEST_ASSERT_EQUAL_UINT8(10, first.writeTo(segment, 200));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, leds, 11);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_initializer_list_pads_and_truncates);
+    RUN_TEST(test_rotate_matches_std_rotate);
+    RUN_TEST(test_rotate_back_matches_std_rotate);
+    RUN_TEST(test_mirror_reverses);
+    RUN_TEST(test_random_operation_sequences);
+    RUN_TEST(test_copy_to_clips_to_ring);
+    RUN_TEST(test_write_to_concatenates_and_clips);
+    return UNITY_END();
+}
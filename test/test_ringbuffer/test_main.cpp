@@ -0,0 +1,145 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Ordering and overflow accounting of EFRingBuffer
+ *
+ * Run: pio test -e native -f test_ringbuffer
+ */
+
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include <EFRingBuffer.h>
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_fifo_order_across_wrap() {
+    EFRingBuffer<uint32_t, 4> buffer;
+    uint32_t value;
+
+    for (uint32_t i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(buffer.push(i));
+        TEST_ASSERT_TRUE(buffer.push(i + 100));
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i + 100, value);
+    }
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_FALSE(buffer.pop(value));
+}
+
+void test_full_buffer_drops_and_counts() {
+    EFRingBuffer<uint32_t, 4> buffer;
+    uint32_t value;
+
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(buffer.push(i));
+    }
+    TEST_ASSERT_FALSE(buffer.push(4));
+    TEST_ASSERT_FALSE(buffer.push(5));
+    TEST_ASSERT_EQUAL_UINT32(2, buffer.getOverflowCount());
+    TEST_ASSERT_EQUAL_UINT32(4, buffer.size());
+
+    // The buffered elements are untouched, the new ones were dropped
+    TEST_ASSERT_TRUE(buffer.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(0, value);
+    TEST_ASSERT_TRUE(buffer.push(6));
+    TEST_ASSERT_EQUAL_UINT32(1, *buffer.peek(0));
+    TEST_ASSERT_EQUAL_UINT32(6, *buffer.peek(3));
+    TEST_ASSERT_NULL(buffer.peek(4));
+}
+
+void test_discard_is_clamped() {
+    EFRingBuffer<uint32_t, 8> buffer;
+
+    buffer.push(1);
+    buffer.push(2);
+    buffer.push(3);
+    buffer.discard(2);
+    TEST_ASSERT_EQUAL_UINT32(1, buffer.size());
+    TEST_ASSERT_EQUAL_UINT32(3, *buffer.peek());
+    buffer.discard(5);
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_TRUE(buffer.push(4));
+    TEST_ASSERT_EQUAL_UINT32(4, *buffer.peek());
+}
+
+void test_spsc_stress() {
+    const uint32_t values = 1000000;
+    EFRingBuffer<uint32_t, 64> buffer;
+    std::atomic<bool> done(false);
+    uint64_t pushed_sum = 0;
+    uint32_t pushed = 0;
+    uint64_t popped_sum = 0;
+    uint32_t popped = 0;
+    uint32_t out_of_order = 0;
+
+    std::thread consumer([&]() {
+        int64_t last = -1;
+        uint32_t value;
+        while (true) {
+            // Read the flag first, so nothing pushed before it was set is missed
+            const bool finished = done.load();
+            if (!buffer.pop(value)) {
+                if (finished) {
+                    break;
+                }
+                continue;
+            }
+            if ((int64_t) value <= last) {
+                out_of_order++;
+            }
+            last = value;
+            popped_sum += value;
+            popped++;
+        }
+    });
+    for (uint32_t value = 0; value < values; value++) {
+        if (buffer.push(value)) {
+            pushed_sum += value;
+            pushed++;
+        }
+    }
+    done.store(true);
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(pushed, popped);
+    TEST_ASSERT_EQUAL_UINT64(pushed_sum, popped_sum);
+    TEST_ASSERT_EQUAL_UINT32(values - pushed, buffer.getOverflowCount());
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order_across_wrap);
+    RUN_TEST(test_full_buffer_drops_and_counts);
+    RUN_TEST(test_discard_is_clamped);
+    RUN_TEST(test_spsc_stress);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Handoff of the latest state through EFSnapshot
+ *
+ * Run: pio test -e native -f test_snapshot
+ */
+
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#include <EFSnapshot.h>
+
+/**
+ * @brief State large enough that a torn copy shows as differing words
+ */
+struct TestState {
+    uint32_t seq;
+    uint32_t words[31];
+};
+
+static TestState makeState(uint32_t seq) {
+    TestState state;
+    state.seq = seq;
+    for (uint32_t& word : state.words) {
+        word = seq;
+    }
+    return state;
+}
+
+static bool isConsistent(const TestState& state) {
+    for (uint32_t word : state.words) {
+        if (word != state.seq) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_initial_value() {
+    EFSnapshot<TestState> snapshot;
+
+    TEST_ASSERT_FALSE(snapshot.pending());
+    TEST_ASSERT_FALSE(snapshot.update());
+    TEST_ASSERT_EQUAL_UINT32(0, snapshot.read().seq);
+    TEST_ASSERT_TRUE(isConsistent(snapshot.read()));
+}
+
+void test_read_keeps_value_until_update() {
+    EFSnapshot<TestState> snapshot;
+
+    snapshot.publish(makeState(1));
+    TEST_ASSERT_TRUE(snapshot.pending());
+    TEST_ASSERT_EQUAL_UINT32(0, snapshot.read().seq);
+
+    TEST_ASSERT_TRUE(snapshot.update());
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.read().seq);
+
+    // Nothing new: the consumer keeps the value it has
+    TEST_ASSERT_FALSE(snapshot.update());
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.read().seq);
+}
+
+void test_latest_value_wins() {
+    EFSnapshot<TestState> snapshot;
+
+    for (uint32_t seq = 1; seq <= 5; seq++) {
+        snapshot.publish(makeState(seq));
+    }
+    TEST_ASSERT_TRUE(snapshot.update());
+    TEST_ASSERT_EQUAL_UINT32(5, snapshot.read().seq);
+    TEST_ASSERT_TRUE(isConsistent(snapshot.read()));
+    TEST_ASSERT_EQUAL_UINT32(5, snapshot.getPublishedCount());
+    TEST_ASSERT_EQUAL_UINT32(4, snapshot.getCoalescedCount());
+}
+
+void test_concurrent_reads_never_tear() {
+    const uint32_t values = 200000;
+    EFSnapshot<TestState> snapshot;
+    std::atomic<bool> done(false);
+    uint32_t torn = 0;
+    uint32_t went_back = 0;
+    uint32_t updates = 0;
+    uint32_t last_seq = 0;
+
+    std::thread consumer([&]() {
+        while (!done.load() || snapshot.pending()) {
+            if (!snapshot.update()) {
+                continue;
+            }
+            const TestState& state = snapshot.read();
+            if (!isConsistent(state)) {
+                torn++;
+            }
+            if (state.seq <= last_seq) {
+                went_back++;
+            }
+            last_seq = state.seq;
+            updates++;
+        }
+    });
+    for (uint32_t seq = 1; seq <= values; seq++) {
+        snapshot.publish(makeState(seq));
+    }
+    done.store(true);
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, went_back);
+    TEST_ASSERT_EQUAL_UINT32(values, last_seq);
+    TEST_ASSERT_EQUAL_UINT32(values, updates + snapshot.getCoalescedCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_initial_value);
+    RUN_TEST(test_read_keeps_value_until_update);
+    RUN_TEST(test_latest_value_wins);
+    RUN_TEST(test_concurrent_reads_never_tear);
+    return UNITY_END();
+}
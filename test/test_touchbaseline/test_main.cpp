@@ -0,0 +1,181 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Replays synthetic drift, noise and touch traces through EFTouchBaseline
+ *
+ * Run: pio test -e native -f test_touchbaseline
+ */
+
+#include <unity.h>
+
+#include <EFTouchBaseline.h>
+
+#define SAMPLE_INTERVAL_MS 100
+#define BASELINE 40000
+#define MIN_PRESS_DELTA 10000
+#define MAX_TOUCH_MS 60000
+
+static const EFTouchBaselineConfig config = {MIN_PRESS_DELTA, 4, 75, 4, MAX_TOUCH_MS};
+
+static EFTouchBaseline baseline(config);
+static uint32_t now_ms;
+static uint32_t touched_samples;
+static uint32_t random_state;
+
+/**
+ * @brief Deterministic noise, uniformly distributed in [-amplitude, amplitude]
+ */
+static int32_t noise(int32_t amplitude) {
+    random_state = random_state * 1103515245 + 12345;
+    return static_cast<int32_t>((random_state >> 8) % (2 * amplitude + 1)) - amplitude;
+}
+
+/**
+ * @brief Feeds samples_count samples of the given level, counting the ones detected as touched
+ */
+static void replay(uint32_t level, uint32_t samples_count, int32_t noise_amplitude = 0) {
+    for (uint32_t i = 0; i < samples_count; i++) {
+        now_ms += SAMPLE_INTERVAL_MS;
+        if (baseline.update(level + noise(noise_amplitude), now_ms)) {
+            touched_samples++;
+        }
+    }
+}
+
+void setUp() {
+    baseline = EFTouchBaseline(config);
+    baseline.reset(BASELINE);
+    now_ms = 0;
+    touched_samples = 0;
+    random_state = 1;
+}
+
+void tearDown() {}
+
+void test_follows_slow_upward_drift() {
+    // Warming up raises the reading by 8000 over ten minutes
+    for (uint32_t level = BASELINE; level < BASELINE + 8000; level += 8) {
+        replay(level, 6, 300);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, touched_samples);
+    TEST_ASSERT_UINT32_WITHIN(500, BASELINE + 8000, baseline.getBaseline());
+}
+
+void test_follows_falling_reading_quickly() {
+    replay(BASELINE - 15000, 10);
+    TEST_ASSERT_EQUAL_UINT32(0, touched_samples);
+    TEST_ASSERT_UINT32_WITHIN(100, BASELINE - 15000, baseline.getBaseline());
+}
+
+void test_rejects_single_spikes() {
+    for (uint32_t i = 0; i < 50; i++) {
+        replay(BASELINE, 5, 200);
+        replay(BASELINE + 3 * MIN_PRESS_DELTA, 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, touched_samples);
+}
+
+void test_threshold_adapts_to_noise() {
+    replay(BASELINE, 200, 200);
+    TEST_ASSERT_EQUAL_UINT32(MIN_PRESS_DELTA, baseline.getPressThreshold());
+
+    // A noisy supply raises the threshold above the minimum instead of triggering touches
+    replay(BASELINE, 600, 7000);
+    TEST_ASSERT_EQUAL_UINT32(0, touched_samples);
+    TEST_ASSERT_GREATER_THAN(MIN_PRESS_DELTA, baseline.getPressThreshold());
+    TEST_ASSERT_UINT32_WITHIN(1000, BASELINE, baseline.getBaseline());
+
+    // And lowers it again once the noise is gone
+    replay(BASELINE, 600, 200);
+    TEST_ASSERT_EQUAL_UINT32(MIN_PRESS_DELTA, baseline.getPressThreshold());
+}
+
+void test_release_hysteresis() {
+    replay(BASELINE, 20, 200);
+    TEST_ASSERT_EQUAL_UINT32(7500, baseline.getReleaseThreshold());
+
+    replay(BASELINE + MIN_PRESS_DELTA + 3000, 5);
+    TEST_ASSERT_TRUE(baseline.isTouched());
+
+    // Between release and press threshold the touch holds
+    replay(BASELINE + 8000, 10);
+    TEST_ASSERT_TRUE(baseline.isTouched());
+    TEST_ASSERT_UINT32_WITHIN(200, BASELINE, baseline.getBaseline());
+
+    replay(BASELINE + 7000, 2);
+    TEST_ASSERT_FALSE(baseline.isTouched());
+}
+
+void test_approaching_finger_does_not_move_baseline() {
+    replay(BASELINE, 20, 200);
+    // Hovering above the pad stays between release and press threshold
+    replay(BASELINE + 9000, 200);
+    TEST_ASSERT_EQUAL_UINT32(0, touched_samples);
+    TEST_ASSERT_UINT32_WITHIN(200, BASELINE, baseline.getBaseline());
+
+    // So the press threshold still counts from the untouched pad
+    replay(BASELINE + MIN_PRESS_DELTA, 5);
+    TEST_ASSERT_TRUE(baseline.isTouched());
+}
+
+void test_relearns_after_max_touch() {
+    replay(BASELINE, 20, 200);
+
+    // Condensation on the pad looks like a touch that never ends
+    const uint32_t shifted = BASELINE + 2 * MIN_PRESS_DELTA;
+    replay(shifted, MAX_TOUCH_MS / SAMPLE_INTERVAL_MS, 200);
+    TEST_ASSERT_TRUE(baseline.isTouched());
+
+    replay(shifted, 1000 / SAMPLE_INTERVAL_MS, 200);
+    TEST_ASSERT_FALSE(baseline.isTouched());
+    TEST_ASSERT_UINT32_WITHIN(300, shifted, baseline.getBaseline());
+
+    // Touches on top of the new baseline are detected again
+    touched_samples = 0;
+    replay(shifted, 20, 200);
+    TEST_ASSERT_EQUAL_UINT32(0, touched_samples);
+    replay(shifted + MIN_PRESS_DELTA + 3000, 5);
+    TEST_ASSERT_TRUE(baseline.isTouched());
+    replay(shifted, 3);
+    TEST_ASSERT_FALSE(baseline.isTouched());
+}
+
+void test_regular_touch_is_not_relearned() {
+    replay(BASELINE, 20, 200);
+    replay(BASELINE + 2 * MIN_PRESS_DELTA, (MAX_TOUCH_MS - 1000) / SAMPLE_INTERVAL_MS, 200);
+    TEST_ASSERT_TRUE(baseline.isTouched());
+    TEST_ASSERT_UINT32_WITHIN(200, BASELINE, baseline.getBaseline());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_follows_slow_upward_drift);
+    RUN_TEST(test_follows_falling_reading_quickly);
+    RUN_TEST(test_rejects_single_spikes);
+    RUN_TEST(test_threshold_adapts_to_noise);
+    RUN_TEST(test_release_hysteresis);
+    RUN_TEST(test_approaching_finger_does_not_move_baseline);
+    RUN_TEST(test_relearns_after_max_touch);
+    RUN_TEST(test_regular_touch_is_not_relearned);
+    return UNITY_END();
+}
@@ -0,0 +1,228 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Classification of touch edges by EFTouchGestures
+ *
+ * Run: pio test -e native -f test_touchgestures
+ */
+
+#include <unity.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <EFTouchGestures.h>
+
+#define TICK_INTERVAL_MS 10
+#define MAX_RECORDED 64
+
+static EFTouchGestures gestures;
+static EFTouchGestureEvent recorded[MAX_RECORDED];
+static uint32_t recorded_ms[MAX_RECORDED];
+static uint8_t recorded_count;
+static uint32_t now_ms;
+
+static void record(const EFTouchGestureEvent* events, uint8_t count) {
+    TEST_ASSERT_LESS_OR_EQUAL(EFTOUCH_GESTURES_MAX_EVENTS, count);
+    for (uint8_t i = 0; i < count && recorded_count < MAX_RECORDED; i++) {
+        recorded_ms[recorded_count] = events[i].timestamp_us / 1000;
+        recorded[recorded_count++] = events[i];
+    }
+}
+
+/**
+ * @brief Advances to the given time, calling tick() like EFTouch::poll() does
+ */
+static void runUntil(uint32_t until_ms) {
+    EFTouchGestureEvent events[EFTOUCH_GESTURES_MAX_EVENTS];
+    while (now_ms + TICK_INTERVAL_MS <= until_ms) {
+        now_ms += TICK_INTERVAL_MS;
+        record(events, gestures.tick(now_ms, now_ms * 1000, events));
+    }
+    now_ms = until_ms;
+}
+
+static void edge(EFTouchZone zone, bool touched, uint32_t at_ms, bool ticks = true) {
+    if (ticks) {
+        runUntil(at_ms);
+    }
+    now_ms = at_ms;
+    EFTouchGestureEvent events[EFTOUCH_GESTURES_MAX_EVENTS];
+    record(events, gestures.feed({zone, touched, at_ms, at_ms * 1000}, events));
+}
+
+static uint8_t countOf(EFTouchZone zone, EFTouchGesture gesture) {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < recorded_count; i++) {
+        if (recorded[i].zone == zone && recorded[i].gesture == gesture) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Asserts the recorded gestures, ignoring holds
+ */
+static void assertSequence(const EFTouchGestureEvent* expected, uint8_t count) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < recorded_count; i++) {
+        if (recorded[i].gesture == EFTouchGesture::Hold) {
+            continue;
+        }
+        char message[64];
+        snprintf(message, sizeof(message), "gesture #%u", n);
+        TEST_ASSERT_LESS_THAN_MESSAGE(count, n, message);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected[n].zone, recorded[i].zone, message);
+        TEST_ASSERT_EQUAL_INT_MESSAGE((int) expected[n].gesture, (int) recorded[i].gesture, message);
+        n++;
+    }
+    TEST_ASSERT_EQUAL_UINT8(count, n);
+}
+
+#define ASSERT_SEQUENCE(...) do { \
+    const EFTouchGestureEvent expected[] = {__VA_ARGS__}; \
+    assertSequence(expected, sizeof(expected) / sizeof(expected[0])); \
+} while (0)
+
+#define G(zone, gesture) {EFTouchZone::zone, EFTouchGesture::gesture, 0}
+
+void setUp() {
+    gestures.reset();
+    recorded_count = 0;
+    // Start well after the cooldowns that reset() armed at 0 ms
+    now_ms = 10000;
+}
+
+void tearDown() {}
+
+void test_tap_is_no_shortpress() {
+    edge(EFTouchZone::Fingerprint, true, 10000);
+    edge(EFTouchZone::Fingerprint, false, 10000 + EFTOUCH_SHORTPRESS_DURATION_MS);
+    ASSERT_SEQUENCE(G(Fingerprint, Touch), G(Fingerprint, Release));
+}
+
+void test_shortpress() {
+    edge(EFTouchZone::Nose, true, 10000);
+    edge(EFTouchZone::Nose, false, 10000 + EFTOUCH_SHORTPRESS_DURATION_MS + 1);
+    ASSERT_SEQUENCE(G(Nose, Touch), G(Nose, Shortpress), G(Nose, Release));
+    TEST_ASSERT_EQUAL_UINT32(10000 + EFTOUCH_SHORTPRESS_DURATION_MS + 1, recorded_ms[1]);
+}
+
+void test_longpress_and_holds() {
+    edge(EFTouchZone::Fingerprint, true, 10000);
+    runUntil(10000 + EFTOUCH_LONGPRESS_DURATION_MS);
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Longpress));
+
+    runUntil(10000 + EFTOUCH_LONGPRESS_DURATION_MS + TICK_INTERVAL_MS);
+    TEST_ASSERT_EQUAL_UINT8(1, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Longpress));
+    TEST_ASSERT_EQUAL_UINT32(10000 + EFTOUCH_LONGPRESS_DURATION_MS + TICK_INTERVAL_MS, recorded_ms[1]);
+
+    edge(EFTouchZone::Fingerprint, false, 10000 + EFTOUCH_LONGPRESS_DURATION_MS + 4 * EFTOUCH_HOLD_INTERVAL_MS + TICK_INTERVAL_MS);
+    TEST_ASSERT_EQUAL_UINT8(4, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Hold));
+    // The longpress consumed the touch, releasing it is no shortpress
+    ASSERT_SEQUENCE(G(Fingerprint, Touch), G(Fingerprint, Longpress), G(Fingerprint, Release));
+}
+
+void test_late_release_is_longpress_only() {
+    // Released before tick() caught up with the longpress
+    edge(EFTouchZone::Nose, true, 10000, false);
+    edge(EFTouchZone::Nose, false, 10000 + EFTOUCH_LONGPRESS_DURATION_MS + 50, false);
+    ASSERT_SEQUENCE(G(Nose, Touch), G(Nose, Longpress), G(Nose, Release));
+}
+
+void test_all_zone_shortpress_and_cooldown() {
+    edge(EFTouchZone::Fingerprint, true, 10000);
+    edge(EFTouchZone::Nose, true, 10100);
+    edge(EFTouchZone::Fingerprint, false, 10600);
+    edge(EFTouchZone::Nose, false, 10650);
+    ASSERT_SEQUENCE(
+        G(Fingerprint, Touch), G(Nose, Touch),
+        G(All, Shortpress), G(Fingerprint, Shortpress), G(Fingerprint, Release),
+        G(Nose, Shortpress), G(Nose, Release)
+    );
+
+    // Within the cooldown only the single zones press
+    recorded_count = 0;
+    edge(EFTouchZone::Fingerprint, true, 10700);
+    edge(EFTouchZone::Nose, true, 10700);
+    edge(EFTouchZone::Fingerprint, false, 10700 + EFTOUCH_SHORTPRESS_DURATION_MS + 1);
+    edge(EFTouchZone::Nose, false, 10700 + EFTOUCH_SHORTPRESS_DURATION_MS + 1);
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::All, EFTouchGesture::Shortpress));
+    TEST_ASSERT_EQUAL_UINT8(1, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Shortpress));
+    TEST_ASSERT_EQUAL_UINT8(1, countOf(EFTouchZone::Nose, EFTouchGesture::Shortpress));
+
+    // Afterwards the all-zone shortpress is back
+    recorded_count = 0;
+    edge(EFTouchZone::Fingerprint, true, 12000);
+    edge(EFTouchZone::Nose, true, 12000);
+    edge(EFTouchZone::Nose, false, 12500);
+    TEST_ASSERT_EQUAL_UINT8(1, countOf(EFTouchZone::All, EFTouchGesture::Shortpress));
+}
+
+void test_deferred_all_zone_longpress() {
+    // The nose joins late, the fingerprint longpress waits for it
+    edge(EFTouchZone::Fingerprint, true, 10000);
+    edge(EFTouchZone::Nose, true, 10500);
+    runUntil(10000 + EFTOUCH_LONGPRESS_DURATION_MS + 200);
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Longpress));
+
+    runUntil(10500 + EFTOUCH_LONGPRESS_DURATION_MS + TICK_INTERVAL_MS);
+    TEST_ASSERT_EQUAL_UINT8(1, countOf(EFTouchZone::All, EFTouchGesture::Longpress));
+    TEST_ASSERT_EQUAL_UINT32(10500 + EFTOUCH_LONGPRESS_DURATION_MS + TICK_INTERVAL_MS, recorded_ms[2]);
+
+    // The all-zone longpress consumes both touches, so neither holds nor shortpresses
+    edge(EFTouchZone::Nose, false, 13000);
+    edge(EFTouchZone::Fingerprint, false, 13100);
+    ASSERT_SEQUENCE(
+        G(Fingerprint, Touch), G(Nose, Touch),
+        G(All, Longpress), G(Fingerprint, Longpress),
+        G(Nose, Release), G(Fingerprint, Release)
+    );
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Hold));
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::Nose, EFTouchGesture::Hold));
+}
+
+void test_deferral_ends_when_other_zone_releases() {
+    edge(EFTouchZone::Fingerprint, true, 10000);
+    edge(EFTouchZone::Nose, true, 11000);
+    runUntil(11900);
+    edge(EFTouchZone::Nose, false, 12000);
+    runUntil(12010);
+    // The nose was not held long enough, so the fingerprint longpresses alone
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::All, EFTouchGesture::Longpress));
+    TEST_ASSERT_EQUAL_UINT8(1, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Longpress));
+    TEST_ASSERT_EQUAL_UINT8(0, countOf(EFTouchZone::Fingerprint, EFTouchGesture::Shortpress));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_tap_is_no_shortpress);
+    RUN_TEST(test_shortpress);
+    RUN_TEST(test_longpress_and_holds);
+    RUN_TEST(test_late_release_is_longpress_only);
+    RUN_TEST(test_all_zone_shortpress_and_cooldown);
+    RUN_TEST(test_deferred_all_zone_longpress);
+    RUN_TEST(test_deferral_ends_when_other_zone_releases);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Replays the checked-in serial capture of GET TOUCHTRACE through the
+ * touch classification and the FSM, like `--touch-trace` of the simulator
+ *
+ * The capture holds 14 s of raw readings of both pads with drift and noise: a
+ * fingerprint shortpress, a nose tap, a fingerprint longpress and an all-zone
+ * shortpress.
+ *
+ * Run: pio test -e native -f test_touchtrace
+ */
+
+#include <unity.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include <EFTouch.h>
+#include <FSM.h>
+
+#include "EFSim.h"
+
+#define TRACE_PATH "test/test_touchtrace/capture.bin"
+
+extern FSM fsm;
+void setup();
+void loop();
+
+/**
+ * @brief An event handled by the FSM and the state that handled it
+ */
+struct HandledEvent {
+    const char* event;
+    const char* state;
+};
+
+static const HandledEvent expected[] = {
+    {"FingerprintTouch", "AnimateMatrix"},
+    {"FingerprintShortpress", "AnimateMatrix"},
+    {"NoseTouch", "MenuMain"},
+    {"NoseRelease", "MenuMain"},
+    {"FingerprintTouch", "MenuMain"},
+    {"FingerprintLongpress", "MenuMain"},
+    {"FingerprintHold", "DisplayPrideFlag"},
+    {"FingerprintHold", "DisplayPrideFlag"},
+    {"FingerprintHold", "DisplayPrideFlag"},
+    {"FingerprintHold", "DisplayPrideFlag"},
+    {"FingerprintTouch", "DisplayPrideFlag"},
+    {"NoseTouch", "DisplayPrideFlag"},
+    {"AllShortpress", "DisplayPrideFlag"},
+    {"NoseShortpress", "DisplayPrideFlag"},
+};
+
+static char events_path[] = "/tmp/test_touchtrace_XXXXXX";
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_replay_produces_event_sequence() {
+    FILE* f = fopen(events_path, "r");
+    TEST_ASSERT_NOT_NULL(f);
+
+    char line[128];
+    size_t n = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') {
+            continue;
+        }
+        char event[64];
+        char state[64];
+        TEST_ASSERT_EQUAL_INT(2, sscanf(line, "%*u %63s %63s", event, state));
+        TEST_ASSERT_LESS_THAN(sizeof(expected) / sizeof(expected[0]), n);
+        TEST_ASSERT_EQUAL_STRING(expected[n].event, event);
+        TEST_ASSERT_EQUAL_STRING(expected[n].state, state);
+        n++;
+    }
+    fclose(f);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected) / sizeof(expected[0]), n);
+}
+
+void test_no_touch_edge_dropped() {
+    TEST_ASSERT_EQUAL_UINT32(0, EFTouch.getDroppedEdgeCount());
+    TEST_ASSERT_EQUAL_UINT32(0, fsm.getDroppedEventCount());
+}
+
+int main() {
+    const int fd = mkstemp(events_path);
+    if (fd < 0 || !EFSim.loadTouchTrace(TRACE_PATH) || !EFSim.openEvents(events_path)) {
+        return 1;
+    }
+    close(fd);
+
+    setup();
+    EFSim.startTouchTrace();
+    const uint64_t end_us = EFSim.now() + (EFSim.getTouchTraceDurationMs() + EFSIM_TOUCH_TRACE_TAIL_MS) * 1000;
+    while (EFSim.now() < end_us) {
+        loop();
+        EFSim.advance(1000);
+    }
+    fflush(nullptr);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_produces_event_sequence);
+    RUN_TEST(test_no_touch_edge_dropped);
+    const int failures = UNITY_END();
+    unlink(events_path);
+    return failures;
+}
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright 2024 Eurofurence e.V. 
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the “Software”),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @brief Runs setup() from src/main.cpp in the simulator and checks that no
+ * FSM transition allocates heap memory, including the one into DeepSleep.
+ *
+ * Run: pio test -e native -f test_transitions
+ */
+
+#include <unity.h>
+
+#include <FSM.h>
+
+#include "EFSim.h"
+
+extern FSM fsm;
+void setup();
+
+static const uint8_t first = static_cast<uint8_t>(FSMStateId::None) + 1;
+static const uint8_t last = static_cast<uint8_t>(FSMStateId::DeepSleep);
+
+static uint64_t transitionAllocations(FSMStateId id) {
+    const uint64_t allocations_start = efsim_heap_allocations;
+    fsm.transition(id);
+    return efsim_heap_allocations - allocations_start;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_every_state_entered_without_allocation() {
+    // First pass lets states perform one-time lazy initialization
+    for (uint8_t id = first; id <= last; id++) {
+        transitionAllocations(static_cast<FSMStateId>(id));
+    }
+
+    for (uint8_t id = first; id <= last; id++) {
+        const char* from = fsm.getStateName();
+        const uint64_t allocations = transitionAllocations(static_cast<FSMStateId>(id));
+        char message[64];
+        snprintf(message, sizeof(message), "%s -> %s", from, fsm.getStateName());
+        TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, allocations, message);
+    }
+}
+
+void test_deep_sleep_entered_from_every_state_without_allocation() {
+    for (uint8_t id = first; id < last; id++) {
+        transitionAllocations(static_cast<FSMStateId>(id));
+        const char* from = fsm.getStateName();
+        const uint64_t allocations = transitionAllocations(FSMStateId::DeepSleep);
+        TEST_ASSERT_EQUAL_STRING("DeepSleep", fsm.getStateName());
+        TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, allocations, from);
+    }
+}
+
+int main() {
+    // DeepSleep only goes to sleep from run(), which loop() is never called for here
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_state_entered_without_allocation);
+    RUN_TEST(test_deep_sleep_entered_from_every_state_without_allocation);
+    return UNITY_END();
+}